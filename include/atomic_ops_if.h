@@ -249,6 +249,8 @@
 	#  define FAI_U16(a) __sync_fetch_and_add(a,1)
 	#  define FAI_U32(a) __sync_fetch_and_add(a,1)
 	#  define FAI_U64(a) __sync_fetch_and_add(a,1)
+	//Fetch-and-add
+	#  define FAA_U64(a,b) __sync_fetch_and_add(a,b)
 	//Fetch-and-decrement
 	#  define FAD_U8(a) __sync_fetch_and_sub(a,1)
 	#  define FAD_U16(a) __sync_fetch_and_sub(a,1)
@@ -45,6 +45,9 @@
 	typedef intptr_t skey_t;
 	typedef intptr_t sval_t;
 
+	// Called on every item taken by a bulk drain, or seen by a snapshot
+	typedef void (*visit_fn_t)(sval_t val, void *arg);
+
 	typedef struct strkey_t
 	{
 		char key[STRING_LENGTH];
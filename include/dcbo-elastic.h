@@ -0,0 +1,81 @@
+#ifndef DCBO_ELASTIC_H
+#define DCBO_ELASTIC_H
+
+/*
+ * Elastic width for the d-CBO queues. All sub-queues are allocated up front and enqueues only
+ * go to the first width of them, while the span bounds the sub-queues that may still hold items.
+ *
+ * - Growing raises the span before the width, so dequeuers can reach the new sub-queues first.
+ * - Shrinking lowers only the width. Dequeuers drain the retired sub-queues from the top and
+ *   lower the span past each one found empty, re-checking it afterwards.
+ * - An enqueue that lands above the span, from a width read before a shrink, raises it again.
+ *
+ * The span carries a change count in its high half, so the double-collect can tell that it
+ * did not move between its two passes, even if it moved back to the same value.
+ */
+
+#define SPAN_WIDTH(span) ((uint32_t) (span))
+#define SPAN_CHANGE(span, width) (((((span) >> 32) + 1) << 32) | (uint64_t) (width))
+
+static inline void span_raise(volatile uint64_t *span, uint32_t width)
+{
+	uint64_t old = *span;
+	while (SPAN_WIDTH(old) < width)
+	{
+		uint64_t seen = CAS_U64(span, old, SPAN_CHANGE(old, width));
+		if (seen == old)
+		{
+			return;
+		}
+		old = seen;
+	}
+}
+
+#ifdef ELASTIC_CONTROLLER
+/*
+ * Contention-driven width controller, as for the elastic 2D queue. Each thread keeps a balance
+ * that failed CAS operations push up and uncontended operations pull down, and proposes a wider
+ * set when it passes the threshold upwards and a narrower one when it passes it downwards.
+ */
+
+// How much to increment count at contention
+#define CONT_INC 75
+// How much to decrement count when no contention
+#define UNCONT_DEC 1
+// At what absolute count to change the width
+#define CONT_THRESHOLD 5000
+// How often to halve the count, preventing drift
+#define ITER_THRESHOLD (1 << 20)
+// Widths change by an eighth, so both few and many threads are reached in a few steps
+#define WIDTH_STEP(width) ((width) / 8 + 1)
+
+typedef struct elastic_controller
+{
+	int32_t count;
+	uint32_t iters;
+} elastic_controller_t;
+
+// Returns the width the controller asks for, which is the current one until the threshold is passed
+static inline uint32_t controller_width(elastic_controller_t *cont, uint32_t width, uint32_t min_width, uint32_t max_width, int contended)
+{
+	cont->count += contended ? CONT_INC : -UNCONT_DEC;
+	if (unlikely(++cont->iters == ITER_THRESHOLD))
+	{
+		cont->count >>= 1;
+		cont->iters = 0;
+	}
+	if (unlikely(cont->count > CONT_THRESHOLD))
+	{
+		cont->count = 0;
+		return width + WIDTH_STEP(width) < max_width ? width + WIDTH_STEP(width) : max_width;
+	}
+	if (unlikely(cont->count < -CONT_THRESHOLD))
+	{
+		cont->count = 0;
+		return width > min_width + WIDTH_STEP(width) ? width - WIDTH_STEP(width) : min_width;
+	}
+	return width;
+}
+#endif
+
+#endif
@@ -0,0 +1,626 @@
+/*
+ * The d-CBO engine, compiled by the d-balanced-queue.c of each d-CBO, and once per backend by the
+ * backend-<name>.c of dcbo-multi, after it has included the backend's partial queue and defined:
+ * - DCBO_FN(name), the name of each engine function, prefixed by the backend in dcbo-multi,
+ * - BACKEND_ENQUEUE(q,k,v,i), BACKEND_DEQUEUE(q,i), BACKEND_ENQUEUE_BATCH(q,v,n,i) and
+ *   BACKEND_DEQUEUE_BATCH(q,v,m,i), where i is the sub-queue index some backends need,
+ * - BACKEND_REGISTER(set), the per thread setup of the backend,
+ * - BACKEND_THREAD_STATE, the address of the backend's thread local word, NULL if it has none,
+ *   only defined where an embedder needs it.
+ * Each copy is thereby specialized to its backend, with direct calls to the partial queue. A backend
+ * with PARTIAL_DRAIN also gets queue_drain and queue_snapshot, and DCBO_LINEARIZATION_TIMESTAMPS
+ * records every operation for RELAXATION_ANALYSIS=APPROX. The header provides QUEUE(set,i), the
+ * address of sub-queue i.
+ */
+
+#ifdef DCBO_LINEARIZATION_TIMESTAMPS
+static __thread uint64_t enq_start_timestamp;
+static __thread uint64_t deq_start_timestamp;
+
+// Records the n items of an operation started at the thread's start timestamp, as ending now
+static inline void add_relaxed_puts(sval_t *vals, size_t n)
+{
+    uint64_t end = get_timestamp();
+    for (size_t i = 0; i < n; i++) add_relaxed_put(vals[i], enq_start_timestamp, end);
+}
+
+static inline void add_relaxed_gets(sval_t *vals, size_t n)
+{
+    uint64_t end = get_timestamp();
+    for (size_t i = 0; i < n; i++) add_relaxed_get(vals[i], deq_start_timestamp, end);
+}
+#define ENQ_START_TIMESTAMP enq_start_timestamp = get_timestamp()
+#define DEQ_START_TIMESTAMP deq_start_timestamp = get_timestamp()
+#define RELAXED_PUTS(vals, n) add_relaxed_puts(vals, n)
+#define RELAXED_GETS(vals, n) add_relaxed_gets(vals, n)
+#else
+#define ENQ_START_TIMESTAMP
+#define DEQ_START_TIMESTAMP
+#define RELAXED_PUTS(vals, n)
+#define RELAXED_GETS(vals, n)
+#endif
+
+// Contention met by this thread, which re-samples the sticky sub-queue and drives the width controller
+#define PUT_CONTENTION (my_put_cas_fail_count + my_put_retry_count)
+#define GET_CONTENTION (my_get_cas_fail_count + my_get_retry_count)
+
+#ifdef DCBO_NUMA
+// Sub-queues of socket s are [s*width/sockets, (s+1)*width/sockets) of the allocated width, as their pages
+// are bound to the node of the socket once and for all, whatever width is enqueued to later
+static inline uint32_t socket_start(mqueue_t *set, uint32_t socket)
+{
+    return (uint32_t)(((uint64_t) socket * ALLOCATED_WIDTH(set)) / set->sockets);
+}
+
+static inline uint32_t socket_of(mqueue_t *set, uint32_t index)
+{
+    return (uint32_t)((((uint64_t) index + 1) * set->sockets - 1) / ALLOCATED_WIDTH(set));
+}
+
+// A candidate from the part of this socket's partition below the current width, or from all sub-queues if
+// the width has shrunk below the partition
+static inline uint32_t random_local_index(mqueue_t *set)
+{
+    uint32_t width = set->width;
+    uint32_t start = socket_start(set, my_socket);
+    uint32_t end = socket_start(set, my_socket + 1);
+    if (end > width)
+        end = width;
+    if (end <= start)
+        return random_index(set);
+    return start + (my_random(&(seeds[0]), &(seeds[1]), &(seeds[2])) % (end - start));
+}
+
+#define CANDIDATE_INDEX(set) ((set)->numa_flat ? random_index(set) : random_local_index(set))
+#define COUNT_REMOTE(set, index) if (socket_of(set, index) != my_socket) my_remote_count += 1
+#else
+#define CANDIDATE_INDEX(set) random_index(set)
+#define COUNT_REMOTE(set, index)
+#endif
+
+#ifdef EMPTY_SUMMARY
+#define SUMMARY_MARK(set, index) summary_mark((set)->summary, 0, index)
+#define EMPTY_FALLBACK(set, index) DCBO_FN(summary_dequeue)(set)
+#else
+#define SUMMARY_MARK(set, index)
+#define EMPTY_FALLBACK(set, index) DCBO_FN(double_collect)(set, (index) + 1)
+#endif
+
+#ifdef COUNT_MIRROR
+// The mirrors are NULL when d is below MIRROR_MIN_D, then nothing is stored
+#define MIRROR_ENQ(set, index) if ((set)->enq_mirror != NULL) (set)->enq_mirror[index] = (uint32_t) PARTIAL_ENQ_COUNT(QUEUE(set, index))
+#define MIRROR_DEQ(set, index) if ((set)->deq_mirror != NULL) (set)->deq_mirror[index] = (uint32_t) PARTIAL_DEQ_COUNT(QUEUE(set, index))
+#else
+#define MIRROR_ENQ(set, index)
+#define MIRROR_DEQ(set, index)
+#endif
+
+#ifdef DCBO_ELASTIC
+#define SPAN_OF(set) ((set)->span)
+// An enqueue to a sub-queue retired after its width was read makes it reachable for dequeuers again
+#define SPAN_COVER(set, index) if (unlikely((index) >= SPAN_WIDTH((set)->span))) span_raise(&(set)->span, (index) + 1)
+#define DRAIN_RETIRED(set, vals, max) drain_retired(set, vals, max)
+
+// Takes from the highest retired sub-queue while the span is above the width, lowering the span once it is empty
+static inline size_t drain_retired(mqueue_t *set, sval_t *vals, size_t max)
+{
+    uint64_t span = set->span;
+    if (likely(SPAN_WIDTH(span) <= set->width)) return 0;
+
+    uint32_t top = SPAN_WIDTH(span) - 1;
+    uint64_t version = PARTIAL_TAIL_VERSION(QUEUE(set, top));
+    size_t n = BACKEND_DEQUEUE_BATCH(QUEUE(set, top), vals, max, top);
+    MIRROR_DEQ(set, top);
+    if (n > 0)
+    {
+        RELAXED_GETS(vals, n);
+        return n;
+    }
+
+    // Lowered before the re-check, so an enqueue landing meanwhile either sees the lower span or moves the version
+    if (CAS_U64(&set->span, span, SPAN_CHANGE(span, top)) == span && PARTIAL_TAIL_VERSION(QUEUE(set, top)) != version)
+        span_raise(&set->span, top + 1);
+    return 0;
+}
+#else
+#define SPAN_OF(set) ((uint64_t) (set)->width)
+#define SPAN_COVER(set, index)
+#define DRAIN_RETIRED(set, vals, max) 0
+#endif
+
+#ifdef ELASTIC_CONTROLLER
+// Feeds an operation to this thread's controller, a width it asks for is dropped if another thread resized first
+static inline void control_width(mqueue_t *set, int contended)
+{
+    uint32_t width = set->width;
+    uint32_t target = controller_width(&controller, width, MIN_WIDTH(set), set->max_width, contended);
+    if (unlikely(target != width))
+    {
+        span_raise(&set->span, target);
+        CAS_U32(&set->width, width, target);
+    }
+}
+#define CONTROL_WIDTH(set, contended) control_width(set, contended)
+#else
+#define CONTROL_WIDTH(set, contended)
+#endif
+
+
+// A sub-queue at the capacity is passed over when enqueuing, the length read is approximate under concurrency
+#define SUB_QUEUE_FULL(set, index) ((set)->capacity != 0 && PARTIAL_LENGTH(QUEUE(set, index)) >= (set)->capacity)
+// Returned by the enqueue choice when all the sub-queues sampled are full
+#define FULL_INDEX UINT32_MAX
+
+// Samples d sub-queues and returns the index of the best one to enqueue to, or FULL_INDEX
+static inline uint32_t enqueue_choice(mqueue_t *set) {
+    #ifdef LENGTH_HEURISTIC
+    #define ENQ_HEURISTIC(q) PARTIAL_LENGTH(q)
+    #define ENQ_MIRROR_SELECT(set, c) mirror_select_length((set)->enq_mirror, (set)->deq_mirror, c, (set)->d, 0)
+    #else
+    #define ENQ_HEURISTIC(q) PARTIAL_ENQ_COUNT(q)
+    #define ENQ_MIRROR_SELECT(set, c) mirror_select_count((set)->enq_mirror, c, (set)->d)
+    #endif
+
+    if (set->sticky)
+    {
+        if (sticky_enq_left > 0 && sticky_enq_index < set->width && !SUB_QUEUE_FULL(set, sticky_enq_index))
+        {
+            sticky_enq_left--;
+            COUNT_REMOTE(set, sticky_enq_index);
+            return sticky_enq_index;
+        }
+        sticky_enq_left = set->sticky - 1;
+        my_sticky_resample_count += 1;
+    }
+
+    uint32_t opt_index;
+#ifdef COUNT_MIRROR
+    if (set->enq_mirror != NULL)
+    {
+        uint32_t candidates[set->d];
+        candidates[0] = random_index(set);
+        for(int i = 1; i < set->d; i++ )
+        {
+            candidates[i] = CANDIDATE_INDEX(set);
+        }
+        opt_index = candidates[ENQ_MIRROR_SELECT(set, candidates)];
+        if (unlikely(SUB_QUEUE_FULL(set, opt_index)))
+        {
+            // The mirrors only hold counts, so a full choice falls back on the first candidate with room
+            opt_index = FULL_INDEX;
+            for(int i = 0; i < set->d && opt_index == FULL_INDEX; i++ )
+            {
+                if (!SUB_QUEUE_FULL(set, candidates[i])) opt_index = candidates[i];
+            }
+            if (opt_index == FULL_INDEX) return FULL_INDEX;
+        }
+    }
+    else
+#endif
+    {
+        opt_index = random_index(set);
+        uint64_t opt = ENQ_HEURISTIC(QUEUE(set, opt_index));
+        int opt_full = SUB_QUEUE_FULL(set, opt_index);
+        for(int i = 1; i < set->d; i++ )
+        {
+            uint32_t index = CANDIDATE_INDEX(set);
+            uint64_t index_val = ENQ_HEURISTIC(QUEUE(set, index));
+            // Any sub-queue with room beats a full one
+            if((index_val < opt || opt_full) && !SUB_QUEUE_FULL(set, index))
+            {
+                opt_index = index;
+                opt = index_val;
+                opt_full = 0;
+            }
+        }
+        if (unlikely(opt_full)) return FULL_INDEX;
+    }
+
+    COUNT_REMOTE(set, opt_index);
+    sticky_enq_index = opt_index;
+    return opt_index;
+}
+
+int DCBO_FN(enqueue)(mqueue_t *set, skey_t key, sval_t val) {
+    ENQ_START_TIMESTAMP;
+    uint32_t opt_index = enqueue_choice(set);
+    if (unlikely(opt_index == FULL_INDEX)) return QUEUE_FULL;
+    RELAXED_PUTS(&val, 1);
+    unsigned long fails = PUT_CONTENTION;
+    int res = BACKEND_ENQUEUE(QUEUE(set, opt_index), key, val, opt_index);
+    SPAN_COVER(set, opt_index);
+    MIRROR_ENQ(set, opt_index);
+    SUMMARY_MARK(set, opt_index);
+    // Re-sample on the next operation if the sticky sub-queue was contended
+    if (PUT_CONTENTION != fails) sticky_enq_left = 0;
+    CONTROL_WIDTH(set, PUT_CONTENTION != fails);
+    return res;
+}
+
+// Places the whole batch in the sub-queue chosen by a single sampling round
+int DCBO_FN(enqueue_batch)(mqueue_t *set, sval_t *vals, size_t n) {
+    ENQ_START_TIMESTAMP;
+    uint32_t opt_index = enqueue_choice(set);
+    if (unlikely(opt_index == FULL_INDEX)) return QUEUE_FULL;
+    RELAXED_PUTS(vals, n);
+    unsigned long fails = PUT_CONTENTION;
+    int res = BACKEND_ENQUEUE_BATCH(QUEUE(set, opt_index), vals, n, opt_index);
+    SPAN_COVER(set, opt_index);
+    MIRROR_ENQ(set, opt_index);
+    SUMMARY_MARK(set, opt_index);
+    // Re-sample on the next operation if the sticky sub-queue was contended
+    if (PUT_CONTENTION != fails) sticky_enq_left = 0;
+    CONTROL_WIDTH(set, PUT_CONTENTION != fails);
+    return res;
+}
+
+// Samples d sub-queues and returns the index of the best one to dequeue from
+static inline uint32_t dequeue_choice(mqueue_t *set) {
+    #ifdef LENGTH_HEURISTIC
+    #define DEQ_HEURISTIC(q) -PARTIAL_LENGTH(q)
+    #define DEQ_MIRROR_SELECT(set, c) mirror_select_length((set)->enq_mirror, (set)->deq_mirror, c, (set)->d, 1)
+    #else
+    #define DEQ_HEURISTIC(q) PARTIAL_DEQ_COUNT(q)
+    #define DEQ_MIRROR_SELECT(set, c) mirror_select_count((set)->deq_mirror, c, (set)->d)
+    #endif
+
+    if (set->sticky)
+    {
+        if (sticky_deq_left > 0)
+        {
+            sticky_deq_left--;
+            COUNT_REMOTE(set, sticky_deq_index);
+            return sticky_deq_index;
+        }
+        sticky_deq_left = set->sticky - 1;
+        my_sticky_resample_count += 1;
+    }
+
+    uint32_t opt_index;
+#ifdef COUNT_MIRROR
+    if (set->deq_mirror != NULL)
+    {
+        uint32_t candidates[set->d];
+        candidates[0] = random_index(set);
+        for(int i = 1; i < set->d; i++ )
+        {
+            candidates[i] = CANDIDATE_INDEX(set);
+        }
+        opt_index = candidates[DEQ_MIRROR_SELECT(set, candidates)];
+    }
+    else
+#endif
+    {
+        opt_index = random_index(set);
+        int64_t opt = DEQ_HEURISTIC(QUEUE(set, opt_index));
+        for(int i = 1; i < set->d; i++ )
+        {
+            uint32_t index = CANDIDATE_INDEX(set);
+            int64_t index_val = DEQ_HEURISTIC(QUEUE(set, index));
+            if(index_val < opt)
+            {
+                opt_index = index;
+                opt = index_val;
+            }
+        }
+    }
+
+    COUNT_REMOTE(set, opt_index);
+    sticky_deq_index = opt_index;
+    return opt_index;
+}
+
+sval_t DCBO_FN(dequeue)(mqueue_t *set) {
+    DEQ_START_TIMESTAMP;
+    sval_t v;
+    if (DRAIN_RETIRED(set, &v, 1)) return v;
+
+    uint32_t opt_index = dequeue_choice(set);
+    unsigned long fails = GET_CONTENTION;
+    v = BACKEND_DEQUEUE(QUEUE(set, opt_index), opt_index);
+    MIRROR_DEQ(set, opt_index);
+    // Re-sample on the next operation if the sticky sub-queue was contended or empty
+    if (GET_CONTENTION != fails || v == EMPTY) sticky_deq_left = 0;
+    CONTROL_WIDTH(set, GET_CONTENTION != fails);
+    if(v != EMPTY)
+    {
+        RELAXED_GETS(&v, 1);
+        return v;
+    }
+    return EMPTY_FALLBACK(set, opt_index);
+}
+
+// Takes a run of up to max items from the sub-queue chosen by a single sampling round
+size_t DCBO_FN(dequeue_batch)(mqueue_t *set, sval_t *vals, size_t max) {
+    if (max == 0) return 0;
+    DEQ_START_TIMESTAMP;
+    size_t n = DRAIN_RETIRED(set, vals, max);
+    if (n > 0) return n;
+
+    uint32_t opt_index = dequeue_choice(set);
+    unsigned long fails = GET_CONTENTION;
+    n = BACKEND_DEQUEUE_BATCH(QUEUE(set, opt_index), vals, max, opt_index);
+    MIRROR_DEQ(set, opt_index);
+    if (GET_CONTENTION != fails || n == 0) sticky_deq_left = 0;
+    CONTROL_WIDTH(set, GET_CONTENTION != fails);
+    if (n > 0)
+    {
+        RELAXED_GETS(vals, n);
+        return n;
+    }
+
+    // Fall back on the empty check for a single item to stay empty-linearizable
+    vals[0] = EMPTY_FALLBACK(set, opt_index);
+    return vals[0] != EMPTY;
+}
+
+sval_t DCBO_FN(double_collect)(mqueue_t *set, uint32_t start_index){
+    uint32_t index;
+    uint64_t span;
+    uint32_t width;
+
+    start:
+    // Only the sub-queues below the span can hold items
+    span = SPAN_OF(set);
+    width = (uint32_t) span;
+    // Loop through all, collecting their tail versions and then try to dequeue if not empty
+    for(uint32_t i = 0; i<width; i++){
+        index = (start_index + i) % width; // TODO: Optimize away modulo
+
+        double_collect_counts[index] = PARTIAL_TAIL_VERSION(QUEUE(set, index));
+        sval_t v = BACKEND_DEQUEUE(QUEUE(set, index), index);
+        if(v != EMPTY){
+            RELAXED_GETS(&v, 1);
+            return v;
+        }
+    }
+
+    // Return empty if all counts are the same and the queues are still empty, otherwise restart
+    for(uint32_t i = 0; i<width; i++){
+        index = (start_index + i) % width;
+        if (double_collect_counts[index] != PARTIAL_TAIL_VERSION(QUEUE(set, index)))
+        {
+            start_index = index;
+            goto start;
+        }
+    }
+    // A span that moved in between may have uncovered or retired sub-queues during the passes
+    if (SPAN_OF(set) != span) goto start;
+
+    return EMPTY;
+}
+
+#ifdef EMPTY_SUMMARY
+// Walks down the summary to a possibly non-empty sub-queue, clearing the flags of the sub-queues found empty on the way.
+// After SUMMARY_RETRIES walks it falls back to the double-collect, so an empty queue is still detected while
+// a stalled clearer keeps the root from reading 0
+sval_t DCBO_FN(summary_dequeue)(mqueue_t *set){
+    summary_t *s = set->summary;
+
+    for(uint32_t tries = 0; tries < SUMMARY_RETRIES; tries++){
+        uint32_t level = s->levels - 1;
+        uint32_t index = 0;
+        uint64_t word = s->level[level][0].word;
+        // No flags and no clearers in flight, so every sub-queue was empty when the root was read
+        if(word == 0) return EMPTY;
+
+        while((word & SUMMARY_FLAGS) != 0){
+            index = index*SUMMARY_FANOUT + summary_pick(word, my_random(&(seeds[0]), &(seeds[1]), &(seeds[2])));
+            if(level == 0) break;
+            level--;
+            word = s->level[level][index].word;
+        }
+
+        if((word & SUMMARY_FLAGS) == 0){
+            // Stale flag of an empty word, or clearers still in flight at the root
+            if(level < s->levels - 1) summary_clear_up(s, level + 1, index);
+            continue;
+        }
+
+        uint64_t version = PARTIAL_TAIL_VERSION(QUEUE(set, index));
+        sval_t v = BACKEND_DEQUEUE(QUEUE(set, index), index);
+        if(v != EMPTY){
+            RELAXED_GETS(&v, 1);
+            return v;
+        }
+
+        // Any enqueue since the version was read restores the flag
+        summary_clear_begin(s, 0, index);
+        int nonempty = PARTIAL_TAIL_VERSION(QUEUE(set, index)) != version;
+        summary_clear_end(s, 0, index, nonempty);
+        if(!nonempty) summary_clear_up(s, 1, index/SUMMARY_FANOUT);
+    }
+
+    return DCBO_FN(double_collect)(set, 0);
+}
+#endif
+
+#ifdef DCBO_NUMA
+// Allocates each socket's partition of sub-queues on pages of its own, on the node of the socket, and returns the
+// table of the sub-queue addresses
+static PARTIAL_T** alloc_partitioned_queues(mqueue_t *set)
+{
+    PARTIAL_T **queues = ssalloc_aligned(CACHE_LINE_SIZE, ALLOCATED_WIDTH(set)*sizeof(PARTIAL_T*));
+    int nodes = numa_available() < 0 ? 0 : numa_max_node() + 1;
+    for (uint32_t socket = 0; socket < set->sockets; socket++)
+    {
+        uint32_t start = socket_start(set, socket);
+        uint32_t end = socket_start(set, socket + 1);
+        size_t size = (end - start)*sizeof(PARTIAL_T);
+        PARTIAL_T *partition = nodes ? numa_alloc_onnode(size, socket % nodes) : ssalloc_aligned(CACHE_LINE_SIZE, size);
+        if (partition == NULL)
+        {
+            perror("numa_alloc_onnode");
+            exit(1);
+        }
+        for (uint32_t i = start; i < end; i++)
+            queues[i] = &partition[i - start];
+    }
+    return queues;
+}
+
+// Moves this thread's allocators to a page boundary, so that what they allocate next is first touched on
+// pages of its own
+static void allocator_page_break()
+{
+    size_t page = numa_pagesize();
+    ssalloc_aligned(page, 0);
+#if GC == 1
+    uintptr_t next = (uintptr_t) alloc->mem + alloc->mem_curr;
+    if (next % page != 0)
+        ssmem_alloc(alloc, page - next % page);
+#endif
+}
+
+// Initializes the sub-queues of each partition under a preference for its node, so the first node, segment
+// or ring INIT_PARTIAL allocates for them is placed there by the first touch
+static void init_partitioned_queues(mqueue_t *set, int nbr_threads)
+{
+    int nodes = numa_available() < 0 ? 0 : numa_max_node() + 1;
+    for (uint32_t socket = 0; socket < set->sockets; socket++)
+    {
+        if (nodes)
+        {
+            allocator_page_break();
+            numa_set_preferred(socket % nodes);
+        }
+        for (uint32_t i = socket_start(set, socket); i < socket_start(set, socket + 1); i++)
+            INIT_PARTIAL(QUEUE(set, i), nbr_threads);
+    }
+    if (nodes)
+    {
+        allocator_page_break();
+        numa_set_localalloc();
+    }
+}
+#endif
+
+// Allocates and initializes the sub-queues of an already set up mqueue_t
+void DCBO_FN(init_queues)(mqueue_t *set, int nbr_threads)
+{
+	uint32_t i;
+#ifdef DCBO_NUMA
+    set->queues = alloc_partitioned_queues(set);
+    init_partitioned_queues(set, nbr_threads);
+#else
+	set->queues = ssalloc_aligned(CACHE_LINE_SIZE, set->width*sizeof(PARTIAL_T));
+	for(i=0; i < set->width; i++)
+	{
+        INIT_PARTIAL(QUEUE(set, i), nbr_threads);
+	}
+#endif
+#ifdef COUNT_MIRROR
+    set->enq_mirror = NULL;
+    set->deq_mirror = NULL;
+    if (set->d >= MIRROR_MIN_D)
+    {
+        set->enq_mirror = mirror_alloc(set->width);
+        set->deq_mirror = mirror_alloc(set->width);
+    }
+    for(i=0; i < set->width; i++)
+    {
+        MIRROR_ENQ(set, i);
+        MIRROR_DEQ(set, i);
+    }
+#endif
+}
+
+size_t DCBO_FN(queue_size)(mqueue_t *set)
+{
+    uint64_t total = 0;
+    for(int i=0; i<ALLOCATED_WIDTH(set); i++){
+        total+=PARTIAL_LENGTH(QUEUE(set, i));
+    }
+    return total;
+}
+
+#ifdef PARTIAL_DRAIN
+#ifdef PARTIAL_CHAIN_T
+// Sub-queues whose chains are walked together by a drain or snapshot
+#ifndef DRAIN_STREAMS
+#define DRAIN_STREAMS 8
+#endif
+#endif
+
+// Takes every item from the allocated sub-queues with one detach per sub-queue, skipping the d-choice sampling
+// and the empty check, and returns the number of items visited. Items enqueued to a sub-queue after the drain
+// passed it are left, so a queue that is no longer enqueued to is empty after one call.
+size_t DCBO_FN(queue_drain)(mqueue_t *set, visit_fn_t visit, void *arg)
+{
+    size_t total = 0;
+#ifdef PARTIAL_CHAIN_T
+    // The chains of DRAIN_STREAMS sub-queues are walked a node at a time in turn, so the cache misses on their
+    // next nodes overlap, rather than each one waiting for the previous one as in a walk of a single chain
+    PARTIAL_CHAIN_T chains[DRAIN_STREAMS];
+    for(uint32_t base = 0; base < ALLOCATED_WIDTH(set); base += DRAIN_STREAMS){
+        uint32_t streams = ALLOCATED_WIDTH(set) - base < DRAIN_STREAMS ? ALLOCATED_WIDTH(set) - base : DRAIN_STREAMS;
+        size_t longest = 0;
+        for(uint32_t i = 0; i < streams; i++){
+            size_t n = PARTIAL_DETACH(QUEUE(set, base + i), &chains[i]);
+            MIRROR_DEQ(set, base + i);
+            if(n > longest) longest = n;
+            total += n;
+        }
+        for(size_t step = 0; step < longest; step++){
+            for(uint32_t i = 0; i < streams; i++){
+                if(chains[i].left > 0) visit(PARTIAL_CHAIN_TAKE(&chains[i]), arg);
+            }
+        }
+    }
+#else
+    for(uint32_t i = 0; i < ALLOCATED_WIDTH(set); i++){
+        total += PARTIAL_DRAIN(QUEUE(set, i), visit, arg);
+        MIRROR_DEQ(set, i);
+    }
+#endif
+    return total;
+}
+
+// Visits the items of the allocated sub-queues without taking them, and returns the number visited. The
+// sub-queues are read at different times, so under concurrent operations this is an approximate view, which may
+// miss items or see taken ones.
+size_t DCBO_FN(queue_snapshot)(mqueue_t *set, visit_fn_t visit, void *arg)
+{
+    size_t total = 0;
+#ifdef PARTIAL_CHAIN_T
+    // Walked like the chains of a drain
+    PARTIAL_CHAIN_T chains[DRAIN_STREAMS];
+    for(uint32_t base = 0; base < ALLOCATED_WIDTH(set); base += DRAIN_STREAMS){
+        uint32_t streams = ALLOCATED_WIDTH(set) - base < DRAIN_STREAMS ? ALLOCATED_WIDTH(set) - base : DRAIN_STREAMS;
+        size_t longest = 0;
+        for(uint32_t i = 0; i < streams; i++){
+            size_t n = PARTIAL_CHAIN_OPEN(QUEUE(set, base + i), &chains[i]);
+            if(n > longest) longest = n;
+        }
+        for(size_t step = 0; step < longest; step++){
+            for(uint32_t i = 0; i < streams; i++){
+                if(chains[i].left == 0) continue;
+                sval_t v = PARTIAL_CHAIN_PEEK(&chains[i]);
+                if(v == EMPTY) continue;
+                visit(v, arg);
+                total++;
+            }
+        }
+    }
+#else
+    for(uint32_t i = 0; i < ALLOCATED_WIDTH(set); i++){
+        total += PARTIAL_SNAPSHOT(QUEUE(set, i), visit, arg);
+    }
+#endif
+    return total;
+}
+#endif
+
+// Backend specific part of d_balanced_register
+void DCBO_FN(register_thread)(mqueue_t *set, int thread_id)
+{
+    BACKEND_REGISTER(set);
+}
+
+#ifdef BACKEND_THREAD_STATE
+// Lets an embedder move the backend's thread state between its own per thread handles
+void** DCBO_FN(thread_state)(void)
+{
+    return BACKEND_THREAD_STATE;
+}
+#endif
@@ -0,0 +1,138 @@
+#ifndef DCBO_MIRROR_H
+#define DCBO_MIRROR_H
+
+/*
+ * Packed mirror of the d-CBO sub-queue operation counts, 16 sub-queues per cache line instead of
+ * one padded control block each, so sampling d candidates touches far fewer lines. The engine
+ * stores a sub-queue's counts after each operation on it, making the mirror approximately current,
+ * which costs a store to a shared line per operation. It therefore only keeps a mirror for at least
+ * MIRROR_MIN_D candidates, and samples the control blocks directly below that.
+ * Candidates are compared on gathered keys, eight at a time with AVX2 and one at a time otherwise.
+ */
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#ifndef MIRROR_MIN_D
+#define MIRROR_MIN_D 8
+#endif
+
+// Counts are kept modulo 2^32, so they are compared by their distance to the count of the first candidate,
+// which stays exact across wraparound as long as the candidates are within 2^31 operations of each other
+#define MIRROR_COUNT_KEY(c, ref) ((int32_t) ((c) - (ref)))
+
+static inline uint32_t* mirror_alloc(uint32_t width)
+{
+	uint32_t *counts = ssalloc_aligned(CACHE_LINE_SIZE, width * sizeof(uint32_t));
+	for (uint32_t i = 0; i < width; i++)
+	{
+		counts[i] = 0;
+	}
+	return counts;
+}
+
+#ifdef __AVX2__
+// Loads candidates [from, from+8), lanes past n repeat candidate 0 which never changes the minimum
+static inline __m256i mirror_candidates(const uint32_t *idx, uint32_t n, uint32_t from)
+{
+	if (n - from >= 8)
+	{
+		return _mm256_loadu_si256((const __m256i*) &idx[from]);
+	}
+	uint32_t tail[8];
+	for (uint32_t k = 0; k < 8; k++)
+	{
+		tail[k] = from + k < n ? idx[from + k] : idx[0];
+	}
+	return _mm256_loadu_si256((const __m256i*) tail);
+}
+
+// Returns the position of the first smallest key, given in chunks of 8 lanes
+static inline uint32_t mirror_argmin(const __m256i *keys, uint32_t chunks)
+{
+	__m256i best = keys[0];
+	for (uint32_t c = 1; c < chunks; c++)
+	{
+		best = _mm256_min_epi32(best, keys[c]);
+	}
+	__m128i m = _mm_min_epi32(_mm256_castsi256_si128(best), _mm256_extracti128_si256(best, 1));
+	m = _mm_min_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+	m = _mm_min_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+	__m256i min = _mm256_set1_epi32(_mm_cvtsi128_si32(m));
+
+	for (uint32_t c = 0; c < chunks; c++)
+	{
+		int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(keys[c], min)));
+		if (mask)
+		{
+			return c * 8 + __builtin_ctz(mask);
+		}
+	}
+	return 0;
+}
+#endif
+
+// Returns the position among the n candidate indices of the one with the smallest count
+static inline uint32_t mirror_select_count(volatile uint32_t *counts, const uint32_t *idx, uint32_t n)
+{
+#ifdef __AVX2__
+	uint32_t chunks = (n + 7) / 8;
+	__m256i keys[chunks];
+	__m256i ref = _mm256_set1_epi32(counts[idx[0]]);
+	for (uint32_t c = 0; c < chunks; c++)
+	{
+		__m256i counts_c = _mm256_i32gather_epi32((const int*) counts, mirror_candidates(idx, n, c * 8), 4);
+		keys[c] = _mm256_sub_epi32(counts_c, ref);
+	}
+	return mirror_argmin(keys, chunks);
+#else
+	uint32_t pos = 0;
+	uint32_t ref = counts[idx[0]];
+	int32_t best = 0;
+	for (uint32_t i = 1; i < n; i++)
+	{
+		int32_t key = MIRROR_COUNT_KEY(counts[idx[i]], ref);
+		if (key < best)
+		{
+			pos = i;
+			best = key;
+		}
+	}
+	return pos;
+#endif
+}
+
+// Returns the position among the n candidate indices of the shortest sub-queue, or the longest if longest is set.
+// The difference of the two counts modulo 2^32 is the length, whether or not either count has wrapped
+static inline uint32_t mirror_select_length(volatile uint32_t *enq, volatile uint32_t *deq, const uint32_t *idx, uint32_t n, int longest)
+{
+#ifdef __AVX2__
+	uint32_t chunks = (n + 7) / 8;
+	__m256i keys[chunks];
+	for (uint32_t c = 0; c < chunks; c++)
+	{
+		__m256i cand = mirror_candidates(idx, n, c * 8);
+		__m256i len = _mm256_sub_epi32(_mm256_i32gather_epi32((const int*) enq, cand, 4), _mm256_i32gather_epi32((const int*) deq, cand, 4));
+		keys[c] = longest ? _mm256_sub_epi32(_mm256_setzero_si256(), len) : len;
+	}
+	return mirror_argmin(keys, chunks);
+#else
+	uint32_t pos = 0;
+	int32_t best = (int32_t) (enq[idx[0]] - deq[idx[0]]);
+	if (longest) best = -best;
+	for (uint32_t i = 1; i < n; i++)
+	{
+		int32_t key = (int32_t) (enq[idx[i]] - deq[idx[i]]);
+		if (longest) key = -key;
+		if (key < best)
+		{
+			pos = i;
+			best = key;
+		}
+	}
+	return pos;
+#endif
+}
+
+#endif
@@ -0,0 +1,112 @@
+/*
+ * Backend independent state and set up of the d-CBO queues, included by each d-balanced-queue.c
+ * before the engine. It defines the thread local variables the engine reads, and the parts of
+ * create_queue and d_balanced_register that do not depend on the sub-queue type.
+ */
+
+// Internal thread local count for double-collect
+// Don't have in header as it would double-instantiate both here and in the test file
+__thread uint64_t *double_collect_counts;
+__thread ssmem_allocator_t* alloc;
+
+// Sticky sub-queue affinity, the last chosen sub-queue is kept for set->sticky operations or until it is contended
+__thread uint32_t sticky_enq_index;
+__thread uint32_t sticky_enq_left;
+__thread uint32_t sticky_deq_index;
+__thread uint32_t sticky_deq_left;
+__thread unsigned long my_sticky_resample_count;
+// Retries that are not CAS failures, e.g. skipped tickets or fast-path retries, kept out of the CAS fail columns
+__thread unsigned long my_put_retry_count;
+__thread unsigned long my_get_retry_count;
+
+#ifdef DCBO_NUMA
+// Two-level sampling, d-1 candidates come from the partition of this thread's socket and one from the whole set
+__thread uint32_t my_socket;
+__thread unsigned long my_remote_count;
+#endif
+
+#ifdef ELASTIC_CONTROLLER
+__thread elastic_controller_t controller;
+#endif
+
+// Allocates the mqueue_t of n_partial sub-queues, create_queue then has the engine allocate the sub-queues
+static mqueue_t* alloc_queue_set(uint32_t n_partial, uint32_t d, int nbr_threads)
+{
+    mqueue_t *set;
+
+	// Create an allocator for the main thread to more easily allocate the first queue node
+    ssalloc_init();
+	#if GC == 1
+    if (alloc == NULL)
+    {
+		alloc = (ssmem_allocator_t*) malloc(sizeof(ssmem_allocator_t));
+		assert(alloc != NULL);
+		ssmem_alloc_init_fs_size(alloc, SSMEM_DEFAULT_MEM_SIZE, SSMEM_GC_FREE_SET_SIZE, nbr_threads);
+    }
+	#endif
+
+	if ((set = (mqueue_t*) ssalloc_aligned(CACHE_LINE_SIZE, sizeof(mqueue_t))) == NULL)
+    {
+		perror("malloc");
+		exit(1);
+    }
+	set->width = n_partial;
+    set->d = d;
+    set->sticky = 0;
+    set->capacity = 0;
+#ifdef DCBO_ELASTIC
+    set->max_width = n_partial;
+    set->span = n_partial;
+#endif
+#ifdef EMPTY_SUMMARY
+    set->summary = ssalloc_aligned(CACHE_LINE_SIZE, sizeof(summary_t));
+    summary_init(set->summary, n_partial);
+#endif
+#ifdef DCBO_NUMA
+    set->sockets = NUMBER_OF_SOCKETS < n_partial ? NUMBER_OF_SOCKETS : n_partial;
+    set->numa_flat = 0;
+#endif
+    return set;
+}
+
+// Sets up the thread local variables that do not depend on the backend, before the backend's own set up
+static void register_queue_thread(mqueue_t *set, int thread_id)
+{
+    ssalloc_init();
+	#if GC == 1
+    if (alloc == NULL)
+    {
+		alloc = (ssmem_allocator_t*) malloc(sizeof(ssmem_allocator_t));
+		assert(alloc != NULL);
+		ssmem_alloc_init_fs_size(alloc, SSMEM_DEFAULT_MEM_SIZE, SSMEM_GC_FREE_SET_SIZE, thread_id);
+    }
+	#endif
+
+	double_collect_counts = malloc(ALLOCATED_WIDTH(set)*sizeof(uint64_t));
+#ifdef DCBO_NUMA
+    int n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    my_socket = (thread_id < n_cpus ? get_cluster(the_cores[thread_id]) : 0) % set->sockets;
+#endif
+#ifdef RELAXATION_TIMER_ANALYSIS
+	init_relaxation_analysis_local(thread_id);
+#endif
+}
+
+// Bounds the queue to about capacity items, split evenly over the allocated sub-queues, 0 lifts the bound
+void dcbo_set_capacity(mqueue_t *set, size_t capacity)
+{
+    uint32_t width = ALLOCATED_WIDTH(set);
+    set->capacity = (uint32_t) ((capacity + width - 1) / width);
+}
+
+#ifdef DCBO_ELASTIC
+// Changes the number of sub-queues enqueued to and returns the old one, items left in retired sub-queues are drained by later dequeues
+uint32_t dcbo_update_width(mqueue_t *set, uint32_t width)
+{
+    if (width > set->max_width) width = set->max_width;
+    if (width < MIN_WIDTH(set)) width = MIN_WIDTH(set);
+    // Dequeuers have to reach new sub-queues before the first enqueue to them
+    span_raise(&set->span, width);
+    return SWAP_U32(&set->width, width);
+}
+#endif
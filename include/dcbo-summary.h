@@ -0,0 +1,131 @@
+#ifndef DCBO_SUMMARY_H
+#define DCBO_SUMMARY_H
+
+/*
+ * Hierarchical non-emptiness summary over the d-CBO sub-queues, used instead of the
+ * O(width) double-collect when a dequeue finds its sampled sub-queue empty.
+ *
+ * Every level is an array of words with 32 child flags in the low half and a count of
+ * in-flight clearers in the high half. Level 0 flags sub-queues, level l flags words of
+ * level l-1, and the last level is a single root word.
+ *
+ * - An enqueuer sets or verifies its flag on every level after its item is in the sub-queue.
+ * - A clearer registers itself, clears the flag, re-checks the child and restores the flag
+ *   if the child is no longer empty, and only then unregisters.
+ *
+ * So every item whose enqueue has returned is covered by a set flag or a registered clearer
+ * on each level, and a root word reading 0 means the whole queue was empty at that point.
+ */
+
+#define SUMMARY_FANOUT 32
+#define SUMMARY_MAX_LEVELS 7
+#define SUMMARY_FLAGS 0xffffffffULL
+#define SUMMARY_CLEARER (1ULL << 32)
+
+// Walks of a dequeue down the summary before it falls back to the double-collect, as clearers stalled
+// between registering and unregistering keep the root from reading 0 on an empty queue
+#ifndef SUMMARY_RETRIES
+#define SUMMARY_RETRIES 64
+#endif
+
+typedef ALIGNED(CACHE_LINE_SIZE) struct summary_word
+{
+	volatile uint64_t word;
+	uint8_t padding[CACHE_LINE_SIZE - sizeof(uint64_t)];
+} summary_word_t;
+
+typedef struct summary
+{
+	uint32_t levels;
+	summary_word_t *level[SUMMARY_MAX_LEVELS];
+} summary_t;
+
+static inline void summary_init(summary_t *s, uint32_t width)
+{
+	uint32_t n = width;
+	s->levels = 0;
+	do
+	{
+		n = (n + SUMMARY_FANOUT - 1) / SUMMARY_FANOUT;
+		s->level[s->levels] = ssalloc_aligned(CACHE_LINE_SIZE, n * sizeof(summary_word_t));
+		for (uint32_t i = 0; i < n; i++)
+		{
+			s->level[s->levels][i].word = 0;
+		}
+		s->levels++;
+	} while (n > 1);
+}
+
+static inline summary_word_t* summary_parent(summary_t *s, uint32_t level, uint32_t child)
+{
+	return &s->level[level][child / SUMMARY_FANOUT];
+}
+
+static inline uint64_t summary_bit(uint32_t child)
+{
+	return 1ULL << (child % SUMMARY_FANOUT);
+}
+
+// Makes sure the flags of child are set from level upwards, reading only while they already are
+static inline void summary_mark(summary_t *s, uint32_t level, uint32_t child)
+{
+	for (; level < s->levels; level++)
+	{
+		summary_word_t *w = summary_parent(s, level, child);
+		if (!(w->word & summary_bit(child)))
+		{
+			__sync_fetch_and_or(&w->word, summary_bit(child));
+		}
+		child /= SUMMARY_FANOUT;
+	}
+}
+
+// Registers as clearer before clearing, so the word never reads 0 while the child is unchecked
+static inline void summary_clear_begin(summary_t *s, uint32_t level, uint32_t child)
+{
+	summary_word_t *w = summary_parent(s, level, child);
+	FAA_U64(&w->word, SUMMARY_CLEARER);
+	__sync_fetch_and_and(&w->word, ~summary_bit(child));
+}
+
+// Restores the flags if the re-check found the child non-empty, then unregisters
+static inline void summary_clear_end(summary_t *s, uint32_t level, uint32_t child, int nonempty)
+{
+	if (nonempty)
+	{
+		summary_mark(s, level, child);
+	}
+	FAA_U64(&summary_parent(s, level, child)->word, -SUMMARY_CLEARER);
+}
+
+// Clears the flags of all words above level-1 child that have become 0, stopping at the first non-empty one
+static inline void summary_clear_up(summary_t *s, uint32_t level, uint32_t child)
+{
+	for (; level < s->levels; level++)
+	{
+		volatile uint64_t *below = &s->level[level - 1][child].word;
+		if (*below != 0)
+		{
+			return;
+		}
+		summary_clear_begin(s, level, child);
+		int nonempty = *below != 0;
+		summary_clear_end(s, level, child, nonempty);
+		if (nonempty)
+		{
+			return;
+		}
+		child /= SUMMARY_FANOUT;
+	}
+}
+
+// Picks a set flag starting from a random position, to spread dequeuers over the non-empty children
+static inline uint32_t summary_pick(uint64_t word, uint32_t start)
+{
+	uint32_t flags = (uint32_t) (word & SUMMARY_FLAGS);
+	start %= SUMMARY_FANOUT;
+	uint32_t rotated = start ? (flags >> start) | (flags << (SUMMARY_FANOUT - start)) : flags;
+	return (__builtin_ctz(rotated) + start) % SUMMARY_FANOUT;
+}
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef EVENTCOUNT_H
+#define EVENTCOUNT_H
+
+/*
+ * Eventcount for parking consumers of a structure that returns EMPTY instead of blocking.
+ *
+ * A consumer that keeps finding the structure empty announces itself as a waiter, reads
+ * the sequence number, tries the structure once more and only then sleeps on a futex,
+ * unless the sequence number has changed. An enqueuer reads the waiter count after its
+ * item is in place and only bumps the sequence number and wakes a sleeper if it is
+ * non-zero, so enqueues pay a single shared load while nobody sleeps.
+ *
+ * The item is published by a locked instruction on x86, which orders it before the load
+ * of the waiter count, and the waiter count is raised before the consumer's last try. So
+ * either the enqueuer sees the waiter, or the last try runs after the item is in place.
+ * A relaxed dequeue can still return EMPTY while items remain, so parked consumers also
+ * wake up after EVENTCOUNT_PARK_MS to try again.
+ *
+ * Closing wakes every consumer, which then return EMPTY once the structure is drained.
+ */
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Empty tries before a consumer parks
+#ifndef EVENTCOUNT_SPINS
+#define EVENTCOUNT_SPINS 64
+#endif
+
+// Longest sleep before a parked consumer tries the structure again
+#ifndef EVENTCOUNT_PARK_MS
+#define EVENTCOUNT_PARK_MS 10
+#endif
+
+typedef ALIGNED(CACHE_LINE_SIZE) struct eventcount
+{
+	volatile uint32_t seq;		// Futex word, bumped by every wake-up
+	volatile uint32_t waiters;	// Consumers between announcing themselves and waking up
+	volatile uint32_t closed;
+	uint8_t padding[CACHE_LINE_SIZE - 3*sizeof(uint32_t)];
+} eventcount_t;
+
+static inline void eventcount_init(eventcount_t *ec)
+{
+	ec->seq = 0;
+	ec->waiters = 0;
+	ec->closed = 0;
+}
+
+static inline long eventcount_futex(volatile uint32_t *addr, int op, uint32_t val, const struct timespec *timeout)
+{
+	return syscall(SYS_futex, addr, op | FUTEX_PRIVATE_FLAG, val, timeout, NULL, 0);
+}
+
+// Wakes up to n parked consumers, after the items they should find are in place
+static inline void eventcount_notify(eventcount_t *ec, int n)
+{
+	if (likely(ec->waiters == 0))
+		return;
+	FAI_U32(&ec->seq);
+	eventcount_futex(&ec->seq, FUTEX_WAKE, n, NULL);
+}
+
+// Wakes every consumer, which return EMPTY from then on when the structure is empty
+static inline void eventcount_close(eventcount_t *ec)
+{
+	ec->closed = 1;
+	FAI_U32(&ec->seq);
+	eventcount_futex(&ec->seq, FUTEX_WAKE, INT32_MAX, NULL);
+}
+
+static inline int eventcount_closed(eventcount_t *ec)
+{
+	return ec->closed;
+}
+
+// Announces the caller as a waiter and returns the key to wait on, to read before the last try
+static inline uint32_t eventcount_prepare_wait(eventcount_t *ec)
+{
+	FAI_U32(&ec->waiters);
+	return ec->seq;
+}
+
+// Withdraws the announcement, for when the last try found an item
+static inline void eventcount_cancel_wait(eventcount_t *ec)
+{
+	FAD_U32(&ec->waiters);
+}
+
+// Sleeps until notified after the key was read, or until the park timeout
+static inline void eventcount_wait(eventcount_t *ec, uint32_t key)
+{
+	struct timespec timeout = { .tv_sec = 0, .tv_nsec = EVENTCOUNT_PARK_MS * 1000000L };
+	eventcount_futex(&ec->seq, FUTEX_WAIT, key, &timeout);
+	FAD_U32(&ec->waiters);
+}
+
+#if defined(DS_REMOVE) && defined(DS_HANDLE)
+
+// DS_REMOVE which parks while the structure is empty, and only returns EMPTY once it is closed
+static inline sval_t ds_remove_blocking(eventcount_t *ec, DS_HANDLE s)
+{
+	sval_t val;
+	uint32_t tries = 0;
+	while (1)
+	{
+		if ((val = DS_REMOVE(s)) != 0 || eventcount_closed(ec))
+			return val;
+		if (tries++ < EVENTCOUNT_SPINS)
+		{
+			PAUSE;
+			continue;
+		}
+
+		uint32_t key = eventcount_prepare_wait(ec);
+		if ((val = DS_REMOVE(s)) != 0 || eventcount_closed(ec))
+		{
+			eventcount_cancel_wait(ec);
+			return val;
+		}
+		eventcount_wait(ec, key);
+	}
+}
+
+// DS_ADD which wakes a parked consumer, if there is one
+static inline int ds_add_notify(eventcount_t *ec, DS_HANDLE s, skey_t key, sval_t val)
+{
+	int res = DS_ADD(s, key, val);
+	if (res)
+		eventcount_notify(ec, 1);
+	return res;
+}
+
+#endif
+
+#endif // EVENTCOUNT_H
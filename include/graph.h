@@ -19,11 +19,13 @@ typedef struct graph {
   uint64_t n_edges;
   uint64_t *verticies;
   uint64_t *neighbors;
+  uint64_t *weights; // Parallel to neighbors
   uint64_t *distances;
 } graph_t;
 
 // Interface
 static uint64_t get_neighbors(graph_t *g, uint64_t index, uint64_t **neighbors);
+static uint64_t *get_neighbor_weights(graph_t *g, uint64_t index);
 static graph_t *parse_mtx_file(char *fp, bool directed);
 
 static char* create_binary_filename(char *filename) {
@@ -54,7 +56,11 @@ static bool file_exists(char *filename) {
     return (stat(filename, &buffer) == 0);
 }
 
-// Load the binary graph from memory
+// First word of a cache file, the version in its low half is bumped whenever the layout after it changes,
+// version 2 added the weights after the neighbors
+#define GRAPH_CACHE_HEADER ((UINT64_C(0x47525048) << 32) | 2)
+
+// Load the binary graph from memory, or return NULL if the file is not a cache of the current layout
 static graph_t* mmap_graph(char *filename) {
     int fd = open(filename, O_RDONLY);
     if (fd == -1) {
@@ -74,8 +80,18 @@ static graph_t* mmap_graph(char *filename) {
         exit(EXIT_FAILURE);
     }
 
+    uint64_t *words = (uint64_t *)file_memory;
+    size_t n_words = sb.st_size / sizeof(uint64_t);
+    // Header and counts, then verticies, neighbors and weights
+    if (n_words < 3 || words[0] != GRAPH_CACHE_HEADER ||
+        (size_t)sb.st_size != (4 + words[1] + 2*words[2]) * sizeof(uint64_t)) {
+        munmap(file_memory, sb.st_size);
+        close(fd);
+        return NULL;
+    }
+
     graph_t *g = malloc(sizeof(graph_t));
-    char *ptr = (char *)file_memory;
+    char *ptr = (char *)file_memory + sizeof(uint64_t);
 
     // Pointer arithmetic to read out the different fields
     g->n_verticies = *(uint64_t *)ptr;
@@ -87,6 +103,9 @@ static graph_t* mmap_graph(char *filename) {
     ptr += (g->n_verticies+1) * sizeof(uint64_t);
 
     g->neighbors = (uint64_t *)ptr;
+    ptr += g->n_edges * sizeof(uint64_t);
+
+    g->weights = (uint64_t *)ptr;
 
     g->distances = (uint64_t*) malloc(sizeof(uint64_t) * (g->n_verticies + 1));
     for (uint64_t i=1; i<=g->n_verticies; i++) {
@@ -105,10 +124,13 @@ static void serialize_graph(const char *filename, graph_t *g) {
         exit(EXIT_FAILURE);
     }
 
+    uint64_t header = GRAPH_CACHE_HEADER;
+    fwrite(&header, sizeof(uint64_t), 1, file);
     fwrite(&g->n_verticies, sizeof(uint64_t), 1, file);
     fwrite(&g->n_edges, sizeof(uint64_t), 1, file);
     fwrite(g->verticies, sizeof(uint64_t), g->n_verticies + 1, file);
     fwrite(g->neighbors, sizeof(uint64_t), g->n_edges, file);
+    fwrite(g->weights, sizeof(uint64_t), g->n_edges, file);
 
     fclose(file);
 }
@@ -119,8 +141,12 @@ static graph_t* parse_mtx_file(char* fp, bool directed) {
     char *bin_fp = create_binary_filename(fp);
     if (file_exists(bin_fp)) {
         graph_t* g = mmap_graph(bin_fp);
-        free(bin_fp);
-        return g;
+        if (g != NULL) {
+            free(bin_fp);
+            return g;
+        }
+        // Caches of an older layout, e.g. without weights, are rebuilt from the mtx file
+        fprintf(stderr, "Rebuilding outdated graph cache %s\n", bin_fp);
     }
 
     // Just parse it as normally
@@ -136,6 +162,7 @@ static graph_t* parse_mtx_file(char* fp, bool directed) {
     uint64_t *verticies;
     uint64_t *offsets;
     uint64_t *neighbors;
+    uint64_t *weights;
     uint64_t n_verticies;
     uint64_t n_edges;
 
@@ -148,8 +175,9 @@ static graph_t* parse_mtx_file(char* fp, bool directed) {
             if (!directed) n_edges *= 2;
             verticies = (uint64_t*) calloc(n_verticies + 1, sizeof(uint64_t));
             neighbors = (uint64_t*) malloc(sizeof(uint64_t) * n_edges);
+            weights = (uint64_t*) malloc(sizeof(uint64_t) * n_edges);
 
-            if (!verticies || !neighbors) {
+            if (!verticies || !neighbors || !weights) {
                 printf("Error in allocating graph\n");
                 exit(EXIT_FAILURE);
             }
@@ -157,8 +185,6 @@ static graph_t* parse_mtx_file(char* fp, bool directed) {
         else {
             uint64_t vertex;
             uint64_t neighbor;
-            //unused
-            uint64_t weight;
 
             sscanf(line, "%lu %lu", &vertex, &neighbor);
             //Starts with 1
@@ -195,19 +221,27 @@ static graph_t* parse_mtx_file(char* fp, bool directed) {
         else {
             uint64_t vertex;
             uint64_t neighbor;
-            //unused
-            uint64_t weight;
-            sscanf(line, "%lu %lu", &vertex, &neighbor);
+            // Pattern files have no third column, and then every edge weighs one
+            double weight = 1;
+            sscanf(line, "%lu %lu %lf", &vertex, &neighbor, &weight);
 
             assert(neighbor <= n_verticies);
             assert(vertex <= n_verticies);
+            if (weight < 0) {
+                fprintf(stderr, "Negative edge weight %f from %lu to %lu\n", weight, vertex, neighbor);
+                exit(EXIT_FAILURE);
+            }
+            // Distances are integers, so fractional weights are rounded
+            uint64_t int_weight = (uint64_t)(weight + 0.5);
 
             verticies[vertex]--;
             neighbors[verticies[vertex]] = neighbor;
+            weights[verticies[vertex]] = int_weight;
 
             if (!directed) {
                 verticies[neighbor]--;
                 neighbors[verticies[neighbor]] = vertex;
+                weights[verticies[neighbor]] = int_weight;
             }
 
         }
@@ -230,6 +264,7 @@ static graph_t* parse_mtx_file(char* fp, bool directed) {
     g->n_edges = n_edges;
     g->verticies = verticies;
     g->neighbors = neighbors;
+    g->weights = weights;
     g->distances = distances;
 
     serialize_graph(bin_fp, g);
@@ -248,4 +283,70 @@ static uint64_t get_neighbors(graph_t *g, uint64_t index, uint64_t **neighbors)
     else return g->verticies[index + 1] - loc;
 }
 
+// Weights of the edges returned by get_neighbors, in the same order
+static uint64_t *get_neighbor_weights(graph_t *g, uint64_t index) {
+    return &g->weights[g->verticies[index]];
+}
+
+// Sequential Dijkstra from root into distances, the reference the relaxed SSSP runs are checked against
+static void sssp_dijkstra(graph_t *g, uint64_t root, uint64_t *distances) {
+    typedef struct { uint64_t distance; uint64_t vertex; } heap_entry_t;
+
+    // Binary heap with lazy deletion, stale entries are skipped when popped
+    size_t capacity = g->n_verticies + 1;
+    size_t size = 0;
+    heap_entry_t *heap = (heap_entry_t*) malloc(sizeof(heap_entry_t) * capacity);
+    if (heap == NULL) {
+        perror("Failed to allocate the Dijkstra heap");
+        exit(EXIT_FAILURE);
+    }
+
+    for (uint64_t i = 1; i <= g->n_verticies; i++) {
+        distances[i] = UINT64_MAX;
+    }
+    distances[root] = 0;
+    heap[size++] = (heap_entry_t){0, root};
+
+    while (size > 0) {
+        heap_entry_t top = heap[0];
+        heap_entry_t last = heap[--size];
+        size_t pos = 0;
+        while (2*pos + 1 < size) {
+            size_t child = 2*pos + 1;
+            if (child + 1 < size && heap[child + 1].distance < heap[child].distance) child++;
+            if (last.distance <= heap[child].distance) break;
+            heap[pos] = heap[child];
+            pos = child;
+        }
+        if (size > 0) heap[pos] = last;
+
+        if (top.distance > distances[top.vertex]) continue;
+
+        uint64_t *neighbors;
+        uint64_t n = get_neighbors(g, top.vertex, &neighbors);
+        uint64_t *weights = get_neighbor_weights(g, top.vertex);
+        for (uint64_t i = 0; i < n; i++) {
+            uint64_t distance = top.distance + weights[i];
+            if (distance >= distances[neighbors[i]]) continue;
+            distances[neighbors[i]] = distance;
+
+            if (size == capacity) {
+                capacity *= 2;
+                heap = (heap_entry_t*) realloc(heap, sizeof(heap_entry_t) * capacity);
+                if (heap == NULL) {
+                    perror("Failed to grow the Dijkstra heap");
+                    exit(EXIT_FAILURE);
+                }
+            }
+            pos = size++;
+            while (pos > 0 && heap[(pos - 1) / 2].distance > distance) {
+                heap[pos] = heap[(pos - 1) / 2];
+                pos = (pos - 1) / 2;
+            }
+            heap[pos] = (heap_entry_t){distance, neighbors[i]};
+        }
+    }
+    free(heap);
+}
+
 #endif
@@ -0,0 +1,102 @@
+#ifndef HOP_POLICY_H
+#define HOP_POLICY_H
+
+/*
+ * Policies for the hops of the 2D window search, from a sub-structure that can not take the operation
+ * to the next one to try, chosen per structure before the threads register.
+ *
+ * A window only shifts once a search has found every sub-structure outside it, so each policy first
+ * makes a few probes of its own, and then sweeps all sub-structures in an order that visits each one
+ * within a width of hops:
+ *
+ * HOP_DEFAULT       random_hops random probes, then a linear sweep
+ * HOP_RANDOM        a width of random probes, then a linear sweep
+ * HOP_TWO_CHOICES   random_hops probes, each to the better of two random sub-structures by their counts
+ * HOP_LAST_SUCCESS  one probe to where the previous search of the same kind ended after hopping
+ * HOP_STRIDE        a sweep with a per-thread stride coprime with the width, so threads spread apart
+ * HOP_SOCKET_LOCAL  a sweep over the share of the sub-structures of the thread's socket first
+ *
+ * The length of each search, in hops, is counted in a histogram of power of two buckets.
+ */
+
+#define HOP_DEFAULT         0
+#define HOP_RANDOM          1
+#define HOP_TWO_CHOICES     2
+#define HOP_LAST_SUCCESS    3
+#define HOP_STRIDE          4
+#define HOP_SOCKET_LOCAL    5
+#define HOP_POLICIES        6
+
+static const char *hop_policy_names[HOP_POLICIES] = {
+	"default", "random", "two-choices", "last-success", "stride", "socket-local"
+};
+
+// Searches of 0, 1, 2-3, 4-7, ... hops, with the last bucket for all longer ones
+#ifndef HOP_HIST_BUCKETS
+#define HOP_HIST_BUCKETS 10
+#endif
+
+static inline int hop_hist_bucket(uint64_t hops)
+{
+	int bucket = hops == 0 ? 0 : 64 - __builtin_clzl(hops);
+	return bucket < HOP_HIST_BUCKETS ? bucket : HOP_HIST_BUCKETS - 1;
+}
+
+// Smallest lower bound of the bucket, for printing
+static inline uint64_t hop_hist_floor(int bucket)
+{
+	return bucket == 0 ? 0 : 1UL << (bucket - 1);
+}
+
+static inline uint64_t hop_gcd(uint64_t a, uint64_t b)
+{
+	while (b != 0)
+	{
+		uint64_t t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+// Stride of a thread, coprime with the width so that a sweep visits every sub-structure, and spread
+// over the threads so that they do not sweep in step
+static inline uint64_t hop_stride(uint64_t width, int thread_id)
+{
+	if (width < 2)
+	{
+		return 1;
+	}
+	uint64_t stride = 1 + ((uint64_t) thread_id * 2654435761UL) % (width - 1);
+	while (hop_gcd(stride, width) != 1)
+	{
+		stride = stride % (width - 1) + 1;
+	}
+	return stride;
+}
+
+// Next index of a sweep from within [local, local + local_width) of [0, width), which visits the local
+// sub-structures first and then the others, so that it sees each one within a width of hops
+static inline uint64_t hop_local_first(uint64_t index, uint64_t hops, uint64_t width, uint64_t local, uint64_t local_width)
+{
+	if (hops < local_width)
+	{
+		index += 1;
+		return index == local + local_width ? local : index;
+	}
+	if (hops == local_width)
+	{
+		index = local + local_width;
+	}
+	else
+	{
+		index += 1;
+	}
+	if (index >= width)
+	{
+		index -= width;
+	}
+	return index;
+}
+
+#endif // HOP_POLICY_H
@@ -488,6 +488,78 @@
 			}
 	#endif	/* WORKLOAD */
 
+	/* Batched variant of TEST_LOOP_ONLY_UPDATES, each coin flip moves batch_size items */
+	#define TEST_LOOP_BATCH_UPDATES()														\
+		c = (uint32_t)(my_random(&(seeds[0]),&(seeds[1]),&(seeds[2])));						\
+		if (unlikely(c < scale_put))														\
+		{																			\
+			size_t b;																\
+			for (b = 0; b < batch_size; b++)												\
+				batch_vals[b] = (num_elems_thread + my_putting_count + b + 1) << 8 | thread_id;	\
+			int res;																	\
+			START_TS(1);															\
+			res = DS_ADD_BATCH(handle, batch_vals, batch_size);							\
+			if(res)																	\
+			{																	\
+				END_TS(1, my_putting_count_succ);											\
+				ADD_DUR(my_putting_succ);												\
+				my_putting_count_succ += batch_size;										\
+			}																	\
+			END_TS_ELSE(4, my_putting_count - my_putting_count_succ, my_putting_fail);		\
+			my_putting_count += batch_size;												\
+		}																		\
+		else if(unlikely(c <= scale_rem))													\
+		{																		\
+			size_t removed;															\
+			START_TS(2);															\
+			removed = DS_REMOVE_BATCH(handle, batch_vals, batch_size);						\
+			if(removed != 0)														\
+			{																	\
+				END_TS(2, my_removing_count_succ);											\
+				ADD_DUR(my_removing_succ);												\
+				my_removing_count_succ += removed;										\
+			}																	\
+			END_TS_ELSE(5, my_removing_count - my_removing_count_succ, my_removing_fail);	\
+			my_removing_count += removed ? removed : 1;									\
+		}																		\
+		if(side_work>0)															\
+			cpause(my_random(&(seeds[0]), &(seeds[1]), &(seeds[2])) % (side_work));			\
+
+	/* Priority queue variant of TEST_LOOP_ONLY_UPDATES, inserting random keys with unique values */
+	#define PQ_LOOP_ONLY_UPDATES()															\
+		c = (uint32_t)(my_random(&(seeds[0]),&(seeds[1]),&(seeds[2])));						\
+		if (unlikely(c < scale_put))														\
+		{																			\
+			key = (my_random(&(seeds[0]), &(seeds[1]), &(seeds[2])) % (rand_max + 1)) + rand_min;	\
+			int res;																	\
+			START_TS(1);															\
+			res = DS_ADD(handle, key, (num_elems_thread + my_putting_count + 1) << 8 | thread_id);	\
+			if(res)																	\
+			{																	\
+				END_TS(1, my_putting_count_succ);											\
+				ADD_DUR(my_putting_succ);												\
+				my_putting_count_succ++;												\
+			}																	\
+			END_TS_ELSE(4, my_putting_count - my_putting_count_succ, my_putting_fail);		\
+			my_putting_count++;															\
+		}																		\
+		else if(unlikely(c <= scale_rem))													\
+		{																		\
+			sval_t removed;															\
+			START_TS(2);															\
+			removed = DS_REMOVE(handle);												\
+			if(removed != 0)														\
+			{																	\
+				END_TS(2, my_removing_count_succ);											\
+				ADD_DUR(my_removing_succ);												\
+				my_removing_count_succ++;												\
+			}																	\
+			END_TS_ELSE(5, my_removing_count - my_removing_count_succ, my_removing_fail);	\
+			my_removing_count++;														\
+		}																		\
+		if(side_work>0)															\
+			cpause(my_random(&(seeds[0]), &(seeds[1]), &(seeds[2])) % (side_work));			\
+
 	#define POW_CORRECTED 0
 	// double pow_tot_correction = (throughput * eng_per_test_iter_nj[num_threads-1][0]) / 1e9;
 	//  printf("#Duration: %f, %f, %f\n", s.duration[0], s.duration[1], s.duration[2]);
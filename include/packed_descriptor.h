@@ -0,0 +1,73 @@
+#ifndef PACKED_DESCRIPTOR_H
+#define PACKED_DESCRIPTOR_H
+
+#include <assert.h>
+#include <stdint.h>
+#include "atomic_ops_if.h"
+
+/*
+ * A descriptor of a 2D sub-structure, a node pointer and a 64-bit count, packed into one word for
+ * PACKED_DESCRIPTORS builds, so that it is updated with an 8-byte CAS rather than a 16-byte CAE. The
+ * pointer takes the low 48 bits, which hold all user space addresses on x86-64 and AArch64, and the
+ * low 16 bits of the count take the rest.
+ *
+ * The count is widened back to 64 bits against the max of a window, which fixes its high bits for as
+ * long as the window is current. The counts of the sub-structures stay within a few depths of the
+ * windows, so a count read while its window is current is the one closest to the window max with the
+ * same low bits. The searches check the window after reading a descriptor anyway, and only use counts
+ * read under the window they compare them with, while other reads take the window max before and after
+ * the descriptor until the two agree. As with the 16-bit window version, this only goes wrong for a
+ * thread stalled while the windows move 2^15 rows.
+ *
+ * The elastic variants leave sub-structures behind, outside the windows, when they narrow, and take
+ * them back in later wherever the windows have moved to. Their indexes keep a reference count beside
+ * the word, in the same cache line, and widen against that instead. It only follows the count once the
+ * count is PACKED_REFERENCE_SLACK away from it, so most swaps are still a single CAS.
+ *
+ * A CAS compares the whole word, and ssmem does not reuse a node an operation has read before the
+ * operation is done, so the 16 count bits make the CAS no more prone to ABA than the full count does.
+ */
+
+typedef uint64_t packed_descriptor_t;
+
+#define PACKED_POINTER_BITS     48
+#define PACKED_POINTER_MASK     ((1UL << PACKED_POINTER_BITS) - 1)
+
+// Distance from the window max within which a count is widened correctly
+#define PACKED_COUNT_REACH      (1UL << 15)
+
+static inline packed_descriptor_t pack_descriptor(void* node, uint64_t count)
+{
+	assert(((uintptr_t) node & ~PACKED_POINTER_MASK) == 0);
+	return (uintptr_t) node | (count << PACKED_POINTER_BITS);
+}
+
+static inline void* packed_node(packed_descriptor_t word)
+{
+	return (void*) (uintptr_t) (word & PACKED_POINTER_MASK);
+}
+
+// The count closest to reference with the low bits of the count of word
+static inline uint64_t packed_count(packed_descriptor_t word, uint64_t reference)
+{
+	int16_t offset = (int16_t) ((uint16_t) (word >> PACKED_POINTER_BITS) - (uint16_t) reference);
+	return reference + offset;
+}
+
+// Distance a count moves from the reference count of its index before the reference follows it
+#define PACKED_REFERENCE_SLACK  (PACKED_COUNT_REACH >> 2)
+
+// Moves the reference at reference_loc to count, just swapped into word_loc as word, once they are far
+// enough apart. A writer that stalled after its swap finds its word gone, rather than moving the
+// reference back to a count long passed.
+static inline void follow_packed_count(volatile packed_descriptor_t* word_loc, volatile uint64_t* reference_loc, packed_descriptor_t word, uint64_t count)
+{
+	uint64_t reference = *reference_loc;
+	uint64_t distance = count > reference ? count - reference : reference - count;
+	if (distance >= PACKED_REFERENCE_SLACK && *word_loc == word)
+	{
+		CAS(reference_loc, reference, count);
+	}
+}
+
+#endif // PACKED_DESCRIPTOR_H
@@ -0,0 +1,52 @@
+#ifndef PAYLOAD_H
+#define PAYLOAD_H
+
+/*
+ * Fixed-size items of PAYLOAD_BYTES, for the structures built with PAYLOAD=<bytes>.
+ *
+ * With PAYLOAD_INLINE the payload is copied into the queue node or cell, and the dequeue
+ * copies it out again and returns whether it found an item. Emptiness is then never
+ * encoded in the item, so every payload value, including all zeroes, can be stored.
+ * With PAYLOAD_POINTER the structure is unchanged and the benchmark passes pointers to
+ * payloads it allocates, as callers do with the plain sval_t interface.
+ */
+
+#ifndef PAYLOAD_BYTES
+#define PAYLOAD_BYTES 8
+#endif
+
+#if PAYLOAD_BYTES <= 0 || PAYLOAD_BYTES % 8 != 0
+#error "PAYLOAD_BYTES must be a positive multiple of 8"
+#endif
+
+#if defined(PAYLOAD_INLINE) && (defined(RELAXATION_ANALYSIS) || defined(RELAXATION_TIMER_ANALYSIS) || defined(RELAXATION_LINEARIZATION_TIMESTAMP))
+#error "The relaxation analysis tracks sval_t items, and can not be combined with inline payloads"
+#endif
+
+#define PAYLOAD_WORDS (PAYLOAD_BYTES / 8)
+
+// Padding that rounds a node of the given size up to whole cache lines
+#define PAYLOAD_NODE_PADDING(bytes) ((CACHE_LINE_SIZE - (bytes) % CACHE_LINE_SIZE) % CACHE_LINE_SIZE)
+
+typedef struct payload
+{
+	uint64_t words[PAYLOAD_WORDS];
+} payload_t;
+
+// Fills the payload of item seq, where word i holds seq + i
+static inline void payload_fill(payload_t *p, uint64_t seq)
+{
+	for (int i = 0; i < PAYLOAD_WORDS; i++)
+		p->words[i] = seq + i;
+}
+
+// Reads every word, and returns 0 if the payload is torn between two items
+static inline int payload_check(const payload_t *p)
+{
+	int ok = 1;
+	for (int i = 1; i < PAYLOAD_WORDS; i++)
+		ok &= p->words[i] == p->words[0] + i;
+	return ok;
+}
+
+#endif // PAYLOAD_H
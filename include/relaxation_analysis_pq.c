@@ -0,0 +1,255 @@
+#include "relaxation_analysis_pq.h"
+
+// Thread local arrays for storing records
+__thread relax_stamp_t *thread_put_stamps;
+__thread size_t *thread_put_stamps_ind;
+__thread relax_stamp_t *thread_get_stamps;
+__thread size_t *thread_get_stamps_ind;
+
+// Shared array of all threads records
+relax_stamp_t **shared_put_stamps;
+relax_stamp_t **shared_get_stamps;
+size_t **shared_put_stamps_ind; // Array of pointers, to make it more thread local without dropping too early
+size_t **shared_get_stamps_ind; // Array of pointers, to make it more thread local without dropping too early
+
+// Get a timestamp from the realtime clock, shared accross processors
+uint64_t get_timestamp()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts); // Get the current time
+    // Integer arithmetic, as a double rounds the current time to 256ns and would tie operations in a row
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Add an insert of a key with its timestamp
+void add_relaxed_put(skey_t key, uint64_t timestamp)
+{
+    relax_stamp_t stamp;
+    stamp.timestamp = timestamp;
+    stamp.key = key;
+    thread_put_stamps[*thread_put_stamps_ind] = stamp;
+    *thread_put_stamps_ind += 1;
+    if (*thread_put_stamps_ind > MAX_RELAX_COUNTS)
+    {
+        perror("Out of bounds on relaxation stamps\n");
+        exit(1);
+    }
+}
+
+// Add a delete-min of a key with its timestamp
+void add_relaxed_get(skey_t key, uint64_t timestamp)
+{
+    relax_stamp_t stamp;
+    stamp.timestamp = timestamp;
+    stamp.key = key;
+    thread_get_stamps[*thread_get_stamps_ind] = stamp;
+    *thread_get_stamps_ind += 1;
+    if (*thread_get_stamps_ind > MAX_RELAX_COUNTS)
+    {
+        perror("Out of bounds on relaxation stamps\n");
+        exit(1);
+    }
+}
+
+// Init the relaxation analysis, global variables before the thread local one
+void init_relaxation_analysis_shared(int nbr_threads)
+{
+    shared_put_stamps = (relax_stamp_t **)calloc(nbr_threads, sizeof(relax_stamp_t **));
+    shared_get_stamps = (relax_stamp_t **)calloc(nbr_threads, sizeof(relax_stamp_t **));
+    shared_put_stamps_ind = (size_t **)calloc(nbr_threads, sizeof(size_t **));
+    shared_get_stamps_ind = (size_t **)calloc(nbr_threads, sizeof(size_t **));
+}
+
+// Init the relaxation analysis, thread local variables
+void init_relaxation_analysis_local(int thread_id)
+{
+    thread_put_stamps_ind = (size_t *)calloc(1, sizeof(size_t));
+    thread_get_stamps_ind = (size_t *)calloc(1, sizeof(size_t));
+    thread_put_stamps = (relax_stamp_t *)calloc(MAX_RELAX_COUNTS, sizeof(relax_stamp_t));
+    thread_get_stamps = (relax_stamp_t *)calloc(MAX_RELAX_COUNTS, sizeof(relax_stamp_t));
+
+    if (thread_put_stamps == NULL || thread_get_stamps == NULL)
+    {
+        perror("Could not allocated thread local relaxation timestamp slots");
+        exit(1);
+    }
+    shared_put_stamps[thread_id] = thread_put_stamps;
+    shared_get_stamps[thread_id] = thread_get_stamps;
+    shared_put_stamps_ind[thread_id] = thread_put_stamps_ind;
+    shared_get_stamps_ind[thread_id] = thread_get_stamps_ind;
+}
+
+// de-init all memory for all threads
+void destoy_relaxation_analysis_all(int nbr_threads)
+{
+    for (int thread = 0; thread < nbr_threads; thread += 1)
+    {
+        free(shared_get_stamps[thread]);
+        free(shared_put_stamps[thread]);
+        free(shared_get_stamps_ind[thread]);
+        free(shared_put_stamps_ind[thread]);
+    }
+    free(shared_put_stamps);
+    free(shared_get_stamps);
+    free(shared_put_stamps_ind);
+    free(shared_get_stamps_ind);
+}
+
+// An insert or delete-min in the replayed history
+typedef struct pq_event
+{
+    uint64_t timestamp;
+    skey_t key;
+    int is_get;
+} pq_event_t;
+
+// Orders by time, with inserts before delete-mins taken at the same time
+int compare_pq_events(const void *a, const void *b)
+{
+    const pq_event_t *event1 = (const pq_event_t *)a;
+    const pq_event_t *event2 = (const pq_event_t *)b;
+    if (event1->timestamp != event2->timestamp)
+        return event1->timestamp < event2->timestamp ? -1 : 1;
+    return event1->is_get - event2->is_get;
+}
+
+int compare_keys(const void *a, const void *b)
+{
+    skey_t key1 = *(const skey_t *)a;
+    skey_t key2 = *(const skey_t *)b;
+    if (key1 < key2)
+        return -1;
+    if (key1 > key2)
+        return 1;
+    return 0;
+}
+
+// Position of a key among the sorted distinct keys
+static size_t key_rank(skey_t *keys, size_t n_keys, skey_t key)
+{
+    size_t low = 0, high = n_keys;
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+        if (keys[mid] < key)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+// Fenwick tree over the key ranks, counting the items present with each key
+static void present_add(int64_t *tree, size_t n_keys, size_t rank, int64_t delta)
+{
+    for (size_t i = rank + 1; i <= n_keys; i += i & -i)
+        tree[i] += delta;
+}
+
+// Items present with a rank below the given one
+static int64_t present_below(int64_t *tree, size_t rank)
+{
+    int64_t sum = 0;
+    for (size_t i = rank; i > 0; i -= i & -i)
+        sum += tree[i];
+    return sum;
+}
+
+// Print the stats from the relaxation measurement. Also destroys all memory
+void print_relaxation_measurements(int nbr_threads)
+{
+    size_t tot_put = 0, tot_get = 0;
+    for (int thread = 0; thread < nbr_threads; thread += 1)
+    {
+        tot_put += *shared_put_stamps_ind[thread];
+        tot_get += *shared_get_stamps_ind[thread];
+    }
+
+    pq_event_t *events = (pq_event_t *)calloc(tot_put + tot_get, sizeof(pq_event_t));
+    skey_t *keys = (skey_t *)calloc(tot_put + 1, sizeof(skey_t));
+    if (events == NULL || keys == NULL)
+    {
+        fprintf(stderr, "Memory allocation failed for combining relaxation errors\n");
+        exit(1);
+    }
+
+    // Combine all threads records into one history, and the inserted keys into one list
+    size_t n_events = 0;
+    for (int thread = 0; thread < nbr_threads; thread++)
+    {
+        for (size_t i = 0; i < *shared_put_stamps_ind[thread]; i++)
+        {
+            keys[n_events] = shared_put_stamps[thread][i].key;
+            events[n_events++] = (pq_event_t){shared_put_stamps[thread][i].timestamp, shared_put_stamps[thread][i].key, 0};
+        }
+    }
+    for (int thread = 0; thread < nbr_threads; thread++)
+    {
+        for (size_t i = 0; i < *shared_get_stamps_ind[thread]; i++)
+        {
+            events[n_events++] = (pq_event_t){shared_get_stamps[thread][i].timestamp, shared_get_stamps[thread][i].key, 1};
+        }
+    }
+    qsort(events, n_events, sizeof(pq_event_t), compare_pq_events);
+
+    // Compress the keys to their ranks among the distinct inserted keys
+    qsort(keys, tot_put, sizeof(skey_t), compare_keys);
+    size_t n_keys = 0;
+    for (size_t i = 0; i < tot_put; i++)
+    {
+        if (n_keys == 0 || keys[n_keys - 1] != keys[i])
+            keys[n_keys++] = keys[i];
+    }
+    int64_t *present = (int64_t *)calloc(n_keys + 1, sizeof(int64_t));
+
+    uint64_t rank_error_sum = 0;
+    uint64_t rank_error_max = 0;
+    uint64_t *rank_errors = (uint64_t *)calloc(tot_get + 1, sizeof(uint64_t));
+    size_t deq_ind = 0;
+
+    // Replay the history, each delete-min counting the present items it should have preceded
+    for (size_t i = 0; i < n_events; i++)
+    {
+        size_t rank = key_rank(keys, n_keys, events[i].key);
+        if (!events[i].is_get)
+        {
+            present_add(present, n_keys, rank, 1);
+            continue;
+        }
+
+        // Clock skew between cores can order a delete-min before its insert, never count below zero
+        int64_t below = present_below(present, rank);
+        uint64_t rank_error = below > 0 ? (uint64_t)below : 0;
+        present_add(present, n_keys, rank, -1);
+
+        rank_errors[deq_ind++] = rank_error;
+        rank_error_sum += rank_error;
+        if (rank_error > rank_error_max)
+            rank_error_max = rank_error;
+    }
+
+    long double rank_error_mean = (long double)rank_error_sum / (long double)tot_get;
+    if (tot_get == 0)
+        rank_error_mean = 0.0;
+    printf("mean_relaxation , %.4Lf\n", rank_error_mean);
+    printf("max_relaxation , %zu\n", rank_error_max);
+
+    // Find variance
+    long double rank_error_variance = 0;
+    for (deq_ind = 0; deq_ind < tot_get; deq_ind += 1)
+    {
+        long double off = (long double)rank_errors[deq_ind] - rank_error_mean;
+        rank_error_variance += off * off;
+    }
+    if (tot_get > 1)
+        rank_error_variance /= tot_get - 1;
+
+    printf("variance_relaxation , %.4Lf\n", rank_error_variance);
+
+    // Free everything used, as well as all earlier used relaxation analysis things
+    free(rank_errors);
+    free(present);
+    free(keys);
+    free(events);
+    destoy_relaxation_analysis_all(nbr_threads);
+}
@@ -0,0 +1,51 @@
+#ifndef RELAXATION_ANALYSIS_PQ_H
+#define RELAXATION_ANALYSIS_PQ_H
+
+#include "common.h"
+#include <stdint.h>
+#include <time.h>
+#include <sys/time.h>
+
+/*
+ * Rank error of a relaxed priority queue, measured with timestamps in the same way as
+ * relaxation_analysis_timestamps.h does for FIFO queues. Every insert and delete-min records the
+ * key it moved and the time it did so, and after the run the operations are replayed in timestamp
+ * order. The rank error of a delete-min is the number of items with a strictly smaller key present
+ * at that time, so a strict priority queue always has zero.
+ */
+
+// How many operations we can track per thread
+// This should be set experimentally, but we probably can't handle too large values
+#define MAX_RELAX_COUNTS 1e8
+
+// The record for a single operation
+typedef struct relax_stamp
+{
+    uint64_t timestamp;
+    skey_t key;
+} relax_stamp_t;
+
+// Shared functions
+
+// Get a timestamp from the realtime clock, shared accross processors
+uint64_t get_timestamp();
+
+// Add an insert of a key with its timestamp
+void add_relaxed_put(skey_t key, uint64_t timestamp);
+
+// Add a delete-min of a key with its timestamp
+void add_relaxed_get(skey_t key, uint64_t timestamp);
+
+// Init the relaxation analysis, global variables before the thread local one
+void init_relaxation_analysis_shared(int nbr_threads);
+
+// Init the relaxation analysis, thread local variables
+void init_relaxation_analysis_local(int thread_id);
+
+// de-init all memory for all threads
+void destoy_relaxation_analysis_all(int nbr_threads);
+
+// Print the stats from the relaxation measurement
+void print_relaxation_measurements(int nbr_threads);
+
+#endif
@@ -13,6 +13,7 @@
 	#include <sched.h>
 	#include <inttypes.h>
 	#include <sys/time.h>
+	#include <sys/resource.h>
 	#include <unistd.h>
 	#ifdef __sparc__
 		#include <sys/types.h>
@@ -881,6 +882,14 @@
 			return (double)t.tv_sec + ((double)t.tv_usec)/1000000.0;
 		}
 
+		// Peak resident set size of the process, in MB
+		static inline double max_rss_mb(void)
+		{
+			struct rusage usage;
+			getrusage(RUSAGE_SELF, &usage);
+			return usage.ru_maxrss / 1024.0;
+		}
+
 		static inline
 		void set_cpu(int cpu)
 		{
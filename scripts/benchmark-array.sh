@@ -0,0 +1,17 @@
+#!/bin/sh
+
+# Throughput of the optimized 2D stack with array sub-stacks (ARRAY=1) against node sub-stacks, over the depth and number of threads
+threads="1 2 4 8 16 32 64"  # Set to the thread counts of your machine
+duration=2000
+width=128
+initial=1048576
+
+make 2Dc-stack_optimized 2Dc-stack_optimized-array
+for depth in 4 16 64; do
+    for bin in 2Dc-stack_optimized 2Dc-stack_optimized-array; do
+        for n in $threads; do
+            echo "$bin depth=$depth threads=$n"
+            ./bin/$bin -n $n -w $width -l $depth -i $initial -d $duration | grep -E "^Mops"
+        done
+    done
+done
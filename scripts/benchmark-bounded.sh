@@ -0,0 +1,9 @@
+#!/bin/sh
+
+# Producer-consumer throughput and peak memory of the bounded queues over their capacity (-C), from 2^16 to 2^24
+nbr_threads=64              # Set to the number of threads you want to use
+duration=1000
+runs=5
+
+python3 scripts/benchmark.py --allow_null --initial 65536 --runs $runs --width 128 -n $nbr_threads -p 75 -v C --start 65536 --to 16777216 --exp_steps -d $duration --test_timeout 600 --ndebug --prod-con dcbo-ms 2Dd-queue_optimized faaaq --title "Producer-Consumer"    --name bounded-capacity-mops
+python3 scripts/benchmark.py --allow_null --initial 65536 --runs $runs --width 128 -n $nbr_threads -p 75 -v C --start 65536 --to 16777216 --exp_steps -d $duration --test_timeout 600 --ndebug --prod-con dcbo-ms 2Dd-queue_optimized faaaq --title "Peak Memory" --track Max_RSS_MB --name bounded-capacity-rss
@@ -0,0 +1,15 @@
+#!/bin/sh
+
+# Time to empty a filled queue with one bulk drain (-m 1) against repeated dequeues (-m 0), and a snapshot of it
+nbr_threads=64              # Set to the number of threads filling the queue
+items=100000000
+
+for struct in dcbo-ms dcbo-faaaq 2Dd-queue_optimized; do
+    TEST=DRAIN make $struct
+    for mode in 1 0; do
+        echo "$struct mode=$mode"
+        ./bin/$struct -n $nbr_threads -w 128 -i $items -m $mode | grep -E "Snapshot|Drain|Lost|Checksum"
+    done
+    # Restore the throughput benchmark
+    make $struct
+done
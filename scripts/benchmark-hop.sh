@@ -0,0 +1,17 @@
+#!/bin/sh
+
+# Throughput and hops per window search of each hop policy (-H 0 to 5), over the number of threads
+threads="1 2 4 8 16 32 64"  # Set to the thread counts of your machine
+duration=2000
+width=128
+depth=16
+
+for struct in 2Dd-queue_optimized 2Dc-stack_optimized; do
+    make $struct
+    for policy in 0 1 2 3 4 5; do
+        for n in $threads; do
+            echo "$struct policy=$policy threads=$n"
+            ./bin/$struct -n $n -w $width -l $depth -d $duration -H $policy | grep -E "^Mops|Mean_Hops|Hop_Histogram"
+        done
+    done
+done
@@ -0,0 +1,17 @@
+#!/bin/sh
+
+# Consumer CPU time and wake-up latency with bursts separated by idle periods, spinning (-B 0) against parking (-B 1)
+nbr_threads=64              # Set to the number of consumer threads you want to use
+duration=5000
+idle_us=10000
+burst=256
+
+for struct in dcbo-ms 2Dd-queue_optimized; do
+    TEST=IDLE make $struct
+    for blocking in 0 1; do
+        echo "$struct blocking=$blocking"
+        ./bin/$struct -n $nbr_threads -w 128 -d $duration -i $idle_us -b $burst -B $blocking | grep -E "Consumed|Wake_Latency|CPU"
+    done
+    # Restore the throughput benchmark
+    make $struct
+done
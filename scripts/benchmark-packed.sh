@@ -0,0 +1,17 @@
+#!/bin/sh
+
+# Throughput with descriptors packed into one word (PACKED=1) against the 16-byte ones, over the number of threads
+threads="1 2 4 8 16 32 64"  # Set to the thread counts of your machine
+duration=2000
+width=128
+depth=16
+
+for struct in 2Dc-stack_optimized 2Dd-queue_optimized 2Dc-stack_elastic-lpw 2Dd-queue_elastic-lpw 2Dd-queue_elastic-law; do
+    make $struct $struct-packed
+    for bin in $struct $struct-packed; do
+        for n in $threads; do
+            echo "$bin threads=$n"
+            ./bin/$bin -n $n -w $width -l $depth -d $duration | grep -E "^Mops"
+        done
+    done
+done
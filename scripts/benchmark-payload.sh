@@ -0,0 +1,19 @@
+#!/bin/sh
+
+# Throughput of random enqueues and dequeues, including the read of every dequeued payload, for payloads stored
+# inline in the queues against payloads passed as pointers, from 8 to 64 bytes
+nbr_threads=64              # Set to the number of threads you want to use
+duration=1000
+
+for struct in ms faaaq 2Dd-queue_optimized; do
+    args="-n $nbr_threads -d $duration"
+    if [ $struct = 2Dd-queue_optimized ]; then
+        args="$args -w 128"
+    fi
+    for payload in 8 16 32 64; do
+        make $struct PAYLOAD=$payload
+        make $struct PAYLOAD=$payload PAYLOAD_PTR=1
+        echo "$struct payload=$payload inline: $(./bin/$struct-payload$payload     $args | grep Mops)"
+        echo "$struct payload=$payload pointer: $(./bin/$struct-payload$payload-ptr $args | grep Mops)"
+    done
+done
@@ -0,0 +1,9 @@
+#!/bin/sh
+
+# Throughput of the FAAArrayQueue and its d-CBO over the items per segment (-R), from 64 to 4096
+nbr_threads=64              # Set to the number of threads you want to use
+duration=500
+runs=5
+
+python3 scripts/benchmark.py --allow_null --initial 1048576 --runs $runs --width 128 -n $nbr_threads -v R --start 64 --to 4096 --exp_steps -d $duration --test_timeout 600 --ndebug --prod-con faaaq dcbo-faaaq --title "Producer-Consumer"      --name faaaq-segment-size-prod-con
+python3 scripts/benchmark.py --allow_null --initial 1048576 --runs $runs --width 128 -n $nbr_threads -v R --start 64 --to 4096 --exp_steps -d $duration --test_timeout 600 --ndebug            faaaq dcbo-faaaq --title "Random Enqueue/Dequeue" --name faaaq-segment-size-enq-deq
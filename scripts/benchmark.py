@@ -41,6 +41,8 @@ COLOR_LIST = [
 RENAME_MAP = {
     # Queues
     '2Dd-queue_optimized': '2D Static',
+    '2Dd-queue_optimized-unrolled': '2D Static Unrolled',
+    '2Dd-queue_faa': '2D Static FAA',
     '2Dd-queue_elastic-law': '2D Elastic LaW',
     '2Dd-queue_elastic-lpw': '2D Elastic LpW',
     'queue-wf': 'WFQ',
@@ -52,10 +54,12 @@ RENAME_MAP = {
     'dcbo-lcrq': 'LCRQ d-CBO',
     'dcbo-wfqueue': 'WFQ d-CBO',
     'dcbo-ms': 'MS d-CBO',
+    'dcbo-ums': 'Unrolled MS d-CBO',
     'dcbl-faaaq': 'FAAArrayQueue d-CBL',
     'dcbl-lcrq': 'LCRQ d-CBL',
     'dcbl-wfqueue': 'WFQ d-CBL',
     'dcbl-ms': 'MS d-CBL',
+    'dcbl-ums': 'Unrolled MS d-CBL',
     'simple-dcbo-faaaq': 'FAAArrayQueue Simple d-CBO',
     'simple-dcbo-lcrq': 'LCRQ Simple d-CBO',
     'simple-dcbo-wfqueue': 'WFQ Simple d-CBO',
@@ -318,6 +322,10 @@ class Bench:
             elif self.varying == 'k':
                 # Rank error bound?
                 plt.xlabel("Rank Error Bound", fontsize=12)
+            elif self.varying == 'R':
+                plt.xlabel("Segment Size")
+            elif self.varying == 'C':
+                plt.xlabel("Capacity")
             else:
                 plt.xlabel(f"{self.varying}")
 
@@ -436,6 +444,10 @@ class Bench:
             elif self.varying == 'k':
                 # Rank error bound?
                 x_ax.set_xlabel("Rank Error Bound", fontsize=12)
+            elif self.varying == 'R':
+                x_ax.set_xlabel("Segment Size")
+            elif self.varying == 'C':
+                x_ax.set_xlabel("Capacity")
             else:
                 x_ax.set_xlabel(f"{self.varying}")
 
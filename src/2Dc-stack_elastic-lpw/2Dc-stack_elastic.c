@@ -136,18 +136,17 @@ mstack_t* create_stack(size_t num_threads, width_t width, depth_t depth, width_t
 	int i;
 	for(i=0; i < set->max_width; i++)
 	{
-		set->set_array[i].descriptor.node = NULL;
-		set->set_array[i].descriptor.count = 0;
+		store_descriptor(&set->set_array[i], NULL, 0);
 	}
 	return set;
 }
 
-int stack_cae(volatile descriptor_t* des_loc, descriptor_t* read_des_loc, descriptor_t* new_des_loc, int push)
+int stack_cae(index_t* des_loc, descriptor_t* read_des_loc, descriptor_t* new_des_loc, int push)
 {
 #ifdef RELAXATION_ANALYSIS
 
 	lock_relaxation_lists();
-	if (CAE(des_loc, read_des_loc, new_des_loc))
+	if (descriptor_cae(des_loc, read_des_loc, new_des_loc))
 	{
 		if (push) {
 			new_des_loc->node->val = gen_relaxation_count();
@@ -165,7 +164,7 @@ int stack_cae(volatile descriptor_t* des_loc, descriptor_t* read_des_loc, descri
 	}
 
 #else
-	return CAE(des_loc, read_des_loc, new_des_loc);
+	return descriptor_cae(des_loc, read_des_loc, new_des_loc);
 #endif
 }
 
@@ -194,7 +193,7 @@ int push(mstack_t *set, skey_t key, sval_t val)
 		}
 
 
-		if(stack_cae(&set->set_array[thread_put_index].descriptor, &descriptor, &new_descriptor, 1))
+		if(stack_cae(&set->set_array[thread_put_index], &descriptor, &new_descriptor, 1))
 		{
 			return 1;
 		}
@@ -220,7 +219,7 @@ sval_t pop(mstack_t *set)
 			new_descriptor.node = descriptor.node->next;
 			new_descriptor.count = descriptor.node->next_count;
 
-			if(stack_cae(&set->set_array[thread_get_index].descriptor, &descriptor, &new_descriptor, 0))
+			if(stack_cae(&set->set_array[thread_get_index], &descriptor, &new_descriptor, 0))
 			{
 				sval_t node_val = descriptor.node->val;
 				//garbage collector
@@ -251,7 +250,7 @@ size_t stack_size(mstack_t *set)
 	node_t *node;
 	for(i=0; i < set->max_width; i++)
 	{
-		node = set->set_array[i].descriptor.node;
+		node = load_descriptor(&set->set_array[i]).node;
 		while (node != NULL)
 		{
 			size++;
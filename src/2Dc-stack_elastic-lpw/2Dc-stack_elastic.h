@@ -15,6 +15,9 @@
 #include "utils.h"
 #include "lateral_stack.h"
 #include "types.h"
+#ifdef PACKED_DESCRIPTORS
+#include "packed_descriptor.h"
+#endif
 
 #ifdef RELAXATION_ANALYSIS
 #include "relaxation_analysis_queue.h"
@@ -54,8 +57,14 @@ typedef struct file_descriptor
 
 typedef ALIGNED(CACHE_LINE_SIZE) struct array_index
 {
+#ifdef PACKED_DESCRIPTORS
+	volatile packed_descriptor_t descriptor;	// The node and the low bits of the count, see packed_descriptor.h
+	volatile uint64_t count;	// A recent count, which the low bits are widened against
+	uint8_t padding[CACHE_LINE_SIZE - sizeof(packed_descriptor_t) - sizeof(uint64_t)];
+#else
 	volatile descriptor_t descriptor;
 	uint8_t padding[CACHE_LINE_SIZE - sizeof(descriptor_t)];
+#endif
 } index_t;
 
 typedef ALIGNED(CACHE_LINE_SIZE) struct mstack_file
@@ -71,6 +80,47 @@ typedef ALIGNED(CACHE_LINE_SIZE) struct mstack_file
 	uint8_t padding[CACHE_LINE_SIZE - sizeof(index_t*) - sizeof(lateral_stack_t*) - sizeof(uint64_t)*2 - sizeof(depth_t) - 2*sizeof(width_t) - sizeof(uint8_t)];
 } mstack_t;
 
+// The descriptor of des_loc. A packed count is widened against the reference count of the index, as sub-stacks
+// left outside the window while it is narrow can be any distance away from it.
+static inline descriptor_t load_descriptor(index_t* des_loc)
+{
+#ifdef PACKED_DESCRIPTORS
+	packed_descriptor_t word = des_loc->descriptor;
+	descriptor_t descriptor = {(node_t*) packed_node(word), packed_count(word, des_loc->count)};
+	return descriptor;
+#else
+	return des_loc->descriptor;
+#endif
+}
+
+static inline void store_descriptor(index_t* des_loc, node_t* node, uint64_t count)
+{
+#ifdef PACKED_DESCRIPTORS
+	des_loc->descriptor = pack_descriptor(node, count);
+	des_loc->count = count;
+#else
+	des_loc->descriptor.node = node;
+	des_loc->descriptor.count = count;
+#endif
+}
+
+// Swaps the descriptor of des_loc from read_des_loc to new_des_loc, with an 8-byte CAS if packed. Only the CAE
+// of unpacked descriptors reads the descriptor into read_des_loc if it fails, so callers read it again.
+static inline int descriptor_cae(index_t* des_loc, descriptor_t* read_des_loc, descriptor_t* new_des_loc)
+{
+#ifdef PACKED_DESCRIPTORS
+	packed_descriptor_t new = pack_descriptor(new_des_loc->node, new_des_loc->count);
+	if (CAS(&des_loc->descriptor, pack_descriptor(read_des_loc->node, read_des_loc->count), new))
+	{
+		follow_packed_count(&des_loc->descriptor, &des_loc->count, new, new_des_loc->count);
+		return 1;
+	}
+	return 0;
+#else
+	return CAE(&des_loc->descriptor, read_des_loc, new_des_loc);
+#endif
+}
+
 /*Global variables*/
 
 
@@ -147,7 +147,7 @@ descriptor_t put_window(DS_TYPE* set, uint8_t contention)
 	while(1)
 	{
 		/* read descriptor */
-		descriptor =  set->set_array[thread_put_index].descriptor;
+		descriptor = load_descriptor(&set->set_array[thread_put_index]);
 
 		if (global_Window.content.version != thread_Window.version)
 		{
@@ -238,7 +238,7 @@ descriptor_t get_window(DS_TYPE* set, uint8_t contention)
 	{
 
 		/* read descriptor */
-		descriptor =  set->set_array[thread_get_index].descriptor;
+		descriptor = load_descriptor(&set->set_array[thread_get_index]);
 
 		/* Read the global window and possibly sync */
 		if (global_Window.content.version != thread_Window.version)
@@ -43,7 +43,7 @@ static inline row_t push_wider_count(index_t* substructures)
 	row_t max = 0;
 	for (width_t i = thread_Window.put_width; i < thread_Window.old_put_width; i += 1)
 	{
-		row_t count = substructures[i].descriptor.count;
+		row_t count = load_descriptor(&substructures[i]).count;
 		if (unlikely(count > max)) {
 			max = count;
 		}
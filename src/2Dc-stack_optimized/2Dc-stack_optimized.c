@@ -46,6 +46,36 @@ node_t* create_node(skey_t key, sval_t val, node_t* next)
 	return node;
 }
 
+#ifdef ARRAY_SUBSTACKS
+// Cells per chunk, the depth rounded up to whole cache lines
+static inline uint64_t chunk_cells(mstack_t* set)
+{
+	uint64_t line_cells = CACHE_LINE_SIZE / sizeof(cell_t);
+	return (set->depth + line_cells - 1) / line_cells * line_cells;
+}
+
+// The bottom chunks of the sub-stacks are made with the stack, before the threads have allocators
+chunk_t* create_chunk(mstack_t* set, chunk_t* prev, uint64_t first)
+{
+	size_t size = sizeof(chunk_t) + chunk_cells(set) * sizeof(cell_t);
+	#if GC == 1
+		chunk_t* chunk = prev == NULL ? ssalloc_aligned(CACHE_LINE_SIZE, size) : ssmem_alloc(alloc, size);
+	#else
+		chunk_t* chunk = ssalloc_aligned(CACHE_LINE_SIZE, size);
+	#endif
+	chunk->prev = prev;
+	chunk->next = NULL;
+	chunk->first = first;
+	memset((void*) chunk->cells, 0, chunk_cells(set) * sizeof(cell_t));
+
+	#ifdef __tile__
+		MEM_BARRIER;
+	#endif
+
+	return chunk;
+}
+#endif
+
 mstack_t* create_stack(size_t num_threads, width_t width, depth_t depth, width_t max_width, uint8_t k_mode, uint64_t relaxation_bound)
 {
 	mstack_t *set;
@@ -130,29 +160,316 @@ mstack_t* create_stack(size_t num_threads, width_t width, depth_t depth, width_t
 	set->random_hops = 2;
 	set->k_mode = k_mode;
 	set->relaxation_bound = relaxation_bound;
+	set->hop_policy = HOP_DEFAULT;
+#ifdef PACKED_DESCRIPTORS
+	// The counts stay within a few depths of the window they are widened against
+	assert(4 * (uint64_t) depth < PACKED_COUNT_REACH);
+#endif
+#ifdef HIERARCHICAL_WINDOWS
+	set->budget = 0;
+	stack_set_sockets(set, 0, WINDOW_BUDGET);
+#endif
 
 	int i;
 	for(i=0; i < set->width; i++)
 	{
-		set->set_array[i].descriptor.node = NULL;
-		set->set_array[i].descriptor.count = 0;
+#ifdef ARRAY_SUBSTACKS
+		store_descriptor(&set->set_array[i], create_chunk(set, NULL, 0), 0);
+#else
+		store_descriptor(&set->set_array[i], NULL, 0);
+#endif
 	}
 	return set;
 }
 
-int stack_cae(volatile descriptor_t* des_loc, descriptor_t* read_des_loc, descriptor_t* new_des_loc, int push)
+#ifdef ARRAY_SUBSTACKS
+/*
+ * Array sub-stacks keep their items in cells of chunks, rather than in a node each. A push or pop moves a
+ * sub-stack on from the descriptor it read by claiming the cell of row descriptor.count, the one above the
+ * top item, with a 16-byte CAE that writes the version of the descriptor and the number of rows it moves
+ * into the cell, and the pushed item for a push. As every move from a version claims the same cell, only
+ * one succeeds, and the descriptor is then swapped to the next version by whoever sees the claim first, so
+ * that no operation waits for a stalled one.
+ *
+ * The cell is read before the descriptor is checked again, so a claim also fails for a descriptor that the
+ * sub-stack has moved on from since, with its cell claimed again for a later version. The 48-bit versions do
+ * not wrap around within the life of a stack.
+ */
+
+static inline uint64_t claim_word(descriptor_t descriptor, int16_t rows)
+{
+	return descriptor.version << 16 | (uint16_t) rows;
+}
+
+// The chunk above, made by the first push to reach it, and kept for the next push when pops empty it again
+static chunk_t* next_chunk(mstack_t* set, chunk_t* chunk)
+{
+	chunk_t* next = chunk->next;
+	if (next == NULL)
+	{
+		next = create_chunk(set, chunk, chunk->first + chunk_cells(set));
+		if (!CAS(&chunk->next, NULL, next))
+		{
+			#if GC == 1
+				ssmem_free(alloc, (void*) next);
+			#endif
+			next = chunk->next;
+		}
+	}
+	return next;
+}
+
+// The cell of row, searched for from chunk
+static cell_t* row_cell(mstack_t* set, chunk_t* chunk, uint64_t row)
+{
+	while (row < chunk->first)
+	{
+		chunk = chunk->prev;
+	}
+	while (row >= chunk->first + chunk_cells(set))
+	{
+		chunk = next_chunk(set, chunk);
+	}
+	return &chunk->cells[row - chunk->first];
+}
+
+// Swaps the descriptor of des_loc to the next version, rows moved by claim, unless someone else did already
+static void finish_claim(mstack_t* set, index_t* des_loc, descriptor_t descriptor, uint64_t claim)
+{
+	descriptor_t new_descriptor;
+	new_descriptor.count = descriptor.count + (int16_t) (uint16_t) claim;
+	new_descriptor.version = descriptor.version + 1;
+	new_descriptor.node = descriptor.node;
+	while (new_descriptor.count < new_descriptor.node->first)
+	{
+		new_descriptor.node = new_descriptor.node->prev;
+	}
+	if (new_descriptor.count == new_descriptor.node->first + chunk_cells(set))
+	{
+		new_descriptor.node = next_chunk(set, new_descriptor.node);
+	}
+	descriptor_cae(des_loc, &descriptor, &new_descriptor);
+}
+
+// The cell to claim to move on from descriptor, read into old. NULL if the descriptor was read halfway through
+// a swap, or if the cell is claimed for its version already, in which case the claim is finished first.
+static cell_t* claim_start(mstack_t* set, index_t* des_loc, descriptor_t descriptor, cell_t* old)
+{
+	chunk_t* chunk = descriptor.node;
+	if (descriptor.count < chunk->first || descriptor.count >= chunk->first + chunk_cells(set))
+	{
+		return NULL;
+	}
+	cell_t* cell = &chunk->cells[descriptor.count - chunk->first];
+	old->claim = cell->claim;
+	old->val = cell->val;
+	if (old->claim >> 16 == descriptor.version)
+	{
+		finish_claim(set, des_loc, descriptor, old->claim);
+		return NULL;
+	}
+	return cell;
+}
+
+// Claims cell, read into old by claim_start, to move the sub-stack rows from descriptor, if that is still its
+// descriptor. A push claims it with the item in vals, and a pop with the items it read in vals, top first.
+static int claim_cell(mstack_t* set, index_t* des_loc, descriptor_t descriptor, cell_t* cell, cell_t* old, sval_t* vals, int16_t rows)
+{
+	descriptor_t current = load_descriptor(set, des_loc - set->set_array, 0);
+	if (current.node != descriptor.node || current.count != descriptor.count || current.version != descriptor.version)
+	{
+		return 0;
+	}
+
+	cell_t claimed;
+	claimed.claim = claim_word(descriptor, rows);
+#ifdef RELAXATION_ANALYSIS
+	lock_relaxation_lists();
+	claimed.val = rows > 0 ? gen_relaxation_count() : 0;
+	if (!CAE(cell, old, &claimed))
+	{
+		unlock_relaxation_lists();
+		return 0;
+	}
+	if (rows > 0)
+	{
+		add_linear(claimed.val, 1);
+	}
+	for (int16_t i = 0; i < -rows; i++)
+	{
+		remove_linear(vals[i]);
+	}
+	unlock_relaxation_lists();
+#else
+	claimed.val = rows > 0 ? vals[0] : 0;
+	if (!CAE(cell, old, &claimed))
+	{
+		return 0;
+	}
+#endif
+	finish_claim(set, des_loc, descriptor, claimed.claim);
+	return 1;
+}
+
+int push(mstack_t *set, skey_t key, sval_t val)
+{
+	uint8_t contention = 0;
+	descriptor_t descriptor;
+	cell_t* cell;
+	cell_t old;
+
+	while(1)
+	{
+		descriptor = put_window(set, contention);
+
+		index_t* des_loc = &set->set_array[thread_index];
+		cell = claim_start(set, des_loc, descriptor, &old);
+		if(cell != NULL && claim_cell(set, des_loc, descriptor, cell, &old, &val, 1))
+		{
+			return 1;
+		}
+		contention = 1;
+
+		my_put_cas_fail_count += 1;
+	}
+}
+
+sval_t pop(mstack_t *set)
+{
+	uint8_t contention = 0;
+	descriptor_t descriptor;
+	cell_t* cell;
+	cell_t old;
+
+	while (1)
+	{
+		descriptor = get_window(set, contention);
+		if(descriptor.count == 0)
+		{
+			my_null_count += 1;
+			return 0;
+		}
+
+		index_t* des_loc = &set->set_array[thread_index];
+		cell = claim_start(set, des_loc, descriptor, &old);
+		if(cell != NULL)
+		{
+			sval_t val = row_cell(set, descriptor.node, descriptor.count - 1)->val;
+			if(claim_cell(set, des_loc, descriptor, cell, &old, &val, -1))
+			{
+				return val;
+			}
+		}
+		contention = 1;
+
+		my_get_cas_fail_count += 1;
+	}
+}
+
+// Pushes the n items in order, so the last one ends up on top, and returns n. The cells above the top of a
+// sub-stack can only be written once claimed, one at a time, so these are n single pushes.
+size_t push_bulk(mstack_t *set, const sval_t *vals, size_t n)
+{
+	for(size_t i = 0; i < n; i++)
+	{
+		push(set, vals[i], vals[i]);
+	}
+	return n;
+}
+
+// Pops up to n items into vals, top first, and returns the number popped, fewer only once the stack is
+// empty. Each sub-stack the get window hands out gives the items it has above the bottom of the window,
+// which are read from their cells and taken with a single claim.
+size_t pop_bulk(mstack_t *set, sval_t *vals, size_t n)
+{
+	uint8_t contention = 0;
+	size_t done = 0;
+	descriptor_t descriptor;
+	cell_t* cell;
+	cell_t old;
+
+	while(done < n)
+	{
+		descriptor = get_window(set, contention);
+		if(descriptor.count == 0)
+		{
+			my_null_count += 1;
+			break;
+		}
+
+		size_t count = get_window_room(set, descriptor);
+		if(count > n - done)
+		{
+			count = n - done;
+		}
+		if(count > INT16_MAX)
+		{
+			count = INT16_MAX;
+		}
+
+		index_t* des_loc = &set->set_array[thread_index];
+		cell = claim_start(set, des_loc, descriptor, &old);
+		if(cell != NULL && count <= descriptor.count)
+		{
+			chunk_t* chunk = descriptor.node;
+			for(size_t i = 0; i < count; i++)
+			{
+				uint64_t row = descriptor.count - 1 - i;
+				while(row < chunk->first)
+				{
+					chunk = chunk->prev;
+				}
+				vals[done + i] = chunk->cells[row - chunk->first].val;
+			}
+			if(window_current() && claim_cell(set, des_loc, descriptor, cell, &old, vals + done, -(int16_t) count))
+			{
+				done += count;
+				contention = 0;
+				continue;
+			}
+		}
+		contention = 1;
+		my_get_cas_fail_count += 1;
+	}
+	return done;
+}
+
+size_t stack_size(mstack_t *set)
+{
+	size_t size = 0;
+	uint64_t i;
+	for(i=0; i < set->width; i++)
+	{
+		size += load_descriptor(set, i, 0).count;
+	}
+	return size;
+}
+#else
+
+int stack_cae(index_t* des_loc, descriptor_t* read_des_loc, descriptor_t* new_des_loc, int push)
 {
 #ifdef RELAXATION_ANALYSIS
 
 	lock_relaxation_lists();
-	if (CAE(des_loc, read_des_loc, new_des_loc))
+	if (descriptor_cae(des_loc, read_des_loc, new_des_loc))
 	{
+		// Bulk operations move several nodes, which are pushed from the bottom up and popped from the top down
 		if (push) {
-			new_des_loc->node->val = gen_relaxation_count();
-			add_linear(new_des_loc->node->val, 1);
+			uint64_t pushed = new_des_loc->count - read_des_loc->count;
+			node_t* nodes[pushed];
+			node_t* node = new_des_loc->node;
+			for (uint64_t i = pushed; i-- > 0; node = node->next)
+				nodes[i] = node;
+			for (uint64_t i = 0; i < pushed; i++) {
+				nodes[i]->val = gen_relaxation_count();
+				add_linear(nodes[i]->val, 1);
+			}
+		}
+		else {
+			node_t* node = read_des_loc->node;
+			for (uint64_t i = read_des_loc->count - new_des_loc->count; i > 0; i--, node = node->next)
+				remove_linear(node->val);
 		}
-		else
-			remove_linear(read_des_loc->node->val);
 
 		unlock_relaxation_lists();
 		return true;
@@ -163,7 +480,7 @@ int stack_cae(volatile descriptor_t* des_loc, descriptor_t* read_des_loc, descri
 	}
 
 #else
-	return CAE(des_loc, read_des_loc, new_des_loc);
+	return descriptor_cae(des_loc, read_des_loc, new_des_loc);
 #endif
 }
 
@@ -183,7 +500,7 @@ int push(mstack_t *set, skey_t key, sval_t val)
 		new_descriptor.count = descriptor.count + 1;
 
 
-		if(stack_cae(&set->set_array[thread_index].descriptor, &descriptor, &new_descriptor, 1))
+		if(stack_cae(&set->set_array[thread_index], &descriptor, &new_descriptor, 1))
 		{
 			return 1;
 		}
@@ -209,7 +526,7 @@ sval_t pop(mstack_t *set)
 			new_descriptor.node = descriptor.node->next;
 			new_descriptor.count = descriptor.count - 1;
 
-			if(stack_cae(&set->set_array[thread_index].descriptor, &descriptor, &new_descriptor, 0))
+			if(stack_cae(&set->set_array[thread_index], &descriptor, &new_descriptor, 0))
 			{
 				sval_t node_val = descriptor.node->val;
 				//garbage collector
@@ -233,6 +550,146 @@ sval_t pop(mstack_t *set)
     }
 }
 
+// Pushes the n items in order, so the last one ends up on top, and returns n. Each sub-stack the put window
+// hands out takes as many items as it has rows left below the window, as one chain of nodes swapped in with
+// a single CAS, so the items are where n single pushes could have put them. The keys are set to the items.
+size_t push_bulk(mstack_t *set, const sval_t *vals, size_t n)
+{
+	uint8_t contention = 0;
+	size_t done = 0;
+	descriptor_t descriptor, new_descriptor;
+
+	// Nodes of failed attempts, reused by the next ones
+	node_t* spare = NULL;
+	while(done < n)
+	{
+		descriptor = put_window(set, contention);
+		size_t count = put_window_room(set, descriptor);
+		if(count > n - done)
+		{
+			count = n - done;
+		}
+
+		// Chain of the items from done up, with the last one on top
+		node_t *top = descriptor.node, *bottom = NULL;
+		for(size_t i = 0; i < count; i++)
+		{
+			node_t* node = spare;
+			if(node != NULL)
+			{
+				spare = node->next;
+				node->key = vals[done + i];
+				node->val = vals[done + i];
+			}
+			else
+			{
+				node = create_node(vals[done + i], vals[done + i], NULL);
+			}
+			node->next = top;
+			top = node;
+			if(bottom == NULL)
+			{
+				bottom = node;
+			}
+		}
+
+		new_descriptor.node = top;
+		new_descriptor.count = descriptor.count + count;
+
+		if(!window_current())
+		{
+			bottom->next = spare;
+			spare = top;
+			continue;
+		}
+		if(stack_cae(&set->set_array[thread_index], &descriptor, &new_descriptor, 1))
+		{
+			done += count;
+			contention = 0;
+			continue;
+		}
+		bottom->next = spare;
+		spare = top;
+		contention = 1;
+
+		my_put_cas_fail_count += 1;
+	}
+
+	while(spare != NULL)
+	{
+		node_t* next = spare->next;
+		#if GC == 1
+			ssmem_free(alloc, (void*) spare);
+		#endif
+		spare = next;
+	}
+	return n;
+}
+
+// Pops up to n items into vals, top first, and returns the number popped, fewer only once the stack is
+// empty. Each sub-stack the get window hands out gives the items it has above the bottom of the window,
+// which are taken by moving its descriptor below all of them with a single CAS.
+size_t pop_bulk(mstack_t *set, sval_t *vals, size_t n)
+{
+	uint8_t contention = 0;
+	size_t done = 0;
+	descriptor_t descriptor, new_descriptor;
+
+	while(done < n)
+	{
+		descriptor = get_window(set, contention);
+		if(descriptor.node == NULL)
+		{
+			my_null_count += 1;
+			break;
+		}
+
+		size_t count = get_window_room(set, descriptor);
+		if(count > n - done)
+		{
+			count = n - done;
+		}
+
+		// Shorter than counted only for a descriptor read halfway through a change, whose CAS fails anyway
+		node_t* last = descriptor.node;
+		size_t linked = 1;
+		for(; linked < count && last->next != NULL; linked++)
+		{
+			last = last->next;
+		}
+		count = linked;
+		if(!window_current())
+		{
+			continue;
+		}
+
+		new_descriptor.node = last->next;
+		new_descriptor.count = descriptor.count - count;
+
+		if(stack_cae(&set->set_array[thread_index], &descriptor, &new_descriptor, 0))
+		{
+			node_t* node = descriptor.node;
+			for(size_t i = 0; i < count; i++)
+			{
+				node_t* next = node->next;
+				vals[done++] = node->val;
+				//garbage collector
+				#if GC == 1
+					ssmem_free(alloc, (void*) node);
+				#endif
+				node = next;
+			}
+			contention = 0;
+		}
+		else
+		{
+			contention = 1;
+			my_get_cas_fail_count += 1;
+		}
+	}
+	return done;
+}
+
 size_t stack_size(mstack_t *set)
 {
 	size_t size = 0;
@@ -240,7 +697,7 @@ size_t stack_size(mstack_t *set)
 	node_t *node;
 	for(i=0; i < set->width; i++)
 	{
-		node = set->set_array[i].descriptor.node;
+		node = load_descriptor(set, i, 0).node;
 		while (node != NULL)
 		{
 			size++;
@@ -249,6 +706,43 @@ size_t stack_size(mstack_t *set)
 	}
 	return size;
 }
+#endif
+
+// Picks the policy of the hops between sub-stacks, HOP_DEFAULT for an unknown one. To call before the threads register.
+void stack_set_hop_policy(mstack_t *set, uint8_t policy)
+{
+	set->hop_policy = policy < HOP_POLICIES ? policy : HOP_DEFAULT;
+}
+
+#ifdef HIERARCHICAL_WINDOWS
+// Splits the sub-stacks into one slice per socket, or those of the platform for 0, whose windows may
+// each move budget shifts away from the global window. To call before the threads register.
+void stack_set_sockets(mstack_t *set, width_t sockets, depth_t budget)
+{
+	if (sockets == 0)
+	{
+		sockets = NUMBER_OF_SOCKETS;
+	}
+	if (sockets > set->width)
+	{
+		sockets = set->width;
+	}
+	if (sockets > WINDOW_MAX_SOCKETS)
+	{
+		sockets = WINDOW_MAX_SOCKETS;
+	}
+
+	// Two socket windows may be two budgets apart, so the bound is that of a flat stack that much deeper
+	set->relaxation_bound -= 2 * (set->width - 1) * set->budget;
+	set->sockets = sockets;
+	set->budget = (row_t)budget * set->shift;
+	set->relaxation_bound += 2 * (set->width - 1) * set->budget;
+#ifdef PACKED_DESCRIPTORS
+	// Sub-stacks of other sockets are widened against the global window, which they may be two budgets from
+	assert(4 * ((uint64_t) set->depth + 2 * set->budget) < PACKED_COUNT_REACH);
+#endif
+}
+#endif
 
 mstack_t* register_stack(mstack_t *set, int thread_id)
 {
@@ -261,6 +755,10 @@ mstack_t* register_stack(mstack_t *set, int thread_id)
 		ssmem_alloc_init_fs_size(alloc, SSMEM_DEFAULT_MEM_SIZE, SSMEM_GC_FREE_SET_SIZE, thread_id);
     }
 	#endif
+#ifdef HIERARCHICAL_WINDOWS
+	window_register(set, thread_id);
+#endif
+	hop_register(set, thread_id);
 
     return set;
 }
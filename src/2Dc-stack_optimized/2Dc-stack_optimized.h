@@ -14,6 +14,13 @@
 #include "ssmem.h"
 #include "utils.h"
 #include "types.h"
+#include "hop_policy.h"
+#if defined(PACKED_DESCRIPTORS) || defined(ARRAY_SUBSTACKS)
+#include "packed_descriptor.h"
+#endif
+#if defined(PACKED_DESCRIPTORS) && defined(ARRAY_SUBSTACKS)
+#error "The descriptors of array sub-stacks are two words, and can not be packed"
+#endif
 
 #ifdef RELAXATION_ANALYSIS
 #include "relaxation_analysis_queue.h"
@@ -25,13 +32,26 @@
 
 #define DS_ADD(s,k,v)       push(s,k,v)
 #define DS_REMOVE(s)        pop(s)
+#define DS_ADD_BULK(s,v,n)  push_bulk(s,v,n)
+#define DS_REMOVE_BULK(s,v,n) pop_bulk(s,v,n)
 #define DS_SIZE(s)          stack_size(s)
 #define DS_NEW(n,w,d,b,m,k)       create_stack(n,w,d,b,m,k)
 #define DS_REGISTER(s,i)    register_stack(s,i)
 
+#ifdef HIERARCHICAL_WINDOWS
+// Shifts a socket window may move away from the global window
+#ifndef WINDOW_BUDGET
+#define WINDOW_BUDGET 4
+#endif
+#endif
+
 #define DS_TYPE             mstack_t
 #define DS_HANDLE           mstack_t*
+#ifdef ARRAY_SUBSTACKS
+#define DS_NODE             cell_t
+#else
 #define DS_NODE             node_t
+#endif
 
 /* Type definitions */
 typedef struct mstack_node
@@ -43,16 +63,62 @@ typedef struct mstack_node
 	uint8_t padding[CACHE_LINE_SIZE - sizeof(skey_t) - sizeof(sval_t) - sizeof(struct mstack_node*)];
 } node_t;
 
+#ifdef ARRAY_SUBSTACKS
+// An item of an array sub-stack. The claim holds the version of the descriptor that the operation which
+// took the cell moved the sub-stack on from, and by how many rows, see claim_cell in 2Dc-stack_optimized.c.
+typedef struct ALIGNED(16) mstack_cell
+{
+	volatile sval_t val;
+	volatile uint64_t claim;
+} cell_t;
+
+// Rows first up to first + chunk_cells(set) of a sub-stack, the depth rounded up to whole cache lines. The
+// chunks of a sub-stack are linked both ways, and one a pop empties stays as the next of the one below, so
+// a sub-stack only allocates when it grows past its highest row so far.
+typedef struct mstack_chunk
+{
+	struct mstack_chunk* prev;
+	struct mstack_chunk* volatile next;
+	uint64_t first;
+
+	uint8_t padding[CACHE_LINE_SIZE - 2 * sizeof(struct mstack_chunk*) - sizeof(uint64_t)];
+	cell_t cells[];
+} chunk_t;
+
+// The chunk with row count, the next one to push to, and a version that every move of the sub-stack bumps
+typedef struct file_descriptor
+{
+	chunk_t* node;
+	uint64_t count;
+	uint64_t version;
+} descriptor_t;
+
+// A descriptor as stored, the chunk with the high 16 bits of the 48-bit version, and the count with the rest
+typedef struct array_descriptor
+{
+	packed_descriptor_t chunk_word;
+	uint64_t count_word;
+} array_descriptor_t;
+#else
 typedef struct file_descriptor
 {
 	node_t* node;
 	uint64_t count;
 } descriptor_t;
+#endif
 
 typedef ALIGNED(CACHE_LINE_SIZE) struct array_index
 {
+#ifdef ARRAY_SUBSTACKS
+	volatile array_descriptor_t descriptor;
+	uint8_t padding[CACHE_LINE_SIZE - sizeof(array_descriptor_t)];
+#elif defined(PACKED_DESCRIPTORS)
+	volatile packed_descriptor_t descriptor;	// The node and the low bits of the count, see packed_descriptor.h
+	uint8_t padding[CACHE_LINE_SIZE - sizeof(packed_descriptor_t)];
+#else
 	volatile descriptor_t descriptor;
 	uint8_t padding[CACHE_LINE_SIZE - sizeof(descriptor_t)];
+#endif
 } index_t;
 
 typedef ALIGNED(CACHE_LINE_SIZE) struct mstack_file
@@ -64,9 +130,77 @@ typedef ALIGNED(CACHE_LINE_SIZE) struct mstack_file
 	width_t width;
 	depth_t shift;
 	uint8_t k_mode;
-	uint8_t padding[CACHE_LINE_SIZE - sizeof(index_t*) - sizeof(uint64_t)*2 - 2*sizeof(depth_t) - sizeof(width_t) - sizeof(uint8_t)];
+	uint8_t hop_policy;	// One of the HOP_* policies of hop_policy.h
+#ifdef HIERARCHICAL_WINDOWS
+	width_t sockets;	// Sub-stacks are split evenly into one slice per socket, with a window of its own
+	row_t budget;	// Rows a socket window may move away from the global window
+	uint8_t padding[CACHE_LINE_SIZE - sizeof(index_t*) - sizeof(uint64_t)*2 - 2*sizeof(depth_t) - 2*sizeof(width_t) - 2*sizeof(uint8_t) - sizeof(row_t)];
+#else
+	uint8_t padding[CACHE_LINE_SIZE - sizeof(index_t*) - sizeof(uint64_t)*2 - 2*sizeof(depth_t) - sizeof(width_t) - 2*sizeof(uint8_t)];
+#endif
 } mstack_t;
 
+// The descriptor of sub-stack index. A packed count is widened against reference, the max of the window the
+// caller compares it with, which must still be current after the read for the count to be right.
+static inline descriptor_t load_descriptor(mstack_t* set, uint64_t index, uint64_t reference)
+{
+#ifdef ARRAY_SUBSTACKS
+	packed_descriptor_t chunk_word = set->set_array[index].descriptor.chunk_word;
+	uint64_t count_word = set->set_array[index].descriptor.count_word;
+	descriptor_t descriptor = {(chunk_t*) packed_node(chunk_word), (uint32_t) count_word, (chunk_word >> PACKED_POINTER_BITS) << 32 | count_word >> 32};
+	return descriptor;
+#elif defined(PACKED_DESCRIPTORS)
+	packed_descriptor_t word = set->set_array[index].descriptor;
+	descriptor_t descriptor = {(node_t*) packed_node(word), packed_count(word, reference)};
+	return descriptor;
+#else
+	return set->set_array[index].descriptor;
+#endif
+}
+
+#ifdef ARRAY_SUBSTACKS
+static inline array_descriptor_t pack_array_descriptor(descriptor_t* descriptor)
+{
+	array_descriptor_t packed = {pack_descriptor(descriptor->node, descriptor->version >> 32 & 0xffff), (uint32_t) descriptor->count | descriptor->version << 32};
+	return packed;
+}
+
+static inline void store_descriptor(index_t* des_loc, chunk_t* node, uint64_t count)
+{
+	descriptor_t descriptor = {node, count, 1};
+	des_loc->descriptor = pack_array_descriptor(&descriptor);
+}
+
+// Swaps the descriptor of des_loc from read_des_loc to new_des_loc, without reading it back if it fails
+static inline int descriptor_cae(index_t* des_loc, descriptor_t* read_des_loc, descriptor_t* new_des_loc)
+{
+	array_descriptor_t read = pack_array_descriptor(read_des_loc);
+	array_descriptor_t new = pack_array_descriptor(new_des_loc);
+	return CAE(&des_loc->descriptor, &read, &new);
+}
+#else
+static inline void store_descriptor(index_t* des_loc, node_t* node, uint64_t count)
+{
+#ifdef PACKED_DESCRIPTORS
+	des_loc->descriptor = pack_descriptor(node, count);
+#else
+	des_loc->descriptor.node = node;
+	des_loc->descriptor.count = count;
+#endif
+}
+
+// Swaps the descriptor of des_loc from read_des_loc to new_des_loc, with an 8-byte CAS if packed. Only the CAE
+// of unpacked descriptors reads the descriptor into read_des_loc if it fails, so callers read it again.
+static inline int descriptor_cae(index_t* des_loc, descriptor_t* read_des_loc, descriptor_t* new_des_loc)
+{
+#ifdef PACKED_DESCRIPTORS
+	return CAS(&des_loc->descriptor, pack_descriptor(read_des_loc->node, read_des_loc->count), pack_descriptor(new_des_loc->node, new_des_loc->count));
+#else
+	return CAE(&des_loc->descriptor, read_des_loc, new_des_loc);
+#endif
+}
+#endif
+
 /*Global variables*/
 
 
@@ -80,12 +214,26 @@ extern __thread unsigned long my_null_count;
 extern __thread unsigned long my_hop_count;
 extern __thread unsigned long my_slide_count;
 extern __thread unsigned long my_slide_fail_count;
+extern __thread unsigned long my_hop_hist[HOP_HIST_BUCKETS];
+#ifdef HIERARCHICAL_WINDOWS
+extern __thread unsigned long my_global_slide_count;
+extern __thread unsigned long my_remote_count;
+#endif
 
 /* Interfaces */
 int push(mstack_t *set, skey_t key, sval_t val);
 sval_t pop(mstack_t *set);
+size_t push_bulk(mstack_t *set, const sval_t *vals, size_t n);
+size_t pop_bulk(mstack_t *set, sval_t *vals, size_t n);
 node_t* create_node(skey_t key, sval_t val, node_t* next);
+#ifdef ARRAY_SUBSTACKS
+chunk_t* create_chunk(mstack_t* set, chunk_t* prev, uint64_t first);
+#endif
 mstack_t* create_stack(size_t num_threads, width_t width, depth_t depth, width_t max_width, uint8_t k_mode, uint64_t relaxation_bound);
 mstack_t* register_stack(mstack_t *set, int thread_id);
+void stack_set_hop_policy(mstack_t *set, uint8_t policy);
+#ifdef HIERARCHICAL_WINDOWS
+void stack_set_sockets(mstack_t *set, width_t sockets, depth_t budget);
+#endif
 size_t stack_size(mstack_t *set);
 int floor_log_2(unsigned int n);
\ No newline at end of file
@@ -1,45 +1,407 @@
 #include "2Dc-window_optimized.h"
 
 
-static inline uint64_t hop(DS_TYPE* set, uint64_t index, uint8_t* random, width_t* hops, width_t width)
+// The better of two random sub-stacks of [base, base + width), the lower one for a push and the higher one for a pop
+static inline uint64_t two_choices(DS_TYPE* set, uint64_t base, width_t width, uint8_t push)
 {
-	uint64_t old_index = index;
+	uint64_t a = base + random_index(width);
+	uint64_t b = base + random_index(width);
+	uint64_t count_a = load_descriptor(set, a, thread_Window.max).count;
+	uint64_t count_b = load_descriptor(set, b, thread_Window.max).count;
 
+	if(push)
+	{
+		return count_a <= count_b ? a : b;
+	}
+	return count_a >= count_b ? a : b;
+}
+
+// Probes before the sweep over all sub-stacks
+static inline width_t hop_probes(DS_TYPE* set, width_t width)
+{
+	switch(set->hop_policy)
+	{
+		case HOP_RANDOM:
+			return width;
+		case HOP_LAST_SUCCESS:
+			return 1;
+		case HOP_STRIDE:
+		case HOP_SOCKET_LOCAL:
+			return 0;
+		default:
+			return set->random_hops;
+	}
+}
+
+// Hops from index to the next sub-stack of [base, base + width) to try, for a push if push is set. The
+// probes are counted in random and the hops of the sweep in hops, which sees every sub-stack within width hops.
+static inline uint64_t hop(DS_TYPE* set, uint64_t index, width_t* random, width_t* hops, uint64_t base, width_t width, uint8_t push)
+{
 	my_hop_count += 1;
+	thread_hop_chain += 1;
 
-	if(*random < set->random_hops)
+	if(*random < hop_probes(set, width))
 	{
 		*random += 1;
-		index = random_index(width);
+		uint64_t last = push ? thread_last_push : thread_last_pop;
+		if(set->hop_policy == HOP_TWO_CHOICES)
+		{
+			return two_choices(set, base, width, push);
+		}
+		if(set->hop_policy == HOP_LAST_SUCCESS && last != index && last >= base && last < base + width)
+		{
+			return last;
+		}
+		return base + random_index(width);
+	}
+
+	*hops += 1;
+	index -= base;
+	switch(set->hop_policy)
+	{
+		case HOP_STRIDE:
+			index += thread_hop_stride;
+			break;
+		case HOP_SOCKET_LOCAL:
+			return base + hop_local_first(index, *hops, width, thread_local_start - base, thread_local_width);
+		default:
+			index += 1;
+	}
+	if(index >= width)
+	{
+		index -= width;
+	}
+
+	return base + index;
+}
+
+// Index a search starts from after contention, within the share of the thread's socket for HOP_SOCKET_LOCAL
+static inline uint64_t hop_start_index(DS_TYPE* set)
+{
+	if(set->hop_policy == HOP_SOCKET_LOCAL)
+	{
+		return thread_local_start + random_index(thread_local_width);
+	}
+	return random_index(set->width);
+}
+
+
+// Reads the global window into the thread local one, can think of it as atomic
+static void read_window()
+{
+	// Opt: Can we read it in two consecutive parts? First in that case the version, and then the rest
+	__atomic_load(&global_Window.content, &thread_Window, __ATOMIC_SEQ_CST);
+}
+
+
+#ifdef HIERARCHICAL_WINDOWS
+/*
+ * Each socket owns a slice of the sub-stacks, with a window of its own that shifts up (down) once the
+ * slice is full (has nothing left within it) as the global window does in the flat design, but only
+ * to within a budget of the global window. The global window is only written once a socket has used
+ * up its budget, so in the common case the window lines stay within their sockets.
+ *
+ * The global window is shifted as in the flat design, once no sub-stack of any socket is within it,
+ * and then straight past the lowest (highest) sub-stack. A socket window the global window has moved
+ * away from is pulled along to within the budget, so two socket windows are at most two budgets apart.
+ */
+
+// Sub-stacks of socket s are [s*width/sockets, (s+1)*width/sockets)
+static inline width_t slice_start(DS_TYPE* set, width_t socket)
+{
+	return (width_t)(((uint32_t) socket * set->width) / set->sockets);
+}
+
+static inline int in_slice(uint64_t index)
+{
+	return index >= thread_slice_start && index < thread_slice_start + thread_slice_width;
+}
+
+static inline uint64_t random_slice_index()
+{
+	return thread_slice_start + random_index(thread_slice_width);
+}
+
+// Hops within the slice of this thread's socket
+static inline uint64_t slice_hop(DS_TYPE* set, uint64_t index, width_t* random, width_t* hops, uint8_t push)
+{
+	return hop(set, index, random, hops, thread_slice_start, thread_slice_width, push);
+}
+
+// Reads the window of this thread's socket and the global window, can think of each as atomic
+static void read_windows()
+{
+	__atomic_load(&socket_Window[thread_socket].content, &thread_Window, __ATOMIC_SEQ_CST);
+	__atomic_load(&global_Window.content, &thread_GlobalWindow, __ATOMIC_SEQ_CST);
+}
+
+static inline int windows_changed()
+{
+	return socket_Window[thread_socket].content.version != thread_Window.version || global_Window.content.version != thread_GlobalWindow.version;
+}
+
+// The socket window, pulled to within the budget of the global window, but never below the depth
+static inline row_t socket_max(DS_TYPE* set)
+{
+	row_t low = thread_GlobalWindow.max >= set->depth + set->budget ? thread_GlobalWindow.max - set->budget : set->depth;
+	row_t high = thread_GlobalWindow.max + set->budget;
+
+	if(thread_Window.max < low)
+	{
+		return low;
+	}
+	return thread_Window.max > high ? high : thread_Window.max;
+}
+
+// Moves the socket window to max, unless another thread has moved it since it was read
+static void shift_socket_window(row_t max)
+{
+	window_t new_window;
+
+	new_window.version = thread_Window.version + 1;
+	new_window.max = max;
+
+	if(CAE(&socket_Window[thread_socket].content, &thread_Window, &new_window))
+	{
+		thread_Window = new_window;
+		my_slide_count+=1;
 	}
 	else
 	{
-		*hops += 1;
-		index += 1;
+		read_windows();
+		my_slide_fail_count+=1;
+	}
+}
+
+static void shift_global_window(row_t max)
+{
+	window_t new_window;
 
-		if(index >= width)
+	new_window.version = thread_GlobalWindow.version + 1;
+	new_window.max = max;
+
+	if(CAE(&global_Window.content, &thread_GlobalWindow, &new_window))
+	{
+		thread_GlobalWindow = new_window;
+		my_global_slide_count+=1;
+	}
+	else
+	{
+		read_windows();
+		my_slide_fail_count+=1;
+	}
+}
+
+// Pushes at the global window once the socket window has used up its budget. A sub-stack below it, on a
+// socket that lags behind, is pushed to first. Otherwise the global window shifts up past the lowest
+// sub-stack. Returns 1 with the descriptor to push to, and 0 to retry within the slice.
+static int push_global(DS_TYPE* set, descriptor_t* descriptor)
+{
+	uint64_t lowest = UINT64_MAX;
+	uint64_t i, index = random_index(set->width);
+
+	for(i = 0; i < set->width; i++)
+	{
+		*descriptor = load_descriptor(set, index, thread_GlobalWindow.max);
+		if(descriptor->count < thread_GlobalWindow.max)
+		{
+			thread_index = index;
+			if(!in_slice(index))
+			{
+				my_remote_count+=1;
+			}
+			return 1;
+		}
+		if(descriptor->count < lowest)
+		{
+			lowest = descriptor->count;
+		}
+		if(++index == set->width)
 		{
 			index = 0;
 		}
 	}
 
-	return index;
+	shift_global_window(lowest + set->shift);
+	return 0;
 }
 
+// Pops at the global window once the socket window has used up its budget, or the slice is empty. A
+// sub-stack within it, on another socket, is popped from first. Otherwise the global window shifts down
+// past the highest sub-stack. Returns 1 with the descriptor to pop from, 0 to retry within the slice
+// and -1 with an empty descriptor if all sub-stacks are empty.
+static int pop_global(DS_TYPE* set, descriptor_t* descriptor)
+{
+	uint64_t highest = 0;
+	uint64_t i, index = random_index(set->width);
 
-// Reads the global window into the thread local one, can think of it as atomic
-static void read_window()
+	for(i = 0; i < set->width; i++)
+	{
+		*descriptor = load_descriptor(set, index, thread_GlobalWindow.max);
+		if(descriptor->count > thread_GlobalWindow.max - set->depth)
+		{
+			thread_index = index;
+			if(!in_slice(index))
+			{
+				my_remote_count+=1;
+			}
+			return 1;
+		}
+		if(descriptor->count > highest)
+		{
+			highest = descriptor->count;
+		}
+		if(++index == set->width)
+		{
+			index = 0;
+		}
+	}
+
+	if(highest == 0)
+	{
+		descriptor->node = NULL;
+		return -1;
+	}
+
+	shift_global_window(highest + set->depth > set->depth + set->shift ? highest + set->depth - set->shift : set->depth);
+	return 0;
+}
+
+static descriptor_t search_put_window(DS_TYPE* set, uint8_t contention)
 {
-	// Opt: Can we read it in two consecutive parts? First in that case the version, and then the rest
-	__atomic_load(&global_Window.content, &thread_Window, __ATOMIC_SEQ_CST);
+	width_t hops;
+	width_t random;
+	descriptor_t descriptor;
+	row_t max;
+	hops = random = 0;
+
+	if(windows_changed())
+	{
+		read_windows();
+	}
+
+	if(contention || !in_slice(thread_index))
+	{
+		thread_index = random_slice_index();
+	}
+
+	while(1)
+	{
+		/* read descriptor */
+		descriptor = load_descriptor(set, thread_index, socket_max(set));
+
+		if (windows_changed())
+		{
+			hops = 0;
+			read_windows();
+		}
+
+		/* Try to work on the descriptor */
+		else if(descriptor.count < socket_max(set))
+		{
+			return descriptor;
+		}
+
+		/* hop within the slice */
+		else if(hops != thread_slice_width)
+		{
+			thread_index = slice_hop(set, thread_index, &random, &hops, 1);
+		}
+
+		/* shift the socket window up, within the budget */
+		else if((max = socket_max(set)) + set->shift <= thread_GlobalWindow.max + set->budget)
+		{
+			shift_socket_window(max + set->shift);
+			hops = 0;
+		}
+
+		/* the budget is used up, push at the global window */
+		else
+		{
+			if(push_global(set, &descriptor))
+			{
+				return descriptor;
+			}
+			thread_index = random_slice_index();
+			hops = 0;
+		}
+	}
 }
 
 
-descriptor_t put_window(DS_TYPE* set, uint8_t contention)
+static descriptor_t search_get_window(DS_TYPE* set, uint8_t contention)
+{
+	width_t hops;
+	width_t random;
+	descriptor_t descriptor;
+	uint8_t empty = 1;
+	row_t max;
+	hops = random = 0;
+
+	if(windows_changed())
+	{
+		read_windows();
+	}
+
+	if(contention || !in_slice(thread_index))
+	{
+		thread_index = random_slice_index();
+	}
+
+	while(1)
+	{
+		/* read descriptor */
+		descriptor = load_descriptor(set, thread_index, socket_max(set));
+
+		if (windows_changed())
+		{
+			hops = 0; empty = 1;
+			read_windows();
+		}
+
+		/* the socket window is never below the depth, so empty sub-stacks are skipped */
+		else if(descriptor.count > socket_max(set) - set->depth)
+		{
+			break;
+		}
+
+		/* hop within the slice */
+		else if(hops != thread_slice_width)
+		{
+			if(descriptor.count > 0)
+			{
+				empty = 0;
+			}
+			thread_index = slice_hop(set, thread_index, &random, &hops, 0);
+		}
+
+		/* shift the socket window down, within the budget */
+		else if(!empty && (max = socket_max(set)) >= set->depth + set->shift && max + set->budget >= thread_GlobalWindow.max + set->shift)
+		{
+			shift_socket_window(max - set->shift);
+			hops = 0; empty = 1;
+		}
+
+		/* the slice is empty or the budget used up, pop at the global window */
+		else
+		{
+			if(pop_global(set, &descriptor) != 0)
+			{
+				break;
+			}
+			thread_index = random_slice_index();
+			hops = 0; empty = 1;
+		}
+	}
+
+	return descriptor;
+}
+#else
+static descriptor_t search_put_window(DS_TYPE* set, uint8_t contention)
 {
 	window_t new_window;
 	width_t hops;
-	uint8_t random;
+	width_t random;
 	descriptor_t descriptor;
 	hops = random = 0;
 
@@ -50,13 +412,13 @@ descriptor_t put_window(DS_TYPE* set, uint8_t contention)
 
 	if(contention)
 	{
-		thread_index = random_index(set->width);
+		thread_index = hop_start_index(set);
 	}
 
 	while(1)
 	{
 		/* read descriptor */
-		descriptor =  set->set_array[thread_index].descriptor;
+		descriptor = load_descriptor(set, thread_index, thread_Window.max);
 
 		if (global_Window.content.version != thread_Window.version)
 		{
@@ -73,7 +435,7 @@ descriptor_t put_window(DS_TYPE* set, uint8_t contention)
 		/* hop */
 		else if(hops != set->width)
 		{
-			thread_index = hop(set, thread_index, &random, &hops, set->width);
+			thread_index = hop(set, thread_index, &random, &hops, 0, set->width, 1);
 		}
 
 		/* shift window */
@@ -104,11 +466,11 @@ descriptor_t put_window(DS_TYPE* set, uint8_t contention)
 }
 
 
-descriptor_t get_window(DS_TYPE* set, uint8_t contention)
+static descriptor_t search_get_window(DS_TYPE* set, uint8_t contention)
 {
 	window_t new_window;
 	width_t hops;
-	uint8_t random; // shift
+	width_t random; // shift
 	hops = random = 0;
 	descriptor_t descriptor;
 	uint8_t empty = 1;
@@ -120,14 +482,14 @@ descriptor_t get_window(DS_TYPE* set, uint8_t contention)
 
 	if(contention)
 	{
-		thread_index = random_index(set->width);
+		thread_index = hop_start_index(set);
 	}
 
 	while(1)
 	{
 
 		/* read descriptor */
-		descriptor =  set->set_array[thread_index].descriptor;
+		descriptor = load_descriptor(set, thread_index, thread_Window.max);
 
 		/* Read the global window and possibly sync */
 		if (global_Window.content.version != thread_Window.version)
@@ -150,7 +512,7 @@ descriptor_t get_window(DS_TYPE* set, uint8_t contention)
 			{
 				empty = 0;
 			}
-			thread_index = hop(set, thread_index, &random, &hops, set->width);
+			thread_index = hop(set, thread_index, &random, &hops, 0, set->width, 0);
 		}
 
 		/* Return empty descriptor */
@@ -189,6 +551,95 @@ descriptor_t get_window(DS_TYPE* set, uint8_t contention)
 
 	return descriptor;
 }
+#endif
+
+static inline int hop_local(uint64_t index)
+{
+	return index >= thread_local_start && index < thread_local_start + thread_local_width;
+}
+
+// Searches like search_put_window (search_get_window), and counts the hops of the search in the histogram
+descriptor_t put_window(DS_TYPE* set, uint8_t contention)
+{
+	descriptor_t descriptor;
+
+	thread_hop_chain = 0;
+	if(set->hop_policy == HOP_SOCKET_LOCAL && !hop_local(thread_index))
+	{
+		thread_index = hop_start_index(set);
+	}
+	descriptor = search_put_window(set, contention);
+
+	my_hop_hist[hop_hist_bucket(thread_hop_chain)] += 1;
+	if(thread_hop_chain != 0)
+	{
+		thread_last_push = thread_index;
+	}
+	return descriptor;
+}
+
+descriptor_t get_window(DS_TYPE* set, uint8_t contention)
+{
+	descriptor_t descriptor;
+
+	thread_hop_chain = 0;
+	if(set->hop_policy == HOP_SOCKET_LOCAL && !hop_local(thread_index))
+	{
+		thread_index = hop_start_index(set);
+	}
+	descriptor = search_get_window(set, contention);
+
+	my_hop_hist[hop_hist_bucket(thread_hop_chain)] += 1;
+	if(thread_hop_chain != 0)
+	{
+		thread_last_pop = thread_index;
+	}
+	return descriptor;
+}
+
+// Whether the windows the last put_window (get_window) compared with are still current. The bulk operations
+// check this right before their CAS, as a window that moved meanwhile would misplace a whole run of items.
+static inline int window_current()
+{
+#ifdef HIERARCHICAL_WINDOWS
+	return !windows_changed();
+#else
+	return thread_Window.version == global_Window.content.version;
+#endif
+}
+
+// Items the sub-stack of the descriptor from the last put_window can take before it reaches the window
+static inline row_t put_window_room(DS_TYPE* set, descriptor_t descriptor)
+{
+#ifdef HIERARCHICAL_WINDOWS
+	// A push at the global window may also fill a sub-stack of the slice up to it
+	row_t window = thread_GlobalWindow.max;
+	if(in_slice(thread_index) && socket_max(set) > window)
+	{
+		window = socket_max(set);
+	}
+#else
+	row_t window = thread_Window.max;
+#endif
+	return window > descriptor.count ? window - descriptor.count : 1;
+}
+
+// Items the sub-stack of the descriptor from the last get_window can give before it reaches the bottom of
+// the window, at least one as for the descriptor of an empty return
+static inline row_t get_window_room(DS_TYPE* set, descriptor_t descriptor)
+{
+#ifdef HIERARCHICAL_WINDOWS
+	// A pop at the global window may also empty a sub-stack of the slice down to it
+	row_t window = thread_GlobalWindow.max;
+	if(in_slice(thread_index) && socket_max(set) < window)
+	{
+		window = socket_max(set);
+	}
+#else
+	row_t window = thread_Window.max;
+#endif
+	return descriptor.count + set->depth > window ? descriptor.count + set->depth - window : 1;
+}
 
 
 uint64_t random_index(width_t width)
@@ -201,5 +652,52 @@ void initialize_global_window(depth_t depth, width_t width)
 {
 	global_Window.content.max = depth;
 	global_Window.content.version = 1;
+#ifdef HIERARCHICAL_WINDOWS
+	for (width_t s = 0; s < WINDOW_MAX_SOCKETS; s++)
+	{
+		socket_Window[s].content.max = depth;
+		socket_Window[s].content.version = 1;
+	}
+#endif
+}
+
+#ifdef HIERARCHICAL_WINDOWS
+// Gives the thread the slice and window of its socket. With more sockets than the platform has, the
+// threads are spread over them in turn, to try the windows out on fewer sockets.
+void window_register(DS_TYPE* set, int thread_id)
+{
+	int n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (set->sockets > NUMBER_OF_SOCKETS)
+	{
+		thread_socket = thread_id % set->sockets;
+	}
+	else
+	{
+		thread_socket = (thread_id < n_cpus ? get_cluster(the_cores[thread_id]) : 0) % set->sockets;
+	}
+	thread_slice_start = slice_start(set, thread_socket);
+	thread_slice_width = slice_start(set, thread_socket + 1) - thread_slice_start;
+	thread_index = thread_slice_start;
+	read_windows();
+}
+#endif
+
+// Gives the thread its stride and the share of the sub-stacks of its socket, for the hop policies. With
+// hierarchical windows the searches stay within the slice of the socket, which is then all local.
+void hop_register(DS_TYPE* set, int thread_id)
+{
+#ifdef HIERARCHICAL_WINDOWS
+	thread_local_start = thread_slice_start;
+	thread_local_width = thread_slice_width;
+	thread_hop_stride = hop_stride(thread_slice_width, thread_id);
+#else
+	int n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	width_t sockets = NUMBER_OF_SOCKETS < set->width ? NUMBER_OF_SOCKETS : set->width;
+	width_t socket = (thread_id < n_cpus ? get_cluster(the_cores[thread_id]) : 0) % sockets;
+	thread_local_start = (width_t)(((uint32_t) socket * set->width) / sockets);
+	thread_local_width = (width_t)(((uint32_t) (socket + 1) * set->width) / sockets) - thread_local_start;
+	thread_hop_stride = hop_stride(set->width, thread_id);
+#endif
+	thread_last_push = thread_last_pop = thread_local_start;
 }
 
@@ -24,10 +24,40 @@ __thread window_t thread_Window;
 // __thread uint64_t thread_get_index;
 __thread uint64_t thread_index;
 
+#ifdef HIERARCHICAL_WINDOWS
+// Threads on further sockets share the windows of the first ones
+#ifndef WINDOW_MAX_SOCKETS
+#define WINDOW_MAX_SOCKETS 8
+#endif
+
+/* Windows of the slice of sub-stacks owned by each socket, kept within a budget of the global one */
+volatile padded_window_t socket_Window[WINDOW_MAX_SOCKETS];
+
+__thread window_t thread_GlobalWindow;
+__thread width_t thread_socket;
+__thread width_t thread_slice_start;
+__thread width_t thread_slice_width;
+__thread unsigned long my_global_slide_count;
+__thread unsigned long my_remote_count;
+#endif
+
+/*hop policy variables*/
+__thread width_t thread_hop_stride;
+__thread width_t thread_local_start;
+__thread width_t thread_local_width;
+__thread uint64_t thread_last_push;
+__thread uint64_t thread_last_pop;
+__thread uint64_t thread_hop_chain;
+__thread unsigned long my_hop_hist[HOP_HIST_BUCKETS];
+
 /*functions, descriptor_t defined within the data structure header file*/
 descriptor_t put_window(DS_TYPE* set, uint8_t contention);
 descriptor_t get_window(DS_TYPE* set, uint8_t contention);
 uint64_t random_index(width_t width);
 void initialize_global_window(depth_t depth, width_t width);
+void hop_register(DS_TYPE* set, int thread_id);
+#ifdef HIERARCHICAL_WINDOWS
+void window_register(DS_TYPE* set, int thread_id);
+#endif
 
 #endif
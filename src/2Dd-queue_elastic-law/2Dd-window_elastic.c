@@ -73,7 +73,7 @@ descriptor_t put_window(DS_TYPE* set, uint8_t contention)
 	while(1)
 	{
 		//read descriptor
-		descriptor =  set->put_array[thread_put_index].descriptor;
+		descriptor = load_descriptor(&set->put_array[thread_put_index]);
 
 		// Read the global put window and possibly sync
 		lateral_node_t* lat_tail = lateral->tail;
@@ -159,7 +159,7 @@ descriptor_t get_window(DS_TYPE* set, uint8_t contention)
 	{
 
 		//read descriptor
-		descriptor =  set->get_array[thread_get_index].descriptor;
+		descriptor = load_descriptor(&set->get_array[thread_get_index]);
 
 		// Check put count, to see that the queue is not empty. (this is not nice, would be better with segment implementation)
 		if (thread_put_window->max > thread_get_window->max)
@@ -168,7 +168,7 @@ descriptor_t get_window(DS_TYPE* set, uint8_t contention)
 		}
 		else
 		{
-			put_count = set->put_array[thread_get_index].descriptor.put_count;
+			put_count = load_descriptor(&set->put_array[thread_get_index]).put_count;
 		}
 
 		// Read the global get window and possibly sync
@@ -170,9 +170,8 @@ mqueue_t* create_queue(size_t num_threads, width_t width, depth_t depth, width_t
 			printf("ERROR: Memory ran out when allocating queue");
 		node->next = NULL;
 
-		set->put_array[i].descriptor.node = set->get_array[i].descriptor.node = node;
-		set->put_array[i].descriptor.put_count = 0;
-		set->get_array[i].descriptor.get_count = 0;
+		store_descriptor(&set->put_array[i], node, 0);
+		store_descriptor(&set->get_array[i], node, 0);
 	}
 
 	return set;
@@ -213,11 +212,11 @@ static int enq_cae(node_t* volatile *next_loc, node_t* new_node)
 #endif
 }
 
-static int deq_cae(volatile descriptor_t* des_loc, descriptor_t* read_des_loc, descriptor_t* new_des_loc)
+static int deq_cae(index_t* des_loc, descriptor_t* read_des_loc, descriptor_t* new_des_loc)
 {
 #ifdef RELAXATION_TIMER_ANALYSIS
 	// Use timers to track relaxation instead of locks
-	if (CAE(des_loc, read_des_loc, new_des_loc))
+	if (descriptor_cae(des_loc, read_des_loc, new_des_loc))
 	{
 		// Save this count in a local array of (timestamp, )
 		add_relaxed_get(new_des_loc->node->val, get_timestamp());
@@ -228,7 +227,7 @@ static int deq_cae(volatile descriptor_t* des_loc, descriptor_t* read_des_loc, d
 #elif RELAXATION_ANALYSIS
 
 	lock_relaxation_lists();
-	if (CAE(des_loc, read_des_loc, new_des_loc))
+	if (descriptor_cae(des_loc, read_des_loc, new_des_loc))
 	{
 		remove_linear(new_des_loc->node->val);
 		unlock_relaxation_lists();
@@ -240,7 +239,7 @@ static int deq_cae(volatile descriptor_t* des_loc, descriptor_t* read_des_loc, d
 	}
 
 #else
-	return CAE(des_loc, read_des_loc, new_des_loc);
+	return descriptor_cae(des_loc, read_des_loc, new_des_loc);
 #endif
 }
 
@@ -262,7 +261,7 @@ int enqueue(mqueue_t* set, skey_t key, sval_t val, int no_init)
 		tail = descriptor.node; // Use tail->count instead of descriptor->count, as the descriptor can have the wrong count (non-atomic read)
 		// row_t curr_count = tail->count;
 		// ERR: Is this an error in the original algorithm?
-		if (set->put_array[thread_put_index].descriptor.get_count >= thread_PWindow.max) {
+		if (load_descriptor(&set->put_array[thread_put_index]).get_count >= thread_PWindow.max) {
 			continue;
 		}
 
@@ -302,7 +301,7 @@ int enqueue(mqueue_t* set, skey_t key, sval_t val, int no_init)
 			// From the same descriptor, so it must be the same count
 			new_descriptor.node = tail->next;
 
-			if(!CAE(&set->put_array[thread_put_index].descriptor, &descriptor, &new_descriptor))
+			if(!descriptor_cae(&set->put_array[thread_put_index], &descriptor, &new_descriptor))
 			{
 				contention = 1;
 			}
@@ -316,7 +315,7 @@ int enqueue(mqueue_t* set, skey_t key, sval_t val, int no_init)
 		my_put_cas_fail_count+=1;
   }
 
-	CAE(&set->put_array[thread_put_index].descriptor, &descriptor, &new_descriptor);
+	descriptor_cae(&set->put_array[thread_put_index], &descriptor, &new_descriptor);
 
 	return 1;
 }
@@ -342,7 +341,7 @@ sval_t dequeue(mqueue_t* set, int no_init)
 		if (thread_PWindow.max - thread_PWindow.depth < thread_GWindow.max)
 		{
 			// Normal case, where have have to check head and tail, as they can overlap
-			enq_descriptor = set->put_array[thread_get_index].descriptor;
+			enq_descriptor = load_descriptor(&set->put_array[thread_get_index]);
 			tail = enq_descriptor.node;
 			if (unlikely(head == tail))	// Empty, or close to it
 			{
@@ -366,7 +365,7 @@ sval_t dequeue(mqueue_t* set, int no_init)
 					}
 					// new_enq_descriptor.put_count = new_enq_descriptor.node->count;
 
-					if(!CAE(&set->put_array[thread_get_index].descriptor, &enq_descriptor, &new_enq_descriptor))
+					if(!descriptor_cae(&set->put_array[thread_get_index], &enq_descriptor, &new_enq_descriptor))
 					{
 						contention = 1;
 						// TODO: Which controller should we increment here? This basically just happens when we have too few items.
@@ -396,7 +395,7 @@ sval_t dequeue(mqueue_t* set, int no_init)
 			}
 
 
-			if(deq_cae(&set->get_array[thread_get_index].descriptor, &deq_descriptor, &new_deq_descriptor))
+			if(deq_cae(&set->get_array[thread_get_index], &deq_descriptor, &new_deq_descriptor))
 			{
 				free_node(head);
 				if (likely(no_init)) dec_get_controller(&controller, set, thread_GWindow);
@@ -421,8 +420,8 @@ size_t queue_size(mqueue_t *set)
 
 	while(q < set->max_width)
 	{
-		head = set->get_array[q].descriptor.node;
-		tail = set->put_array[q].descriptor.node;
+		head = load_descriptor(&set->get_array[q]).node;
+		tail = load_descriptor(&set->put_array[q]).node;
 		while (head!=tail)	// is this correct? What about halfway done ones?
 		{
 			head = head->next;
@@ -464,7 +463,7 @@ void validate_structure(mqueue_t *set)
 	row_t put_max = global_PWindow.content.max;
 	for (int i = 0; i < put_next_width; i++)
 	{
-		descriptor_t des = set->put_array[i].descriptor;
+		descriptor_t des = load_descriptor(&set->put_array[i]);
 
 		// Check that they all have ok put counts
 		if (des.put_count > put_max)
@@ -475,7 +474,7 @@ void validate_structure(mqueue_t *set)
 	row_t get_max = global_GWindow.content.max;
 	for (int i = 0; i < get_width; i++)
 	{
-		descriptor_t des = set->get_array[i].descriptor;
+		descriptor_t des = load_descriptor(&set->get_array[i]);
 
 		// Check that they all have ok get counts
 		if (des.get_count > get_max)
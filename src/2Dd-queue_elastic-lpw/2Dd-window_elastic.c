@@ -124,7 +124,7 @@ descriptor_t put_window(DS_TYPE* set, uint8_t contention)
 	while(1)
 	{
 		//read descriptor
-		descriptor =  set->put_array[thread_put_index].descriptor;
+		descriptor = load_descriptor(&set->put_array[thread_put_index]);
 
 		// Read the global get window and possibly sync
 		window_word1 = global_PWindow.content.word1;
@@ -223,7 +223,7 @@ descriptor_t get_window(DS_TYPE* set, uint8_t contention)
 	{
 
 		//read descriptor
-		descriptor =  set->get_array[thread_get_index].descriptor;
+		descriptor = load_descriptor(&set->get_array[thread_get_index]);
 
 		if (put_count_lower_bound >= descriptor.get_count)
 		{
@@ -233,7 +233,7 @@ descriptor_t get_window(DS_TYPE* set, uint8_t contention)
 		}
 		else {
 			// Here we must check if the sub-structure is actually empty, which has performance implications
-			put_count = set->put_array[thread_get_index].descriptor.put_count;
+			put_count = load_descriptor(&set->put_array[thread_get_index]).put_count;
 		}
 
 
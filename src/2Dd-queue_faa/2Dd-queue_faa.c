@@ -0,0 +1,476 @@
+#include "2Dd-queue_faa.h"
+#include "2Dd-window.c"
+
+#ifdef RELAXATION_TIMER_ANALYSIS
+#include "relaxation_analysis_timestamps.c"
+#elif RELAXATION_ANALYSIS
+#include "relaxation_analysis_queue.c"
+#elif RELAXATION_LINEARIZATION_TIMESTAMP
+#include "relaxation_linearization_timestamps.c"
+#endif
+
+// Enqueue timers at the tickets, which order the items of a sub-queue, and not at the writes of the cells
+#ifdef RELAXATION_TIMER_ANALYSIS
+__thread uint64_t enq_timestamp;
+#define ENQ_TIMESTAMP (enq_timestamp = get_timestamp());
+#else
+#define ENQ_TIMESTAMP
+#endif
+
+#ifdef RELAXATION_LINEARIZATION_TIMESTAMP
+__thread uint64_t enq_start_timestamp;
+__thread uint64_t enq_end_timestamp;
+__thread uint64_t deq_start_timestamp;
+__thread uint64_t deq_end_timestamp;
+#define ENQ_START_TIMESTAMP (enq_start_timestamp = get_timestamp());
+#define ENQ_END_TIMESTAMP (enq_end_timestamp = get_timestamp());
+#define DEQ_START_TIMESTAMP (deq_start_timestamp = get_timestamp());
+#define DEQ_END_TIMESTAMP (deq_end_timestamp = get_timestamp());
+#else
+#define ENQ_START_TIMESTAMP
+#define ENQ_END_TIMESTAMP
+#define DEQ_START_TIMESTAMP
+#define DEQ_END_TIMESTAMP
+#endif
+
+RETRY_STATS_VARS;
+__thread ssmem_allocator_t *alloc;
+
+#include "latency.h"
+
+#if LATENCY_PARSING == 1
+__thread size_t lat_parsing_get = 0;
+__thread size_t lat_parsing_put = 0;
+__thread size_t lat_parsing_rem = 0;
+#endif /* LATENCY_PARSING == 1 */
+
+/*
+ * Each sub-queue is an array of cells, split into linked segments, where enqueuers and dequeuers take
+ * tickets as in the FAAArrayQueue. The put_count of a sub-queue is its enqueue ticket, taken with a FAA,
+ * and the get_count its dequeue ticket, taken with a CAE of the get descriptor.
+ *
+ * The put window bounds the tickets that may hold items, rather than the tickets taken. An enqueuer whose
+ * ticket is at or past the put window, as other enqueuers took the rest of the row since it read the
+ * descriptor, leaves the cell empty and searches again. A dequeuer only takes a ticket within the get
+ * window, as with a FAA it could not give up a ticket holding an item. A dequeuer reads the cell of its
+ * ticket before the CAE, so taking the ticket also takes the item, which is left in the cell. A dequeuer
+ * finding its cell empty marks it TAKEN first, so the enqueuer of the ticket, if any, enqueues its item at
+ * another ticket, and the ticket is taken without an item.
+ */
+
+void free_segment(segment_t *segment)
+{
+#if GC == 1
+	ssmem_free(alloc, (void *)segment);
+#endif
+}
+
+segment_t *create_segment(uint64_t first)
+{
+#if GC == 1
+	segment_t *segment = ssmem_alloc(alloc, sizeof(segment_t));
+#else
+	segment_t *segment = ssalloc(sizeof(segment_t));
+#endif
+	segment->next = NULL;
+	segment->first = first;
+	memset((void *)segment->cells, 0, sizeof(segment->cells));
+
+#ifdef __tile__
+	MEM_BARRIER;
+#endif
+
+	return segment;
+}
+
+mqueue_t *create_queue(size_t num_threads, uint32_t width, uint64_t depth, uint8_t k_mode, uint64_t relaxation_bound, int thread_id)
+{
+	// Creates the data structure, including windows
+	ssalloc_init();
+#if GC == 1
+	if (alloc == NULL)
+	{
+		alloc = (ssmem_allocator_t *)malloc(sizeof(ssmem_allocator_t));
+		assert(alloc != NULL);
+		ssmem_alloc_init_fs_size(alloc, SSMEM_DEFAULT_MEM_SIZE, SSMEM_GC_FREE_SET_SIZE, thread_id);
+	}
+#endif
+
+	mqueue_t *set;
+
+	/**** calculate width and depth using the relaxation bound ****/
+	if (k_mode == 3)
+	{
+		// maximum width is fixed as a multiple of number of threads
+		width = num_threads * width;
+		if (width < 2)
+		{
+			width = 1;
+			depth = relaxation_bound;
+			relaxation_bound = 0;
+		}
+		else
+		{
+			depth = relaxation_bound / (width - 1);
+			if (depth < 1)
+			{
+				depth = 1;
+				width = (relaxation_bound / depth) + 1;
+			}
+		}
+	}
+	else if (k_mode == 2)
+	{
+		// maximum depth is fixed
+		width = (relaxation_bound / depth) + 1;
+		if (width < 1)
+		{
+			width = 1;
+			depth = relaxation_bound;
+			relaxation_bound = 0;
+		}
+	}
+	else if (k_mode == 1)
+	{
+		// width parameter is fixed
+		if (width < 2)
+		{
+			width = 1;
+			depth = relaxation_bound;
+			relaxation_bound = 0;
+		}
+		else
+		{
+			depth = relaxation_bound / (width - 1);
+			if (depth < 1)
+			{
+				depth = 1;
+				width = (relaxation_bound / depth) + 1;
+			}
+		}
+	}
+	else if (k_mode == 0)
+	{
+		relaxation_bound = depth * (width - 1);
+	}
+	/*************************************************************/
+
+	if ((set = (mqueue_t *)ssalloc_aligned(CACHE_LINE_SIZE, sizeof(mqueue_t))) == NULL)
+	{
+		perror("malloc");
+		exit(1);
+	}
+
+	// Initialize all descriptors to zero (empty)
+	set->get_array = (index_t *)ssalloc_aligned(CACHE_LINE_SIZE, width * sizeof(index_t));
+	set->put_array = (index_t *)ssalloc_aligned(CACHE_LINE_SIZE, width * sizeof(index_t));
+	set->random_hops = 2;
+	set->depth = depth;
+	set->width = width;
+	set->k_mode = k_mode;
+	set->relaxation_bound = relaxation_bound;
+
+	// Initlialize the window variables
+	initialize_global_window(depth);
+
+	uint64_t i;
+	for (i = 0; i < width; i++)
+	{
+		segment_t *segment = create_segment(0);
+		if (segment == NULL)
+			printf("ERROR: Memory ran out when allocating queue");
+
+		set->put_array[i].descriptor.node = set->get_array[i].descriptor.node = segment;
+		set->put_array[i].descriptor.put_count = 0;
+		set->get_array[i].descriptor.get_count = 0;
+	}
+
+	return set;
+}
+
+// The segment of ticket, from one at or before it, linking the segments up to it that are not linked yet
+static segment_t *find_segment(segment_t *segment, uint64_t ticket)
+{
+	while (ticket >= segment->first + FAA_SEGMENT_SIZE)
+	{
+		segment_t *next = segment->next;
+		if (next == NULL)
+		{
+			segment_t *new_segment = create_segment(segment->first + FAA_SEGMENT_SIZE);
+			if (CAS(&segment->next, NULL, new_segment))
+			{
+				next = new_segment;
+			}
+			else
+			{
+				// Never seen by another thread
+				free_segment(new_segment);
+				next = segment->next;
+			}
+		}
+		segment = next;
+	}
+	return segment;
+}
+
+// Moves the put segment of sub-queue index forward to segment, unless it is there or beyond already
+static void advance_put_segment(mqueue_t *set, uint64_t index, segment_t *segment)
+{
+	segment_t *hint = set->put_array[index].descriptor.node;
+
+	while (hint->first < segment->first)
+	{
+		if (CAS(&set->put_array[index].descriptor.node, hint, segment))
+		{
+			return;
+		}
+		hint = set->put_array[index].descriptor.node;
+	}
+}
+
+// Frees the segments of sub-queue index from first up to last, whose tickets are all dequeued. The put
+// segment is moved past them first, so no operation that starts later can load them.
+static void retire_segments(mqueue_t *set, uint64_t index, segment_t *first, segment_t *last)
+{
+	advance_put_segment(set, index, last);
+	while (first != last)
+	{
+		segment_t *next = first->next;
+		free_segment(first);
+		first = next;
+	}
+}
+
+// Takes a ticket of the sub-queue of the put descriptor, and writes val to its cell if the ticket is within the put window
+static int enq_ticket(mqueue_t *set, segment_t *segment, sval_t val)
+{
+	uint64_t ticket = FAI_U64(&set->put_array[thread_index].descriptor.put_count);
+	ENQ_TIMESTAMP;
+
+	if (ticket >= global_PWindow.content.max)
+	{
+		// The rest of the row was taken since the descriptor was read, the cell is left for a dequeuer to skip
+		return false;
+	}
+
+	// The put segment was read before the ticket was taken, so it is at or before the ticket
+	segment_t *ticket_segment = find_segment(segment, ticket);
+	if (ticket_segment != segment)
+	{
+		advance_put_segment(set, thread_index, ticket_segment);
+	}
+
+	// Fails if a dequeuer found the cell empty and took it
+	return CAS(&ticket_segment->cells[ticket - ticket_segment->first], EMPTY, val);
+}
+
+static int enq_faa(mqueue_t *set, segment_t *segment, sval_t val)
+{
+#ifdef RELAXATION_TIMER_ANALYSIS
+	// Use timers to track relaxation instead of locks
+	if (enq_ticket(set, segment, val))
+	{
+		add_relaxed_put(val, enq_timestamp);
+		return true;
+	}
+	return false;
+#elif RELAXATION_ANALYSIS
+	// The ticket and the write are one step under the lock, so a sub-queue holds its items in their linearization order
+	lock_relaxation_lists();
+
+	sval_t count = gen_relaxation_count();
+	if (enq_ticket(set, segment, count))
+	{
+		add_linear(count, 0);
+		unlock_relaxation_lists();
+		return true;
+	}
+	else
+	{
+		unlock_relaxation_lists();
+		return false;
+	}
+#else
+	return enq_ticket(set, segment, val);
+#endif
+}
+
+// Takes the ticket of the get descriptor, whose cell holds val, where a TAKEN cell holds no item
+static int deq_cae(volatile descriptor_t *des_loc, descriptor_t *read_des_loc, descriptor_t *new_des_loc, sval_t val)
+{
+#ifdef RELAXATION_TIMER_ANALYSIS
+	// Use timers to track relaxation instead of locks
+	if (CAE(des_loc, read_des_loc, new_des_loc))
+	{
+		if (val != TAKEN)
+		{
+			add_relaxed_get(val, get_timestamp());
+		}
+		return true;
+	}
+	return false;
+#elif RELAXATION_ANALYSIS
+	lock_relaxation_lists();
+	if (CAE(des_loc, read_des_loc, new_des_loc))
+	{
+		if (val != TAKEN)
+		{
+			remove_linear(val);
+		}
+		unlock_relaxation_lists();
+		return true;
+	}
+	else
+	{
+		unlock_relaxation_lists();
+		return false;
+	}
+#else
+	return CAE(des_loc, read_des_loc, new_des_loc);
+#endif
+}
+
+int enqueue(mqueue_t *set, skey_t key, sval_t val)
+{
+	ENQ_START_TIMESTAMP;
+	uint8_t contention = 0;
+	descriptor_t descriptor;
+
+	while (1)
+	{
+		descriptor = put_window(set, contention);
+
+		if (enq_faa(set, descriptor.node, val))
+		{
+			break;
+		}
+		contention = 1;
+		my_put_cas_fail_count += 1;
+	}
+	ENQ_END_TIMESTAMP;
+
+#ifdef RELAXATION_LINEARIZATION_TIMESTAMP
+	add_relaxed_put(val, enq_start_timestamp, enq_end_timestamp);
+#endif
+
+	return 1;
+}
+
+sval_t dequeue(mqueue_t *set)
+{
+	DEQ_START_TIMESTAMP;
+	sval_t val;
+	uint8_t contention = 0;
+	uint64_t ticket;
+	descriptor_t descriptor, new_descriptor;
+	segment_t *segment;
+	volatile sval_t *cell;
+
+	while (1)
+	{
+		descriptor = get_window(set, contention);
+		ticket = descriptor.get_count;
+
+		if (unlikely(ticket >= set->put_array[thread_index].descriptor.put_count))
+		{
+			my_null_count += 1;
+			return 0;
+		}
+
+		// Not read atomically, a segment past the ticket is from a later dequeue and the CAE would fail
+		if (unlikely(ticket < descriptor.node->first))
+		{
+			contention = 1;
+			continue;
+		}
+
+		segment = find_segment(descriptor.node, ticket);
+		cell = &segment->cells[ticket - segment->first];
+		val = *cell;
+		if (val == EMPTY)
+		{
+			// The enqueuer of the ticket has not written the cell yet, or left it, and enqueues elsewhere
+			CAS(cell, EMPTY, TAKEN);
+			val = *cell;
+		}
+
+		// The item stays in the cell, as only the dequeuer of the ticket takes it
+		new_descriptor.node = segment;
+		new_descriptor.get_count = ticket + 1;
+		if (deq_cae(&set->get_array[thread_index].descriptor, &descriptor, &new_descriptor, val))
+		{
+			if (segment != descriptor.node)
+			{
+				retire_segments(set, thread_index, descriptor.node, segment);
+			}
+
+			if (val != TAKEN)
+			{
+				DEQ_END_TIMESTAMP;
+#ifdef RELAXATION_LINEARIZATION_TIMESTAMP
+				add_relaxed_get(val, deq_start_timestamp, deq_end_timestamp);
+#endif
+				return val;
+			}
+		}
+		else
+		{
+			contention = 1;
+		}
+		my_get_cas_fail_count += 1;
+	}
+}
+
+size_t queue_size(mqueue_t *set)
+{
+	size_t size = 0;
+	segment_t *segment;
+	uint64_t ticket, put_count;
+	sval_t val;
+
+	for (int q = 0; q < set->width; q++)
+	{
+		segment = set->get_array[q].descriptor.node;
+		ticket = set->get_array[q].descriptor.get_count;
+		put_count = set->put_array[q].descriptor.put_count;
+
+		if (ticket < segment->first)
+		{
+			ticket = segment->first;
+		}
+		for (; ticket < put_count; ticket++)
+		{
+			while (segment != NULL && ticket >= segment->first + FAA_SEGMENT_SIZE)
+			{
+				segment = segment->next;
+			}
+			if (segment == NULL)
+			{
+				break;
+			}
+
+			val = segment->cells[ticket - segment->first];
+			if (val != EMPTY && val != TAKEN)
+			{
+				size += 1;
+			}
+		}
+	}
+
+	return size;
+}
+
+mqueue_t *queue_register(mqueue_t *set, int thread_id)
+{
+	ssalloc_init();
+#if GC == 1
+	if (alloc == NULL)
+	{
+		alloc = (ssmem_allocator_t *)malloc(sizeof(ssmem_allocator_t));
+		assert(alloc != NULL);
+		ssmem_alloc_init_fs_size(alloc, SSMEM_DEFAULT_MEM_SIZE, SSMEM_GC_FREE_SET_SIZE, thread_id);
+	}
+#endif
+
+	return set;
+}
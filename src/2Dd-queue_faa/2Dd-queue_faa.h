@@ -0,0 +1,116 @@
+#ifndef TWODd_queue_faa
+#define TWODd_queue_faa
+
+#include <assert.h>
+#include <getopt.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/time.h>
+#include <time.h>
+#include <stdint.h>
+#include "common.h"
+
+#include "lock_if.h"
+#include "ssmem.h"
+#include "utils.h"
+
+#ifdef RELAXATION_TIMER_ANALYSIS
+#include "relaxation_analysis_timestamps.h"
+#elif RELAXATION_ANALYSIS
+#include "relaxation_analysis_queue.h"
+#endif
+
+
+ /* ################################################################### *
+	* Definition of macros: per data structure
+* ################################################################### */
+
+#define DS_ADD(s,k,v)       enqueue(s,k,v)
+#define DS_REMOVE(s)        dequeue(s)
+#define DS_SIZE(s)          queue_size(s)
+#define DS_REGISTER(s,i)    queue_register(s,i)
+#define DS_NEW(n,w,d,m,k,i) create_queue(n,w,d,m,k,i)
+
+#define DS_TYPE             mqueue_t
+#define DS_HANDLE           mqueue_t*
+#define DS_NODE             sval_t
+
+// A cell not yet enqueued to, and one a dequeuer has taken or given up on
+#define EMPTY               ((sval_t)0)
+#define TAKEN               ((sval_t)-1)
+
+// Cells per segment of a sub-queue
+#ifndef FAA_SEGMENT_SIZE
+#define FAA_SEGMENT_SIZE    1024
+#endif
+
+/* Type definitions */
+
+// Item i of a sub-queue, its i:th ticket, is in cell i - first of the segment with first <= i < first + FAA_SEGMENT_SIZE
+typedef struct mqueue_segment
+{
+	struct mqueue_segment* volatile next;
+	uint64_t first;
+
+	uint8_t padding[CACHE_LINE_SIZE - sizeof(struct mqueue_segment*) - sizeof(uint64_t)];
+	volatile sval_t cells[FAA_SEGMENT_SIZE];
+} segment_t;
+
+// The put_count (get_count) is the next ticket to enqueue (dequeue) at this sub-queue. The put segment is
+// a hint that is never ahead of the last ticket taken, and the get segment holds ticket get_count - 1.
+typedef struct file_descriptor
+{
+	segment_t* node;
+	union
+	{
+		uint64_t put_count;
+		uint64_t get_count;
+	};
+} descriptor_t;
+
+typedef ALIGNED(CACHE_LINE_SIZE) struct array_index
+{
+	volatile descriptor_t descriptor;
+	uint8_t padding[CACHE_LINE_SIZE - sizeof(descriptor_t)];
+} index_t;
+
+typedef ALIGNED(CACHE_LINE_SIZE) struct mqueue_file
+{
+	// Contains all constant information about the data structure
+	index_t *get_array;
+	index_t *put_array;
+	uint64_t random_hops;
+	uint64_t relaxation_bound;
+    uint64_t depth;
+	uint32_t width;
+	uint8_t k_mode;
+	uint8_t padding[CACHE_LINE_SIZE - sizeof(uint8_t) - (2 * sizeof(index_t*)) - (sizeof(uint64_t)*3) - sizeof(uint32_t)];
+} mqueue_t;
+
+/*Global variables*/
+
+
+/*Thread local variables*/
+extern __thread ssmem_allocator_t* alloc;
+extern __thread int thread_id;
+
+extern __thread unsigned long my_put_cas_fail_count;
+extern __thread unsigned long my_get_cas_fail_count;
+extern __thread unsigned long my_null_count;
+extern __thread unsigned long my_hop_count;
+extern __thread unsigned long my_slide_count;
+
+/* Interfaces */
+int enqueue(mqueue_t *set, skey_t key, sval_t val);
+sval_t dequeue(mqueue_t *set);
+segment_t* create_segment(uint64_t first);
+void free_segment(segment_t* segment);
+mqueue_t* create_queue(size_t num_threads, uint32_t width, uint64_t depth, uint8_t k_mode, uint64_t relaxation_bound, int thread_id);
+mqueue_t* queue_register(mqueue_t* set, int thread_id);
+size_t queue_size(mqueue_t *set);
+int floor_log_2(unsigned int n);
+
+#endif
@@ -39,6 +39,9 @@ __thread size_t lat_parsing_put = 0;
 __thread size_t lat_parsing_rem = 0;
 #endif /* LATENCY_PARSING == 1 */
 
+#ifdef UNROLLED_NODES
+#include "2Dd-queue_unrolled.c"
+#else
 void free_node(node_t *node)
 {
 #if GC == 1
@@ -46,15 +49,23 @@ void free_node(node_t *node)
 #endif
 }
 
+#ifdef PAYLOAD_INLINE
+node_t *create_node(const payload_t *val, node_t *next)
+#else
 node_t *create_node(skey_t key, sval_t val, node_t *next)
+#endif
 {
 #if GC == 1
 	node_t *node = ssmem_alloc(alloc, sizeof(node_t));
 #else
 	node_t *node = ssalloc(sizeof(node_t));
 #endif
+#ifdef PAYLOAD_INLINE
+	node->val = *val;
+#else
 	node->key = key;
 	node->val = val;
+#endif
 	node->next = next;
 
 #ifdef __tile__
@@ -63,6 +74,7 @@ node_t *create_node(skey_t key, sval_t val, node_t *next)
 
 	return node;
 }
+#endif
 
 mqueue_t *create_queue(size_t num_threads, width_t width, depth_t depth, uint8_t k_mode, uint64_t relaxation_bound, int thread_id)
 {
@@ -157,6 +169,16 @@ mqueue_t *create_queue(size_t num_threads, width_t width, depth_t depth, uint8_t
 	set->width = width;
 	set->k_mode = k_mode;
 	set->relaxation_bound = relaxation_bound;
+	set->capacity = 0;
+	set->hop_policy = HOP_DEFAULT;
+#ifdef PACKED_DESCRIPTORS
+	// The counts stay within a few depths of the window they are widened against
+	assert(4 * (uint64_t) depth < PACKED_COUNT_REACH);
+#endif
+#ifdef HIERARCHICAL_WINDOWS
+	set->budget = 0;
+	queue_set_sockets(set, 0, WINDOW_BUDGET);
+#endif
 
 	// Initlialize the window variables
 	initialize_global_window(depth, width);
@@ -171,16 +193,21 @@ mqueue_t *create_queue(size_t num_threads, width_t width, depth_t depth, uint8_t
 		if (node == NULL)
 			printf("ERROR: Memory ran out when allocating queue");
 		node->next = NULL;
+#ifdef UNROLLED_NODES
+		// Counts as full, with the items before item 0
+		node->first = -(row_t)UNROLLED_NODE_SLOTS;
+#endif
 
-		set->put_array[i].descriptor.node = set->get_array[i].descriptor.node = node;
-		set->put_array[i].descriptor.put_count = 0;
-		set->get_array[i].descriptor.get_count = 0;
+		store_descriptor(&set->put_array[i], node, 0);
+		store_descriptor(&set->get_array[i], node, 0);
 	}
 
 	return set;
 }
 
-static int enq_cae(node_t *volatile *next_loc, node_t *new_node)
+#ifndef UNROLLED_NODES
+// Links the nodes from new_node to last_node after the tail, which is more than one for a bulk enqueue
+static int enq_cae(node_t *volatile *next_loc, node_t *new_node, node_t *last_node)
 {
 	node_t *expected = NULL;
 #ifdef RELAXATION_TIMER_ANALYSIS
@@ -188,7 +215,12 @@ static int enq_cae(node_t *volatile *next_loc, node_t *new_node)
 	if (CAE(next_loc, &expected, &new_node))
 	{
 		// Save this count in a local array of (timestamp, )
-		add_relaxed_put(new_node->val, get_timestamp());
+		for (node_t *node = new_node; ; node = node->next)
+		{
+			add_relaxed_put(node->val, get_timestamp());
+			if (node == last_node)
+				break;
+		}
 		return true;
 	}
 	return false;
@@ -198,8 +230,13 @@ static int enq_cae(node_t *volatile *next_loc, node_t *new_node)
 
 	if (CAE(next_loc, &expected, &new_node))
 	{
-		new_node->val = gen_relaxation_count();
-		add_linear(new_node->val, 0);
+		for (node_t *node = new_node; ; node = node->next)
+		{
+			node->val = gen_relaxation_count();
+			add_linear(node->val, 0);
+			if (node == last_node)
+				break;
+		}
 		unlock_relaxation_lists();
 		return true;
 	}
@@ -213,13 +250,19 @@ static int enq_cae(node_t *volatile *next_loc, node_t *new_node)
 #endif
 }
 
-static int deq_cae(volatile descriptor_t *des_loc, descriptor_t *read_des_loc, descriptor_t *new_des_loc)
+// Moves the head past all nodes up to new_des_loc->node, which is more than one for a drain
+static int deq_cae(index_t *des_loc, descriptor_t *read_des_loc, descriptor_t *new_des_loc)
 {
 #ifdef RELAXATION_TIMER_ANALYSIS
 	// Use timers to track relaxation instead of locks
-	if (CAE(des_loc, read_des_loc, new_des_loc))
+	node_t *first_node = read_des_loc->node->next;
+	if (descriptor_cae(des_loc, read_des_loc, new_des_loc))
 	{
 		// Save this count in a local array of (timestamp, )
+		for (node_t *node = first_node; node != new_des_loc->node; node = node->next)
+		{
+			add_relaxed_get(node->val, get_timestamp());
+		}
 		add_relaxed_get(new_des_loc->node->val, get_timestamp());
 		return true;
 	}
@@ -228,8 +271,13 @@ static int deq_cae(volatile descriptor_t *des_loc, descriptor_t *read_des_loc, d
 #elif RELAXATION_ANALYSIS
 
 	lock_relaxation_lists();
-	if (CAE(des_loc, read_des_loc, new_des_loc))
+	node_t *first_node = read_des_loc->node->next;
+	if (descriptor_cae(des_loc, read_des_loc, new_des_loc))
 	{
+		for (node_t *node = first_node; node != new_des_loc->node; node = node->next)
+		{
+			remove_linear(node->val);
+		}
 		remove_linear(new_des_loc->node->val);
 		unlock_relaxation_lists();
 		return true;
@@ -240,29 +288,52 @@ static int deq_cae(volatile descriptor_t *des_loc, descriptor_t *read_des_loc, d
 		return false;
 	}
 #else
-	return CAE(des_loc, read_des_loc, new_des_loc);
+	return descriptor_cae(des_loc, read_des_loc, new_des_loc);
 #endif
 }
 
+#ifdef PAYLOAD_INLINE
+int enqueue_payload(mqueue_t *set, const payload_t *val)
+#else
 int enqueue(mqueue_t *set, skey_t key, sval_t val)
+#endif
 {
 	ENQ_START_TIMESTAMP;
 	node_t *tail;
 	uint8_t contention = 0;
 	descriptor_t descriptor, new_descriptor;
 
-	node_t *new_node = create_node(key, val, NULL);
+	node_t *new_node = NULL;
 	while (1)
 	{
 
 		descriptor = put_window(set, contention);
+		if (unlikely(descriptor.node == NULL))
+		{
+			if (new_node != NULL)
+			{
+				free_node(new_node);
+			}
+			return QUEUE_FULL;
+		}
+		if (new_node == NULL)
+		{
+			// Created once the window has room, so enqueues to a full queue do not churn the allocator
+#ifdef PAYLOAD_INLINE
+			new_node = create_node(val, NULL);
+#else
+			new_node = create_node(key, val, NULL);
+#endif
+		}
+#ifndef HIERARCHICAL_WINDOWS
 		assert(thread_PWindow.max >= thread_GWindow.max);
+#endif
 		assert(descriptor.put_count < thread_PWindow.max);
 
 		tail = descriptor.node; // Use tail->count instead of descriptor->count, as the descriptor can have the wrong count (non-atomic read)
 		// row_t curr_count = tail->count;
 		// ERR: Is this an error in the original algorithm?
-		if (set->put_array[thread_put_index].descriptor.get_count >= thread_PWindow.max)
+		if (load_descriptor(set->put_array, thread_put_index, thread_PWindow.max).put_count >= thread_PWindow.max)
 		{
 			continue;
 		}
@@ -272,7 +343,7 @@ int enqueue(mqueue_t *set, skey_t key, sval_t val)
 
 		if (tail->next == NULL)
 		{
-			if (enq_cae(&tail->next, new_node))
+			if (enq_cae(&tail->next, new_node, new_node))
 			{
 				// Linearization of the enqueue, enqueing the node.
 				break;
@@ -288,7 +359,7 @@ int enqueue(mqueue_t *set, skey_t key, sval_t val)
 			// From the same descriptor, so it must be the same count
 			new_descriptor.node = tail->next;
 
-			if (!CAE(&set->put_array[thread_put_index].descriptor, &descriptor, &new_descriptor))
+			if (!descriptor_cae(&set->put_array[thread_put_index], &descriptor, &new_descriptor))
 			{
 				contention = 1;
 			}
@@ -296,7 +367,7 @@ int enqueue(mqueue_t *set, skey_t key, sval_t val)
 		my_put_cas_fail_count += 1;
 	}
 
-	CAE(&set->put_array[thread_put_index].descriptor, &descriptor, &new_descriptor);
+	descriptor_cae(&set->put_array[thread_put_index], &descriptor, &new_descriptor);
 	ENQ_END_TIMESTAMP;
 #ifdef RELAXATION_LINEARIZATION_TIMESTAMP
 	add_relaxed_put(val, enq_start_timestamp, enq_end_timestamp);
@@ -305,21 +376,28 @@ int enqueue(mqueue_t *set, skey_t key, sval_t val)
 	return 1;
 }
 
+#ifdef PAYLOAD_INLINE
+// Copies the payload out of the node, and returns 0 if empty
+int dequeue_payload(mqueue_t *set, payload_t *val)
+#else
 sval_t dequeue(mqueue_t *set)
+#endif
 {
 	DEQ_START_TIMESTAMP;
+#ifndef PAYLOAD_INLINE
 	sval_t val;
+#endif
 	node_t *head, *tail;
 	uint8_t contention = 0;
 	descriptor_t enq_descriptor, new_enq_descriptor, deq_descriptor, new_deq_descriptor;
-	thread_PWindow.max = global_PWindow.content.max;
+	thread_PWindow.max = put_window_max();
 
 	while (1)
 	{
 		deq_descriptor = get_window(set, contention);
 
 		head = deq_descriptor.node;
-		enq_descriptor = set->put_array[thread_get_index].descriptor;
+		enq_descriptor = load_descriptor_at(set->put_array, thread_get_index, &global_PWindow.content.max);
 
 		if (thread_PWindow.max > thread_GWindow.max)
 		{
@@ -342,7 +420,7 @@ sval_t dequeue(mqueue_t *set)
 				new_enq_descriptor.node = tail->next;
 				new_enq_descriptor.put_count = enq_descriptor.put_count + 1;
 
-				if (!CAE(&set->put_array[thread_get_index].descriptor, &enq_descriptor, &new_enq_descriptor))
+				if (!descriptor_cae(&set->put_array[thread_get_index], &enq_descriptor, &new_enq_descriptor))
 				{
 					contention = 1;
 				}
@@ -355,8 +433,13 @@ sval_t dequeue(mqueue_t *set)
 
 			new_deq_descriptor.get_count = deq_descriptor.get_count + 1;
 
-			if (deq_cae(&set->get_array[thread_get_index].descriptor, &deq_descriptor, &new_deq_descriptor))
+			if (deq_cae(&set->get_array[thread_get_index], &deq_descriptor, &new_deq_descriptor))
 			{
+#ifdef PAYLOAD_INLINE
+				*val = new_deq_descriptor.node->val;
+				free_node(head);
+				return 1;
+#else
 				val = new_deq_descriptor.node->val;
 				free_node(head);
 				DEQ_END_TIMESTAMP
@@ -364,6 +447,7 @@ sval_t dequeue(mqueue_t *set)
 				add_relaxed_get(val, deq_start_timestamp, deq_end_timestamp);
 #endif
 				return val;
+#endif
 			}
 			else
 			{
@@ -382,8 +466,8 @@ size_t queue_size(mqueue_t *set)
 
 	while (q < set->width)
 	{
-		head = set->get_array[q].descriptor.node;
-		tail = set->put_array[q].descriptor.node;
+		head = load_descriptor(set->get_array, q, 0).node;
+		tail = load_descriptor(set->put_array, q, 0).node;
 		while (head != tail)
 		{
 			head = head->next;
@@ -393,6 +477,376 @@ size_t queue_size(mqueue_t *set)
 	}
 	return size;
 }
+#endif
+
+#ifndef PAYLOAD_INLINE
+// Enqueues like enqueue, but backs off and retries while the queue is full
+int enqueue_wait(mqueue_t *set, skey_t key, sval_t val)
+{
+	int res;
+	size_t full = 0;
+	while ((res = enqueue(set, key, val)) == QUEUE_FULL)
+	{
+		do_pause_exp(full++);
+	}
+	return res;
+}
+#endif
+
+#if !defined(UNROLLED_NODES) && !defined(PAYLOAD_INLINE)
+// Reads the put descriptor until two reads agree, as the node and count are not read atomically, and the count only grows
+static inline descriptor_t read_put_descriptor(mqueue_t *set, width_t index)
+{
+	descriptor_t descriptor = load_descriptor_at(set->put_array, index, &global_PWindow.content.max);
+	while (1)
+	{
+		descriptor_t again = load_descriptor_at(set->put_array, index, &global_PWindow.content.max);
+		if (again.node == descriptor.node && again.put_count == descriptor.put_count)
+		{
+			return descriptor;
+		}
+		descriptor = again;
+	}
+}
+
+// Enqueues the n items in order and returns the number enqueued, fewer only once the queue is full. Each
+// sub-queue the put window hands out takes as many items as it has rows left below the window, as one chain
+// of nodes linked with a single CAS, so the items are where n single enqueues could have put them. The keys
+// are set to the items.
+size_t enqueue_bulk(mqueue_t *set, const sval_t *vals, size_t n)
+{
+	size_t done = 0, built = 0;
+	uint8_t contention = 0;
+	descriptor_t descriptor, new_descriptor;
+
+	// Nodes of the next built items, created once the window has room for them
+	node_t *first = NULL, *end = NULL;
+	while (done < n)
+	{
+		descriptor = put_window(set, contention);
+		if (unlikely(descriptor.node == NULL))
+		{
+			break;
+		}
+		contention = 0;
+		if (load_descriptor(set->put_array, thread_put_index, thread_PWindow.max).put_count >= thread_PWindow.max)
+		{
+			continue;
+		}
+
+		size_t count = min(put_window_room(descriptor), n - done);
+		for (; built < count; built++)
+		{
+			node_t *node = create_node(vals[done + built], vals[done + built], NULL);
+			if (first == NULL)
+			{
+				first = node;
+			}
+			else
+			{
+				end->next = node;
+			}
+			end = node;
+		}
+
+		// Cut the chain after count nodes
+		node_t *last = first;
+		for (size_t i = 1; i < count; i++)
+		{
+			last = last->next;
+		}
+		node_t *rest = last->next;
+		last->next = NULL;
+
+		node_t *tail = descriptor.node;
+		if (tail->next == NULL)
+		{
+			if (enq_cae(&tail->next, first, last))
+			{
+				// Other threads may have helped the descriptor onto nodes of the chain, which it then skips
+				new_descriptor.node = last;
+				new_descriptor.put_count = descriptor.put_count + count;
+				while (!descriptor_cae(&set->put_array[thread_put_index], &descriptor, &new_descriptor))
+				{
+					descriptor = read_put_descriptor(set, thread_put_index);
+					if (descriptor.put_count >= new_descriptor.put_count)
+					{
+						break;
+					}
+				}
+				done += count;
+				built -= count;
+				first = rest;
+				continue;
+			}
+		}
+		else
+		{
+			// Try helping pending enqueue
+			new_descriptor.node = tail->next;
+			new_descriptor.put_count = descriptor.put_count + 1;
+			descriptor_cae(&set->put_array[thread_put_index], &descriptor, &new_descriptor);
+		}
+		last->next = rest;
+		contention = 1;
+		my_put_cas_fail_count += 1;
+	}
+
+	// Items left over by a full queue
+	while (built-- > 0)
+	{
+		node_t *next = first->next;
+		free_node(first);
+		first = next;
+	}
+	return done;
+}
+
+// Dequeues up to n items into vals and returns the number dequeued, fewer only once the queue is empty. Each
+// sub-queue the get window hands out gives up to the items it has below the window, which are taken by moving
+// its get descriptor past all of them with a single CAS.
+size_t dequeue_bulk(mqueue_t *set, sval_t *vals, size_t n)
+{
+	size_t done = 0;
+	uint8_t contention = 0;
+	descriptor_t enq_descriptor, new_enq_descriptor, deq_descriptor, new_deq_descriptor;
+	thread_PWindow.max = put_window_max();
+
+	while (done < n)
+	{
+		deq_descriptor = get_window(set, contention);
+		contention = 0;
+		node_t *head = deq_descriptor.node;
+		enq_descriptor = read_put_descriptor(set, thread_get_index);
+
+		size_t count = enq_descriptor.put_count > deq_descriptor.get_count ? enq_descriptor.put_count - deq_descriptor.get_count : 0;
+		if (unlikely(count == 0))
+		{
+			if (head->next == NULL)
+			{
+				my_null_count += 1;
+				break;
+			}
+			if (head == enq_descriptor.node)
+			{
+				// Try helping pending enqueue
+				new_enq_descriptor.node = head->next;
+				new_enq_descriptor.put_count = enq_descriptor.put_count + 1;
+				if (!descriptor_cae(&set->put_array[thread_get_index], &enq_descriptor, &new_enq_descriptor))
+				{
+					contention = 1;
+				}
+				continue;
+			}
+			count = 1;
+		}
+		count = min(count, min(get_window_room(deq_descriptor), n - done));
+
+		// Shorter than counted only for a get descriptor read halfway through a change, whose CAS fails anyway
+		node_t *last = head;
+		size_t linked = 0;
+		for (; linked < count && last->next != NULL; linked++)
+		{
+			last = last->next;
+		}
+		if (unlikely(linked == 0))
+		{
+			contention = 1;
+			continue;
+		}
+		count = linked;
+		new_deq_descriptor.node = last;
+		new_deq_descriptor.get_count = deq_descriptor.get_count + count;
+
+		if (deq_cae(&set->get_array[thread_get_index], &deq_descriptor, &new_deq_descriptor))
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				node_t *next = head->next;
+				free_node(head);
+				head = next;
+				vals[done++] = head->val;
+			}
+		}
+		else
+		{
+			contention = 1;
+			my_get_cas_fail_count += 1;
+		}
+	}
+	return done;
+}
+
+// Sub-queues whose chains are walked together by a drain or snapshot
+#ifndef DRAIN_STREAMS
+#define DRAIN_STREAMS 8
+#endif
+
+// Nodes taken from a sub-queue, or read by a snapshot, the items are in the left nodes after node
+typedef struct chain
+{
+	node_t *node;
+	size_t left;
+} chain_t;
+
+#ifndef PACKED_DESCRIPTORS
+// Moves the get descriptor of sub-queue q onto its put descriptor with a single CAS, and returns the number of items
+static size_t detach(mqueue_t *set, width_t q, chain_t *chain)
+{
+	descriptor_t enq_descriptor, deq_descriptor;
+	while (1)
+	{
+		deq_descriptor = load_descriptor_at(set->get_array, q, &global_GWindow.content.max);
+		enq_descriptor = read_put_descriptor(set, q);
+
+		// The get count runs ahead of a put descriptor that is behind a pending enqueue
+		if (enq_descriptor.put_count <= deq_descriptor.get_count)
+		{
+			chain->left = 0;
+			return 0;
+		}
+		if (deq_cae(&set->get_array[q], &deq_descriptor, &enq_descriptor))
+		{
+			chain->node = deq_descriptor.node;
+			chain->left = enq_descriptor.put_count - deq_descriptor.get_count;
+			return chain->left;
+		}
+		my_get_cas_fail_count += 1;
+	}
+}
+
+// Takes every item of the sub-queues with one detach per sub-queue, and returns the number of items visited. This
+// skips the windows, so the drained items are not dequeued in the order they bound, and the get window catches up
+// by shifting past the drained rows. Items enqueued to a sub-queue after the drain passed it are left, so a queue
+// that is no longer enqueued to is empty after one call.
+size_t queue_drain(mqueue_t *set, visit_fn_t visit, void *arg)
+{
+	size_t total = 0;
+	chain_t chains[DRAIN_STREAMS];
+
+	// The chains of DRAIN_STREAMS sub-queues are walked a node at a time in turn, so the cache misses on their
+	// next nodes overlap, rather than each one waiting for the previous one as in a walk of a single chain
+	for (width_t base = 0; base < set->width; base += DRAIN_STREAMS)
+	{
+		width_t streams = set->width - base < DRAIN_STREAMS ? set->width - base : DRAIN_STREAMS;
+		size_t longest = 0;
+		for (width_t i = 0; i < streams; i++)
+		{
+			longest = max(longest, detach(set, base + i, &chains[i]));
+			total += chains[i].left;
+		}
+		for (size_t step = 0; step < longest; step++)
+		{
+			for (width_t i = 0; i < streams; i++)
+			{
+				if (chains[i].left == 0)
+				{
+					continue;
+				}
+				node_t *node = chains[i].node;
+				node_t *next = node->next;
+				free_node(node);
+				chains[i].node = next;
+				chains[i].left--;
+				visit(next->val, arg);
+			}
+		}
+	}
+	return total;
+}
+#endif
+
+// Visits the items of the sub-queues without taking them, and returns the number visited. The sub-queues are read
+// at different times, so under concurrent operations this is an approximate view, which may miss items or see
+// taken ones. Nodes dequeued meanwhile are still readable, as the caller holds back ssmem from reusing them.
+size_t queue_snapshot(mqueue_t *set, visit_fn_t visit, void *arg)
+{
+	size_t total = 0;
+	chain_t chains[DRAIN_STREAMS];
+
+	// Walked like the chains of a drain
+	for (width_t base = 0; base < set->width; base += DRAIN_STREAMS)
+	{
+		width_t streams = set->width - base < DRAIN_STREAMS ? set->width - base : DRAIN_STREAMS;
+		size_t longest = 0;
+		for (width_t i = 0; i < streams; i++)
+		{
+			descriptor_t deq_descriptor = load_descriptor_at(set->get_array, base + i, &global_GWindow.content.max);
+			descriptor_t enq_descriptor = read_put_descriptor(set, base + i);
+			chains[i].node = deq_descriptor.node;
+			chains[i].left = enq_descriptor.put_count > deq_descriptor.get_count ? enq_descriptor.put_count - deq_descriptor.get_count : 0;
+			longest = max(longest, chains[i].left);
+		}
+		for (size_t step = 0; step < longest; step++)
+		{
+			for (width_t i = 0; i < streams; i++)
+			{
+				if (chains[i].left == 0)
+				{
+					continue;
+				}
+				node_t *next = chains[i].node->next;
+				if (next == NULL)
+				{
+					// Shorter than counted, as the descriptors were read at different times
+					chains[i].left = 0;
+					continue;
+				}
+				chains[i].node = next;
+				chains[i].left--;
+				visit(next->val, arg);
+				total++;
+			}
+		}
+	}
+	return total;
+}
+#endif
+
+// Bounds the queue to about capacity items, rounded up to whole depths per sub-queue, 0 lifts the bound.
+// The get window may trail the oldest items by a depth, so the put window runs that much less ahead of it,
+// but at least a depth so that it can always shift once the queue is drained.
+void queue_set_capacity(mqueue_t *set, size_t capacity)
+{
+	if (capacity == 0)
+	{
+		set->capacity = 0;
+		return;
+	}
+	uint64_t rows = (capacity + set->width - 1) / set->width;
+	rows = (rows + set->depth - 1) / set->depth * set->depth;
+	set->capacity = max(set->depth, rows - set->depth);
+}
+
+// Picks the policy of the hops between sub-queues, HOP_DEFAULT for an unknown one. To call before the threads register.
+void queue_set_hop_policy(mqueue_t *set, uint8_t policy)
+{
+	set->hop_policy = policy < HOP_POLICIES ? policy : HOP_DEFAULT;
+}
+
+#ifdef HIERARCHICAL_WINDOWS
+// Splits the sub-queues into one slice per socket, or those of the platform for 0, whose windows may
+// each run budget depths ahead of the global windows. To call before the threads register.
+void queue_set_sockets(mqueue_t *set, width_t sockets, depth_t budget)
+{
+	if (sockets == 0)
+	{
+		sockets = NUMBER_OF_SOCKETS;
+	}
+	sockets = min(sockets, min(set->width, WINDOW_MAX_SOCKETS));
+
+	// The put and the get windows of two sockets may each drift apart by the budget, so the bound is
+	// that of a flat queue which is two budgets deeper
+	set->relaxation_bound -= 2 * (set->width - 1) * set->budget;
+	set->sockets = sockets;
+	set->budget = (row_t)budget * set->depth;
+	set->relaxation_bound += 2 * (set->width - 1) * set->budget;
+#ifdef PACKED_DESCRIPTORS
+	// Sub-queues of other sockets are widened against the global windows, which they may be two budgets from
+	assert(4 * ((uint64_t) set->depth + 2 * set->budget) < PACKED_COUNT_REACH);
+#endif
+}
+#endif
 
 mqueue_t *queue_register(mqueue_t *set, int thread_id)
 {
@@ -408,6 +862,10 @@ mqueue_t *queue_register(mqueue_t *set, int thread_id)
 
 	thread_depth = set->depth;
 	thread_width = set->width;
+#ifdef HIERARCHICAL_WINDOWS
+	window_register(set, thread_id);
+#endif
+	hop_register(set, thread_id);
 
 	return set;
 }
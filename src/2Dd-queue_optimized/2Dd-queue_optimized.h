@@ -17,6 +17,10 @@
 #include "ssmem.h"
 #include "utils.h"
 #include "types.h"
+#include "hop_policy.h"
+#ifdef PACKED_DESCRIPTORS
+#include "packed_descriptor.h"
+#endif
 
 #ifdef RELAXATION_TIMER_ANALYSIS
 #include "relaxation_analysis_timestamps.h"
@@ -29,18 +33,87 @@
 	* Definition of macros: per data structure
 * ################################################################### */
 
+#ifdef PAYLOAD_INLINE
+#include "payload.h"
+#define DS_ADD_PAYLOAD(s,p)     enqueue_payload(s,p)
+#define DS_REMOVE_PAYLOAD(s,p)  dequeue_payload(s,p)
+#else
 #define DS_ADD(s,k,v)       enqueue(s,k,v)
 #define DS_REMOVE(s)        dequeue(s)
+#ifndef UNROLLED_NODES
+#define DS_ADD_BULK(s,v,n)  enqueue_bulk(s,v,n)
+#define DS_REMOVE_BULK(s,v,n) dequeue_bulk(s,v,n)
+#ifndef PACKED_DESCRIPTORS
+// A drain moves get counts onto the put counts, too far from the get window for packed counts
+#define DS_DRAIN(s,f,a)     queue_drain(s,f,a)
+#endif
+#define DS_SNAPSHOT(s,f,a)  queue_snapshot(s,f,a)
+#endif
+#endif
 #define DS_SIZE(s)          queue_size(s)
 #define DS_REGISTER(s,i)    queue_register(s,i)
 #define DS_NEW(n,w,d,m,k,i) create_queue(n,w,d,m,k,i)
 
+// Returned by the enqueues of a queue with a capacity, when the put window can not shift
+#define QUEUE_FULL 0
+
+#ifdef HIERARCHICAL_WINDOWS
+// Depths a socket window may run ahead of the global window
+#ifndef WINDOW_BUDGET
+#define WINDOW_BUDGET 4
+#endif
+#endif
+
 #define DS_TYPE             mqueue_t
 #define DS_HANDLE           mqueue_t*
-#define DS_NODE             node_t
 
 /* Type definitions */
 
+#if defined(UNROLLED_NODES) && defined(PAYLOAD_INLINE)
+#error "Inline payloads are only supported by the sub-queues of one node per item"
+#endif
+
+#if defined(UNROLLED_NODES) && defined(TEST_BULK)
+#error "The bulk operations link and detach chains of one node per item, so UNROLLED=1 has no DS_ADD_BULK or DS_REMOVE_BULK"
+#endif
+
+#if defined(UNROLLED_NODES) && defined(TEST_DRAIN)
+#error "The drain and snapshot walk sub-queues of one node per item, so UNROLLED=1 has no DS_DRAIN"
+#endif
+
+#if defined(PACKED_DESCRIPTORS) && defined(TEST_DRAIN)
+#error "A drain moves get counts onto the put counts, too far from the get window for packed counts, so PACKED=1 has no DS_DRAIN"
+#endif
+
+#ifdef UNROLLED_NODES
+#define DS_NODE             sval_t
+#define EMPTY               ((sval_t)0)
+
+// Items per node, the default fills two cache lines with the node header
+#ifndef UNROLLED_NODE_SLOTS
+#define UNROLLED_NODE_SLOTS 14
+#endif
+
+// Item i of a sub-queue is in slot i - first of the node with first <= i < first + UNROLLED_NODE_SLOTS, and an EMPTY slot is not yet enqueued
+typedef struct mqueue_node
+{
+	struct mqueue_node* volatile next;
+	row_t first;
+	volatile sval_t vals[UNROLLED_NODE_SLOTS];
+} node_t;
+#elif defined(PAYLOAD_INLINE)
+#define DS_NODE             node_t
+
+// The payload is stored in the node, which is padded to whole cache lines
+typedef struct mqueue_node
+{
+	payload_t val;
+	struct mqueue_node* volatile next;
+	uint8_t padding[PAYLOAD_NODE_PADDING(sizeof(payload_t) + sizeof(struct mqueue_node*))];
+} node_t;
+#else
+#define DS_NODE             node_t
+
 typedef struct mqueue_node
 {
 	skey_t key;
@@ -52,7 +125,9 @@ typedef struct mqueue_node
 
 	uint8_t padding[CACHE_LINE_SIZE - 2*sizeof(skey_t) - sizeof(struct mqueue_node*) - sizeof(row_t)];
 } node_t;
+#endif
 
+// The node holds item put_count - 1 (get_count - 1), the last one enqueued (dequeued) at this sub-queue
 typedef struct file_descriptor
 {
 	node_t* node;
@@ -65,8 +140,13 @@ typedef struct file_descriptor
 
 typedef ALIGNED(CACHE_LINE_SIZE) struct array_index
 {
+#ifdef PACKED_DESCRIPTORS
+	volatile packed_descriptor_t descriptor;	// The node and the low bits of the count, see packed_descriptor.h
+	uint8_t padding[CACHE_LINE_SIZE - sizeof(packed_descriptor_t)];
+#else
 	volatile descriptor_t descriptor;
 	uint8_t padding[CACHE_LINE_SIZE - sizeof(descriptor_t)];
+#endif
 } index_t;
 
 typedef ALIGNED(CACHE_LINE_SIZE) struct mqueue_file
@@ -76,12 +156,74 @@ typedef ALIGNED(CACHE_LINE_SIZE) struct mqueue_file
 	index_t *put_array;
 	uint64_t random_hops;
 	uint64_t relaxation_bound;	// Is not updated by elastic changes
+	uint64_t capacity;	// Rows the put window may run ahead of the get window, 0 for unbounded
     volatile depth_t depth;
 	volatile width_t width;
 	uint8_t k_mode;
-	uint8_t padding[CACHE_LINE_SIZE - sizeof(uint8_t) - 2*sizeof(void*) - 2*sizeof(uint64_t) - sizeof(depth_t) - sizeof(width_t)];
+	uint8_t hop_policy;	// One of the HOP_* policies of hop_policy.h
+#ifdef HIERARCHICAL_WINDOWS
+	width_t sockets;	// Sub-queues are split evenly into one slice per socket, with windows of its own
+	row_t budget;	// Rows a socket window may run ahead of the global window
+	uint8_t padding[CACHE_LINE_SIZE - 2*sizeof(uint8_t) - 2*sizeof(void*) - 3*sizeof(uint64_t) - sizeof(depth_t) - 2*sizeof(width_t) - sizeof(row_t)];
+#else
+	uint8_t padding[CACHE_LINE_SIZE - 2*sizeof(uint8_t) - 2*sizeof(void*) - 3*sizeof(uint64_t) - sizeof(depth_t) - sizeof(width_t)];
+#endif
 } mqueue_t;
 
+// The descriptor of sub-queue index of array. A packed count is widened against reference, the max of the put
+// (get) window the caller compares it with, which must still be current after the read for the count to be right.
+static inline descriptor_t load_descriptor(index_t* array, width_t index, row_t reference)
+{
+#ifdef PACKED_DESCRIPTORS
+	packed_descriptor_t word = array[index].descriptor;
+	descriptor_t descriptor;
+	descriptor.node = (node_t*) packed_node(word);
+	descriptor.put_count = packed_count(word, reference);
+	return descriptor;
+#else
+	return array[index].descriptor;
+#endif
+}
+
+// Reads the descriptor like load_descriptor, for callers that do not check a window of their own afterwards,
+// against the max at window read before and after it. The windows only move up, so it held meanwhile.
+static inline descriptor_t load_descriptor_at(index_t* array, width_t index, volatile row_t* window)
+{
+#ifdef PACKED_DESCRIPTORS
+	row_t reference;
+	descriptor_t descriptor;
+	do
+	{
+		reference = *window;
+		descriptor = load_descriptor(array, index, reference);
+	} while (reference != *window);
+	return descriptor;
+#else
+	return array[index].descriptor;
+#endif
+}
+
+static inline void store_descriptor(index_t* des_loc, node_t* node, row_t count)
+{
+#ifdef PACKED_DESCRIPTORS
+	des_loc->descriptor = pack_descriptor(node, count);
+#else
+	des_loc->descriptor.node = node;
+	des_loc->descriptor.put_count = count;
+#endif
+}
+
+// Swaps the descriptor of des_loc from read_des_loc to new_des_loc, with an 8-byte CAS if packed. Only the CAE
+// of unpacked descriptors reads the descriptor into read_des_loc if it fails, so callers read it again.
+static inline int descriptor_cae(index_t* des_loc, descriptor_t* read_des_loc, descriptor_t* new_des_loc)
+{
+#ifdef PACKED_DESCRIPTORS
+	return CAS(&des_loc->descriptor, pack_descriptor(read_des_loc->node, read_des_loc->put_count), pack_descriptor(new_des_loc->node, new_des_loc->put_count));
+#else
+	return CAE(&des_loc->descriptor, read_des_loc, new_des_loc);
+#endif
+}
+
 /*Global variables*/
 
 
@@ -94,17 +236,47 @@ extern __thread unsigned long my_get_cas_fail_count;
 extern __thread unsigned long my_null_count;
 extern __thread unsigned long my_hop_count;
 extern __thread unsigned long my_slide_count;
+extern __thread unsigned long my_hop_hist[HOP_HIST_BUCKETS];
+#ifdef HIERARCHICAL_WINDOWS
+extern __thread unsigned long my_global_slide_count;
+extern __thread unsigned long my_remote_count;
+#endif
 
 /* Interfaces */
+#ifdef PAYLOAD_INLINE
+int enqueue_payload(mqueue_t *set, const payload_t *val);
+int dequeue_payload(mqueue_t *set, payload_t *val);
+#else
 int enqueue(mqueue_t *set, skey_t key, sval_t val);
+int enqueue_wait(mqueue_t *set, skey_t key, sval_t val);
 sval_t dequeue(mqueue_t *set);
+#ifndef UNROLLED_NODES
+size_t enqueue_bulk(mqueue_t *set, const sval_t *vals, size_t n);
+size_t dequeue_bulk(mqueue_t *set, sval_t *vals, size_t n);
+#ifndef PACKED_DESCRIPTORS
+size_t queue_drain(mqueue_t *set, visit_fn_t visit, void *arg);
+#endif
+size_t queue_snapshot(mqueue_t *set, visit_fn_t visit, void *arg);
+#endif
+#endif
 mqueue_t* create_queue(size_t num_threads, width_t width, depth_t depth, uint8_t k_mode, uint64_t relaxation_bound, int thread_id);
 mqueue_t* queue_register(mqueue_t* set, int thread_id);
 size_t queue_size(mqueue_t *set);
+void queue_set_capacity(mqueue_t *set, size_t capacity);
+void queue_set_hop_policy(mqueue_t *set, uint8_t policy);
+#ifdef HIERARCHICAL_WINDOWS
+void queue_set_sockets(mqueue_t *set, width_t sockets, depth_t budget);
+#endif
 int floor_log_2(unsigned int n);
 
 // Mainly for internal use
+#ifdef UNROLLED_NODES
+node_t* create_node(row_t first, sval_t val);
+#elif defined(PAYLOAD_INLINE)
+node_t* create_node(const payload_t *val, node_t* next);
+#else
 node_t* create_node(skey_t key, sval_t val, node_t* next);
+#endif
 void free_node(node_t* node);
 
 #endif
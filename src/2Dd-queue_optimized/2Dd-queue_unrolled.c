@@ -0,0 +1,354 @@
+// Sub-queues of unrolled nodes, included by 2Dd-queue_optimized.c when compiled with UNROLLED_NODES.
+// An enqueue places its item in the next slot of the tail node, and only allocates and links a node when the
+// tail node is full. The windows are unchanged, as they only look at the descriptor counts.
+
+void free_node(node_t *node)
+{
+#if GC == 1
+	ssmem_free(alloc, (void *)node);
+#endif
+}
+
+node_t *create_node(row_t first, sval_t val)
+{
+#if GC == 1
+	node_t *node = ssmem_alloc(alloc, sizeof(node_t));
+#else
+	node_t *node = ssalloc(sizeof(node_t));
+#endif
+	node->next = NULL;
+	node->first = first;
+	node->vals[0] = val;
+	for (int i = 1; i < UNROLLED_NODE_SLOTS; i++)
+	{
+		node->vals[i] = EMPTY;
+	}
+
+#ifdef __tile__
+	MEM_BARRIER;
+#endif
+
+	return node;
+}
+
+// Slot after the last item of the descriptor, UNROLLED_NODE_SLOTS if the next item starts a new node, and 0 if
+// the descriptor was read torn between two versions, as the node and count are not read atomically
+static inline row_t next_slot(descriptor_t *descriptor)
+{
+	row_t slot = descriptor->put_count - descriptor->node->first;
+	return slot <= UNROLLED_NODE_SLOTS ? slot : 0;
+}
+
+// Node of the item after the one in slot, where the slot is updated to that of the item. This must be read
+// after the tail or window that shows that the item is in place, as the node might be linked just before that.
+static inline node_t *item_node(node_t *node, row_t *slot)
+{
+	if (*slot == UNROLLED_NODE_SLOTS)
+	{
+		*slot = 0;
+		return node->next;
+	}
+	return node;
+}
+
+// Places the item in a free slot of the tail node
+static int enq_slot_cae(volatile sval_t *slot_loc, sval_t val)
+{
+	sval_t expected = EMPTY;
+#ifdef RELAXATION_TIMER_ANALYSIS
+	// Use timers to track relaxation instead of locks
+	if (CAE(slot_loc, &expected, &val))
+	{
+		add_relaxed_put(val, get_timestamp());
+		return true;
+	}
+	return false;
+
+#elif RELAXATION_ANALYSIS
+	lock_relaxation_lists();
+
+	if (CAE(slot_loc, &expected, &val))
+	{
+		*slot_loc = gen_relaxation_count();
+		add_linear(*slot_loc, 0);
+		unlock_relaxation_lists();
+		return true;
+	}
+	else
+	{
+		unlock_relaxation_lists();
+		return false;
+	}
+#else
+	return CAE(slot_loc, &expected, &val);
+#endif
+}
+
+// Links a new node, holding the item in its first slot, after the full tail node
+static int enq_cae(node_t *volatile *next_loc, node_t *new_node)
+{
+	node_t *expected = NULL;
+#ifdef RELAXATION_TIMER_ANALYSIS
+	// Use timers to track relaxation instead of locks
+	if (CAE(next_loc, &expected, &new_node))
+	{
+		add_relaxed_put(new_node->vals[0], get_timestamp());
+		return true;
+	}
+	return false;
+
+#elif RELAXATION_ANALYSIS
+	lock_relaxation_lists();
+
+	if (CAE(next_loc, &expected, &new_node))
+	{
+		new_node->vals[0] = gen_relaxation_count();
+		add_linear(new_node->vals[0], 0);
+		unlock_relaxation_lists();
+		return true;
+	}
+	else
+	{
+		unlock_relaxation_lists();
+		return false;
+	}
+#else
+	return CAE(next_loc, &expected, &new_node);
+#endif
+}
+
+// Moves the head past the item at item_loc, which is read into val before the CAS
+static int deq_cae(index_t *des_loc, descriptor_t *read_des_loc, descriptor_t *new_des_loc, volatile sval_t *item_loc, sval_t *val)
+{
+#ifdef RELAXATION_TIMER_ANALYSIS
+	// Use timers to track relaxation instead of locks
+	*val = *item_loc;
+	if (descriptor_cae(des_loc, read_des_loc, new_des_loc))
+	{
+		add_relaxed_get(*val, get_timestamp());
+		return true;
+	}
+	return false;
+
+#elif RELAXATION_ANALYSIS
+
+	// Read under the lock, as enqueuers replace the items with relaxation counts while holding it
+	lock_relaxation_lists();
+	*val = *item_loc;
+	if (descriptor_cae(des_loc, read_des_loc, new_des_loc))
+	{
+		remove_linear(*val);
+		unlock_relaxation_lists();
+		return true;
+	}
+	else
+	{
+		unlock_relaxation_lists();
+		return false;
+	}
+#else
+	*val = *item_loc;
+	return descriptor_cae(des_loc, read_des_loc, new_des_loc);
+#endif
+}
+
+int enqueue(mqueue_t *set, skey_t key, sval_t val)
+{
+	ENQ_START_TIMESTAMP;
+	node_t *tail, *next, *new_node = NULL;
+	uint8_t contention = 0;
+	descriptor_t descriptor, new_descriptor;
+
+	while (1)
+	{
+
+		descriptor = put_window(set, contention);
+		if (unlikely(descriptor.node == NULL))
+		{
+			if (new_node != NULL)
+			{
+				free_node(new_node);
+			}
+			return QUEUE_FULL;
+		}
+#ifndef HIERARCHICAL_WINDOWS
+		assert(thread_PWindow.max >= thread_GWindow.max);
+#endif
+		assert(descriptor.put_count < thread_PWindow.max);
+
+		tail = descriptor.node;
+		if (load_descriptor(set->put_array, thread_put_index, thread_PWindow.max).put_count >= thread_PWindow.max)
+		{
+			continue;
+		}
+
+		row_t slot = next_slot(&descriptor);
+		if (unlikely(slot == 0))
+		{
+			continue;
+		}
+
+		new_descriptor.put_count = descriptor.put_count + 1;
+
+		if (slot < UNROLLED_NODE_SLOTS)
+		{
+			new_descriptor.node = tail;
+
+			if (tail->vals[slot] == EMPTY)
+			{
+				if (enq_slot_cae(&tail->vals[slot], val))
+				{
+					// Linearization of the enqueue, filling the slot.
+					break;
+				}
+				else
+				{
+					contention = 1;
+				}
+			}
+			else if (!descriptor_cae(&set->put_array[thread_put_index], &descriptor, &new_descriptor))
+			{
+				// Tried helping pending enqueue
+				contention = 1;
+			}
+		}
+		else if ((next = tail->next) == NULL)
+		{
+			if (new_node == NULL)
+			{
+				new_node = create_node(descriptor.put_count, val);
+			}
+			else
+			{
+				new_node->first = descriptor.put_count;
+			}
+			new_descriptor.node = new_node;
+
+			if (enq_cae(&tail->next, new_node))
+			{
+				// Linearization of the enqueue, enqueing the node.
+				new_node = NULL;
+				break;
+			}
+			else
+			{
+				contention = 1;
+			}
+		}
+		else
+		{
+			// Try helping pending enqueue
+			new_descriptor.node = next;
+
+			if (!descriptor_cae(&set->put_array[thread_put_index], &descriptor, &new_descriptor))
+			{
+				contention = 1;
+			}
+		}
+		my_put_cas_fail_count += 1;
+	}
+
+	descriptor_cae(&set->put_array[thread_put_index], &descriptor, &new_descriptor);
+	if (new_node != NULL)
+	{
+		// Created for a full tail node, but the item went into a slot after all
+		free_node(new_node);
+	}
+	ENQ_END_TIMESTAMP;
+#ifdef RELAXATION_LINEARIZATION_TIMESTAMP
+	add_relaxed_put(val, enq_start_timestamp, enq_end_timestamp);
+#endif
+
+	return 1;
+}
+
+sval_t dequeue(mqueue_t *set)
+{
+	DEQ_START_TIMESTAMP;
+	sval_t val;
+	node_t *head, *node;
+	row_t slot;
+	uint8_t contention = 0;
+	descriptor_t enq_descriptor, new_enq_descriptor, deq_descriptor, new_deq_descriptor;
+	thread_PWindow.max = put_window_max();
+
+	while (1)
+	{
+		deq_descriptor = get_window(set, contention);
+
+		head = deq_descriptor.node;
+		slot = next_slot(&deq_descriptor);
+		if (unlikely(slot == 0))
+		{
+			continue;
+		}
+
+		if (thread_PWindow.max > thread_GWindow.max)
+		{
+			// Don't have to read tail, potentially saving a cache miss (especially in prod/con)
+			goto safe_deq;
+		}
+
+		enq_descriptor = load_descriptor_at(set->put_array, thread_get_index, &global_PWindow.content.max);
+
+		if (unlikely(deq_descriptor.get_count >= enq_descriptor.put_count)) // Empty, or close to it
+		{
+			node = item_node(head, &slot);
+			if (node == NULL || node->vals[slot] == EMPTY)
+			{
+				my_null_count += 1;
+				return 0;
+			}
+			else if (deq_descriptor.get_count == enq_descriptor.put_count)
+			{
+				// Try helping pending enqueue
+				new_enq_descriptor.node = node;
+				new_enq_descriptor.put_count = enq_descriptor.put_count + 1;
+
+				if (!descriptor_cae(&set->put_array[thread_get_index], &enq_descriptor, &new_enq_descriptor))
+				{
+					contention = 1;
+				}
+			}
+		}
+		else // Can dequeue without worrying about tail
+		{
+		safe_deq:
+			node = item_node(head, &slot);
+			new_deq_descriptor.node = node;
+
+			new_deq_descriptor.get_count = deq_descriptor.get_count + 1;
+
+			if (deq_cae(&set->get_array[thread_get_index], &deq_descriptor, &new_deq_descriptor, &node->vals[slot], &val))
+			{
+				if (node != head)
+				{
+					free_node(head);
+				}
+				DEQ_END_TIMESTAMP
+#ifdef RELAXATION_LINEARIZATION_TIMESTAMP
+				add_relaxed_get(val, deq_start_timestamp, deq_end_timestamp);
+#endif
+				return val;
+			}
+			else
+			{
+				contention = 1;
+				my_get_cas_fail_count += 1;
+			}
+		}
+	}
+}
+
+size_t queue_size(mqueue_t *set)
+{
+	size_t size = 0;
+	uint64_t q = 0;
+
+	while (q < set->width)
+	{
+		size += load_descriptor_at(set->put_array, q, &global_PWindow.content.max).put_count - load_descriptor_at(set->get_array, q, &global_GWindow.content.max).get_count;
+		q++;
+	}
+	return size;
+}
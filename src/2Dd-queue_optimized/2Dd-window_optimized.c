@@ -27,31 +27,387 @@ static inline uint64_t max(uint64_t x, uint64_t y)
 }
 
 
-static inline width_t hop(DS_TYPE* set, width_t index, width_t* random, width_t* hops, width_t width)
+// The better of two random sub-queues of [base, base + width), the one with fewer enqueues (dequeues)
+static inline width_t two_choices(DS_TYPE* set, width_t base, width_t width, uint8_t put)
+{
+	width_t a = base + random_index(width);
+	width_t b = base + random_index(width);
+
+	if(put)
+	{
+		return load_descriptor(set->put_array, a, thread_PWindow.max).put_count <= load_descriptor(set->put_array, b, thread_PWindow.max).put_count ? a : b;
+	}
+	return load_descriptor(set->get_array, a, thread_GWindow.max).get_count <= load_descriptor(set->get_array, b, thread_GWindow.max).get_count ? a : b;
+}
+
+// Probes before the sweep over all sub-queues
+static inline width_t hop_probes(DS_TYPE* set, width_t width)
+{
+	switch(set->hop_policy)
+	{
+		case HOP_RANDOM:
+			return width;
+		case HOP_LAST_SUCCESS:
+			return 1;
+		case HOP_STRIDE:
+		case HOP_SOCKET_LOCAL:
+			return 0;
+		default:
+			return set->random_hops;
+	}
+}
+
+// Hops from index to the next sub-queue of [base, base + width) to try, for an enqueue if put is set. The
+// probes are counted in random and the hops of the sweep in hops, which sees every sub-queue within width hops.
+static inline width_t hop(DS_TYPE* set, width_t index, width_t* random, width_t* hops, width_t base, width_t width, uint8_t put)
 {
 	my_hop_count+=1;
+	thread_hop_chain+=1;
 
-	if(*random < set->random_hops)
+	if(*random < hop_probes(set, width))
 	{
 		*random += 1;
-		index = random_index(width);
+		width_t last = put ? thread_last_put : thread_last_get;
+		if(set->hop_policy == HOP_TWO_CHOICES)
+		{
+			return two_choices(set, base, width, put);
+		}
+		if(set->hop_policy == HOP_LAST_SUCCESS && last != index && last >= base && last < base + width)
+		{
+			return last;
+		}
+		return base + random_index(width);
 	}
-	else
+
+	*hops += 1;
+	index -= base;
+	switch(set->hop_policy)
+	{
+		case HOP_STRIDE:
+			index += thread_hop_stride;
+			break;
+		case HOP_SOCKET_LOCAL:
+			return base + hop_local_first(index, *hops, width, thread_local_start - base, thread_local_width);
+		default:
+			index += 1;
+	}
+	if(unlikely(index >= width))
+	{
+		index -= width;
+	}
+
+	return base + index;
+}
+
+// Index a search starts from after contention, within the share of the thread's socket for HOP_SOCKET_LOCAL
+static inline width_t hop_start_index(DS_TYPE* set)
+{
+	if(set->hop_policy == HOP_SOCKET_LOCAL)
+	{
+		return thread_local_start + random_index(thread_local_width);
+	}
+	return random_index(thread_width);
+}
+
+#ifdef HIERARCHICAL_WINDOWS
+/*
+ * Each socket owns a slice of the sub-queues, with a put and get window of its own that shifts by
+ * a depth once the slice is full (drained) as the global windows do in the flat design, but only up
+ * to a budget ahead of the global window. The global windows are only written once a socket has
+ * used up its budget, so in the common case the window lines stay within their sockets.
+ *
+ * The global windows are shifted as in the flat design, once no sub-queue of any socket is below
+ * them, and then straight past the lowest sub-queue. A socket window the global window has moved past
+ * is raised to it. So every sub-queue is at most a depth below the global window and at most the
+ * budget above it, and the queue has the relaxation bound of a flat queue of depth + budget rows.
+ */
+
+// Sub-queues of socket s are [s*width/sockets, (s+1)*width/sockets)
+static inline width_t slice_start(DS_TYPE* set, width_t socket)
+{
+	return (width_t)(((uint32_t) socket * set->width) / set->sockets);
+}
+
+static inline int in_slice(width_t index)
+{
+	return index >= thread_slice_start && index < thread_slice_start + thread_slice_width;
+}
+
+static inline width_t random_slice_index()
+{
+	return thread_slice_start + random_index(thread_slice_width);
+}
+
+// Hops within the slice of this thread's socket
+static inline width_t slice_hop(DS_TYPE* set, width_t index, width_t* random, width_t* hops, uint8_t put)
+{
+	return hop(set, index, random, hops, thread_slice_start, thread_slice_width, put);
+}
+
+// The socket window, or the global window if that has moved past it
+static inline row_t socket_window(volatile padded_window_t* window, volatile padded_window_t* global)
+{
+	return max(window->content.max, global->content.max);
+}
+
+// Shifts the socket window a depth past from, unless another thread already has
+static inline void shift_socket_window(volatile padded_window_t* window, row_t from)
+{
+	window_t old_window, new_window;
+
+	old_window.max = window->content.max;
+	new_window.max = from + thread_depth;
+	if(old_window.max <= from && CAE(&window->content, &old_window, &new_window))
+	{
+		my_slide_count+=1;
+	}
+}
+
+// Puts at the global window once the socket window has used up its budget. A sub-queue below it, on a
+// socket that lags behind, is filled first. Otherwise the global window shifts past the lowest sub-queue.
+// Returns 1 with the descriptor to put at, 0 to retry within the slice and -1 if the queue is full.
+static int put_global(DS_TYPE* set, descriptor_t* descriptor)
+{
+	window_t old_window, new_window;
+	row_t lowest = UINT64_MAX;
+	width_t i, index = random_index(set->width);
+
+	old_window.max = global_PWindow.content.max;
+	for(i = 0; i < set->width; i++)
+	{
+		*descriptor = load_descriptor_at(set->put_array, index, &global_PWindow.content.max);
+		if(descriptor->put_count < old_window.max)
+		{
+			thread_put_index = index;
+			if(!in_slice(index))
+			{
+				my_remote_count+=1;
+			}
+			return 1;
+		}
+		lowest = min(lowest, descriptor->put_count);
+		if(++index == set->width)
+		{
+			index = 0;
+		}
+	}
+
+	if(set->capacity != 0 && old_window.max + thread_depth > global_GWindow.content.max + set->capacity)
 	{
-		*hops += 1;
-		index += 1;
+		return -1;
+	}
 
-		if(unlikely(index >= width))
+	new_window.max = lowest / thread_depth * thread_depth + thread_depth;
+	if(CAE(&global_PWindow.content, &old_window, &new_window))
+	{
+		my_global_slide_count+=1;
+	}
+	return 0;
+}
+
+// Dequeues at the global window once the socket window has used up its budget, or the slice is drained.
+// Items below it, left on another socket, are taken first. Otherwise the global window shifts past the
+// lowest non-empty sub-queue. Returns 1 with the descriptor to take from, 0 to retry within the slice
+// and -1 with the descriptor of an empty sub-queue if all are empty.
+static int get_global(DS_TYPE* set, descriptor_t* descriptor)
+{
+	window_t old_window, new_window;
+	row_t lowest = UINT64_MAX;
+	width_t i, index = random_index(set->width);
+
+	old_window.max = global_GWindow.content.max;
+	for(i = 0; i < set->width; i++)
+	{
+		*descriptor = load_descriptor_at(set->get_array, index, &global_GWindow.content.max);
+		thread_get_index = index;
+		if(descriptor->get_count < load_descriptor_at(set->put_array, index, &global_PWindow.content.max).put_count)
+		{
+			if(descriptor->get_count < old_window.max)
+			{
+				if(!in_slice(index))
+				{
+					my_remote_count+=1;
+				}
+				return 1;
+			}
+			lowest = min(lowest, descriptor->get_count);
+		}
+		if(++index == set->width)
 		{
 			index = 0;
 		}
 	}
 
-	return index;
+	if(lowest == UINT64_MAX)
+	{
+		return -1;
+	}
 
+	new_window.max = lowest / thread_depth * thread_depth + thread_depth;
+	if(CAE(&global_GWindow.content, &old_window, &new_window))
+	{
+		my_global_slide_count+=1;
+	}
+	return 0;
 }
 
-descriptor_t put_window(DS_TYPE* set, uint8_t contention)
+static descriptor_t search_put_window(DS_TYPE* set, uint8_t contention)
+{
+	width_t hops, random;
+	descriptor_t descriptor;
+	volatile padded_window_t* window = &socket_PWindow[thread_socket];
+	int res;
+
+	hops = random = 0;
+
+	if(contention == 1 || !in_slice(thread_put_index))
+	{
+		thread_put_index = random_slice_index();
+		contention = 0;
+	}
+
+	thread_PWindow.max = socket_window(window, &global_PWindow);
+
+	while(1)
+	{
+		//read descriptor
+		descriptor = load_descriptor(set->put_array, thread_put_index, thread_PWindow.max);
+
+		// Read the socket put window and possibly sync
+		row_t smax = socket_window(window, &global_PWindow);
+		if(thread_PWindow.max != smax)
+		{
+			thread_PWindow.max = smax;
+			hops = 0;
+		}
+
+		// Valid index
+		else if(descriptor.put_count < thread_PWindow.max)
+		{
+			thread_get_index = thread_put_index;
+			return descriptor;
+		}
+
+		//hop within the slice
+		else if(hops < thread_slice_width)
+		{
+			thread_put_index = slice_hop(set, thread_put_index, &random, &hops, 1);
+		}
+
+		//shift the socket window, within the budget
+		else if(thread_PWindow.max + thread_depth <= global_PWindow.content.max + set->budget)
+		{
+			// Full, the socket put window would run past the capacity ahead of the socket get window
+			if(set->capacity != 0 && thread_PWindow.max + thread_depth > socket_window(&socket_GWindow[thread_socket], &global_GWindow) + set->capacity)
+			{
+				descriptor.node = NULL;
+				return descriptor;
+			}
+
+			shift_socket_window(window, thread_PWindow.max);
+			hops = 0;
+		}
+
+		//the budget is used up, put at the global window
+		else
+		{
+			res = put_global(set, &descriptor);
+			if(res != 0)
+			{
+				if(res < 0)
+				{
+					descriptor.node = NULL;
+				}
+				// At least the global window the descriptor was compared with
+				thread_PWindow.max = socket_window(window, &global_PWindow);
+				thread_get_index = thread_put_index;
+				return descriptor;
+			}
+			thread_put_index = random_slice_index();
+			hops = 0;
+		}
+	}
+}
+
+static descriptor_t search_get_window(DS_TYPE* set, uint8_t contention)
+{
+	descriptor_t descriptor;
+	row_t put_count;
+	width_t hops, random;
+	uint8_t notempty;
+	volatile padded_window_t* window = &socket_GWindow[thread_socket];
+
+	notempty = hops = random = 0;
+
+	if(contention == 1 || !in_slice(thread_get_index))
+	{
+		thread_get_index = random_slice_index();
+		contention = 0;
+	}
+
+	thread_GWindow.max = socket_window(window, &global_GWindow);
+
+	while(1)
+	{
+
+		//read descriptor
+		descriptor = load_descriptor(set->get_array, thread_get_index, thread_GWindow.max);
+		if (thread_GWindow.max < thread_PWindow.max) {
+			put_count = thread_PWindow.max - thread_depth;
+		}
+		else {
+			put_count = load_descriptor_at(set->put_array, thread_get_index, &global_PWindow.content.max).put_count;
+		}
+		// Read the socket get window and possibly sync
+		row_t smax = socket_window(window, &global_GWindow);
+		if(thread_GWindow.max != smax)
+		{
+			thread_GWindow.max = smax;
+			hops = notempty = 0;
+		}
+
+		// Valid return
+		else if(descriptor.get_count < thread_GWindow.max && descriptor.get_count < put_count)
+		{
+			break;
+		}
+
+		// Hop within the slice
+		else if (hops != thread_slice_width)
+		{
+			if (notempty == 0 && descriptor.get_count < put_count)
+			{
+				notempty = 1;
+			}
+			thread_get_index = slice_hop(set, thread_get_index, &random, &hops, 0);
+		}
+
+		// Shift the socket window, within the budget
+		else if ((notempty || thread_GWindow.max < thread_PWindow.max) && thread_GWindow.max + thread_depth <= global_GWindow.content.max + set->budget)
+		{
+			shift_socket_window(window, thread_GWindow.max);
+			hops = notempty = 0;
+		}
+
+		// The slice is drained or the budget used up, take from the global window
+		else
+		{
+			if(get_global(set, &descriptor) != 0)
+			{
+				// The put window of this socket says nothing about the sub-queues of the others
+				thread_GWindow.max = thread_PWindow.max;
+				break;
+			}
+			thread_get_index = random_slice_index();
+			hops = notempty = 0;
+		}
+	}
+
+	thread_put_index = thread_get_index;
+	return descriptor;
+}
+#else
+static descriptor_t search_put_window(DS_TYPE* set, uint8_t contention)
 {
 	width_t hops, random;
 	descriptor_t descriptor;
@@ -61,7 +417,7 @@ descriptor_t put_window(DS_TYPE* set, uint8_t contention)
 
 	if(contention == 1)
 	{
-		thread_put_index = random_index(thread_width);
+		thread_put_index = hop_start_index(set);
 		contention = 0;
 	}
 
@@ -70,7 +426,7 @@ descriptor_t put_window(DS_TYPE* set, uint8_t contention)
 	while(1)
 	{
 		//read descriptor
-		descriptor =  set->put_array[thread_put_index].descriptor;
+		descriptor = load_descriptor(set->put_array, thread_put_index, thread_PWindow.max);
 
 		// Read the global get window and possibly sync
 		row_t gmax = global_PWindow.content.max;
@@ -90,12 +446,19 @@ descriptor_t put_window(DS_TYPE* set, uint8_t contention)
 		//hop
 		else if(hops < thread_width)
 		{
-			thread_put_index = hop(set, thread_put_index, &random, &hops, thread_width);
+			thread_put_index = hop(set, thread_put_index, &random, &hops, 0, thread_width, 1);
 		}
 
 		//shift window
 		else
 		{
+			// Full, the shift would take the put window past the capacity ahead of the get window
+			if(set->capacity != 0 && thread_PWindow.max + thread_depth > global_GWindow.content.max + set->capacity)
+			{
+				descriptor.node = NULL;
+				return descriptor;
+			}
+
 			// Could skip this
 			if(thread_PWindow.max == global_PWindow.content.max)
 			{
@@ -117,7 +480,7 @@ descriptor_t put_window(DS_TYPE* set, uint8_t contention)
 
 }
 
-descriptor_t get_window(DS_TYPE* set, uint8_t contention)
+static descriptor_t search_get_window(DS_TYPE* set, uint8_t contention)
 {
 	descriptor_t descriptor;
 	window_t new_window;
@@ -129,7 +492,7 @@ descriptor_t get_window(DS_TYPE* set, uint8_t contention)
 
 	if(contention == 1)
 	{
-		thread_get_index = random_index(thread_width);
+		thread_get_index = hop_start_index(set);
 		contention = 0;
 	}
 
@@ -139,12 +502,12 @@ descriptor_t get_window(DS_TYPE* set, uint8_t contention)
 	{
 
 		//read descriptor
-		descriptor =  set->get_array[thread_get_index].descriptor;
+		descriptor = load_descriptor(set->get_array, thread_get_index, thread_GWindow.max);
 		if (thread_GWindow.max < thread_PWindow.max) {
 			put_count = thread_PWindow.max - thread_depth;
 		}
 		else {
-			put_count = set->put_array[thread_get_index].descriptor.put_count;
+			put_count = load_descriptor_at(set->put_array, thread_get_index, &global_PWindow.content.max).put_count;
 		}
 		// Read the global get window and possibly sync
 		row_t gmax = global_GWindow.content.max;
@@ -168,7 +531,7 @@ descriptor_t get_window(DS_TYPE* set, uint8_t contention)
 			{
 				notempty = 1;
 			}
-			thread_get_index = hop(set, thread_get_index, &random, &hops, thread_width);
+			thread_get_index = hop(set, thread_get_index, &random, &hops, 0, thread_width, 0);
 		}
 
 		// Shift window
@@ -202,6 +565,85 @@ descriptor_t get_window(DS_TYPE* set, uint8_t contention)
 	thread_put_index = thread_get_index;
 	return descriptor;
 }
+#endif
+
+static inline int hop_local(width_t index)
+{
+	return index >= thread_local_start && index < thread_local_start + thread_local_width;
+}
+
+// Searches like search_put_window (search_get_window), and counts the hops of the search in the histogram
+descriptor_t put_window(DS_TYPE* set, uint8_t contention)
+{
+	descriptor_t descriptor;
+
+	thread_hop_chain = 0;
+	if(set->hop_policy == HOP_SOCKET_LOCAL && !hop_local(thread_put_index))
+	{
+		thread_put_index = hop_start_index(set);
+	}
+	descriptor = search_put_window(set, contention);
+
+	my_hop_hist[hop_hist_bucket(thread_hop_chain)] += 1;
+	if(thread_hop_chain != 0)
+	{
+		thread_last_put = thread_put_index;
+	}
+	return descriptor;
+}
+
+descriptor_t get_window(DS_TYPE* set, uint8_t contention)
+{
+	descriptor_t descriptor;
+
+	thread_hop_chain = 0;
+	if(set->hop_policy == HOP_SOCKET_LOCAL && !hop_local(thread_get_index))
+	{
+		thread_get_index = hop_start_index(set);
+	}
+	descriptor = search_get_window(set, contention);
+
+	my_hop_hist[hop_hist_bucket(thread_hop_chain)] += 1;
+	if(thread_hop_chain != 0)
+	{
+		thread_last_get = thread_get_index;
+	}
+	return descriptor;
+}
+
+// The put window the dequeues of this thread compare their get window with
+static inline row_t put_window_max()
+{
+#ifdef HIERARCHICAL_WINDOWS
+	return socket_window(&socket_PWindow[thread_socket], &global_PWindow);
+#else
+	return global_PWindow.content.max;
+#endif
+}
+
+// Items the sub-queue of the descriptor from the last put_window can take before it reaches the window
+static inline row_t put_window_room(descriptor_t descriptor)
+{
+#ifdef HIERARCHICAL_WINDOWS
+	// A spill into the slice of another socket is only bounded by the global window
+	row_t window = in_slice(thread_put_index) ? thread_PWindow.max : global_PWindow.content.max;
+#else
+	row_t window = thread_PWindow.max;
+#endif
+	return window > descriptor.put_count ? window - descriptor.put_count : 1;
+}
+
+// Items the sub-queue of the descriptor from the last get_window can give before it reaches the window,
+// at least one as for the descriptor of an empty return
+static inline row_t get_window_room(descriptor_t descriptor)
+{
+#ifdef HIERARCHICAL_WINDOWS
+	row_t window = in_slice(thread_get_index) ? socket_window(&socket_GWindow[thread_socket], &global_GWindow) : global_GWindow.content.max;
+#else
+	row_t window = thread_GWindow.max;
+#endif
+	return window > descriptor.get_count ? window - descriptor.get_count : 1;
+}
 
 width_t random_index(width_t width)
 {
@@ -220,5 +662,51 @@ void initialize_global_window(depth_t depth, width_t width)
 
 	global_PWindow.content.max = depth;
 	global_GWindow.content.max = depth;
+#ifdef HIERARCHICAL_WINDOWS
+	for (width_t s = 0; s < WINDOW_MAX_SOCKETS; s++)
+	{
+		socket_PWindow[s].content.max = depth;
+		socket_GWindow[s].content.max = depth;
+	}
+#endif
+}
+
+#ifdef HIERARCHICAL_WINDOWS
+// Gives the thread the slice and windows of its socket. With more sockets than the platform has, the
+// threads are spread over them in turn, to try the windows out on fewer sockets.
+void window_register(DS_TYPE* set, int thread_id)
+{
+	int n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (set->sockets > NUMBER_OF_SOCKETS)
+	{
+		thread_socket = thread_id % set->sockets;
+	}
+	else
+	{
+		thread_socket = (thread_id < n_cpus ? get_cluster(the_cores[thread_id]) : 0) % set->sockets;
+	}
+	thread_slice_start = slice_start(set, thread_socket);
+	thread_slice_width = slice_start(set, thread_socket + 1) - thread_slice_start;
+	thread_put_index = thread_get_index = thread_slice_start;
+}
+#endif
+
+// Gives the thread its stride and the share of the sub-queues of its socket, for the hop policies. With
+// hierarchical windows the searches stay within the slice of the socket, which is then all local.
+void hop_register(DS_TYPE* set, int thread_id)
+{
+#ifdef HIERARCHICAL_WINDOWS
+	thread_local_start = thread_slice_start;
+	thread_local_width = thread_slice_width;
+	thread_hop_stride = hop_stride(thread_slice_width, thread_id);
+#else
+	int n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	width_t sockets = min(NUMBER_OF_SOCKETS, thread_width);
+	width_t socket = (thread_id < n_cpus ? get_cluster(the_cores[thread_id]) : 0) % sockets;
+	thread_local_start = (width_t)(((uint32_t) socket * thread_width) / sockets);
+	thread_local_width = (width_t)(((uint32_t) (socket + 1) * thread_width) / sockets) - thread_local_start;
+	thread_hop_stride = hop_stride(thread_width, thread_id);
+#endif
+	thread_last_put = thread_last_get = thread_local_start;
 }
 
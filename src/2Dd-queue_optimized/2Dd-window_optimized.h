@@ -24,11 +24,41 @@ __thread width_t thread_width;
 __thread width_t thread_put_index;
 __thread width_t thread_get_index;
 
+#ifdef HIERARCHICAL_WINDOWS
+// Threads on further sockets share the windows of the first ones
+#ifndef WINDOW_MAX_SOCKETS
+#define WINDOW_MAX_SOCKETS 8
+#endif
+
+/* Windows of the slice of sub-queues owned by each socket, at most a budget ahead of the global ones */
+volatile padded_window_t socket_PWindow[WINDOW_MAX_SOCKETS];
+volatile padded_window_t socket_GWindow[WINDOW_MAX_SOCKETS];
+
+__thread width_t thread_socket;
+__thread width_t thread_slice_start;
+__thread width_t thread_slice_width;
+__thread unsigned long my_global_slide_count;
+__thread unsigned long my_remote_count;
+#endif
+
+/* hop policy variables */
+__thread width_t thread_hop_stride;
+__thread width_t thread_local_start;
+__thread width_t thread_local_width;
+__thread width_t thread_last_put;
+__thread width_t thread_last_get;
+__thread uint64_t thread_hop_chain;
+__thread unsigned long my_hop_hist[HOP_HIST_BUCKETS];
+
 /* functions */
 descriptor_t put_window(DS_TYPE* set, uint8_t contention);
 descriptor_t get_window(DS_TYPE* set, uint8_t contention);
 width_t random_index(width_t width);
 void initialize_global_window(depth_t depth, width_t width);
 void ds_thread_init(DS_TYPE* set);
+void hop_register(DS_TYPE* set, int thread_id);
+#ifdef HIERARCHICAL_WINDOWS
+void window_register(DS_TYPE* set, int thread_id);
+#endif
 
 #endif
@@ -0,0 +1,344 @@
+/*
+	*   File: test-bulk.c
+	*
+	* Threads enqueue and dequeue batches of items, either with DS_ADD_BULK and DS_REMOVE_BULK,
+	* which take a run of rows of a sub-queue with one CAS, or with a loop of single DS_ADD and
+	* DS_REMOVE calls. Reports the items moved per second, and checks that no item is lost or
+	* taken twice.
+	*
+*/
+
+#include <assert.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include "utils.h"
+
+#include "2Dd-queue_optimized.h"
+
+/* ################################################################### *
+	* GLOBALS
+* ################################################################### */
+
+size_t num_threads = DEFAULT_NB_THREADS;
+size_t duration = DEFAULT_DURATION;
+size_t initial = 1024;
+uint64_t width = 1;
+uint64_t depth = 1;
+size_t put_rate = 50;
+size_t batch = 16;
+int use_bulk = 1;
+size_t sockets = 0;
+size_t window_budget = 4;
+
+static volatile int stop;
+
+uint64_t *put_items;
+uint64_t *get_items;
+uint64_t *put_sum;
+uint64_t *get_sum;
+
+/* ################################################################### *
+	* LOCALS
+* ################################################################### */
+
+__thread unsigned long *seeds;
+__thread unsigned long my_put_cas_fail_count;
+__thread unsigned long my_get_cas_fail_count;
+__thread unsigned long my_null_count;
+__thread unsigned long my_hop_count;
+__thread unsigned long my_slide_count;
+__thread int thread_id;
+
+barrier_t barrier, barrier_global;
+
+typedef struct thread_data
+{
+	uint32_t id;
+	DS_TYPE* set;
+} thread_data_t;
+
+// Non-zero and distinct over all threads
+static inline sval_t next_item(uint64_t n)
+{
+	return (sval_t) ((((uint64_t) thread_id + 1) << 40) | n);
+}
+
+static void put_batch(DS_HANDLE handle, sval_t *vals, size_t n)
+{
+	for (size_t b = 0; b < n; b++)
+	{
+		vals[b] = next_item(++put_items[thread_id]);
+		put_sum[thread_id] += vals[b];
+	}
+	if (use_bulk)
+	{
+		size_t done = DS_ADD_BULK(handle, vals, n);
+		assert(done == n);
+		(void) done;
+		return;
+	}
+	for (size_t b = 0; b < n; b++)
+	{
+		DS_ADD(handle, vals[b], vals[b]);
+	}
+}
+
+// Dequeues up to n items, and returns the number dequeued
+static size_t get_batch(DS_HANDLE handle, sval_t *vals, size_t n)
+{
+	size_t got = 0;
+	if (use_bulk)
+	{
+		got = DS_REMOVE_BULK(handle, vals, n);
+	}
+	else
+	{
+		while (got < n && (vals[got] = DS_REMOVE(handle)) != 0)
+		{
+			got++;
+		}
+	}
+	for (size_t b = 0; b < got; b++)
+	{
+		get_sum[thread_id] += vals[b];
+	}
+	get_items[thread_id] += got;
+	return got;
+}
+
+void* test(void* thread)
+{
+	thread_data_t* td = (thread_data_t*) thread;
+	thread_id = td->id;
+	set_cpu(thread_id);
+	seeds = seed_rand();
+
+	DS_HANDLE handle = DS_REGISTER(td->set, thread_id);
+	sval_t vals[batch];
+	barrier_cross(&barrier);
+
+	size_t share = initial / num_threads + (thread_id < initial % num_threads);
+	for (size_t n = 0; n < share; n += batch)
+	{
+		put_batch(handle, vals, share - n < batch ? share - n : batch);
+	}
+
+	barrier_cross(&barrier_global);
+	while (!stop)
+	{
+		if (my_random(&(seeds[0]), &(seeds[1]), &(seeds[2])) % 100 < put_rate)
+			put_batch(handle, vals, batch);
+		else
+			get_batch(handle, vals, batch);
+	}
+
+	pthread_exit(NULL);
+}
+
+int main(int argc, char **argv)
+{
+	set_cpu(0);
+	seeds = seed_rand();
+
+	struct option long_options[] = {
+		// These options don't set a flag
+		{"help",                      no_argument,       NULL, 'h'},
+		{"num-threads",               required_argument, NULL, 'n'},
+		{"duration",                  required_argument, NULL, 'd'},
+		{"initial-size",              required_argument, NULL, 'i'},
+		{"width",                     required_argument, NULL, 'w'},
+		{"depth",                     required_argument, NULL, 'l'},
+		{"put-rate",                  required_argument, NULL, 'p'},
+		{"batch",                     required_argument, NULL, 'b'},
+		{"mode",                      required_argument, NULL, 'm'},
+		{"sockets",                   required_argument, NULL, 'S'},
+		{"window-budget",             required_argument, NULL, 'B'},
+		{NULL, 0, NULL, 0}
+	};
+
+	int i, c;
+	while(1)
+	{
+		i = 0;
+		c = getopt_long(argc, argv, "hn:d:i:w:l:p:b:m:S:B:", long_options, &i);
+		if(c == -1)
+			break;
+		if(c == 0 && long_options[i].flag == 0)
+			c = long_options[i].val;
+		switch(c)
+		{
+			case 0:
+			/* Flag is automatically set */
+			break;
+			case 'h':
+			printf("Bulk operations"
+			"\n"
+			"\n"
+			"Usage:\n"
+			"  %s [options...]\n"
+			"\n"
+			"Options:\n"
+			"  -h, --help\n"
+			"        Print this message\n"
+			"  -n, --num-threads <int>\n"
+			"        Number of threads\n"
+			"  -d, --duration <int>\n"
+			"        Test duration in milliseconds\n"
+			"  -i, --initial-size <int>\n"
+			"        Number of items inserted before the test [DEFAULT=1024].\n"
+			"  -w, --width <int>\n"
+			"        Width (Number of sub-structures).\n"
+			"  -l, --depth <int>\n"
+			"        Depth (Operations per sub-structure in a window).\n"
+			"  -p, --put-rate <int>\n"
+			"        Percentage of batches that are enqueued [DEFAULT=50].\n"
+			"  -b, --batch <int>\n"
+			"        Items per batch [DEFAULT=16].\n"
+			"  -m, --mode <int>\n"
+			"        1 to move each batch with DS_ADD_BULK and DS_REMOVE_BULK, 0 with single operations [DEFAULT=1].\n"
+			"  -S, --sockets <int>\n"
+			"        With NUMA=1, sockets to split the sub-queues over, 0 for those of the platform [DEFAULT=0].\n"
+			"  -B, --window-budget <int>\n"
+			"        With NUMA=1, depths a socket window may run ahead of the global window [DEFAULT=4].\n"
+			, argv[0]);
+			exit(0);
+			case 'n':
+			num_threads = atoi(optarg);
+			break;
+			case 'd':
+			duration = atoi(optarg);
+			break;
+			case 'i':
+			initial = atol(optarg);
+			break;
+			case 'w':
+			width = atoi(optarg);
+			break;
+			case 'l':
+			depth = atoi(optarg);
+			break;
+			case 'p':
+			put_rate = atoi(optarg);
+			break;
+			case 'b':
+			batch = atoi(optarg);
+			break;
+			case 'm':
+			use_bulk = atoi(optarg);
+			break;
+			case 'S':
+			sockets = atoi(optarg);
+			break;
+			case 'B':
+			window_budget = atoi(optarg);
+			break;
+			case '?':
+			default:
+			printf("Use -h or --help for help\n");
+			exit(1);
+		}
+	}
+	assert(batch > 0);
+
+	// The main thread registers after the others, to empty the queue at the end
+	thread_id = num_threads;
+
+#ifdef RELAXATION_ANALYSIS
+	init_relaxation_analysis();
+#endif
+	DS_TYPE* set = DS_NEW(num_threads + 1, width, depth, 0, 1, thread_id);
+	assert(set != NULL);
+#ifdef HIERARCHICAL_WINDOWS
+	queue_set_sockets(set, sockets, window_budget);
+#endif
+	DS_HANDLE handle = DS_REGISTER(set, thread_id);
+	stop = 0;
+
+	put_items = (uint64_t*) calloc(num_threads + 1, sizeof(uint64_t));
+	get_items = (uint64_t*) calloc(num_threads + 1, sizeof(uint64_t));
+	put_sum = (uint64_t*) calloc(num_threads + 1, sizeof(uint64_t));
+	get_sum = (uint64_t*) calloc(num_threads + 1, sizeof(uint64_t));
+
+	pthread_t threads[num_threads];
+	thread_data_t* tds = (thread_data_t*) malloc(num_threads * sizeof(thread_data_t));
+	barrier_init(&barrier_global, num_threads + 1);
+	barrier_init(&barrier, num_threads);
+
+	long t;
+	for(t = 0; t < num_threads; t++)
+	{
+		tds[t].id = t;
+		tds[t].set = set;
+		int rc = pthread_create(&threads[t], NULL, test, tds + t);
+		if (rc)
+		{
+			printf("ERROR; return code from pthread_create() is %d\n", rc);
+			exit(-1);
+		}
+	}
+
+	struct timespec timeout;
+	timeout.tv_sec = duration / 1000;
+	timeout.tv_nsec = (duration % 1000) * 1000000;
+	struct timeval start, end;
+
+	barrier_cross(&barrier_global);
+	gettimeofday(&start, NULL);
+	nanosleep(&timeout, NULL);
+	stop = 1;
+	gettimeofday(&end, NULL);
+	duration = (end.tv_sec * 1000 + end.tv_usec / 1000) - (start.tv_sec * 1000 + start.tv_usec / 1000);
+
+	for(t = 0; t < num_threads; t++)
+	{
+		pthread_join(threads[t], NULL);
+	}
+	free(tds);
+
+	uint64_t moved = 0;
+	for(t = 0; t < num_threads; t++)
+	{
+		moved += put_items[t] + get_items[t];
+	}
+	// Less the initial items
+	moved -= initial;
+
+	// Empty the queue, so every item left is accounted for
+	sval_t vals[batch];
+	size_t left = 0, got;
+	while ((got = get_batch(handle, vals, batch)) > 0)
+	{
+		left += got;
+	}
+
+	uint64_t in_total = 0, out_total = 0, in_sum = 0, out_sum = 0;
+	for(t = 0; t <= num_threads; t++)
+	{
+		in_total += put_items[t];
+		out_total += get_items[t];
+		in_sum += put_sum[t];
+		out_sum += get_sum[t];
+	}
+
+	printf("num_threads , %zu \n", num_threads);
+	printf("Bulk_Mode , %d\n", use_bulk);
+	printf("Batch , %zu\n", batch);
+	printf("Mitems_s , %.3f\n", moved / (duration * 1000.0));
+	printf("Items_Left , %zu\n", left);
+	printf("Lost_Items , %ld\n", (int64_t) (in_total - out_total));
+#ifdef RELAXATION_ANALYSIS
+	// The analysis replaces the items with their linearization counts
+	print_relaxation_measurements();
+#else
+	printf("Checksum_OK , %d\n", in_sum == out_sum);
+#endif
+	printf("Width , %u\n", set->width);
+	printf("Depth , %u\n", set->depth);
+	printf("Relaxation_bound, %zu\n", set->relaxation_bound);
+
+	pthread_exit(NULL);
+	return 0;
+}
@@ -0,0 +1,304 @@
+/*
+	*   File: test-drain.c
+	*
+	* Fills the queue from all threads, then empties it either with one bulk drain or with
+	* repeated DS_REMOVE calls, and reports the time per item. With a duration, the threads
+	* keep enqueuing while the queue is drained, and a non-destructive snapshot is taken
+	* meanwhile, to check that no item is lost or taken twice.
+	*
+*/
+
+#include <assert.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include "utils.h"
+
+#include "2Dd-queue_optimized.h"
+
+/* ################################################################### *
+	* GLOBALS
+* ################################################################### */
+
+size_t num_threads = DEFAULT_NB_THREADS;
+size_t duration = 0;
+size_t initial = 1 << 22;
+uint64_t width = 1;
+uint64_t depth = 1;
+int use_drain = 1;
+
+static volatile int stop;
+
+uint64_t *produced;
+uint64_t *produced_sum;
+
+/* ################################################################### *
+	* LOCALS
+* ################################################################### */
+
+__thread unsigned long *seeds;
+extern __thread ssmem_allocator_t* alloc;
+__thread unsigned long my_put_cas_fail_count;
+__thread unsigned long my_get_cas_fail_count;
+__thread unsigned long my_null_count;
+__thread unsigned long my_hop_count;
+__thread unsigned long my_slide_count;
+__thread int thread_id;
+
+barrier_t barrier_fill, barrier_live;
+
+typedef struct thread_data
+{
+	uint32_t id;
+	DS_TYPE* set;
+} thread_data_t;
+
+// Items visited by a drain or snapshot, and the sum of their values
+typedef struct visit_count
+{
+	uint64_t items;
+	uint64_t sum;
+} visit_count_t;
+
+static void count_item(sval_t val, void *arg)
+{
+	visit_count_t *count = (visit_count_t*) arg;
+	count->items++;
+	count->sum += val;
+}
+
+uint64_t get_time()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Non-zero and distinct over all threads
+static inline sval_t next_item(uint64_t n)
+{
+	return (sval_t) ((((uint64_t) thread_id + 1) << 40) | n);
+}
+
+static inline void put_item(DS_HANDLE handle)
+{
+	sval_t val = next_item(++produced[thread_id]);
+	DS_ADD(handle, val, val);
+	produced_sum[thread_id] += val;
+}
+
+// Empties the queue with a single drain, or by dequeuing until it is empty or max items were taken
+static void empty_queue(DS_HANDLE handle, visit_count_t *count, size_t max)
+{
+	if (use_drain)
+	{
+		DS_DRAIN(handle, count_item, count);
+		return;
+	}
+	sval_t val;
+	for (size_t left = max; left > 0 && (val = DS_REMOVE(handle)) != 0; left--)
+	{
+		count_item(val, count);
+	}
+}
+
+void* test(void* thread)
+{
+	thread_data_t* td = (thread_data_t*) thread;
+	thread_id = td->id;
+	set_cpu(thread_id);
+	seeds = seed_rand();
+
+	DS_HANDLE handle = DS_REGISTER(td->set, thread_id);
+
+	size_t share = initial / num_threads + (thread_id < initial % num_threads);
+	for (size_t n = 0; n < share; n++)
+	{
+		put_item(handle);
+	}
+	barrier_cross(&barrier_fill);
+
+	if (duration > 0)
+	{
+		barrier_cross(&barrier_live);
+		while (!stop)
+		{
+			put_item(handle);
+		}
+	}
+
+	pthread_exit(NULL);
+}
+
+int main(int argc, char **argv)
+{
+	set_cpu(0);
+	seeds = seed_rand();
+
+	struct option long_options[] = {
+		// These options don't set a flag
+		{"help",                      no_argument,       NULL, 'h'},
+		{"num-threads",               required_argument, NULL, 'n'},
+		{"duration",                  required_argument, NULL, 'd'},
+		{"initial-size",              required_argument, NULL, 'i'},
+		{"width",                     required_argument, NULL, 'w'},
+		{"depth",                     required_argument, NULL, 'l'},
+		{"mode",                      required_argument, NULL, 'm'},
+		{NULL, 0, NULL, 0}
+	};
+
+	int i, c;
+	while(1)
+	{
+		i = 0;
+		c = getopt_long(argc, argv, "hn:d:i:w:l:m:", long_options, &i);
+		if(c == -1)
+			break;
+		if(c == 0 && long_options[i].flag == 0)
+			c = long_options[i].val;
+		switch(c)
+		{
+			case 0:
+			/* Flag is automatically set */
+			break;
+			case 'h':
+			printf("Drain"
+			"\n"
+			"\n"
+			"Usage:\n"
+			"  %s [options...]\n"
+			"\n"
+			"Options:\n"
+			"  -h, --help\n"
+			"        Print this message\n"
+			"  -n, --num-threads <int>\n"
+			"        Number of threads filling the queue\n"
+			"  -d, --duration <int>\n"
+			"        Milliseconds the threads keep enqueuing while the queue is drained, 0 to drain a filled queue [DEFAULT=0].\n"
+			"  -i, --initial-size <int>\n"
+			"        Number of items in the filled queue [DEFAULT=4194304].\n"
+			"  -w, --width <int>\n"
+			"        Width (Number of sub-structures).\n"
+			"  -l, --depth <int>\n"
+			"        Depth (Operations per sub-structure in a window).\n"
+			"  -m, --mode <int>\n"
+			"        1 to empty the queue with DS_DRAIN, 0 with repeated DS_REMOVE [DEFAULT=1].\n"
+			, argv[0]);
+			exit(0);
+			case 'n':
+			num_threads = atoi(optarg);
+			break;
+			case 'd':
+			duration = atoi(optarg);
+			break;
+			case 'i':
+			initial = atol(optarg);
+			break;
+			case 'w':
+			width = atoi(optarg);
+			break;
+			case 'l':
+			depth = atoi(optarg);
+			break;
+			case 'm':
+			use_drain = atoi(optarg);
+			break;
+			case '?':
+			default:
+			printf("Use -h or --help for help\n");
+			exit(1);
+		}
+	}
+
+	// The draining thread registers after the producers
+	thread_id = num_threads;
+
+	DS_TYPE* set = DS_NEW(num_threads + 1, width, depth, 0, 1, thread_id);
+	assert(set != NULL);
+	DS_HANDLE handle = DS_REGISTER(set, thread_id);
+	stop = 0;
+
+	produced = (uint64_t*) calloc(num_threads, sizeof(uint64_t));
+	produced_sum = (uint64_t*) calloc(num_threads, sizeof(uint64_t));
+
+	pthread_t threads[num_threads];
+	thread_data_t* tds = (thread_data_t*) malloc(num_threads * sizeof(thread_data_t));
+	barrier_init(&barrier_fill, num_threads + 1);
+	barrier_init(&barrier_live, num_threads + 1);
+
+	uint64_t start = get_time();
+	long t;
+	for(t = 0; t < num_threads; t++)
+	{
+		tds[t].id = t;
+		tds[t].set = set;
+		int rc = pthread_create(&threads[t], NULL, test, tds + t);
+		if (rc)
+		{
+			printf("ERROR; return code from pthread_create() is %d\n", rc);
+			exit(-1);
+		}
+	}
+	barrier_cross(&barrier_fill);
+	uint64_t fill_time = get_time() - start;
+
+	visit_count_t snapshot = {0, 0};
+	start = get_time();
+	DS_SNAPSHOT(handle, count_item, &snapshot);
+	uint64_t snapshot_time = get_time() - start;
+
+	visit_count_t drained = {0, 0};
+	uint64_t drain_time;
+	size_t rounds = 0;
+	if (duration > 0)
+	{
+		barrier_cross(&barrier_live);
+		uint64_t end = get_time() + duration * 1000000ULL;
+		while (get_time() < end)
+		{
+			visit_count_t seen = {0, 0};
+			DS_SNAPSHOT(handle, count_item, &seen);
+			// Bounded, as the dequeues might otherwise keep up with the enqueues
+			empty_queue(handle, &drained, initial);
+			rounds++;
+		}
+		stop = 1;
+	}
+	for(t = 0; t < num_threads; t++)
+	{
+		pthread_join(threads[t], NULL);
+	}
+	free(tds);
+
+	// Times the last round, which for a filled queue is the only one
+	uint64_t drained_before = drained.items;
+	start = get_time();
+	empty_queue(handle, &drained, SIZE_MAX);
+	drain_time = get_time() - start;
+	uint64_t last_round = drained.items - drained_before;
+
+	uint64_t produced_total = 0, sum_total = 0;
+	for(t = 0; t < num_threads; t++)
+	{
+		produced_total += produced[t];
+		sum_total += produced_sum[t];
+	}
+
+	printf("num_threads , %zu \n", num_threads);
+	printf("Drain_Mode , %d\n", use_drain);
+	printf("Fill_ms , %.2f\n", fill_time / 1e6);
+	printf("Snapshot_Items , %lu\n", snapshot.items);
+	printf("Snapshot_ms , %.2f\n", snapshot_time / 1e6);
+	printf("Live_Rounds , %zu\n", rounds);
+	printf("Drained , %lu\n", drained.items);
+	printf("Drain_ms , %.2f\n", drain_time / 1e6);
+	printf("Drain_Mitems_s , %.2f\n", drain_time ? last_round * 1e3 / drain_time : 0.0);
+	printf("Items_Left , %zu\n", DS_SIZE(set));
+	printf("Lost_Items , %ld\n", (int64_t) (produced_total - drained.items));
+	printf("Checksum_OK , %d\n", sum_total == drained.sum);
+
+	pthread_exit(NULL);
+	return 0;
+}
@@ -0,0 +1,300 @@
+/*
+	*   File: test-idle.c
+	*
+	* Producer with idle periods between bursts of enqueues, and consumers that either
+	* spin on DS_REMOVE or park on an eventcount while the queue is empty. Reports the
+	* CPU time of the consumers and the latency from the start of a burst until the
+	* first of its items is dequeued.
+	*
+*/
+
+#include <assert.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "utils.h"
+
+#include "2Dd-queue_optimized.h"
+#include "eventcount.h"
+
+/* ################################################################### *
+	* GLOBALS
+* ################################################################### */
+
+size_t num_threads = DEFAULT_NB_THREADS;
+size_t duration = DEFAULT_DURATION;
+uint64_t width = 1;
+uint64_t depth = 1;
+size_t idle_us = 10000;
+size_t burst = 256;
+int blocking = 1;
+
+static volatile int stop;
+static eventcount_t ec;
+
+// Start of the latest burst, cleared by the consumer dequeuing its first item
+static volatile uint64_t burst_start;
+
+uint64_t *consumed;
+uint64_t *wake_count;
+uint64_t *wake_latency;
+uint64_t *max_wake_latency;
+uint64_t *cpu_time;
+
+/* ################################################################### *
+	* LOCALS
+* ################################################################### */
+
+__thread unsigned long *seeds;
+extern __thread ssmem_allocator_t* alloc;
+__thread unsigned long my_put_cas_fail_count;
+__thread unsigned long my_get_cas_fail_count;
+__thread unsigned long my_null_count;
+__thread unsigned long my_hop_count;
+__thread unsigned long my_slide_count;
+__thread int thread_id;
+
+barrier_t barrier;
+
+typedef struct thread_data
+{
+	uint32_t id;
+	DS_TYPE* set;
+} thread_data_t;
+
+uint64_t get_time()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static inline void consume(sval_t val)
+{
+	consumed[thread_id]++;
+	uint64_t start = burst_start;
+	if (unlikely(start != 0) && CAS_U64(&burst_start, start, 0) == start)
+	{
+		uint64_t latency = get_time() - start;
+		wake_count[thread_id]++;
+		wake_latency[thread_id] += latency;
+		if (latency > max_wake_latency[thread_id])
+			max_wake_latency[thread_id] = latency;
+	}
+}
+
+void* test(void* thread)
+{
+	thread_data_t* td = (thread_data_t*) thread;
+	thread_id = td->id;
+	set_cpu(thread_id);
+	seeds = seed_rand();
+
+	DS_HANDLE handle = DS_REGISTER(td->set, thread_id);
+	barrier_cross(&barrier);
+
+	sval_t val;
+	if (blocking)
+	{
+		while ((val = ds_remove_blocking(&ec, handle)) != 0)
+			consume(val);
+	}
+	else
+	{
+		while (1)
+		{
+			if ((val = DS_REMOVE(handle)) != 0)
+				consume(val);
+			else if (stop)
+				break;
+		}
+	}
+
+	struct rusage usage;
+	getrusage(RUSAGE_THREAD, &usage);
+	cpu_time[thread_id] = (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000000ULL
+		+ (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000ULL;
+
+	pthread_exit(NULL);
+}
+
+int main(int argc, char **argv)
+{
+	set_cpu(0);
+	seeds = seed_rand();
+
+	struct option long_options[] = {
+		// These options don't set a flag
+		{"help",                      no_argument,       NULL, 'h'},
+		{"num-threads",               required_argument, NULL, 'n'},
+		{"duration",                  required_argument, NULL, 'd'},
+		{"width",                     required_argument, NULL, 'w'},
+		{"depth",                     required_argument, NULL, 'l'},
+		{"idle",                      required_argument, NULL, 'i'},
+		{"burst",                     required_argument, NULL, 'b'},
+		{"blocking",                  required_argument, NULL, 'B'},
+		{NULL, 0, NULL, 0}
+	};
+
+	int i, c;
+	while(1)
+	{
+		i = 0;
+		c = getopt_long(argc, argv, "hn:d:w:l:i:b:B:", long_options, &i);
+		if(c == -1)
+			break;
+		if(c == 0 && long_options[i].flag == 0)
+			c = long_options[i].val;
+		switch(c)
+		{
+			case 0:
+			/* Flag is automatically set */
+			break;
+			case 'h':
+			printf("Idle periods"
+			"\n"
+			"\n"
+			"Usage:\n"
+			"  %s [options...]\n"
+			"\n"
+			"Options:\n"
+			"  -h, --help\n"
+			"        Print this message\n"
+			"  -n, --num-threads <int>\n"
+			"        Number of consumer threads, besides the producer\n"
+			"  -d, --duration <int>\n"
+			"        Test duration in milliseconds\n"
+			"  -w, --width <int>\n"
+			"        Width (Number of sub-structures).\n"
+			"  -l, --depth <int>\n"
+			"        Depth (Operations per sub-structure in a window).\n"
+			"  -i, --idle <int>\n"
+			"        Microseconds the producer sleeps between bursts [DEFAULT=10000].\n"
+			"  -b, --burst <int>\n"
+			"        Items enqueued per burst [DEFAULT=256].\n"
+			"  -B, --blocking <int>\n"
+			"        1 to park the consumers on an eventcount, 0 to spin on the queue [DEFAULT=1].\n"
+			, argv[0]);
+			exit(0);
+			case 'n':
+			num_threads = atoi(optarg);
+			break;
+			case 'd':
+			duration = atoi(optarg);
+			break;
+			case 'w':
+			width = atoi(optarg);
+			break;
+			case 'l':
+			depth = atoi(optarg);
+			break;
+			case 'i':
+			idle_us = atoi(optarg);
+			break;
+			case 'b':
+			burst = atoi(optarg);
+			break;
+			case 'B':
+			blocking = atoi(optarg);
+			break;
+			case '?':
+			default:
+			printf("Use -h or --help for help\n");
+			exit(1);
+		}
+	}
+
+	// The producer registers after the consumers
+	thread_id = num_threads;
+
+	DS_TYPE* set = DS_NEW(num_threads + 1, width, depth, 0, 1, thread_id);
+	assert(set != NULL);
+	DS_HANDLE handle = DS_REGISTER(set, thread_id);
+	eventcount_init(&ec);
+	stop = 0;
+
+	consumed = (uint64_t*) calloc(num_threads, sizeof(uint64_t));
+	wake_count = (uint64_t*) calloc(num_threads, sizeof(uint64_t));
+	wake_latency = (uint64_t*) calloc(num_threads, sizeof(uint64_t));
+	max_wake_latency = (uint64_t*) calloc(num_threads, sizeof(uint64_t));
+	cpu_time = (uint64_t*) calloc(num_threads, sizeof(uint64_t));
+
+	pthread_t threads[num_threads];
+	thread_data_t* tds = (thread_data_t*) malloc(num_threads * sizeof(thread_data_t));
+	barrier_init(&barrier, num_threads + 1);
+
+	long t;
+	for(t = 0; t < num_threads; t++)
+	{
+		tds[t].id = t;
+		tds[t].set = set;
+		int rc = pthread_create(&threads[t], NULL, test, tds + t);
+		if (rc)
+		{
+			printf("ERROR; return code from pthread_create() is %d\n", rc);
+			exit(-1);
+		}
+	}
+	barrier_cross(&barrier);
+
+	struct timespec idle;
+	idle.tv_sec = idle_us / 1000000;
+	idle.tv_nsec = (idle_us % 1000000) * 1000;
+
+	uint64_t produced = 0, bursts = 0;
+	uint64_t start = get_time();
+	uint64_t end = start + duration * 1000000ULL;
+	while (get_time() < end)
+	{
+		nanosleep(&idle, NULL);
+		burst_start = get_time();
+		for (size_t b = 0; b < burst; b++)
+		{
+			produced++;
+			if (blocking)
+				ds_add_notify(&ec, handle, produced, produced);
+			else
+				DS_ADD(handle, produced, produced);
+		}
+		bursts++;
+	}
+
+	if (blocking)
+		eventcount_close(&ec);
+	else
+		stop = 1;
+	for(t = 0; t < num_threads; t++)
+	{
+		pthread_join(threads[t], NULL);
+	}
+	uint64_t elapsed = get_time() - start;
+	free(tds);
+
+	uint64_t consumed_total = 0, wakes_total = 0, latency_total = 0, latency_max = 0, cpu_total = 0;
+	for(t = 0; t < num_threads; t++)
+	{
+		consumed_total += consumed[t];
+		wakes_total += wake_count[t];
+		latency_total += wake_latency[t];
+		if (max_wake_latency[t] > latency_max)
+			latency_max = max_wake_latency[t];
+		cpu_total += cpu_time[t];
+	}
+
+	printf("num_threads , %zu \n", num_threads);
+	printf("Blocking , %d\n", blocking);
+	printf("Bursts , %lu\n", bursts);
+	printf("Produced , %lu\n", produced);
+	printf("Consumed , %lu\n", consumed_total);
+	printf("Wake_Latency_us , %.2f\n", wakes_total ? (double) latency_total / wakes_total / 1000 : 0.0);
+	printf("Max_Wake_Latency_us , %.2f\n", (double) latency_max / 1000);
+	printf("Consumer_CPU_ms , %.2f\n", (double) cpu_total / 1e6);
+	// Share of the consumers' wall-clock time spent on a CPU
+	printf("CPU_Utilization , %.2f\n", 100.0 * cpu_total / ((double) elapsed * num_threads));
+
+	pthread_exit(NULL);
+	return 0;
+}
@@ -0,0 +1,305 @@
+/*
+	*   File: test-wrap.c
+	*
+	* Stress test for sub-queue counts past 2^16, where the counts of PACKED=1 builds wrap around.
+	* Each round the threads fill the queue to a level of rows per sub-queue, enqueue and dequeue
+	* at random, and empty it again. At the end every item must have been dequeued exactly once,
+	* and the get count of every sub-queue must have caught up with its put count. The default
+	* level of 2^16 rows keeps the put window that far ahead of the get window.
+	*
+*/
+
+#include <assert.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include "utils.h"
+
+#include "2Dd-queue_optimized.h"
+
+/* ################################################################### *
+	* GLOBALS
+* ################################################################### */
+
+size_t num_threads = DEFAULT_NB_THREADS;
+uint64_t width = 1;
+uint64_t depth = 1;
+size_t level = 1 << 16;
+size_t ops = 1 << 20;
+size_t rounds = 2;
+size_t sockets = 0;
+size_t window_budget = 4;
+
+uint64_t *put_items;
+uint64_t *get_items;
+uint64_t *put_sum;
+uint64_t *get_sum;
+
+/* ################################################################### *
+	* LOCALS
+* ################################################################### */
+
+__thread unsigned long *seeds;
+__thread unsigned long my_put_cas_fail_count;
+__thread unsigned long my_get_cas_fail_count;
+__thread unsigned long my_null_count;
+__thread unsigned long my_hop_count;
+__thread unsigned long my_slide_count;
+__thread int thread_id;
+
+barrier_t barrier;
+
+typedef struct thread_data
+{
+	uint32_t id;
+	DS_TYPE* set;
+} thread_data_t;
+
+// Non-zero and distinct over all threads
+static inline sval_t next_item(uint64_t n)
+{
+	return (sval_t) ((((uint64_t) thread_id + 1) << 40) | n);
+}
+
+static inline void put_item(DS_HANDLE handle)
+{
+	sval_t val = next_item(++put_items[thread_id]);
+	DS_ADD(handle, val, val);
+	put_sum[thread_id] += val;
+}
+
+static inline int get_item(DS_HANDLE handle)
+{
+	sval_t val = DS_REMOVE(handle);
+	if (val == 0)
+	{
+		return 0;
+	}
+	get_items[thread_id] += 1;
+	get_sum[thread_id] += val;
+	return 1;
+}
+
+void* test(void* thread)
+{
+	thread_data_t* td = (thread_data_t*) thread;
+	thread_id = td->id;
+	set_cpu(thread_id);
+	seeds = seed_rand();
+
+	DS_HANDLE handle = DS_REGISTER(td->set, thread_id);
+	barrier_cross(&barrier);
+
+	size_t fill = level * width;
+	size_t share = fill / num_threads + (thread_id < fill % num_threads);
+	for (size_t r = 0; r < rounds; r++)
+	{
+		for (size_t n = 0; n < share; n++)
+		{
+			put_item(handle);
+		}
+		barrier_cross(&barrier);
+
+		for (size_t n = 0; n < ops; n++)
+		{
+			if (my_random(&(seeds[0]), &(seeds[1]), &(seeds[2])) & 1)
+				put_item(handle);
+			else
+				get_item(handle);
+		}
+		barrier_cross(&barrier);
+
+		while (get_item(handle));
+		barrier_cross(&barrier);
+	}
+
+	pthread_exit(NULL);
+}
+
+int main(int argc, char **argv)
+{
+	set_cpu(0);
+	seeds = seed_rand();
+
+	struct option long_options[] = {
+		// These options don't set a flag
+		{"help",                      no_argument,       NULL, 'h'},
+		{"num-threads",               required_argument, NULL, 'n'},
+		{"width",                     required_argument, NULL, 'w'},
+		{"depth",                     required_argument, NULL, 'l'},
+		{"level",                     required_argument, NULL, 'L'},
+		{"ops",                       required_argument, NULL, 'o'},
+		{"rounds",                    required_argument, NULL, 'r'},
+		{"sockets",                   required_argument, NULL, 'S'},
+		{"window-budget",             required_argument, NULL, 'B'},
+		{NULL, 0, NULL, 0}
+	};
+
+	int i, c;
+	while(1)
+	{
+		i = 0;
+		c = getopt_long(argc, argv, "hn:w:l:L:o:r:S:B:", long_options, &i);
+		if(c == -1)
+			break;
+		if(c == 0 && long_options[i].flag == 0)
+			c = long_options[i].val;
+		switch(c)
+		{
+			case 0:
+			/* Flag is automatically set */
+			break;
+			case 'h':
+			printf("Count wrap-around"
+			"\n"
+			"\n"
+			"Usage:\n"
+			"  %s [options...]\n"
+			"\n"
+			"Options:\n"
+			"  -h, --help\n"
+			"        Print this message\n"
+			"  -n, --num-threads <int>\n"
+			"        Number of threads\n"
+			"  -w, --width <int>\n"
+			"        Width (Number of sub-structures).\n"
+			"  -l, --depth <int>\n"
+			"        Depth (Operations per sub-structure in a window).\n"
+			"  -L, --level <int>\n"
+			"        Rows per sub-queue the queue is filled to each round [DEFAULT=65536].\n"
+			"  -o, --ops <int>\n"
+			"        Random enqueues and dequeues per thread at the level each round [DEFAULT=1048576].\n"
+			"  -r, --rounds <int>\n"
+			"        Rounds of filling and emptying the queue [DEFAULT=2].\n"
+			"  -S, --sockets <int>\n"
+			"        With NUMA=1, sockets to split the sub-queues over, 0 for those of the platform [DEFAULT=0].\n"
+			"  -B, --window-budget <int>\n"
+			"        With NUMA=1, depths a socket window may run ahead of the global window [DEFAULT=4].\n"
+			, argv[0]);
+			exit(0);
+			case 'n':
+			num_threads = atoi(optarg);
+			break;
+			case 'w':
+			width = atoi(optarg);
+			break;
+			case 'l':
+			depth = atoi(optarg);
+			break;
+			case 'L':
+			level = atol(optarg);
+			break;
+			case 'o':
+			ops = atol(optarg);
+			break;
+			case 'r':
+			rounds = atoi(optarg);
+			break;
+			case 'S':
+			sockets = atoi(optarg);
+			break;
+			case 'B':
+			window_budget = atoi(optarg);
+			break;
+			case '?':
+			default:
+			printf("Use -h or --help for help\n");
+			exit(1);
+		}
+	}
+
+	// The main thread registers after the others, to check that the queue is empty at the end
+	thread_id = num_threads;
+
+#ifdef RELAXATION_ANALYSIS
+	init_relaxation_analysis();
+#endif
+	DS_TYPE* set = DS_NEW(num_threads + 1, width, depth, 0, 1, thread_id);
+	assert(set != NULL);
+#ifdef HIERARCHICAL_WINDOWS
+	queue_set_sockets(set, sockets, window_budget);
+#endif
+	DS_HANDLE handle = DS_REGISTER(set, thread_id);
+
+	put_items = (uint64_t*) calloc(num_threads + 1, sizeof(uint64_t));
+	get_items = (uint64_t*) calloc(num_threads + 1, sizeof(uint64_t));
+	put_sum = (uint64_t*) calloc(num_threads + 1, sizeof(uint64_t));
+	get_sum = (uint64_t*) calloc(num_threads + 1, sizeof(uint64_t));
+
+	pthread_t threads[num_threads];
+	thread_data_t* tds = (thread_data_t*) malloc(num_threads * sizeof(thread_data_t));
+	barrier_init(&barrier, num_threads);
+
+	struct timeval start, end;
+	gettimeofday(&start, NULL);
+
+	long t;
+	for(t = 0; t < num_threads; t++)
+	{
+		tds[t].id = t;
+		tds[t].set = set;
+		int rc = pthread_create(&threads[t], NULL, test, tds + t);
+		if (rc)
+		{
+			printf("ERROR; return code from pthread_create() is %d\n", rc);
+			exit(-1);
+		}
+	}
+	for(t = 0; t < num_threads; t++)
+	{
+		pthread_join(threads[t], NULL);
+	}
+	free(tds);
+
+	gettimeofday(&end, NULL);
+	size_t duration = (end.tv_sec * 1000 + end.tv_usec / 1000) - (start.tv_sec * 1000 + start.tv_usec / 1000);
+
+	// Nothing may be left, and the emptied sub-queues have taken as many items out as in
+	size_t left = 0;
+	while (get_item(handle))
+	{
+		left++;
+	}
+	int counts_ok = 1;
+	for (uint64_t q = 0; q < set->width; q++)
+	{
+		// Widened against the same reference, the counts are equal exactly when their low bits are
+		descriptor_t put_descriptor = load_descriptor(set->put_array, q, 0);
+		descriptor_t get_descriptor = load_descriptor(set->get_array, q, 0);
+		if (put_descriptor.node != get_descriptor.node || put_descriptor.put_count != get_descriptor.get_count)
+		{
+			counts_ok = 0;
+		}
+	}
+
+	uint64_t in_total = 0, out_total = 0, in_sum = 0, out_sum = 0;
+	for(t = 0; t <= num_threads; t++)
+	{
+		in_total += put_items[t];
+		out_total += get_items[t];
+		in_sum += put_sum[t];
+		out_sum += get_sum[t];
+	}
+
+	printf("num_threads , %zu \n", num_threads);
+	printf("Level , %zu\n", level);
+	printf("Rounds , %zu\n", rounds);
+	printf("Mops , %.3f\n", (in_total + out_total) / (duration * 1000.0));
+	printf("Items_Left , %zu\n", left);
+	printf("Lost_Items , %ld\n", (int64_t) (in_total - out_total));
+	printf("Counts_OK , %d\n", counts_ok);
+#ifdef RELAXATION_ANALYSIS
+	// The analysis replaces the items with their linearization counts
+	print_relaxation_measurements();
+#else
+	printf("Checksum_OK , %d\n", in_sum == out_sum);
+#endif
+	printf("Width , %u\n", set->width);
+	printf("Depth , %u\n", set->depth);
+	printf("Relaxation_bound, %zu\n", set->relaxation_bound);
+
+	pthread_exit(NULL);
+	return 0;
+}
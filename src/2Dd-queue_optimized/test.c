@@ -53,6 +53,7 @@
 RETRY_STATS_VARS_GLOBAL;
 
 size_t initial = DEFAULT_INITIAL;
+size_t capacity = 0;
 size_t range = DEFAULT_RANGE;
 size_t update = 100;
 size_t load_factor;
@@ -75,6 +76,9 @@ uint64_t width = 1;
 uint64_t depth = 1;
 uint8_t k_mode = 0;
 size_t side_work = 0;
+size_t sockets = 0;
+size_t window_budget = 4;
+size_t hop_policy = HOP_DEFAULT;
 
 TEST_VARS_GLOBAL;
 
@@ -88,7 +92,10 @@ volatile unsigned long *put_cas_fail_count;
 volatile unsigned long *get_cas_fail_count;
 volatile unsigned long *null_count;
 volatile unsigned long *hop_count;
+volatile unsigned long *hop_hist;
 volatile unsigned long *slide_count;
+volatile unsigned long *global_slide_count;
+volatile unsigned long *remote_count;
 volatile ticks *removing_count;
 volatile ticks *removing_count_succ;
 volatile ticks *total;
@@ -236,7 +243,15 @@ void *test(void *thread)
 	get_cas_fail_count[thread_id] = my_get_cas_fail_count;
 	null_count[thread_id] = my_null_count;
 	hop_count[thread_id] = my_hop_count;
+	for (int b = 0; b < HOP_HIST_BUCKETS; b++)
+	{
+		hop_hist[thread_id * HOP_HIST_BUCKETS + b] = my_hop_hist[b];
+	}
 	slide_count[thread_id] = my_slide_count;
+#ifdef HIERARCHICAL_WINDOWS
+	global_slide_count[thread_id] = my_global_slide_count;
+	remote_count[thread_id] = my_remote_count;
+#endif
 
 	EXEC_IN_DEC_ID_ORDER(thread_id, num_threads)
 	{
@@ -270,13 +285,17 @@ int main(int argc, char **argv)
 		{"num-buckets", required_argument, NULL, 'b'},
 		{"print-vals", required_argument, NULL, 'v'},
 		{"vals-pf", required_argument, NULL, 'f'},
+		{"capacity", required_argument, NULL, 'C'},
+		{"sockets", required_argument, NULL, 'S'},
+		{"window-budget", required_argument, NULL, 'B'},
+		{"hop-policy", required_argument, NULL, 'H'},
 		{NULL, 0, NULL, 0}};
 
 	int i, c;
 	while (1)
 	{
 		i = 0;
-		c = getopt_long(argc, argv, "hAf:d:i:n:r:u:m:a:l:p:b:v:f:y:z:k:w:s:", long_options, &i);
+		c = getopt_long(argc, argv, "hAf:d:i:n:r:u:m:a:l:p:b:v:f:y:z:k:w:s:C:S:B:H:", long_options, &i);
 		if (c == -1)
 			break;
 		if (c == 0 && long_options[i].flag == 0)
@@ -323,12 +342,32 @@ int main(int argc, char **argv)
 				   "  -w, --Width <int>\n"
 				   "        Fixed Width or Width to thread ratio depending on the k-mode.\n"
 				   "  -m, --K Mode <int>\n"
-				   "        0 for Fixed Width and Depth, 1 for Fixed Width, 2 for fixed Depth, 3 for fixed Width to thread ratio.\n",
+				   "        0 for Fixed Width and Depth, 1 for Fixed Width, 2 for fixed Depth, 3 for fixed Width to thread ratio.\n"
+				   "  -C, --capacity <int>\n"
+				   "        Items the queue holds before enqueues fail as full, in whole depths per sub-queue, 0 is unbounded [DEFAULT=0].\n"
+				   "  -S, --sockets <int>\n"
+				   "        With NUMA=1, sockets to split the sub-queues over, more than the platform has spreads the threads over them in turn, 0 for those of the platform [DEFAULT=0].\n"
+				   "  -B, --window-budget <int>\n"
+				   "        With NUMA=1, depths a socket window may run ahead of the global window [DEFAULT=4].\n"
+				   "  -H, --hop-policy <int>\n"
+				   "        Hops between sub-queues, 0 default, 1 random, 2 two-choices, 3 last-success, 4 stride, 5 socket-local [DEFAULT=0].\n",
 				   argv[0]);
 			exit(0);
 		case 'd':
 			duration = atoi(optarg);
 			break;
+		case 'C':
+			capacity = atol(optarg);
+			break;
+		case 'S':
+			sockets = atoi(optarg);
+			break;
+		case 'B':
+			window_budget = atoi(optarg);
+			break;
+		case 'H':
+			hop_policy = atoi(optarg);
+			break;
 		case 'i':
 			initial = atoi(optarg);
 			break;
@@ -426,6 +465,12 @@ int main(int argc, char **argv)
 
 	rand_max = range - 1;
 
+	if (capacity != 0 && capacity < initial)
+	{
+		printf("** raising capacity to fit the initial items: old: %zu / new: %zu\n", capacity, initial);
+		capacity = initial;
+	}
+
 	struct timeval start, end;
 	struct timespec timeout;
 	timeout.tv_sec = duration / 1000;
@@ -434,6 +479,11 @@ int main(int argc, char **argv)
 
 	DS_TYPE *set = DS_NEW(num_threads, width, depth, k_mode, relaxation_bound, thread_id);
 	assert(set != NULL);
+	queue_set_capacity(set, capacity);
+	queue_set_hop_policy(set, hop_policy);
+#ifdef HIERARCHICAL_WINDOWS
+	queue_set_sockets(set, sockets, window_budget);
+#endif
 
 	/* Initializes the local data */
 	putting_succ = (ticks *)calloc(num_threads, sizeof(ticks));
@@ -448,7 +498,10 @@ int main(int argc, char **argv)
 	get_cas_fail_count = (unsigned long *)calloc(num_threads, sizeof(unsigned long));
 	null_count = (unsigned long *)calloc(num_threads, sizeof(unsigned long));
 	slide_count = (unsigned long *)calloc(num_threads, sizeof(unsigned long));
+	global_slide_count = (unsigned long *)calloc(num_threads, sizeof(unsigned long));
+	remote_count = (unsigned long *)calloc(num_threads, sizeof(unsigned long));
 	hop_count = (unsigned long *)calloc(num_threads, sizeof(unsigned long));
+	hop_hist = (unsigned long *)calloc(num_threads * HOP_HIST_BUCKETS, sizeof(unsigned long));
 
 	pthread_t threads[num_threads];
 	pthread_attr_t attr;
@@ -513,7 +566,11 @@ int main(int argc, char **argv)
 	volatile unsigned long get_cas_fail_count_total = 0;
 	volatile unsigned long null_count_total = 0;
 	volatile unsigned long slide_count_total = 0;
+	volatile unsigned long global_slide_count_total = 0;
+	volatile unsigned long remote_count_total = 0;
 	volatile unsigned long hop_count_total = 0;
+	unsigned long hop_hist_total[HOP_HIST_BUCKETS] = {0};
+	unsigned long searches_total = 0;
 	volatile uint64_t removing_count_total = 0;
 	volatile uint64_t removing_count_total_succ = 0;
 
@@ -530,7 +587,14 @@ int main(int argc, char **argv)
 		get_cas_fail_count_total += get_cas_fail_count[t];
 		null_count_total += null_count[t];
 		hop_count_total += hop_count[t];
+		for (int b = 0; b < HOP_HIST_BUCKETS; b++)
+		{
+			hop_hist_total[b] += hop_hist[t * HOP_HIST_BUCKETS + b];
+			searches_total += hop_hist[t * HOP_HIST_BUCKETS + b];
+		}
 		slide_count_total += slide_count[t];
+		global_slide_count_total += global_slide_count[t];
+		remote_count_total += remote_count[t];
 		removing_count_total += removing_count[t];
 		removing_count_total_succ += removing_count_succ[t];
 	}
@@ -573,7 +637,8 @@ int main(int argc, char **argv)
 	printf("removing_perc , %10.1f \n", removing_perc);
 	printf("removing_effective , %10.1f \n", (removing_perc * removing_perc_succ) / 100);
 
-	double throughput = (putting_count_total + removing_count_total_succ) * 1000.0 / duration;
+	// Enqueues that found the queue full are left out, like dequeues that found it empty
+	double throughput = (putting_count_total_succ + removing_count_total_succ) * 1000.0 / duration;
 
 	printf("num_threads , %zu \n", num_threads);
 	printf("Mops , %.3f\n", throughput / 1e6);
@@ -587,11 +652,28 @@ int main(int argc, char **argv)
 	printf("Pop_CAS_fails , %zu\n", get_cas_fail_count_total);
 	printf("Null_Count , %zu\n", null_count_total);
 	printf("Hop_Count , %zu\n", hop_count_total);
+	printf("Hop_Policy , %s\n", hop_policy_names[set->hop_policy]);
+	printf("Mean_Hops , %.3f\n", searches_total ? (double)hop_count_total / searches_total : 0.0);
+	// Window searches by their hops, each bucket from the given number of hops up to the next one
+	printf("Hop_Histogram ,");
+	for (int b = 0; b < HOP_HIST_BUCKETS; b++)
+	{
+		printf(" %lu:%lu", hop_hist_floor(b), hop_hist_total[b]);
+	}
+	printf("\n");
 	printf("Slide_Count , %zu\n", slide_count_total);
+	printf("Capacity , %zu\n", capacity);
+	printf("Max_RSS_MB , %.1f\n", max_rss_mb());
 	printf("Width , %u\n", set->width);
 	printf("Depth , %u\n", set->depth);
 	printf("Relaxation_bound, %zu\n", set->relaxation_bound);
 	printf("K_mode , %u\n", set->k_mode);
+#ifdef HIERARCHICAL_WINDOWS
+	printf("Sockets , %u\n", set->sockets);
+	printf("Window_Budget , %zu\n", (size_t)set->budget);
+	printf("Global_Slide_Count , %zu\n", global_slide_count_total);
+	printf("Remote_Ops , %zu\n", remote_count_total);
+#endif
 
 #ifdef RELAXATION_TIMER_ANALYSIS
 	print_relaxation_measurements(num_threads);
@@ -27,6 +27,10 @@
 #define PARTIAL_T                   faaaq_t
 #define PARTIAL_ENQUEUE(q, k, v)    faaaq_enqueue(q, k, v)
 #define PARTIAL_DEQUEUE(q)          faaaq_dequeue(q)
+#define PARTIAL_ENQUEUE_BATCH(q, v, n)  faaaq_enqueue_batch(q, v, n)
+#define PARTIAL_DEQUEUE_BATCH(q, v, m)  faaaq_dequeue_batch(q, v, m)
+#define PARTIAL_DRAIN(q, f, a)      faaaq_drain(q, f, a)
+#define PARTIAL_SNAPSHOT(q, f, a)   faaaq_snapshot(q, f, a)
 #define INIT_PARTIAL(q,n)           init_faaaq_queue(q)
 #define PARTIAL_LENGTH(q)           faaaq_queue_size(q)
 #define PARTIAL_TAIL_VERSION(q)     faaaq_enq_count(q)
@@ -36,7 +40,23 @@
 
 // Internally used macros
 #define TAKEN				        ((sval_t) -1)
-#define BUFFER_SIZE 		        ((uint64_t) 1024)
+
+// Default items per segment, the size of the segments of a queue can be changed with faaaq_set_segment_size
+#ifndef FAAAQ_SEGMENT_SIZE
+#define FAAAQ_SEGMENT_SIZE          ((uint64_t) 1024)
+#endif
+// Segment sizes are powers of two in this range, with one pool of drained segments per size
+#define FAAAQ_MIN_SEGMENT_ORDER     1
+#define FAAAQ_MAX_SEGMENT_ORDER     24
+
+// Operations between the quiescent points where a thread announces it holds no segment loaded before
+#ifndef FAAAQ_QUIESCENT_PERIOD
+#define FAAAQ_QUIESCENT_PERIOD      64
+#endif
+// Threads that can operate on segments at the same time
+#ifndef FAAAQ_MAX_THREADS
+#define FAAAQ_MAX_THREADS           512
+#endif
 
 /* Type definitions */
 
@@ -46,6 +66,9 @@ typedef ALIGNED(CACHE_LINE_SIZE) struct segment
     ALIGNED(CACHE_LINE_SIZE) volatile uint64_t deq_idx;
     ALIGNED(CACHE_LINE_SIZE) struct segment *volatile next;
     uint64_t node_idx;
+    uint64_t size;
+    // Link while retired or pooled, as next stays readable by threads still in the segment
+    struct segment *pool_next;
 	volatile sval_t items[];
 } segment_t;
 
@@ -53,7 +76,9 @@ typedef ALIGNED(CACHE_LINE_SIZE) struct faaaq
 {
     segment_t * volatile head;
     segment_t * volatile tail;
-	uint8_t padding[CACHE_LINE_SIZE - 2*sizeof(segment_t*)];
+    // Items per segment allocated for this queue
+    uint64_t segment_size;
+	uint8_t padding[CACHE_LINE_SIZE - 2*sizeof(segment_t*) - sizeof(uint64_t)];
 } faaaq_t;
 
 
@@ -65,14 +90,24 @@ extern __thread int thread_id;
 
 extern __thread unsigned long my_put_cas_fail_count;
 extern __thread unsigned long my_get_cas_fail_count;
+extern __thread unsigned long my_put_retry_count;
+extern __thread unsigned long my_get_retry_count;
 extern __thread unsigned long my_null_count;
 extern __thread unsigned long my_hop_count;
 extern __thread unsigned long my_slide_count;
+extern __thread unsigned long my_segment_alloc_count;
+extern __thread unsigned long my_segment_reuse_count;
 
 /* Interfaces */
 int faaaq_enqueue(faaaq_t *queue, skey_t key, sval_t val);
 sval_t faaaq_dequeue(faaaq_t *queue);
+int faaaq_enqueue_batch(faaaq_t *queue, sval_t *vals, size_t n);
+size_t faaaq_dequeue_batch(faaaq_t *queue, sval_t *vals, size_t max);
+size_t faaaq_drain(faaaq_t *queue, visit_fn_t visit, void *arg);
+size_t faaaq_snapshot(faaaq_t *queue, visit_fn_t visit, void *arg);
 void init_faaaq_queue(faaaq_t *queue);
+void faaaq_set_segment_size(faaaq_t *queue, uint64_t segment_size);
+void faaaq_thread_offline(void);
 size_t faaaq_queue_size(faaaq_t *queue);
 uint64_t faaaq_enq_count(faaaq_t *queue);
 uint64_t faaaq_deq_count(faaaq_t *queue);
@@ -69,6 +69,14 @@ uint64_t relaxation_bound = 1;
 uint64_t width = 1;
 uint64_t choices = 2;
 size_t side_work = 0;
+size_t batch_size = 1;
+uint32_t sticky = 0;
+int numa_flat = 0;
+uint32_t start_width = 0;
+size_t capacity = 0;
+// Items per segment of each sub-queue, given to the sub-queues in turn
+uint64_t *segment_sizes = NULL;
+size_t n_segment_sizes = 0;
 
 TEST_VARS_GLOBAL;
 
@@ -82,7 +90,11 @@ volatile unsigned long *put_cas_fail_count;
 volatile unsigned long *get_cas_fail_count;
 volatile unsigned long *null_count;
 volatile unsigned long *hop_count;
+volatile unsigned long *sticky_resample_count;
+volatile unsigned long *remote_count;
 volatile unsigned long *slide_count;
+volatile unsigned long *segment_alloc_count;
+volatile unsigned long *segment_reuse_count;
 volatile ticks *removing_count;
 volatile ticks *removing_count_succ;
 volatile ticks *total;
@@ -161,6 +173,7 @@ void *test(void *thread)
 	int c = 0;
 	uint32_t scale_rem = (uint32_t)(update_rate * UINT_MAX);
 	uint32_t scale_put = (uint32_t)(put_rate * UINT_MAX);
+	sval_t *batch_vals = (sval_t *)malloc(batch_size * sizeof(sval_t));
 
 	int i;
 	uint32_t num_elems_thread = (uint32_t)(initial / num_threads);
@@ -189,14 +202,29 @@ void *test(void *thread)
 	if (!thread_id)
 	{
 		printf("BEFORE size is, %zu\n", (size_t)DS_SIZE(set));
+#ifdef DCBO_ELASTIC
+		// Resized after the initial items are in, so the test starts with retired sub-queues to drain
+		if (start_width)
+			dcbo_update_width(set, start_width);
+#endif
 	}
 
 	RETRY_STATS_ZERO();
 	barrier_cross(&barrier_global);
 	RR_START_SIMPLE();
-	while (stop == 0)
+	if (batch_size > 1)
 	{
-		TEST_LOOP_ONLY_UPDATES();
+		while (stop == 0)
+		{
+			TEST_LOOP_BATCH_UPDATES();
+		}
+	}
+	else
+	{
+		while (stop == 0)
+		{
+			TEST_LOOP_ONLY_UPDATES();
+		}
 	}
 	barrier_cross(&barrier);
 	RR_STOP_SIMPLE();
@@ -224,7 +252,13 @@ void *test(void *thread)
 	get_cas_fail_count[thread_id] = my_get_cas_fail_count;
 	null_count[thread_id] = my_null_count;
 	hop_count[thread_id] = my_hop_count;
+	sticky_resample_count[thread_id] = my_sticky_resample_count;
+#ifdef DCBO_NUMA
+	remote_count[thread_id] = my_remote_count;
+#endif
 	slide_count[thread_id] = my_slide_count;
+	segment_alloc_count[thread_id] = my_segment_alloc_count;
+	segment_reuse_count[thread_id] = my_segment_reuse_count;
 
 	EXEC_IN_DEC_ID_ORDER(thread_id, num_threads)
 	{
@@ -233,6 +267,7 @@ void *test(void *thread)
 	}
 	EXEC_IN_DEC_ID_ORDER_END(&barrier);
 
+	free(batch_vals);
 	SSPFDTERM();
 #if GC == 1
 	ssmem_term();
@@ -258,13 +293,19 @@ int main(int argc, char **argv)
 		{"num-buckets", required_argument, NULL, 'b'},
 		{"print-vals", required_argument, NULL, 'v'},
 		{"vals-pf", required_argument, NULL, 'f'},
+		{"batch-size", required_argument, NULL, 'B'},
+		{"sticky", required_argument, NULL, 'S'},
+		{"numa-flat", no_argument, NULL, 'N'},
+		{"start-width", required_argument, NULL, 'W'},
+		{"capacity", required_argument, NULL, 'C'},
+		{"segment-size", required_argument, NULL, 'R'},
 		{NULL, 0, NULL, 0}};
 
 	int i, c;
 	while (1)
 	{
 		i = 0;
-		c = getopt_long(argc, argv, "hAf:d:i:n:r:u:m:a:l:p:b:v:f:y:z:k:w:s:c:", long_options, &i);
+		c = getopt_long(argc, argv, "hAf:d:i:n:r:u:m:a:l:p:b:v:f:y:z:k:w:s:c:B:S:NW:R:C:", long_options, &i);
 		if (c == -1)
 			break;
 		if (c == 0 && long_options[i].flag == 0)
@@ -307,7 +348,19 @@ int main(int argc, char **argv)
 				   "  -w, --width <int>\n"
 				   "        Width (Number of sub-structures).\n"
 				   "  -c, --choices <int>\n"
-				   "        The number of choices to use (refered to as d in d-balanced queues) [DEFAULT=2].\n",
+				   "        The number of choices to use (refered to as d in d-balanced queues) [DEFAULT=2].\n"
+				   "  -B, --batch-size <int>\n"
+				   "        Items moved per enqueue/dequeue, using one sub-queue choice per batch [DEFAULT=1].\n"
+				   "  -S, --sticky <int>\n"
+				   "        Operations a thread stays on its last chosen sub-queue before re-sampling, 0 disables [DEFAULT=0].\n"
+				   "  -N, --numa-flat\n"
+				   "        With NUMA=1, sample all candidates from the whole set as the flat design does, for comparison.\n"
+				   "  -W, --start-width <int>\n"
+				   "        With ELASTIC=1, sub-queues enqueued to once the test starts, the initial items stay spread over all -w [DEFAULT=width].\n"
+				   "  -R, --segment-size <int>[,<int>...]\n"
+				   "        Items per FAAArrayQueue segment, a power of two. A list is given to the sub-queues in turn [DEFAULT=1024].\n"
+				   "  -C, --capacity <int>\n"
+				   "        Items the queue holds before enqueues fail as full, split evenly over the sub-queues, 0 is unbounded [DEFAULT=0].\n",
 				   argv[0]);
 			exit(0);
 		case 'd':
@@ -346,6 +399,38 @@ int main(int argc, char **argv)
 			break;
 		case 'c':
 			choices = atoi(optarg);
+			break;
+		case 'B':
+			batch_size = atoi(optarg);
+			if (batch_size == 0)
+				batch_size = 1;
+			break;
+		case 'S':
+			sticky = atoi(optarg);
+			break;
+		case 'N':
+			numa_flat = 1;
+			break;
+		case 'W':
+			start_width = atoi(optarg);
+			break;
+		case 'C':
+			capacity = atol(optarg);
+			break;
+		case 'R':
+			n_segment_sizes = 0;
+			for (char *size = strtok(optarg, ","); size != NULL; size = strtok(NULL, ","))
+			{
+				segment_sizes = (uint64_t *)realloc(segment_sizes, (n_segment_sizes + 1) * sizeof(uint64_t));
+				segment_sizes[n_segment_sizes] = atol(size);
+				if (!is_power_of_two(segment_sizes[n_segment_sizes]) || segment_sizes[n_segment_sizes] < (1ull << FAAAQ_MIN_SEGMENT_ORDER) || segment_sizes[n_segment_sizes] > (1ull << FAAAQ_MAX_SEGMENT_ORDER))
+				{
+					printf("Segment sizes must be powers of two between %llu and %llu\n", 1ull << FAAAQ_MIN_SEGMENT_ORDER, 1ull << FAAAQ_MAX_SEGMENT_ORDER);
+					exit(1);
+				}
+				n_segment_sizes++;
+			}
+			break;
 		case 'm':
 		case 'k':
 			break;
@@ -404,6 +489,12 @@ int main(int argc, char **argv)
 
 	rand_max = range - 1;
 
+	if (capacity != 0 && capacity < initial)
+	{
+		printf("** raising capacity to fit the initial items: old: %zu / new: %zu\n", capacity, initial);
+		capacity = initial;
+	}
+
 	struct timeval start, end;
 	struct timespec timeout;
 	timeout.tv_sec = duration / 1000;
@@ -412,6 +503,15 @@ int main(int argc, char **argv)
 
 	DS_TYPE *set = DS_NEW(width, choices, num_threads);
 	assert(set != NULL);
+	set->sticky = sticky;
+	dcbo_set_capacity(set, capacity);
+	for (uint32_t q = 0; q < set->width && n_segment_sizes > 0; q++)
+	{
+		faaaq_set_segment_size(QUEUE(set, q), segment_sizes[q % n_segment_sizes]);
+	}
+#ifdef DCBO_NUMA
+	set->numa_flat = numa_flat;
+#endif
 
 	/* Initializes the local data */
 	putting_succ = (ticks *)calloc(num_threads, sizeof(ticks));
@@ -426,7 +526,11 @@ int main(int argc, char **argv)
 	get_cas_fail_count = (unsigned long *)calloc(num_threads, sizeof(unsigned long));
 	null_count = (unsigned long *)calloc(num_threads, sizeof(unsigned long));
 	slide_count = (unsigned long *)calloc(num_threads, sizeof(unsigned long));
+	segment_alloc_count = (unsigned long *)calloc(num_threads, sizeof(unsigned long));
+	segment_reuse_count = (unsigned long *)calloc(num_threads, sizeof(unsigned long));
 	hop_count = (unsigned long *)calloc(num_threads, sizeof(unsigned long));
+	sticky_resample_count = (unsigned long *)calloc(num_threads, sizeof(unsigned long));
+	remote_count = (unsigned long *)calloc(num_threads, sizeof(unsigned long));
 
 	pthread_t threads[num_threads];
 	pthread_attr_t attr;
@@ -489,7 +593,11 @@ int main(int argc, char **argv)
 	volatile unsigned long get_cas_fail_count_total = 0;
 	volatile unsigned long null_count_total = 0;
 	volatile unsigned long slide_count_total = 0;
+	volatile unsigned long segment_alloc_count_total = 0;
+	volatile unsigned long segment_reuse_count_total = 0;
 	volatile unsigned long hop_count_total = 0;
+	volatile unsigned long sticky_resample_count_total = 0;
+	volatile unsigned long remote_count_total = 0;
 	volatile uint64_t removing_count_total = 0;
 	volatile uint64_t removing_count_total_succ = 0;
 
@@ -506,7 +614,11 @@ int main(int argc, char **argv)
 		get_cas_fail_count_total += get_cas_fail_count[t];
 		null_count_total += null_count[t];
 		hop_count_total += hop_count[t];
+		sticky_resample_count_total += sticky_resample_count[t];
+		remote_count_total += remote_count[t];
 		slide_count_total += slide_count[t];
+		segment_alloc_count_total += segment_alloc_count[t];
+		segment_reuse_count_total += segment_reuse_count[t];
 		removing_count_total += removing_count[t];
 		removing_count_total_succ += removing_count_succ[t];
 	}
@@ -549,7 +661,8 @@ int main(int argc, char **argv)
 	printf("removing_perc , %10.1f \n", removing_perc);
 	printf("removing_effective , %10.1f \n", (removing_perc * removing_perc_succ) / 100);
 
-	double throughput = (putting_count_total + removing_count_total_succ) * 1000.0 / duration;
+	// Enqueues that found the queue full are left out, like dequeues that found it empty
+	double throughput = (putting_count_total_succ + removing_count_total_succ) * 1000.0 / duration;
 
 	printf("num_threads , %zu \n", num_threads);
 	printf("Mops , %.3f\n", throughput / 1e6);
@@ -572,8 +685,31 @@ int main(int argc, char **argv)
 	printf("Null_Count , %zu\n", null_count_total);
 	printf("Hop_Count , %zu\n", hop_count_total);
 	printf("Slide_Count , %zu\n", slide_count_total);
+	printf("Capacity , %zu\n", capacity);
+	printf("Max_RSS_MB , %.1f\n", max_rss_mb());
+	printf("Segment_Sizes ,");
+	for (uint32_t q = 0; q < (n_segment_sizes > 0 ? n_segment_sizes : 1); q++)
+	{
+		printf(" %llu", n_segment_sizes > 0 ? (LLU)segment_sizes[q] : (LLU)FAAAQ_SEGMENT_SIZE);
+	}
+	printf("\n");
+	printf("Segment_Allocs , %zu\n", segment_alloc_count_total);
+	printf("Segment_Reuses , %zu\n", segment_reuse_count_total);
 	printf("Width , %u\n", set->width);
 	printf("Choices (d) , %u\n", set->d);
+	printf("Batch_Size , %zu\n", batch_size);
+	printf("Sticky_Ops , %u\n", set->sticky);
+	printf("Sticky_Resamples , %zu\n", sticky_resample_count_total);
+#ifdef DCBO_ELASTIC
+	printf("Max_Width , %u\n", set->max_width);
+	printf("Span , %u\n", SPAN_WIDTH(set->span));
+#endif
+#ifdef DCBO_NUMA
+	printf("Sockets , %u\n", set->sockets);
+	printf("Numa_Flat , %d\n", set->numa_flat);
+	printf("Remote_Ops , %zu\n", remote_count_total);
+	printf("Remote_Perc , %.2f\n", 100.0 * remote_count_total / (putting_count_total + removing_count_total));
+#endif
 
 	pthread_exit(NULL);
 
@@ -16,6 +16,27 @@
 #include "lock_if.h"
 #include "ssmem.h"
 #include "utils.h"
+#ifdef DCBO_NUMA
+#include <numa.h>
+#endif
+#ifdef EMPTY_SUMMARY
+#include "dcbo-summary.h"
+#define SUMMARY_FIELD_SIZE sizeof(summary_t*)
+#else
+#define SUMMARY_FIELD_SIZE 0
+#endif
+#ifdef COUNT_MIRROR
+#include "dcbo-mirror.h"
+#define MIRROR_FIELD_SIZE (2*sizeof(uint32_t*))
+#else
+#define MIRROR_FIELD_SIZE 0
+#endif
+#ifdef DCBO_ELASTIC
+#include "dcbo-elastic.h"
+#define ELASTIC_FIELD_SIZE (sizeof(uint64_t) + sizeof(uint32_t))
+#else
+#define ELASTIC_FIELD_SIZE 0
+#endif
 
 // Include specific partial queue
 #include "partial-queue.h"
@@ -26,22 +47,58 @@
 
 #define DS_ADD(s,k,v)       enqueue(s,k,v)
 #define DS_REMOVE(s)        dequeue(s)
+#define DS_ADD_BATCH(s,v,n)     enqueue_batch(s,v,n)
+#define DS_REMOVE_BATCH(s,v,m)  dequeue_batch(s,v,m)
 #define DS_SIZE(s)          queue_size(s)
 #define DS_NEW(w,d,i)       create_queue(w,d,i)
 #define DS_REGISTER(q,i)	d_balanced_register(q,i)
 
+// Returned by the enqueues of a queue with a capacity, when the sub-queues they sample are all full
+#define QUEUE_FULL 0
+
 #define DS_HANDLE 			mqueue_t*
 #define DS_TYPE             mqueue_t
 #define DS_NODE             sval_t
 
 typedef ALIGNED(CACHE_LINE_SIZE) struct mqueue_file
 {
+#ifdef DCBO_NUMA
+	PARTIAL_T **queues; // Sub-queue addresses, each socket's partition is allocated on pages of its node
+#else
 	PARTIAL_T *queues;
+#endif
+#ifdef EMPTY_SUMMARY
+	summary_t *summary; // Non-emptiness flags searched when a sampled sub-queue is empty
+#endif
+#ifdef COUNT_MIRROR
+	volatile uint32_t *enq_mirror; // Packed copies of the sub-queue operation counts, read when sampling, NULL below MIRROR_MIN_D candidates
+	volatile uint32_t *deq_mirror;
+#endif
+#ifdef DCBO_ELASTIC
+	volatile uint64_t span; // Sub-queues that may hold items in the low half, see dcbo-elastic.h
+	uint32_t max_width; // Sub-queues allocated, the width enqueued to moves within it
+#endif
 	uint32_t width;
     uint32_t d;
-	uint8_t padding[CACHE_LINE_SIZE - (sizeof(PARTIAL_T*)) - 2*sizeof(int32_t)];
+	uint32_t sticky; // Operations to stay on a chosen sub-queue, 0 re-samples on every operation
+	uint32_t capacity; // Items per sub-queue before the enqueue choice passes it over, 0 for unbounded
+#ifdef DCBO_NUMA
+	uint32_t sockets; // Sub-queues are split evenly into one partition per socket
+	uint32_t numa_flat; // Sample all candidates globally, as in the flat design, for comparison
+	// With every option enabled the fields spill over one line, the padding then fills the second
+	uint8_t padding[(2*CACHE_LINE_SIZE - (sizeof(PARTIAL_T*)) - 6*sizeof(int32_t) - SUMMARY_FIELD_SIZE - MIRROR_FIELD_SIZE - ELASTIC_FIELD_SIZE) % CACHE_LINE_SIZE];
+#else
+	uint8_t padding[CACHE_LINE_SIZE - (sizeof(PARTIAL_T*)) - 4*sizeof(int32_t) - SUMMARY_FIELD_SIZE - MIRROR_FIELD_SIZE - ELASTIC_FIELD_SIZE];
+#endif
 } mqueue_t;
 
+// Address of sub-queue i
+#ifdef DCBO_NUMA
+#define QUEUE(set, i) ((set)->queues[i])
+#else
+#define QUEUE(set, i) (&(set)->queues[i])
+#endif
+
 /*Global variables*/
 
 
@@ -54,14 +111,56 @@ extern __thread unsigned long my_get_cas_fail_count;
 extern __thread unsigned long my_null_count;
 extern __thread unsigned long my_hop_count;
 extern __thread unsigned long my_slide_count;
+extern __thread unsigned long my_sticky_resample_count;
+extern __thread unsigned long my_put_retry_count;
+extern __thread unsigned long my_get_retry_count;
+#ifdef DCBO_NUMA
+extern __thread unsigned long my_remote_count;
+#endif
+
+static inline uint32_t random_index(mqueue_t *set)
+{
+	return (my_random(&(seeds[0]), &(seeds[1]), &(seeds[2])) % (set->width));
+}
+
+#ifdef DCBO_NUMA
+#define MIN_WIDTH(set) ((set)->sockets)
+#else
+#define MIN_WIDTH(set) 1
+#endif
+#ifdef DCBO_ELASTIC
+#define ALLOCATED_WIDTH(set) ((set)->max_width)
+#else
+#define ALLOCATED_WIDTH(set) ((set)->width)
+#endif
 
 /* Interfaces */
 int enqueue(mqueue_t *set, skey_t key, sval_t val);
 sval_t dequeue(mqueue_t *set);
+int enqueue_batch(mqueue_t *set, sval_t *vals, size_t n);
+size_t dequeue_batch(mqueue_t *set, sval_t *vals, size_t max);
 mqueue_t* create_queue(uint32_t n_partial, uint32_t d, int nbr_threads);
 size_t queue_size(mqueue_t *set);
-uint32_t random_index(mqueue_t *set);
+void dcbo_set_capacity(mqueue_t *set, size_t capacity);
 sval_t double_collect(mqueue_t *set, uint32_t start_index);
+#ifdef EMPTY_SUMMARY
+sval_t summary_dequeue(mqueue_t *set);
+#endif
+#ifdef DCBO_ELASTIC
+uint32_t dcbo_update_width(mqueue_t *set, uint32_t width);
+#endif
 mqueue_t* d_balanced_register(mqueue_t *set, int thread_id);
 
+// Enqueues like enqueue, but backs off and retries while the sub-queues sampled are full
+static inline int enqueue_wait(mqueue_t *set, skey_t key, sval_t val)
+{
+    int res;
+    size_t full = 0;
+    while ((res = enqueue(set, key, val)) == QUEUE_FULL)
+    {
+        do_pause_exp(full++);
+    }
+    return res;
+}
+
 #endif
\ No newline at end of file
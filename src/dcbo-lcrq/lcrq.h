@@ -33,15 +33,32 @@ extern __thread int thread_id;
 
 extern __thread unsigned long my_put_cas_fail_count;
 extern __thread unsigned long my_get_cas_fail_count;
+extern __thread unsigned long my_put_retry_count;
+extern __thread unsigned long my_get_retry_count;
 extern __thread unsigned long my_null_count;
 extern __thread unsigned long my_hop_count;
 extern __thread unsigned long my_slide_count;
+extern __thread unsigned long my_ring_alloc_count;
+extern __thread unsigned long my_ring_reuse_count;
 
 //#define EMPTY ((void *) -1)
 
+// Default entries per ring, the size of the rings of a queue can be changed with lcrq_set_ring_size
 #ifndef LCRQ_RING_SIZE
 #define LCRQ_RING_SIZE (1ull << 12)
 #endif
+// Ring sizes are powers of two in this range, with one pool of drained rings per size
+#define LCRQ_MIN_RING_ORDER 1
+#define LCRQ_MAX_RING_ORDER 24
+
+// Operations between the quiescent points where a thread announces it holds no ring loaded before
+#ifndef LCRQ_QUIESCENT_PERIOD
+#define LCRQ_QUIESCENT_PERIOD 64
+#endif
+// Threads that can operate on rings at the same time
+#ifndef LCRQ_MAX_THREADS
+#define LCRQ_MAX_THREADS 512
+#endif
 
 typedef struct RingNode {
   volatile uint64_t val;
@@ -59,12 +76,17 @@ typedef ALIGNED(CACHE_LINE_SIZE) struct RingQueue {
   struct RingQueue *next CACHE_ALIGNED;
   //New field
   int64_t items_enqueued;
-  PaddedRingNode array[LCRQ_RING_SIZE];
+  uint64_t size;
+  // Link while retired or pooled, as next stays readable by threads still in the ring
+  struct RingQueue *pool_next;
+  PaddedRingNode array[] __attribute__((aligned(16)));
 } RingQueue;
 
 typedef CACHE_ALIGNED struct {
   RingQueue * volatile head;
   RingQueue * volatile tail;
+  // Entries of the rings allocated for this queue
+  uint64_t ring_size;
   //int nprocs;
 } queue_t;
 
@@ -5,16 +5,20 @@
 
 void queue_init(queue_t * q, int nprocs);
 void queue_register(queue_t * q, handle_t * th, int id);
-void queue_free(queue_t * q, handle_t * h);
+void lcrq_queue_free(queue_t * q, handle_t * h);
 void handle_free(handle_t *h);
+void lcrq_set_ring_size(queue_t * q, uint64_t ring_size);
+void lcrq_thread_offline(void);
 
 
 /* INTERFACE FOR 2D TESTING FRAMEWORK */
 
 // Define generics for d-balanced-queue
 #define PARTIAL_T                   queue_t
-#define PARTIAL_ENQUEUE(q, k, v)    enqueue_wrap(q, &lcrq_handle, v)
-#define PARTIAL_DEQUEUE(q)          dequeue_wrap(q, &lcrq_handle)
+#define PARTIAL_ENQUEUE(q, k, v)    lcrq_enqueue_wrap(q, &lcrq_handle, v)
+#define PARTIAL_DEQUEUE(q)          lcrq_dequeue_wrap(q, &lcrq_handle)
+#define PARTIAL_ENQUEUE_BATCH(q, v, n)  lcrq_enqueue_batch_wrap(q, &lcrq_handle, v, n)
+#define PARTIAL_DEQUEUE_BATCH(q, v, m)  lcrq_dequeue_batch_wrap(q, &lcrq_handle, v, m)
 #define INIT_PARTIAL(q,n)           queue_init(q,n)
 #define PARTIAL_LENGTH(q)           lcrq_queue_size(q)
 #define PARTIAL_TAIL_VERSION(q)     lcrq_tail_version(q)
@@ -25,14 +29,16 @@ void handle_free(handle_t *h);
 extern __thread handle_t lcrq_handle;
 
 // Expose functions
-int enqueue_wrap(queue_t *q, handle_t *th, sval_t v);
-int dequeue_wrap(queue_t *q, handle_t *th);
+int lcrq_enqueue_wrap(queue_t *q, handle_t *th, sval_t v);
+sval_t lcrq_dequeue_wrap(queue_t *q, handle_t *th);
+int lcrq_enqueue_batch_wrap(queue_t *q, handle_t *th, sval_t *vals, size_t n);
+size_t lcrq_dequeue_batch_wrap(queue_t *q, handle_t *th, sval_t *vals, size_t max);
 uint64_t lcrq_queue_size(queue_t *q);
 uint64_t lcrq_enq_count(queue_t *q);
 uint64_t lcrq_deq_count(queue_t *q);
 uint64_t lcrq_tail_version(queue_t *q);
 
-int dequeue_wrap(queue_t *q, handle_t *th);
+sval_t lcrq_dequeue_wrap(queue_t *q, handle_t *th);
 
 /* End of interface */
 
@@ -0,0 +1,41 @@
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include "lprq.h"
+
+void lprq_queue_init(queue_t * q, int nprocs);
+void lprq_queue_free(queue_t * q, handle_t * h);
+void lprq_set_ring_size(queue_t * q, uint64_t ring_size);
+void lprq_thread_offline(void);
+
+
+/* INTERFACE FOR 2D TESTING FRAMEWORK */
+
+// Define generics for d-balanced-queue
+#define PARTIAL_T                   queue_t
+#define PARTIAL_ENQUEUE(q, k, v)    lprq_enqueue_wrap(q, &lprq_handle, v)
+#define PARTIAL_DEQUEUE(q)          lprq_dequeue_wrap(q, &lprq_handle)
+#define PARTIAL_ENQUEUE_BATCH(q, v, n)  lprq_enqueue_batch_wrap(q, &lprq_handle, v, n)
+#define PARTIAL_DEQUEUE_BATCH(q, v, m)  lprq_dequeue_batch_wrap(q, &lprq_handle, v, m)
+#define INIT_PARTIAL(q,n)           lprq_queue_init(q,n)
+#define PARTIAL_LENGTH(q)           lprq_queue_size(q)
+#define PARTIAL_TAIL_VERSION(q)     lprq_tail_version(q)
+#define PARTIAL_ENQ_COUNT(q)        lprq_enq_count(q)
+#define PARTIAL_DEQ_COUNT(q)        lprq_deq_count(q)
+#define EMPTY						((sval_t)0)
+
+extern __thread handle_t lprq_handle;
+
+// Expose functions
+int lprq_enqueue_wrap(queue_t *q, handle_t *th, sval_t v);
+sval_t lprq_dequeue_wrap(queue_t *q, handle_t *th);
+int lprq_enqueue_batch_wrap(queue_t *q, handle_t *th, sval_t *vals, size_t n);
+size_t lprq_dequeue_batch_wrap(queue_t *q, handle_t *th, sval_t *vals, size_t max);
+uint64_t lprq_queue_size(queue_t *q);
+uint64_t lprq_enq_count(queue_t *q);
+uint64_t lprq_deq_count(queue_t *q);
+uint64_t lprq_tail_version(queue_t *q);
+
+/* End of interface */
+
+#endif /* end of include guard: QUEUE_H */
@@ -32,7 +32,8 @@ void init_ms_queue(ms_queue_t *q) {
 		q->tail = init_desc;
 }
 
-static int enq_cae(node_t** next_node_loc, node_t* new_node)
+// Links the chain new_node..last_node, where last_node == new_node for a single enqueue
+static int enq_cae(node_t** next_node_loc, node_t* new_node, node_t* last_node)
 {
 	node_t* expected = NULL;
 #ifdef RELAXATION_TIMER_ANALYSIS
@@ -40,7 +41,11 @@ static int enq_cae(node_t** next_node_loc, node_t* new_node)
 	if (CAE(next_node_loc, &expected, &new_node))
 	{
 		// Save this count in a local array of (timestamp, )
-		add_relaxed_put(new_node->val, get_timestamp());
+		for (node_t* node = new_node; node != last_node; node = node->next)
+		{
+			add_relaxed_put(node->val, get_timestamp());
+		}
+		add_relaxed_put(last_node->val, get_timestamp());
 		return true;
 	}
 	return false;
@@ -51,8 +56,13 @@ static int enq_cae(node_t** next_node_loc, node_t* new_node)
 
 	if (CAE(next_node_loc, &expected, &new_node))
 	{
-		new_node->val = gen_relaxation_count();
-		add_linear(new_node->val, 0);
+		for (node_t* node = new_node; node != last_node; node = node->next)
+		{
+			node->val = gen_relaxation_count();
+			add_linear(node->val, 0);
+		}
+		last_node->val = gen_relaxation_count();
+		add_linear(last_node->val, 0);
 		unlock_relaxation_lists();
 		return true;
 	}
@@ -66,13 +76,19 @@ static int enq_cae(node_t** next_node_loc, node_t* new_node)
 #endif
 }
 
+// Moves the head past all nodes up to new_des_loc->node, which is more than one for a batch dequeue
 static int deq_cae(volatile descriptor_t* des_loc, descriptor_t* read_des_loc, descriptor_t* new_des_loc)
 {
 #ifdef RELAXATION_TIMER_ANALYSIS
 	// Use timers to track relaxation instead of locks
+	node_t* first_node = read_des_loc->node->next;
 	if (CAE(des_loc, read_des_loc, new_des_loc))
 	{
 		// TODO: Should we take the timestamp at another point in time?
+		for (node_t* node = first_node; node != new_des_loc->node; node = node->next)
+		{
+			add_relaxed_get(node->val, get_timestamp());
+		}
 		add_relaxed_get(new_des_loc->node->val, get_timestamp());
 		return true;
 	}
@@ -81,8 +97,13 @@ static int deq_cae(volatile descriptor_t* des_loc, descriptor_t* read_des_loc, d
 #elif RELAXATION_ANALYSIS
 
 	lock_relaxation_lists();
+	node_t* first_node = read_des_loc->node->next;
 	if (CAE(des_loc, read_des_loc, new_des_loc))
 	{
+		for (node_t* node = first_node; node != new_des_loc->node; node = node->next)
+		{
+			remove_linear(node->val);
+		}
 		remove_linear(new_des_loc->node->val);
 		unlock_relaxation_lists();
 		return true;
@@ -107,7 +128,7 @@ int ms_enqueue(ms_queue_t *q, skey_t key, sval_t val)
 		tail = q->tail;
 		if(tail.node->next == NULL)
 		{
-			if(enq_cae((node_t **) &tail.node->next, new_node))
+			if(enq_cae((node_t **) &tail.node->next, new_node, new_node))
 			{
 				break;
 			}
@@ -166,10 +187,205 @@ sval_t ms_dequeue(ms_queue_t *q)
 				#endif
 				return val;
 			}
+			my_get_retry_count+=1;
 		}
     }
 }
 
+// Pre-links all items into a chain, which is spliced in after the tail with a single CAS
+int ms_enqueue_batch(ms_queue_t *q, sval_t *vals, size_t n)
+{
+	if (n == 0) return 1;
+
+	node_t* first_node = create_ms_node(vals[0], vals[0], NULL);
+	node_t* last_node = first_node;
+	for (size_t i = 1; i < n; i++)
+	{
+		last_node->next = create_ms_node(vals[i], vals[i], NULL);
+		last_node = last_node->next;
+	}
+	descriptor_t tail;
+
+	while(1)
+	{
+		tail = q->tail;
+		if(tail.node->next == NULL)
+		{
+			if(enq_cae((node_t **) &tail.node->next, first_node, last_node))
+			{
+				break;
+			}
+		}
+		else
+		{
+			descriptor_t new_tail;
+			new_tail.count = tail.count + 1;
+			new_tail.node = tail.node->next;
+			CAE(&q->tail, &tail, &new_tail);
+		}
+
+		my_put_cas_fail_count+=1;
+	}
+	// Helpers only move the tail one node at a time, so the count stays exact if this CAS fails
+	descriptor_t new_tail;
+	new_tail.count = tail.count + n;
+	new_tail.node = last_node;
+	CAE(&q->tail, &tail, &new_tail);
+	return 1;
+}
+
+// Takes up to max items by moving the head past several nodes with a single CAS
+size_t ms_dequeue_batch(ms_queue_t *q, sval_t *vals, size_t max)
+{
+	descriptor_t head, tail, new_tail, new_head;
+
+	while (1)
+	{
+		head = q->head;
+		tail = q->tail;
+
+		if (unlikely(head.node == tail.node))
+		{
+			if(head.node->next == NULL)
+			{
+				my_null_count+=1;
+				return 0;
+			}
+			else
+			{
+				new_tail.count = tail.count + 1;
+				new_tail.node = tail.node->next;
+				CAE(&q->tail, &tail, &new_tail);
+			}
+		}
+		else
+		{
+			// Never move the head past the tail, as the tail node must not be freed
+			node_t* last_node = head.node;
+			size_t n = 0;
+			while (n < max && last_node != tail.node && last_node->next != NULL)
+			{
+				last_node = last_node->next;
+				n++;
+			}
+			if (n == 0) continue;
+
+			new_head.count = head.count + n;
+			new_head.node = last_node;
+			if(deq_cae((descriptor_t*) &q->head, &head, &new_head))
+			{
+				node_t* node = head.node;
+				for (size_t i = 0; i < n; i++)
+				{
+					node_t* next = node->next;
+					vals[i] = next->val;
+					#if GC == 1
+						ssmem_free(alloc, (void*) node);
+					#endif
+					node = next;
+				}
+				return n;
+			}
+			my_get_retry_count+=1;
+		}
+	}
+}
+
+// Reads the tail until two reads agree, as the node and count are not read atomically, and the count only grows
+static inline descriptor_t read_tail(ms_queue_t *q)
+{
+	descriptor_t tail = q->tail;
+	while (1)
+	{
+		descriptor_t again = q->tail;
+		if (again.node == tail.node && again.count == tail.count) return tail;
+		tail = again;
+	}
+}
+
+// Detaches every item up to the tail by moving the head onto the tail node with a single CAS, and returns the
+// number of items, which are then taken from the chain in order. Items enqueued after the tail was read are left.
+size_t ms_detach(ms_queue_t *q, ms_chain_t *chain)
+{
+	descriptor_t head, tail, new_tail;
+
+	while (1)
+	{
+		head = q->head;
+		tail = read_tail(q);
+
+		if (unlikely(head.node == tail.node || tail.count <= head.count))
+		{
+			if(head.node->next == NULL)
+			{
+				chain->left = 0;
+				return 0;
+			}
+			else
+			{
+				new_tail.count = tail.count + 1;
+				new_tail.node = tail.node->next;
+				CAE(&q->tail, &tail, &new_tail);
+			}
+		}
+		else if(deq_cae((descriptor_t*) &q->head, &head, &tail))
+		{
+			break;
+		}
+		else
+		{
+			my_get_retry_count+=1;
+		}
+	}
+
+	chain->node = head.node;
+	chain->left = tail.count - head.count;
+	return chain->left;
+}
+
+// Detaches every item up to the tail, and visits them in order while freeing their nodes
+size_t ms_drain(ms_queue_t *q, visit_fn_t visit, void *arg)
+{
+	ms_chain_t chain;
+	size_t n = ms_detach(q, &chain);
+	while (chain.left > 0)
+	{
+		visit(ms_chain_take(&chain), arg);
+	}
+	return n;
+}
+
+// Opens a chain over the items between the head and the tail without taking them, and returns their count.
+// Nodes dequeued meanwhile are still readable, as the caller holds back ssmem from reusing them, but their
+// items may since have been taken.
+size_t ms_chain_open(ms_queue_t *q, ms_chain_t *chain)
+{
+	descriptor_t head = q->head;
+	descriptor_t tail = read_tail(q);
+
+	chain->node = head.node;
+	chain->left = tail.count > head.count ? tail.count - head.count : 0;
+	return chain->left;
+}
+
+// Visits the items between the head and the tail without taking them
+size_t ms_snapshot(ms_queue_t *q, visit_fn_t visit, void *arg)
+{
+	ms_chain_t chain;
+	size_t n = 0;
+	ms_chain_open(q, &chain);
+	while (chain.left > 0)
+	{
+		sval_t val = ms_chain_peek(&chain);
+		if (val != EMPTY)
+		{
+			visit(val, arg);
+			n++;
+		}
+	}
+	return n;
+}
+
 size_t ms_queue_size(ms_queue_t *q){
 	return q->tail.count - q->head.count;
 }
@@ -27,6 +27,15 @@
 #define PARTIAL_T                   ms_queue_t
 #define PARTIAL_ENQUEUE(q, k, v)    ms_enqueue(q, k, v)
 #define PARTIAL_DEQUEUE(q)          ms_dequeue(q)
+#define PARTIAL_ENQUEUE_BATCH(q, v, n)  ms_enqueue_batch(q, v, n)
+#define PARTIAL_DEQUEUE_BATCH(q, v, m)  ms_dequeue_batch(q, v, m)
+#define PARTIAL_DRAIN(q, f, a)      ms_drain(q, f, a)
+#define PARTIAL_SNAPSHOT(q, f, a)   ms_snapshot(q, f, a)
+#define PARTIAL_CHAIN_T             ms_chain_t
+#define PARTIAL_DETACH(q, c)        ms_detach(q, c)
+#define PARTIAL_CHAIN_TAKE(c)       ms_chain_take(c)
+#define PARTIAL_CHAIN_OPEN(q, c)    ms_chain_open(q, c)
+#define PARTIAL_CHAIN_PEEK(c)       ms_chain_peek(c)
 #define INIT_PARTIAL(q,i)           init_ms_queue(q)
 #define PARTIAL_LENGTH(q)           ms_queue_size(q)
 #define PARTIAL_TAIL_VERSION(q)		ms_enq_count(q)
@@ -57,6 +66,13 @@ typedef ALIGNED(CACHE_LINE_SIZE) struct array_index
 	uint8_t padding[CACHE_LINE_SIZE - 2*sizeof(descriptor_t)];
 } ms_queue_t;
 
+// Nodes detached from a queue, or read by a snapshot, the items are in the left nodes after node
+typedef struct ms_chain
+{
+	node_t* node;
+	size_t left;
+} ms_chain_t;
+
 
 /*Global variables*/
 
@@ -67,6 +83,8 @@ extern __thread int thread_id;
 
 extern __thread unsigned long my_put_cas_fail_count;
 extern __thread unsigned long my_get_cas_fail_count;
+extern __thread unsigned long my_put_retry_count;
+extern __thread unsigned long my_get_retry_count;
 extern __thread unsigned long my_null_count;
 extern __thread unsigned long my_hop_count;
 extern __thread unsigned long my_slide_count;
@@ -74,9 +92,42 @@ extern __thread unsigned long my_slide_count;
 /* Interfaces */
 int ms_enqueue(ms_queue_t *set, skey_t key, sval_t val);
 sval_t ms_dequeue(ms_queue_t *q);
+int ms_enqueue_batch(ms_queue_t *q, sval_t *vals, size_t n);
+size_t ms_dequeue_batch(ms_queue_t *q, sval_t *vals, size_t max);
+size_t ms_detach(ms_queue_t *q, ms_chain_t *chain);
+size_t ms_drain(ms_queue_t *q, visit_fn_t visit, void *arg);
+size_t ms_chain_open(ms_queue_t *q, ms_chain_t *chain);
+size_t ms_snapshot(ms_queue_t *q, visit_fn_t visit, void *arg);
 void init_ms_queue(ms_queue_t *q);
 size_t ms_queue_size(ms_queue_t *set);
 uint64_t ms_enq_count(ms_queue_t *set);
 uint64_t ms_deq_count(ms_queue_t *set);
 
+// Takes the next item of a detached chain, which must have items left, and frees the node before it
+static inline sval_t ms_chain_take(ms_chain_t *chain)
+{
+	node_t* node = chain->node;
+	node_t* next = node->next;
+	#if GC == 1
+		ssmem_free(alloc, (void*) node);
+	#endif
+	chain->node = next;
+	chain->left--;
+	return next->val;
+}
+
+// Reads the next item of a chain opened by a snapshot, or EMPTY once the chain turns out shorter than counted
+static inline sval_t ms_chain_peek(ms_chain_t *chain)
+{
+	node_t* next = chain->node->next;
+	if (next == NULL)
+	{
+		chain->left = 0;
+		return EMPTY;
+	}
+	chain->node = next;
+	chain->left--;
+	return next->val;
+}
+
 #endif // D_BALANCED_MS_H
@@ -0,0 +1,14 @@
+#include "../dcbo-lprq/partial-queue.h"
+#include "d-balanced-queue.h"
+
+__thread handle_t lprq_handle;
+
+#define DCBO_FN(name) dcbo_lprq_##name
+#define BACKEND_ENQUEUE(q, k, v, i)         PARTIAL_ENQUEUE(q, k, v)
+#define BACKEND_DEQUEUE(q, i)               PARTIAL_DEQUEUE(q)
+#define BACKEND_ENQUEUE_BATCH(q, v, n, i)   PARTIAL_ENQUEUE_BATCH(q, v, n)
+#define BACKEND_DEQUEUE_BATCH(q, v, m, i)   PARTIAL_DEQUEUE_BATCH(q, v, m)
+#define BACKEND_REGISTER(set)
+#define BACKEND_THREAD_STATE                ((void**) &lprq_handle.next)
+
+#include "dcbo-engine.c"
@@ -0,0 +1,12 @@
+#include "../dcbo-ms/partial-ms.h"
+#include "d-balanced-queue.h"
+
+#define DCBO_FN(name) dcbo_ms_##name
+#define BACKEND_ENQUEUE(q, k, v, i)         PARTIAL_ENQUEUE(q, k, v)
+#define BACKEND_DEQUEUE(q, i)               PARTIAL_DEQUEUE(q)
+#define BACKEND_ENQUEUE_BATCH(q, v, n, i)   PARTIAL_ENQUEUE_BATCH(q, v, n)
+#define BACKEND_DEQUEUE_BATCH(q, v, m, i)   PARTIAL_DEQUEUE_BATCH(q, v, m)
+#define BACKEND_REGISTER(set)
+#define BACKEND_THREAD_STATE                NULL
+
+#include "dcbo-engine.c"
@@ -0,0 +1,16 @@
+#include "../dcbo-wfqueue/partial-wfqueue.h"
+#include "d-balanced-queue.h"
+
+// One handle per sub-queue for this thread, registered on its first operation on the sub-queue
+__thread handle_t** thread_handles;
+
+#define DCBO_FN(name) dcbo_wfqueue_##name
+#define BACKEND_ENQUEUE(q, k, v, i)         PARTIAL_ENQUEUE(q, k, v, i)
+#define BACKEND_DEQUEUE(q, i)               PARTIAL_DEQUEUE(q, i)
+#define BACKEND_ENQUEUE_BATCH(q, v, n, i)   PARTIAL_ENQUEUE_BATCH(q, v, n, i)
+#define BACKEND_DEQUEUE_BATCH(q, v, m, i)   PARTIAL_DEQUEUE_BATCH(q, v, m, i)
+#define BACKEND_REGISTER(set) \
+    thread_handles = calloc(ALLOCATED_WIDTH(set), sizeof(handle_t*))
+#define BACKEND_THREAD_STATE                ((void**) &thread_handles)
+
+#include "dcbo-engine.c"
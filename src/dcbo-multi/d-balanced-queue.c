@@ -0,0 +1,50 @@
+#include "d-balanced-queue.h"
+
+#include "dcbo-setup.c"
+
+// Indexed by dcbo_backend_t
+const char *dcbo_backend_names[DCBO_NUM_BACKENDS] = {"ms", "faaaq", "lcrq", "lprq", "wfqueue"};
+
+// Returns the backend with the given name, or -1 if there is none
+int dcbo_backend_parse(const char *name)
+{
+    for (int b = 0; b < DCBO_NUM_BACKENDS; b++)
+    {
+        if (strcmp(name, dcbo_backend_names[b]) == 0)
+            return b;
+    }
+    return -1;
+}
+
+mqueue_t* create_queue(uint32_t n_partial, uint32_t d, int nbr_threads, dcbo_backend_t backend)
+{
+    mqueue_t *set = alloc_queue_set(n_partial, d, nbr_threads);
+    set->backend = backend;
+
+    switch (backend)
+    {
+        case DCBO_MS: dcbo_ms_init_queues(set, nbr_threads); break;
+        case DCBO_FAAAQ: dcbo_faaaq_init_queues(set, nbr_threads); break;
+        case DCBO_LCRQ: dcbo_lcrq_init_queues(set, nbr_threads); break;
+        case DCBO_LPRQ: dcbo_lprq_init_queues(set, nbr_threads); break;
+        default: dcbo_wfqueue_init_queues(set, nbr_threads); break;
+    }
+
+	return set;
+}
+
+// Set up thread local variables for the queue
+mqueue_t* d_balanced_register(mqueue_t *set, int thread_id)
+{
+    register_queue_thread(set, thread_id);
+
+    switch ((dcbo_backend_t) set->backend)
+    {
+        case DCBO_MS: dcbo_ms_register_thread(set, thread_id); break;
+        case DCBO_FAAAQ: dcbo_faaaq_register_thread(set, thread_id); break;
+        case DCBO_LCRQ: dcbo_lcrq_register_thread(set, thread_id); break;
+        case DCBO_LPRQ: dcbo_lprq_register_thread(set, thread_id); break;
+        default: dcbo_wfqueue_register_thread(set, thread_id); break;
+    }
+    return set;
+}
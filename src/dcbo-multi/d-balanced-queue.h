@@ -0,0 +1,236 @@
+#ifndef D_BALANCED_QUEUE_H
+#define D_BALANCED_QUEUE_H
+
+#include <assert.h>
+#include <getopt.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/time.h>
+#include <time.h>
+#include <stdint.h>
+#include "common.h"
+
+#include "lock_if.h"
+#include "ssmem.h"
+#include "utils.h"
+#ifdef DCBO_NUMA
+#include <numa.h>
+#endif
+#ifdef EMPTY_SUMMARY
+#include "dcbo-summary.h"
+#define SUMMARY_FIELD_SIZE sizeof(summary_t*)
+#else
+#define SUMMARY_FIELD_SIZE 0
+#endif
+#ifdef COUNT_MIRROR
+#include "dcbo-mirror.h"
+#define MIRROR_FIELD_SIZE (2*sizeof(uint32_t*))
+#else
+#define MIRROR_FIELD_SIZE 0
+#endif
+#ifdef DCBO_ELASTIC
+#include "dcbo-elastic.h"
+#define ELASTIC_FIELD_SIZE (sizeof(uint64_t) + sizeof(uint32_t))
+#else
+#define ELASTIC_FIELD_SIZE 0
+#endif
+
+// The sub-queue backends are chosen at runtime, see backend-<name>.c for the partial queues
+#ifndef EMPTY
+#define EMPTY						((sval_t)0)
+#endif
+
+ /* ################################################################### *
+	* Definition of macros: per data structure
+* ################################################################### */
+
+#define DS_ADD(s,k,v)       enqueue(s,k,v)
+#define DS_REMOVE(s)        dequeue(s)
+#define DS_ADD_BATCH(s,v,n)     enqueue_batch(s,v,n)
+#define DS_REMOVE_BATCH(s,v,m)  dequeue_batch(s,v,m)
+#define DS_SIZE(s)          queue_size(s)
+#define DS_NEW(w,d,i,b)     create_queue(w,d,i,b)
+#define DS_REGISTER(q,i)	d_balanced_register(q,i)
+
+// Returned by the enqueues of a queue with a capacity, when the sub-queues they sample are all full
+#define QUEUE_FULL 0
+
+#define DS_HANDLE 			mqueue_t*
+#define DS_TYPE             mqueue_t
+#define DS_NODE             sval_t
+
+typedef enum dcbo_backend
+{
+	DCBO_MS,
+	DCBO_FAAAQ,
+	DCBO_LCRQ,
+	DCBO_LPRQ,
+	DCBO_WFQUEUE,
+	DCBO_NUM_BACKENDS
+} dcbo_backend_t;
+
+typedef ALIGNED(CACHE_LINE_SIZE) struct mqueue_file
+{
+	void *queues; // Array of the chosen backend's sub-queue type, of their addresses under NUMA=1
+#ifdef EMPTY_SUMMARY
+	summary_t *summary; // Non-emptiness flags searched when a sampled sub-queue is empty
+#endif
+#ifdef COUNT_MIRROR
+	volatile uint32_t *enq_mirror; // Packed copies of the sub-queue operation counts, read when sampling, NULL below MIRROR_MIN_D candidates
+	volatile uint32_t *deq_mirror;
+#endif
+#ifdef DCBO_ELASTIC
+	volatile uint64_t span; // Sub-queues that may hold items in the low half, see dcbo-elastic.h
+	uint32_t max_width; // Sub-queues allocated, the width enqueued to moves within it
+#endif
+	uint32_t width;
+    uint32_t d;
+	uint32_t sticky; // Operations to stay on a chosen sub-queue, 0 re-samples on every operation
+	uint32_t capacity; // Items per sub-queue before the enqueue choice passes it over, 0 for unbounded
+	uint32_t backend; // dcbo_backend_t dispatched on by every operation
+#ifdef DCBO_NUMA
+	uint32_t sockets; // Sub-queues are split evenly into one partition per socket
+	uint32_t numa_flat; // Sample all candidates globally, as in the flat design, for comparison
+	// With every option enabled the fields spill over one line, the padding then fills the second
+	uint8_t padding[(2*CACHE_LINE_SIZE - (sizeof(void*)) - 7*sizeof(int32_t) - SUMMARY_FIELD_SIZE - MIRROR_FIELD_SIZE - ELASTIC_FIELD_SIZE) % CACHE_LINE_SIZE];
+#else
+	uint8_t padding[CACHE_LINE_SIZE - (sizeof(void*)) - 5*sizeof(int32_t) - SUMMARY_FIELD_SIZE - MIRROR_FIELD_SIZE - ELASTIC_FIELD_SIZE];
+#endif
+} mqueue_t;
+
+// Address of sub-queue i, for the PARTIAL_T of the backend compiling the engine
+#ifdef DCBO_NUMA
+#define QUEUE(set, i) (((PARTIAL_T**) (set)->queues)[i])
+#else
+#define QUEUE(set, i) (&((PARTIAL_T*) (set)->queues)[i])
+#endif
+
+/*Global variables*/
+extern const char *dcbo_backend_names[DCBO_NUM_BACKENDS];
+
+/*Thread local variables*/
+extern __thread ssmem_allocator_t* alloc;
+extern __thread int thread_id;
+extern __thread uint64_t *double_collect_counts;
+extern __thread uint32_t sticky_enq_index;
+extern __thread uint32_t sticky_enq_left;
+extern __thread uint32_t sticky_deq_index;
+extern __thread uint32_t sticky_deq_left;
+
+extern __thread unsigned long my_put_cas_fail_count;
+extern __thread unsigned long my_get_cas_fail_count;
+extern __thread unsigned long my_null_count;
+extern __thread unsigned long my_hop_count;
+extern __thread unsigned long my_slide_count;
+extern __thread unsigned long my_sticky_resample_count;
+extern __thread unsigned long my_put_retry_count;
+extern __thread unsigned long my_get_retry_count;
+#ifdef DCBO_NUMA
+extern __thread uint32_t my_socket;
+extern __thread unsigned long my_remote_count;
+#endif
+#ifdef ELASTIC_CONTROLLER
+extern __thread elastic_controller_t controller;
+#endif
+
+static inline uint32_t random_index(mqueue_t *set)
+{
+	return (my_random(&(seeds[0]), &(seeds[1]), &(seeds[2])) % (set->width));
+}
+
+#ifdef DCBO_NUMA
+#define MIN_WIDTH(set) ((set)->sockets)
+#else
+#define MIN_WIDTH(set) 1
+#endif
+#ifdef DCBO_ELASTIC
+#define ALLOCATED_WIDTH(set) ((set)->max_width)
+#else
+#define ALLOCATED_WIDTH(set) ((set)->width)
+#endif
+
+/* Engine instances, one per backend */
+#define DCBO_ENGINE_INTERFACE(b) \
+	int dcbo_##b##_enqueue(mqueue_t *set, skey_t key, sval_t val); \
+	sval_t dcbo_##b##_dequeue(mqueue_t *set); \
+	int dcbo_##b##_enqueue_batch(mqueue_t *set, sval_t *vals, size_t n); \
+	size_t dcbo_##b##_dequeue_batch(mqueue_t *set, sval_t *vals, size_t max); \
+	sval_t dcbo_##b##_double_collect(mqueue_t *set, uint32_t start_index); \
+	sval_t dcbo_##b##_summary_dequeue(mqueue_t *set); \
+	void dcbo_##b##_init_queues(mqueue_t *set, int nbr_threads); \
+	size_t dcbo_##b##_queue_size(mqueue_t *set); \
+	void dcbo_##b##_register_thread(mqueue_t *set, int thread_id); \
+	void** dcbo_##b##_thread_state(void);
+
+DCBO_ENGINE_INTERFACE(ms)
+DCBO_ENGINE_INTERFACE(faaaq)
+DCBO_ENGINE_INTERFACE(lcrq)
+DCBO_ENGINE_INTERFACE(lprq)
+DCBO_ENGINE_INTERFACE(wfqueue)
+
+// A switch on the backend, well predicted as it never changes, instead of an indirect call per operation
+#define DCBO_DISPATCH(set, fn, ...) \
+	switch ((dcbo_backend_t) (set)->backend) \
+	{ \
+		case DCBO_MS: return dcbo_ms_##fn(__VA_ARGS__); \
+		case DCBO_FAAAQ: return dcbo_faaaq_##fn(__VA_ARGS__); \
+		case DCBO_LCRQ: return dcbo_lcrq_##fn(__VA_ARGS__); \
+		case DCBO_LPRQ: return dcbo_lprq_##fn(__VA_ARGS__); \
+		default: return dcbo_wfqueue_##fn(__VA_ARGS__); \
+	}
+
+/* Interfaces */
+static inline int enqueue(mqueue_t *set, skey_t key, sval_t val)
+{
+	DCBO_DISPATCH(set, enqueue, set, key, val);
+}
+
+static inline sval_t dequeue(mqueue_t *set)
+{
+	DCBO_DISPATCH(set, dequeue, set);
+}
+
+// Enqueues like enqueue, but backs off and retries while the sub-queues sampled are full
+static inline int enqueue_wait(mqueue_t *set, skey_t key, sval_t val)
+{
+	int res;
+	size_t full = 0;
+	while ((res = enqueue(set, key, val)) == QUEUE_FULL)
+	{
+		do_pause_exp(full++);
+	}
+	return res;
+}
+
+static inline int enqueue_batch(mqueue_t *set, sval_t *vals, size_t n)
+{
+	DCBO_DISPATCH(set, enqueue_batch, set, vals, n);
+}
+
+static inline size_t dequeue_batch(mqueue_t *set, sval_t *vals, size_t max)
+{
+	DCBO_DISPATCH(set, dequeue_batch, set, vals, max);
+}
+
+static inline size_t queue_size(mqueue_t *set)
+{
+	DCBO_DISPATCH(set, queue_size, set);
+}
+
+static inline void** backend_thread_state(mqueue_t *set)
+{
+	DCBO_DISPATCH(set, thread_state);
+}
+
+mqueue_t* create_queue(uint32_t n_partial, uint32_t d, int nbr_threads, dcbo_backend_t backend);
+int dcbo_backend_parse(const char *name);
+void dcbo_set_capacity(mqueue_t *set, size_t capacity);
+#ifdef DCBO_ELASTIC
+uint32_t dcbo_update_width(mqueue_t *set, uint32_t width);
+#endif
+mqueue_t* d_balanced_register(mqueue_t *set, int thread_id);
+
+#endif
@@ -0,0 +1,198 @@
+#include "d-balanced-queue.h"
+
+// Internal thread local count for double-collect
+// Don't have in header as it would double-instantiate both here and in the test file
+__thread uint64_t *double_collect_counts;
+__thread ssmem_allocator_t* alloc;
+
+// Sticky sub-queue affinity, the last chosen sub-queue is kept for set->sticky operations or until it is contended
+__thread uint32_t sticky_enq_index;
+__thread uint32_t sticky_enq_left;
+__thread uint32_t sticky_deq_index;
+__thread uint32_t sticky_deq_left;
+__thread unsigned long my_sticky_resample_count;
+// Retries that are not CAS failures, e.g. skipped tickets or fast-path retries, kept out of the CAS fail columns
+__thread unsigned long my_put_retry_count;
+__thread unsigned long my_get_retry_count;
+
+// Contention met by this thread, which re-samples the sticky sub-queue and drives the width controller
+#define PUT_CONTENTION (my_put_cas_fail_count + my_put_retry_count)
+#define GET_CONTENTION (my_get_cas_fail_count + my_get_retry_count)
+
+
+// Inserts go to a uniformly random sub-queue, as in the MultiQueue, which keeps the sub-queues' key distributions alike
+static inline uint32_t insert_choice(mqueue_t *set) {
+    if (set->sticky)
+    {
+        if (sticky_enq_left > 0)
+        {
+            sticky_enq_left--;
+            return sticky_enq_index;
+        }
+        sticky_enq_left = set->sticky - 1;
+        my_sticky_resample_count += 1;
+    }
+
+    sticky_enq_index = random_index(set);
+    return sticky_enq_index;
+}
+
+int enqueue(mqueue_t *set, skey_t key, sval_t val) {
+    uint32_t opt_index = insert_choice(set);
+    unsigned long fails = PUT_CONTENTION;
+    int res = PARTIAL_INSERT(&set->queues[opt_index], key, val);
+    // Re-sample on the next operation if the sticky sub-queue was contended
+    if (PUT_CONTENTION != fails) sticky_enq_left = 0;
+    return res;
+}
+
+// Samples d sub-queues and returns the index of the one with the smallest minimum key
+static inline uint32_t delete_choice(mqueue_t *set) {
+    if (set->sticky)
+    {
+        if (sticky_deq_left > 0)
+        {
+            sticky_deq_left--;
+            return sticky_deq_index;
+        }
+        sticky_deq_left = set->sticky - 1;
+        my_sticky_resample_count += 1;
+    }
+
+    uint32_t opt_index = random_index(set);
+    skey_t opt = PARTIAL_MIN_KEY(&set->queues[opt_index]);
+    for(int i = 1; i < set->d; i++ )
+    {
+        uint32_t index = random_index(set);
+        skey_t index_val = PARTIAL_MIN_KEY(&set->queues[index]);
+        if(index_val < opt)
+        {
+            opt_index = index;
+            opt = index_val;
+        }
+    }
+
+    sticky_deq_index = opt_index;
+    return opt_index;
+}
+
+sval_t dequeue(mqueue_t *set) {
+    sval_t v;
+    uint32_t opt_index;
+    while (1)
+    {
+        opt_index = delete_choice(set);
+        // Every sampled sub-queue was empty
+        if (PARTIAL_MIN_KEY(&set->queues[opt_index]) == HEAP_EMPTY_KEY) break;
+
+        if (PARTIAL_TRY_DELETE_MIN(&set->queues[opt_index], &v))
+        {
+            if (v != EMPTY) return v;
+            // Emptied since it was sampled
+            break;
+        }
+
+        // Re-sample instead of waiting for a locked sub-queue, its minimum is likely being removed anyway
+        my_get_retry_count += 1;
+        sticky_deq_left = 0;
+    }
+
+    sticky_deq_left = 0;
+    return double_collect(set, opt_index + 1);
+}
+
+sval_t double_collect(mqueue_t *set, uint32_t start_index){
+    uint32_t index;
+    uint32_t width = set->width;
+
+    start:
+    // Loop through all, collecting their insert counts and then try to delete if not empty
+    for(uint32_t i = 0; i<width; i++){
+        index = (start_index + i) % width; // TODO: Optimize away modulo
+
+        double_collect_counts[index] = PARTIAL_TAIL_VERSION(&set->queues[index]);
+        if (PARTIAL_MIN_KEY(&set->queues[index]) == HEAP_EMPTY_KEY) continue;
+        sval_t v = PARTIAL_DELETE_MIN(&(set->queues[index]));
+        if(v != EMPTY) return v;
+    }
+
+    // Return empty if all counts are the same and the queues are still empty, otherwise restart
+    for(uint32_t i = 0; i<width; i++){
+        index = (start_index + i) % width;
+        if (double_collect_counts[index] != PARTIAL_TAIL_VERSION(&(set->queues[index])))
+        {
+            start_index = index;
+            goto start;
+        }
+    }
+
+    return EMPTY;
+}
+
+mqueue_t* create_queue(uint32_t n_partial, uint32_t d, int nbr_threads)
+{
+    mqueue_t *set;
+
+	// Create an allocator for the main thread, as for the other d-CBO designs
+    ssalloc_init();
+	#if GC == 1
+    if (alloc == NULL)
+    {
+		alloc = (ssmem_allocator_t*) malloc(sizeof(ssmem_allocator_t));
+		assert(alloc != NULL);
+		ssmem_alloc_init_fs_size(alloc, SSMEM_DEFAULT_MEM_SIZE, SSMEM_GC_FREE_SET_SIZE, nbr_threads);
+    }
+	#endif
+
+	if ((set = (mqueue_t*) ssalloc_aligned(CACHE_LINE_SIZE, sizeof(mqueue_t))) == NULL)
+    {
+		perror("malloc");
+		exit(1);
+    }
+	set->width = n_partial;
+    set->d = d;
+    set->sticky = 0;
+	set->queues = ssalloc_aligned(CACHE_LINE_SIZE, n_partial*sizeof(PARTIAL_T));
+
+	uint32_t i;
+	for(i=0; i < set->width; i++)
+	{
+        INIT_PARTIAL(&(set->queues[i]));
+	}
+
+	return set;
+}
+
+size_t queue_size(mqueue_t *set)
+{
+    uint64_t total = 0;
+    for(int i=0; i<set->width; i++){
+        total+=PARTIAL_LENGTH(&set->queues[i]);
+    }
+    return total;
+}
+
+uint32_t random_index(mqueue_t *set)
+{
+	return (my_random(&(seeds[0]), &(seeds[1]), &(seeds[2])) % (set->width));
+}
+
+// Set up thread local variables for the queue
+mqueue_t* d_balanced_register(mqueue_t *set, int thread_id)
+{
+    ssalloc_init();
+	#if GC == 1
+    if (alloc == NULL)
+    {
+		alloc = (ssmem_allocator_t*) malloc(sizeof(ssmem_allocator_t));
+		assert(alloc != NULL);
+		ssmem_alloc_init_fs_size(alloc, SSMEM_DEFAULT_MEM_SIZE, SSMEM_GC_FREE_SET_SIZE, thread_id);
+    }
+	#endif
+
+	double_collect_counts = malloc(set->width*sizeof(uint64_t));
+#ifdef RELAXATION_TIMER_ANALYSIS
+	init_relaxation_analysis_local(thread_id);
+#endif
+    return set;
+}
@@ -0,0 +1,133 @@
+#include "partial-heap.h"
+
+#ifdef RELAXATION_TIMER_ANALYSIS
+#include "relaxation_analysis_pq.c"
+#endif
+
+
+void init_heap(heap_t *h)
+{
+	h->items = (heap_item_t*) malloc(HEAP_INITIAL_CAPACITY * sizeof(heap_item_t));
+	if (h->items == NULL)
+	{
+		perror("malloc");
+		exit(1);
+	}
+	h->capacity = HEAP_INITIAL_CAPACITY;
+	h->size = 0;
+	h->insert_count = 0;
+	h->min_key = HEAP_EMPTY_KEY;
+	INIT_LOCK(&h->lock);
+}
+
+// Takes the lock, counting it as contended if it first has to wait
+static inline void heap_lock(heap_t *h, unsigned long *fail_count)
+{
+	if (!HEAP_TRYLOCK(&h->lock))
+	{
+		*fail_count += 1;
+		LOCK(&h->lock);
+	}
+}
+
+static void sift_up(heap_item_t *items, size_t pos)
+{
+	heap_item_t item = items[pos];
+	while (pos > 0)
+	{
+		size_t parent = (pos - 1) / 2;
+		if (items[parent].key <= item.key)
+			break;
+		items[pos] = items[parent];
+		pos = parent;
+	}
+	items[pos] = item;
+}
+
+static void sift_down(heap_item_t *items, size_t size, size_t pos)
+{
+	heap_item_t item = items[pos];
+	while (2*pos + 1 < size)
+	{
+		size_t child = 2*pos + 1;
+		if (child + 1 < size && items[child + 1].key < items[child].key)
+			child++;
+		if (item.key <= items[child].key)
+			break;
+		items[pos] = items[child];
+		pos = child;
+	}
+	items[pos] = item;
+}
+
+int heap_insert(heap_t *h, skey_t key, sval_t val)
+{
+	heap_lock(h, &my_put_cas_fail_count);
+	if (h->size == h->capacity)
+	{
+		heap_item_t *items = (heap_item_t*) realloc(h->items, 2 * h->capacity * sizeof(heap_item_t));
+		if (items == NULL)
+		{
+			UNLOCK(&h->lock);
+			return false;
+		}
+		h->items = items;
+		h->capacity *= 2;
+	}
+
+	h->items[h->size].key = key;
+	h->items[h->size].val = val;
+	sift_up(h->items, h->size);
+	h->size += 1;
+	h->insert_count += 1;
+	h->min_key = h->items[0].key;
+#ifdef RELAXATION_TIMER_ANALYSIS
+	// Taken under the lock, so the stamps of one heap follow the order of its operations
+	add_relaxed_put(key, get_timestamp());
+#endif
+	UNLOCK(&h->lock);
+	return true;
+}
+
+// Removes the root, called with the lock held
+static inline sval_t heap_pop(heap_t *h)
+{
+	if (h->size == 0)
+		return EMPTY;
+
+	heap_item_t top = h->items[0];
+	h->size -= 1;
+	if (h->size > 0)
+	{
+		h->items[0] = h->items[h->size];
+		sift_down(h->items, h->size, 0);
+	}
+	h->min_key = h->size > 0 ? h->items[0].key : HEAP_EMPTY_KEY;
+#ifdef RELAXATION_TIMER_ANALYSIS
+	add_relaxed_get(top.key, get_timestamp());
+#endif
+	return top.val;
+}
+
+sval_t heap_delete_min(heap_t *h)
+{
+	heap_lock(h, &my_get_cas_fail_count);
+	sval_t val = heap_pop(h);
+	UNLOCK(&h->lock);
+	return val;
+}
+
+// Returns false without waiting if the heap is locked, otherwise removes its minimum into val, EMPTY if it has none
+int heap_try_delete_min(heap_t *h, sval_t *val)
+{
+	if (!HEAP_TRYLOCK(&h->lock))
+		return false;
+	*val = heap_pop(h);
+	UNLOCK(&h->lock);
+	return true;
+}
+
+size_t heap_size(heap_t *h)
+{
+	return h->size;
+}
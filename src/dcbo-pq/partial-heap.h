@@ -0,0 +1,86 @@
+#ifndef D_BALANCED_HEAP_H
+#define D_BALANCED_HEAP_H
+
+#include <assert.h>
+#include <getopt.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/time.h>
+#include <time.h>
+#include <stdint.h>
+#include "common.h"
+
+#include "lock_if.h"
+#include "ssmem.h"
+#include "utils.h"
+
+#ifdef RELAXATION_TIMER_ANALYSIS
+#include "relaxation_analysis_pq.h"
+#endif
+
+// Define generics for d-balanced-queue
+#define PARTIAL_T                   heap_t
+#define PARTIAL_INSERT(q, k, v)     heap_insert(q, k, v)
+#define PARTIAL_DELETE_MIN(q)       heap_delete_min(q)
+#define PARTIAL_TRY_DELETE_MIN(q, v)    heap_try_delete_min(q, v)
+#define INIT_PARTIAL(q)             init_heap(q)
+#define PARTIAL_LENGTH(q)           heap_size(q)
+#define PARTIAL_MIN_KEY(q)          ((q)->min_key)
+#define PARTIAL_TAIL_VERSION(q)     ((q)->insert_count)
+#define EMPTY						((sval_t)0)
+
+// Minimum key of an empty heap, above every key so empty heaps are never chosen over non-empty ones
+#define HEAP_EMPTY_KEY              ((skey_t) INTPTR_MAX)
+#define HEAP_INITIAL_CAPACITY       64
+
+// TRYLOCK is nonzero on success for the spin locks of lock_if.h, but follows pthreads for the others
+#if defined(MUTEX)
+#define HEAP_TRYLOCK(lock)          (TRYLOCK(lock) == 0)
+#elif defined(SPIN)
+#define HEAP_TRYLOCK(lock)          (pthread_spin_trylock((pthread_spinlock_t *) lock) == 0)
+#else
+#define HEAP_TRYLOCK(lock)          TRYLOCK(lock)
+#endif
+
+
+/* Type definitions */
+typedef struct heap_item
+{
+	skey_t key;
+	sval_t val;
+} heap_item_t;
+
+// A binary min-heap behind a lock, with its minimum key and insert count published for unlocked reads
+typedef ALIGNED(CACHE_LINE_SIZE) struct heap
+{
+	volatile skey_t min_key; // Key at the root, HEAP_EMPTY_KEY when empty
+	volatile uint64_t insert_count; // Only grows, so the double-collect can see inserts in between its passes
+	volatile size_t size;
+	size_t capacity;
+	heap_item_t *items;
+	ptlock_t lock;
+	uint8_t padding[(2*CACHE_LINE_SIZE - sizeof(skey_t) - sizeof(uint64_t) - 2*sizeof(size_t) - sizeof(heap_item_t*) - sizeof(ptlock_t)) % CACHE_LINE_SIZE];
+} heap_t;
+
+
+/*Global variables*/
+
+
+/*Thread local variables*/
+extern __thread ssmem_allocator_t* alloc;
+extern __thread int thread_id;
+
+extern __thread unsigned long my_put_cas_fail_count;
+extern __thread unsigned long my_get_cas_fail_count;
+
+/* Interfaces */
+int heap_insert(heap_t *h, skey_t key, sval_t val);
+sval_t heap_delete_min(heap_t *h);
+int heap_try_delete_min(heap_t *h, sval_t *val);
+void init_heap(heap_t *h);
+size_t heap_size(heap_t *h);
+
+#endif // D_BALANCED_HEAP_H
@@ -0,0 +1,28 @@
+#include "d-balanced-queue.h"
+
+#include "dcbo-setup.c"
+
+// The engine specialized to the one backend of this d-CBO, see dcbo-engine.c
+#define DCBO_FN(name) name
+#define BACKEND_ENQUEUE(q, k, v, i)         PARTIAL_ENQUEUE(q, k, v)
+#define BACKEND_DEQUEUE(q, i)               PARTIAL_DEQUEUE(q)
+#define BACKEND_ENQUEUE_BATCH(q, v, n, i)   PARTIAL_ENQUEUE_BATCH(q, v, n)
+#define BACKEND_DEQUEUE_BATCH(q, v, m, i)   PARTIAL_DEQUEUE_BATCH(q, v, m)
+#define BACKEND_REGISTER(set)
+
+#include "dcbo-engine.c"
+
+mqueue_t* create_queue(uint32_t n_partial, uint32_t d, int nbr_threads)
+{
+    mqueue_t *set = alloc_queue_set(n_partial, d, nbr_threads);
+    init_queues(set, nbr_threads);
+    return set;
+}
+
+// Set up thread local variables for the queue
+mqueue_t* d_balanced_register(mqueue_t *set, int thread_id)
+{
+    register_queue_thread(set, thread_id);
+    register_thread(set, thread_id);
+    return set;
+}
\ No newline at end of file
@@ -0,0 +1,377 @@
+#include "partial-ums.h"
+
+#ifdef RELAXATION_ANALYSIS
+#include "relaxation_analysis_queue.c"
+#elif RELAXATION_TIMER_ANALYSIS
+#include "relaxation_analysis_timestamps.c"
+#endif
+
+
+// Creates a node for the items from first on, holding the first n of vals
+static node_t* create_ums_node(uint64_t first, sval_t* vals, size_t n)
+{
+	#if GC == 1
+		node_t *node = ssmem_alloc(alloc, sizeof(node_t));
+	#else
+	  	node_t* node = ssalloc(sizeof(node_t));
+	#endif
+	node->next = NULL;
+	node->first = first;
+	for (size_t i = 0; i < UMS_NODE_SLOTS; i++)
+	{
+		node->vals[i] = i < n ? vals[i] : EMPTY;
+	}
+
+	return node;
+}
+
+static void free_ums_node(node_t* node)
+{
+	#if GC == 1
+		ssmem_free(alloc, (void*) node);
+	#endif
+}
+
+void init_ums_queue(ums_queue_t *q) {
+		// The first node counts as full, with the items before item 0
+		node_t* node = (node_t*) ssalloc_aligned(CACHE_LINE_SIZE, sizeof(node_t));
+		node->next = NULL;
+		node->first = -(uint64_t) UMS_NODE_SLOTS;
+		descriptor_t init_desc;
+		init_desc.count = 0;
+		init_desc.node = node;
+		q->head = init_desc;
+		q->tail = init_desc;
+}
+
+// Slot after the last item of the descriptor, UMS_NODE_SLOTS if the next item starts a new node, and 0 if
+// the descriptor was read torn between two versions, as the node and count are not read atomically
+static inline uint64_t next_slot(descriptor_t* des)
+{
+	uint64_t slot = des->count - des->node->first;
+	return slot <= UMS_NODE_SLOTS ? slot : 0;
+}
+
+// Places a single item in a free slot of the tail node
+static int enq_slot_cae(volatile sval_t* slot_loc, sval_t val)
+{
+	sval_t expected = EMPTY;
+#ifdef RELAXATION_TIMER_ANALYSIS
+	// Use timers to track relaxation instead of locks
+	if (CAE(slot_loc, &expected, &val))
+	{
+		add_relaxed_put(val, get_timestamp());
+		return true;
+	}
+	return false;
+
+#elif RELAXATION_ANALYSIS
+
+	lock_relaxation_lists();
+
+	if (CAE(slot_loc, &expected, &val))
+	{
+		*slot_loc = gen_relaxation_count();
+		add_linear(*slot_loc, 0);
+		unlock_relaxation_lists();
+		return true;
+	}
+	else {
+		unlock_relaxation_lists();
+		return false;
+	}
+
+#else
+	return CAE(slot_loc, &expected, &val);
+#endif
+}
+
+// Links the chain of nodes from new_node, holding n items, after the full tail node
+static int enq_link_cae(node_t* volatile* next_node_loc, node_t* new_node, size_t n)
+{
+	node_t* expected = NULL;
+#ifdef RELAXATION_TIMER_ANALYSIS
+	// Use timers to track relaxation instead of locks
+	if (CAE(next_node_loc, &expected, &new_node))
+	{
+		node_t* node = new_node;
+		for (size_t i = 0; i < n; i++)
+		{
+			if (i > 0 && i % UMS_NODE_SLOTS == 0) node = node->next;
+			add_relaxed_put(node->vals[i % UMS_NODE_SLOTS], get_timestamp());
+		}
+		return true;
+	}
+	return false;
+
+#elif RELAXATION_ANALYSIS
+
+	lock_relaxation_lists();
+
+	if (CAE(next_node_loc, &expected, &new_node))
+	{
+		node_t* node = new_node;
+		for (size_t i = 0; i < n; i++)
+		{
+			if (i > 0 && i % UMS_NODE_SLOTS == 0) node = node->next;
+			node->vals[i % UMS_NODE_SLOTS] = gen_relaxation_count();
+			add_linear(node->vals[i % UMS_NODE_SLOTS], 0);
+		}
+		unlock_relaxation_lists();
+		return true;
+	}
+	else {
+		unlock_relaxation_lists();
+		return false;
+	}
+
+#else
+	return CAE(next_node_loc, &expected, &new_node);
+#endif
+}
+
+// Moves the head past the n items from slot on in node, which are read into vals before the CAS
+static int deq_cae(volatile descriptor_t* des_loc, descriptor_t* read_des_loc, descriptor_t* new_des_loc, node_t* node, uint64_t slot, sval_t* vals, size_t n)
+{
+#ifdef RELAXATION_TIMER_ANALYSIS
+	// Use timers to track relaxation instead of locks
+	for (size_t i = 0; i < n; i++)
+	{
+		vals[i] = node->vals[slot + i];
+	}
+	if (CAE(des_loc, read_des_loc, new_des_loc))
+	{
+		for (size_t i = 0; i < n; i++)
+		{
+			add_relaxed_get(vals[i], get_timestamp());
+		}
+		return true;
+	}
+	return false;
+
+#elif RELAXATION_ANALYSIS
+
+	// Read under the lock, as enqueuers replace the items with relaxation counts while holding it
+	lock_relaxation_lists();
+	for (size_t i = 0; i < n; i++)
+	{
+		vals[i] = node->vals[slot + i];
+	}
+	if (CAE(des_loc, read_des_loc, new_des_loc))
+	{
+		for (size_t i = 0; i < n; i++)
+		{
+			remove_linear(vals[i]);
+		}
+		unlock_relaxation_lists();
+		return true;
+	}
+	else {
+		unlock_relaxation_lists();
+		return false;
+	}
+
+#else
+	for (size_t i = 0; i < n; i++)
+	{
+		vals[i] = node->vals[slot + i];
+	}
+	return CAE(des_loc, read_des_loc, new_des_loc);
+#endif
+}
+
+// Enqueues the first items of vals and returns how many. A free slot of the tail node takes a single item,
+// while a full tail node gets all n items linked after it as a chain of new nodes, with a single CAS
+static size_t enqueue_some(ums_queue_t *q, sval_t *vals, size_t n)
+{
+	node_t *first_node = NULL, *last_node = NULL, *node;
+	descriptor_t tail, new_tail;
+
+	while(1)
+	{
+		tail = q->tail;
+		uint64_t slot = next_slot(&tail);
+		if (unlikely(slot == 0)) continue;
+
+		if (slot < UMS_NODE_SLOTS)
+		{
+			new_tail.count = tail.count + 1;
+			new_tail.node = tail.node;
+			if (tail.node->vals[slot] == EMPTY)
+			{
+				if (enq_slot_cae(&tail.node->vals[slot], vals[0]))
+				{
+					n = 1;
+					break;
+				}
+			}
+			else
+			{
+				CAE(&q->tail, &tail, &new_tail);
+			}
+		}
+		else if ((node = tail.node->next) == NULL)
+		{
+			if (first_node == NULL)
+			{
+				first_node = last_node = create_ums_node(tail.count, vals, n < UMS_NODE_SLOTS ? n : UMS_NODE_SLOTS);
+				for (size_t i = UMS_NODE_SLOTS; i < n; i += UMS_NODE_SLOTS)
+				{
+					last_node->next = create_ums_node(tail.count + i, vals + i, n - i < UMS_NODE_SLOTS ? n - i : UMS_NODE_SLOTS);
+					last_node = last_node->next;
+				}
+			}
+			else
+			{
+				// Built during an earlier try, against a tail with another count
+				uint64_t first = tail.count;
+				for (node = first_node; node != NULL; node = node->next, first += UMS_NODE_SLOTS)
+				{
+					node->first = first;
+				}
+			}
+
+			if (enq_link_cae(&tail.node->next, first_node, n))
+			{
+				new_tail.count = tail.count + n;
+				new_tail.node = last_node;
+				first_node = NULL;
+				break;
+			}
+		}
+		else
+		{
+			new_tail.count = tail.count + 1;
+			new_tail.node = node;
+			CAE(&q->tail, &tail, &new_tail);
+		}
+
+		my_put_cas_fail_count+=1;
+	}
+	// Helpers only move the tail one item at a time, so the count stays exact if this CAS fails
+	CAE(&q->tail, &tail, &new_tail);
+
+	// A chain built for a full tail node, but the item went into a slot after all
+	while (first_node != NULL)
+	{
+		node = first_node->next;
+		free_ums_node(first_node);
+		first_node = node;
+	}
+	return n;
+}
+
+// Dequeues up to max items from the node of the next item with a single CAS, and returns how many, 0 if empty
+static size_t dequeue_some(ums_queue_t *q, sval_t *vals, size_t max)
+{
+	descriptor_t head, tail, new_tail, new_head;
+
+	while (1)
+	{
+		head = q->head;
+		tail = q->tail;
+
+		uint64_t slot = next_slot(&head);
+		if (unlikely(slot == 0)) continue;
+
+		node_t* node = head.node;
+		if (slot == UMS_NODE_SLOTS)
+		{
+			node = head.node->next;
+			slot = 0;
+		}
+
+		if (unlikely(head.count >= tail.count))
+		{
+			// Empty, unless an enqueue has placed its item without moving the tail yet
+			if (node == NULL || node->vals[slot] == EMPTY)
+			{
+				return 0;
+			}
+			else if (head.count == tail.count)
+			{
+				new_tail.count = tail.count + 1;
+				new_tail.node = node;
+				CAE(&q->tail, &tail, &new_tail);
+			}
+		}
+		else
+		{
+			// All items before the tail count are in place, and the head never moves past the tail node
+			size_t n = UMS_NODE_SLOTS - slot;
+			if (n > max) n = max;
+			if (n > tail.count - head.count) n = tail.count - head.count;
+
+			new_head.count = head.count + n;
+			new_head.node = node;
+			if(deq_cae((descriptor_t*) &q->head, &head, &new_head, node, slot, vals, n))
+			{
+				if (node != head.node)
+				{
+					free_ums_node(head.node);
+				}
+				return n;
+			}
+			my_get_retry_count+=1;
+		}
+	}
+}
+
+int ums_enqueue(ums_queue_t *q, skey_t key, sval_t val)
+{
+	enqueue_some(q, &val, 1);
+	return 1;
+}
+
+sval_t ums_dequeue(ums_queue_t *q)
+{
+	sval_t val;
+	if (dequeue_some(q, &val, 1) == 0)
+	{
+		my_null_count+=1;
+		return EMPTY;
+	}
+	return val;
+}
+
+// Fills the free slots of the tail node one item at a time, and links the rest with a single CAS
+int ums_enqueue_batch(ums_queue_t *q, sval_t *vals, size_t n)
+{
+	size_t i = 0;
+	while (i < n)
+	{
+		i += enqueue_some(q, vals + i, n - i);
+	}
+	return 1;
+}
+
+// Takes up to max items, with one CAS per node they span
+size_t ums_dequeue_batch(ums_queue_t *q, sval_t *vals, size_t max)
+{
+	size_t n = dequeue_some(q, vals, max);
+	if (n == 0)
+	{
+		my_null_count+=1;
+		return 0;
+	}
+
+	while (n < max)
+	{
+		size_t more = dequeue_some(q, vals + n, max - n);
+		if (more == 0) break;
+		n += more;
+	}
+	return n;
+}
+
+size_t ums_queue_size(ums_queue_t *q){
+	return q->tail.count - q->head.count;
+}
+
+uint64_t ums_enq_count(ums_queue_t *q) {
+	return q->tail.count;
+}
+
+uint64_t ums_deq_count(ums_queue_t *q) {
+	return q->head.count;
+}
@@ -0,0 +1,93 @@
+#ifndef D_BALANCED_UMS_H
+#define D_BALANCED_UMS_H
+
+#include <assert.h>
+#include <getopt.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/time.h>
+#include <time.h>
+#include <stdint.h>
+#include "common.h"
+
+#include "lock_if.h"
+#include "ssmem.h"
+#include "utils.h"
+
+#ifdef RELAXATION_TIMER_ANALYSIS
+#include "relaxation_analysis_timestamps.h"
+#elif RELAXATION_ANALYSIS
+#include "relaxation_analysis_queue.h"
+#endif
+
+// Define generics for d-balanced-queue
+#define PARTIAL_T                   ums_queue_t
+#define PARTIAL_ENQUEUE(q, k, v)    ums_enqueue(q, k, v)
+#define PARTIAL_DEQUEUE(q)          ums_dequeue(q)
+#define PARTIAL_ENQUEUE_BATCH(q, v, n)  ums_enqueue_batch(q, v, n)
+#define PARTIAL_DEQUEUE_BATCH(q, v, m)  ums_dequeue_batch(q, v, m)
+#define INIT_PARTIAL(q,i)           init_ums_queue(q)
+#define PARTIAL_LENGTH(q)           ums_queue_size(q)
+#define PARTIAL_TAIL_VERSION(q)		ums_enq_count(q)
+#define PARTIAL_ENQ_COUNT(q)        ums_enq_count(q)
+#define PARTIAL_DEQ_COUNT(q)        ums_deq_count(q)
+#define EMPTY						((sval_t)0)
+
+// Items per node, the default fills two cache lines with the node header
+#ifndef UMS_NODE_SLOTS
+#define UMS_NODE_SLOTS 14
+#endif
+
+/* Type definitions */
+// Item i of a sub-queue is in slot i - first of the node with first <= i < first + UMS_NODE_SLOTS, and an EMPTY slot is not yet enqueued
+typedef struct mqueue_node
+{
+	struct mqueue_node* volatile next;
+	uint64_t first;
+	volatile sval_t vals[UMS_NODE_SLOTS];
+} node_t;
+
+// The node holds item count - 1, the last one enqueued (dequeued) for the tail (head)
+typedef struct file_descriptor
+{
+	node_t* node;
+	uint64_t count;
+} descriptor_t;
+
+typedef ALIGNED(CACHE_LINE_SIZE) struct array_index
+{
+    volatile descriptor_t head;
+    volatile descriptor_t tail;
+	uint8_t padding[CACHE_LINE_SIZE - 2*sizeof(descriptor_t)];
+} ums_queue_t;
+
+
+/*Global variables*/
+
+
+/*Thread local variables*/
+extern __thread ssmem_allocator_t* alloc;
+extern __thread int thread_id;
+
+extern __thread unsigned long my_put_cas_fail_count;
+extern __thread unsigned long my_get_cas_fail_count;
+extern __thread unsigned long my_put_retry_count;
+extern __thread unsigned long my_get_retry_count;
+extern __thread unsigned long my_null_count;
+extern __thread unsigned long my_hop_count;
+extern __thread unsigned long my_slide_count;
+
+/* Interfaces */
+int ums_enqueue(ums_queue_t *q, skey_t key, sval_t val);
+sval_t ums_dequeue(ums_queue_t *q);
+int ums_enqueue_batch(ums_queue_t *q, sval_t *vals, size_t n);
+size_t ums_dequeue_batch(ums_queue_t *q, sval_t *vals, size_t max);
+void init_ums_queue(ums_queue_t *q);
+size_t ums_queue_size(ums_queue_t *q);
+uint64_t ums_enq_count(ums_queue_t *q);
+uint64_t ums_deq_count(ums_queue_t *q);
+
+#endif // D_BALANCED_UMS_H
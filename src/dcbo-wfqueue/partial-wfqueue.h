@@ -13,10 +13,15 @@
 #error "Cannot use lock-based relaxation analysis for wfqueue due to complexity of helping threads"
 #endif
 
+// Handle of this thread for sub-queue q at index i, registered with q on the first operation on it
+#define WFQUEUE_HANDLE(q, i)        (thread_handles[i] != NULL ? thread_handles[i] : wfqueue_register_lazy(q, &thread_handles[i]))
+
 // Define generics for d-balanced-queue
 #define PARTIAL_T                   queue_t
-#define PARTIAL_ENQUEUE(q,k,v,i)    enqueue_wrap(&thread_handles[i], (void*) v)
-#define PARTIAL_DEQUEUE(q, index)   dequeue_wrap(&thread_handles[index])
+#define PARTIAL_ENQUEUE(q,k,v,i)    enqueue_wrap(WFQUEUE_HANDLE(q, i), (void*) v)
+#define PARTIAL_DEQUEUE(q, index)   dequeue_wrap(WFQUEUE_HANDLE(q, index))
+#define PARTIAL_ENQUEUE_BATCH(q,v,n,i)  enqueue_batch_wrap(WFQUEUE_HANDLE(q, i), v, n)
+#define PARTIAL_DEQUEUE_BATCH(q,v,m,i)  dequeue_batch_wrap(WFQUEUE_HANDLE(q, i), v, m)
 #define INIT_PARTIAL(q,n)           wfqueue_init(q,n)
 #define PARTIAL_LENGTH(q)           wfqueue_length_heuristic(q)
 #define PARTIAL_TAIL_VERSION(q)     wfqueue_enq_count(q)
@@ -139,9 +144,10 @@ typedef struct _handle_t {
   struct _handle_t * Dh;
 
   /**
-   * Pointer to a spare node to use, to speedup adding a new node.
+   * Set when this handle linked the spare node of its thread into the queue, so that its next
+   * dequeue runs cleanup. The spare node itself is shared by all handles of the thread.
    */
-  struct _node_t * spare CACHE_ALIGNED;
+  int grown CACHE_ALIGNED;
 
   /**
    * Count the delay rounds of helping another dequeuer.
@@ -164,13 +170,22 @@ typedef struct _handle_t {
 
 
 extern __thread ssmem_allocator_t* alloc;
+extern __thread unsigned long my_put_cas_fail_count;
+extern __thread unsigned long my_get_cas_fail_count;
+extern __thread unsigned long my_put_retry_count;
+extern __thread unsigned long my_get_retry_count;
+// Handles of this thread per sub-queue, NULL until the thread first operates on the sub-queue
+extern __thread handle_t** thread_handles;
 
 // Expose functions
 int enqueue_wrap(handle_t *th, void *v);
 sval_t dequeue_wrap(handle_t *th);
+int enqueue_batch_wrap(handle_t *th, sval_t *vals, size_t n);
+size_t dequeue_batch_wrap(handle_t *th, sval_t *vals, size_t max);
 queue_t* wfqueue_create(int nprocs, int thread_id);
 void wfqueue_init(queue_t *q, int nprocs);
 handle_t* wfqueue_register(queue_t *q, handle_t* th, int id);
+handle_t* wfqueue_register_lazy(queue_t *q, handle_t **slot);
 uint64_t wfqueue_enq_count(queue_t *q);
 uint64_t wfqueue_deq_count(queue_t *q);
 uint64_t wfqueue_length_heuristic(queue_t *q);
@@ -39,24 +39,256 @@ __thread uint64_t deq_end_timestamp;
 
 __thread ssmem_allocator_t *alloc;
 
-// TODO: use ssmem_alloc when using GC (this uses ssmem instead of ssalloc)
-segment_t *create_segment(skey_t key, sval_t val, segment_t *next, uint64_t node_idx)
+__thread unsigned long my_segment_alloc_count;
+__thread unsigned long my_segment_reuse_count;
+
+/*
+ * Recycling of drained segments, as for the LCRQ rings. The dequeuer unlinking a segment from the head keeps
+ * it in a limbo list, and takes a snapshot of the quiescent slots of all threads once it has no older segments
+ * waiting. When every slot has changed since the snapshot, no thread can still be inside those segments, so
+ * their items are cleared and they move to the pool of their size, from where enqueuers take one before
+ * allocating a new segment.
+ *
+ * A thread changes its slot with an atomic swap at the start of every FAAAQ_QUIESCENT_PERIOD-th operation,
+ * when it holds no segment. Clearing the items when pooling keeps the memset away from the enqueuer linking
+ * a new segment, which every other enqueuer on the full tail segment waits for.
+ */
+#define SEGMENT_OFFLINE UINT64_MAX
+#define SEGMENT_BYTES(size) ((sizeof(segment_t) + (size)*sizeof(faaaq_item_t) + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1))
+
+typedef struct __attribute__((aligned(16))) segment_pool_top
+{
+    segment_t *segment;
+    uint64_t tag;
+} segment_pool_top_t;
+
+typedef ALIGNED(CACHE_LINE_SIZE) struct segment_pool
+{
+    segment_pool_top_t top;
+    uint8_t padding[CACHE_LINE_SIZE - sizeof(segment_pool_top_t)];
+} segment_pool_t;
+
+typedef ALIGNED(CACHE_LINE_SIZE) struct quiescent_slot
+{
+    volatile uint64_t epoch;
+    uint8_t padding[CACHE_LINE_SIZE - sizeof(uint64_t)];
+} quiescent_slot_t;
+
+static segment_pool_t segment_pools[FAAAQ_MAX_SEGMENT_ORDER + 1];
+static quiescent_slot_t quiescent_slots[FAAAQ_MAX_THREADS];
+static volatile uint32_t n_quiescent_slots;
+
+static __thread quiescent_slot_t *my_quiescent_slot;
+static __thread uint64_t my_segment_ops;
+static __thread uint64_t my_segment_epoch;
+// Segments retired after the snapshot was taken, and the ones waiting for every slot to change since it
+static __thread segment_t *my_retired_segments;
+static __thread segment_t *my_waiting_segments;
+static __thread uint64_t *my_segment_snapshot;
+static __thread uint32_t my_segment_snapshot_len;
+
+static inline uint32_t segment_order(uint64_t size)
+{
+    return __builtin_ctzll(size);
+}
+
+static void segment_pool_push(segment_t *segment)
+{
+    segment_pool_t *pool = &segment_pools[segment_order(segment->size)];
+    segment_pool_top_t top = pool->top;
+    segment_pool_top_t new_top;
+
+    do
+    {
+        segment->pool_next = top.segment;
+        new_top.segment = segment;
+        new_top.tag = top.tag + 1;
+    } while (!CAE(&pool->top, &top, &new_top));
+}
+
+static segment_t* segment_pool_pop(uint64_t size)
+{
+    segment_pool_t *pool = &segment_pools[segment_order(size)];
+    segment_pool_top_t top = pool->top;
+    segment_pool_top_t new_top;
+
+    // Pooled segments are never freed, so reading pool_next of one popped concurrently is safe, the tag fails the CAE
+    do
+    {
+        if (top.segment == NULL)
+            return NULL;
+        new_top.segment = top.segment->pool_next;
+        new_top.tag = top.tag + 1;
+    } while (!CAE(&pool->top, &top, &new_top));
+    return top.segment;
+}
+
+static void segment_snapshot_take(void)
+{
+    if (my_segment_snapshot == NULL)
+    {
+        my_segment_snapshot = (uint64_t*) malloc(FAAAQ_MAX_THREADS*sizeof(uint64_t));
+        assert(my_segment_snapshot != NULL);
+    }
+    my_segment_snapshot_len = n_quiescent_slots;
+    if (my_segment_snapshot_len > FAAAQ_MAX_THREADS)
+        my_segment_snapshot_len = FAAAQ_MAX_THREADS;
+    for (uint32_t i = 0; i < my_segment_snapshot_len; i++)
+        my_segment_snapshot[i] = quiescent_slots[i].epoch;
+}
+
+static int segment_snapshot_passed(void)
+{
+    for (uint32_t i = 0; i < my_segment_snapshot_len; i++)
+    {
+        if (my_segment_snapshot[i] != SEGMENT_OFFLINE && quiescent_slots[i].epoch == my_segment_snapshot[i])
+            return 0;
+    }
+    return 1;
+}
+
+// Pools the waiting segments if every thread passed a quiescent point, then starts waiting for the retired ones
+static void segment_reclaim(void)
+{
+    if (my_waiting_segments != NULL)
+    {
+        if (!segment_snapshot_passed())
+            return;
+        while (my_waiting_segments != NULL)
+        {
+            segment_t *segment = my_waiting_segments;
+            my_waiting_segments = segment->pool_next;
+            memset((void*) &segment->items[0], 0, segment->size*sizeof(faaaq_item_t));
+            segment_pool_push(segment);
+        }
+    }
+    if (my_retired_segments != NULL)
+    {
+        segment_snapshot_take();
+        my_waiting_segments = my_retired_segments;
+        my_retired_segments = NULL;
+    }
+}
+
+static void segment_retire(segment_t *segment)
+{
+    segment->pool_next = my_retired_segments;
+    my_retired_segments = segment;
+    segment_reclaim();
+}
+
+// Pools a segment that lost the race to be linked, so no other thread has seen it
+static void segment_unused(segment_t *segment, uint64_t filled)
+{
+    memset((void*) &segment->items[0], 0, filled*sizeof(faaaq_item_t));
+    segment_pool_push(segment);
+}
+
+// Takes a free slot, either one released by an offline thread or a new one
+static void segment_thread_online(void)
+{
+    uint64_t offline = SEGMENT_OFFLINE;
+    uint32_t n = n_quiescent_slots;
+    for (uint32_t i = 0; i < n && i < FAAAQ_MAX_THREADS; i++)
+    {
+        if (quiescent_slots[i].epoch == SEGMENT_OFFLINE && CAE(&quiescent_slots[i].epoch, &offline, &my_segment_epoch))
+        {
+            my_quiescent_slot = &quiescent_slots[i];
+            return;
+        }
+        offline = SEGMENT_OFFLINE;
+    }
+    uint32_t i = FAI_U32(&n_quiescent_slots);
+    if (i >= FAAAQ_MAX_THREADS)
+    {
+        fprintf(stderr, "More than %d threads on FAAArrayQueue segments, raise FAAAQ_MAX_THREADS\n", FAAAQ_MAX_THREADS);
+        abort();
+    }
+    my_quiescent_slot = &quiescent_slots[i];
+    SWAP_U64(&my_quiescent_slot->epoch, my_segment_epoch);
+}
+
+static void segment_quiescent(void)
+{
+    SWAP_U64(&my_quiescent_slot->epoch, ++my_segment_epoch);
+    segment_reclaim();
+}
+
+// Called by each entry point before it loads any segment, never while a segment is held
+static inline void segment_op_begin(void)
+{
+    if (unlikely(my_quiescent_slot == NULL))
+        segment_thread_online();
+    else if (unlikely((++my_segment_ops & (FAAAQ_QUIESCENT_PERIOD - 1)) == 0))
+        segment_quiescent();
+}
+
+// Releases the slot of a thread done with queue operations for now, so it no longer holds back recycling
+void faaaq_thread_offline(void)
 {
+    if (my_quiescent_slot == NULL)
+        return;
+    SWAP_U64(&my_quiescent_slot->epoch, SEGMENT_OFFLINE);
+    my_quiescent_slot = NULL;
+    segment_reclaim();
+}
+
+// A segment with all items empty, recycled if the pool has one of the size
+static segment_t* segment_get(uint64_t size)
+{
+    segment_t *segment = segment_pool_pop(size);
+
+    if (segment != NULL)
+    {
+        my_segment_reuse_count += 1;
+        return segment;
+    }
 #if GC == 1
-    segment_t *segment = (segment_t *)ssmem_alloc(alloc, sizeof(segment_t) + BUFFER_SIZE * sizeof(sval_t));
+    segment = (segment_t*) ssmem_alloc(alloc, SEGMENT_BYTES(size));
 #else
-    segment_t *segment = (segment_t *)ssalloc(sizeof(segment_t) + BUFFER_SIZE * sizeof(sval_t));
+    segment = (segment_t*) ssalloc(SEGMENT_BYTES(size));
 #endif
+    segment->size = size;
+    memset((void*) &segment->items[0], 0, size*sizeof(faaaq_item_t));
+    my_segment_alloc_count += 1;
+    return segment;
+}
+
+segment_t *create_segment(faaaq_val_t val, segment_t *next, uint64_t node_idx, uint64_t size)
+{
+    segment_t *segment = segment_get(size);
     segment->next = NULL;
     segment->deq_idx = 0;
     segment->enq_idx = 1;
     segment->node_idx = node_idx;
 
+#ifdef PAYLOAD_INLINE
+    segment->items[0].val = *val;
+    segment->items[0].state = CELL_FULL;
+#else
     segment->items[0] = val;
-    memset((void *)&segment->items[1], 0, (BUFFER_SIZE - 1) * sizeof(sval_t));
+#endif
     return segment;
 }
 
+#ifdef PAYLOAD_INLINE
+static int enq_cae(faaaq_item_t *item_loc, const payload_t *new_value)
+{
+    uint64_t expected = CELL_EMPTY;
+    uint64_t full = CELL_FULL;
+    // Only this enqueuer got the index, and a dequeuer that took the cell first never reads the payload
+    item_loc->val = *new_value;
+    return CAE(&item_loc->state, &expected, &full);
+}
+
+static int deq_swp(faaaq_item_t *item_loc, payload_t *val)
+{
+    if (SWAP_U64(&item_loc->state, CELL_TAKEN) != CELL_FULL)
+        return 0;
+    *val = item_loc->val;
+    return 1;
+}
+#else
 static int enq_cae(volatile sval_t *item_loc, sval_t new_value)
 {
     sval_t expected = EMPTY;
@@ -124,9 +356,15 @@ static sval_t deq_swp(volatile sval_t *item_loc)
     return SWAP_U64(item_loc, TAKEN);
 #endif
 }
+#endif
 
+#ifdef PAYLOAD_INLINE
+int faaaq_enqueue_payload(faaaq_t *q, const payload_t *val)
+#else
 int faaaq_enqueue(faaaq_t *q, skey_t key, sval_t val)
+#endif
 {
+    segment_op_begin();
     while (true)
     {
         ENQ_START_TIMESTAMP;
@@ -134,15 +372,18 @@ int faaaq_enqueue(faaaq_t *q, skey_t key, sval_t val)
         // Linearization point
         uint64_t idx = FAI_U64(&tail->enq_idx);
         ENQ_TIMESTAMP;
-        if (idx > BUFFER_SIZE - 1)
+        if (idx > tail->size - 1)
         {
             if (tail != q->tail)
                 continue;
             segment_t *next = tail->next;
             if (next == NULL)
             {
+                // Full if the segments from the head to this one already hold the capacity
+                if (q->capacity != 0 && (tail->node_idx - q->head->node_idx + 1) * tail->size >= q->capacity)
+                    return QUEUE_FULL;
                 // Create segment (node)
-                segment_t *new_segment = create_segment(key, val, NULL, tail->node_idx + 1);
+                segment_t *new_segment = create_segment(val, NULL, tail->node_idx + 1, tail->size);
                 segment_t *null_segment = NULL;
                 if (CAE(&tail->next, &null_segment, &new_segment))
                 {
@@ -156,9 +397,7 @@ int faaaq_enqueue(faaaq_t *q, skey_t key, sval_t val)
 
                     return 1;
                 }
-#if GC == 1
-                ssmem_free(alloc, (void *)new_segment);
-#endif
+                segment_unused(new_segment, 1);
             }
             else
             {
@@ -174,8 +413,28 @@ int faaaq_enqueue(faaaq_t *q, skey_t key, sval_t val)
     }
 }
 
+#ifndef PAYLOAD_INLINE
+// Enqueues like faaaq_enqueue, but backs off and retries while the queue is full
+int faaaq_enqueue_wait(faaaq_t *q, skey_t key, sval_t val)
+{
+    int res;
+    size_t full = 0;
+    while ((res = faaaq_enqueue(q, key, val)) == QUEUE_FULL)
+    {
+        do_pause_exp(full++);
+    }
+    return res;
+}
+#endif
+
+#ifdef PAYLOAD_INLINE
+// Copies the payload out of its cell, and returns 0 if empty
+int faaaq_dequeue_payload(faaaq_t *q, payload_t *val)
+#else
 sval_t faaaq_dequeue(faaaq_t *q, uint64_t *double_collect_count)
+#endif
 {
+    segment_op_begin();
     while (true)
     { // ta en timestamp här när vi börjar
         DEQ_START_TIMESTAMP;
@@ -185,19 +444,21 @@ sval_t faaaq_dequeue(faaaq_t *q, uint64_t *double_collect_count)
         // Linearization point
         uint64_t idx = FAI_U64(&head->deq_idx);
         DEQ_TIMESTAMP; // IDE: timestamp macro
-        if (idx > BUFFER_SIZE - 1)
+        if (idx > head->size - 1)
         {
             segment_t *next = head->next;
             if (next == NULL)
                 break;
             if (CAE(&q->head, &head, &next))
             {
-#if GC == 1
-                ssmem_free(alloc, (void *)head);
-#endif
+                segment_retire(head);
             }
             continue;
         }
+#ifdef PAYLOAD_INLINE
+        if (deq_swp(&head->items[idx], val))
+            return 1;
+#else
         sval_t item = deq_swp(&head->items[idx]);
         if (item != EMPTY)
         { // och en timestamp innan return
@@ -207,10 +468,24 @@ sval_t faaaq_dequeue(faaaq_t *q, uint64_t *double_collect_count)
 #endif
             return item;
         }
+#endif
     }
     return 0;
 }
 
+static void init_faaaq_queue_sized(faaaq_t *q, uint64_t segment_size)
+{
+    segment_t *segment = segment_get(segment_size);
+    segment->next = NULL;
+    segment->deq_idx = 0;
+    segment->enq_idx = 0;
+    segment->node_idx = 0;
+
+    q->head = segment;
+    q->tail = segment;
+    q->segment_size = segment_size;
+}
+
 void init_faaaq_queue(faaaq_t *q, int thread_id)
 {
 #if GC == 1
@@ -222,19 +497,29 @@ void init_faaaq_queue(faaaq_t *q, int thread_id)
     }
 #endif
 
-#if GC == 1
-    segment_t *segment = (segment_t *)ssmem_alloc(alloc, sizeof(segment_t) + BUFFER_SIZE * sizeof(sval_t));
-#else
-    segment_t *segment = (segment_t *)ssalloc(sizeof(segment_t) + BUFFER_SIZE * sizeof(sval_t));
-#endif
-    segment->next = NULL;
-    segment->deq_idx = 0;
-    segment->enq_idx = 0;
-    segment->node_idx = 0;
-    memset((void *)&segment->items[0], 0, BUFFER_SIZE * sizeof(sval_t));
+    init_faaaq_queue_sized(q, FAAAQ_SEGMENT_SIZE);
+    q->capacity = 0;
+}
 
-    q->head = segment;
-    q->tail = segment;
+// Sets the items per segment of q, including its first segment, so it must be called before q is shared
+void faaaq_set_segment_size(faaaq_t *q, uint64_t segment_size)
+{
+    assert((segment_size & (segment_size - 1)) == 0);
+    assert(segment_order(segment_size) >= FAAAQ_MIN_SEGMENT_ORDER && segment_order(segment_size) <= FAAAQ_MAX_SEGMENT_ORDER);
+    assert(q->head == q->tail && q->head->enq_idx == 0);
+
+    segment_t *first = q->head;
+    if (first->size == segment_size)
+        return;
+    init_faaaq_queue_sized(q, segment_size);
+    // Never used, so it can go straight to the pool
+    segment_pool_push(first);
+}
+
+// Bounds q to capacity items, rounded up to whole segments, 0 lifts the bound
+void faaaq_set_capacity(faaaq_t *q, uint64_t capacity)
+{
+    q->capacity = capacity;
 }
 
 faaaq_t *create_faaaq_queue(int thread_id)
@@ -251,9 +536,13 @@ size_t faaaq_queue_size(faaaq_t *q)
     segment_t *node = q->head;
     while (node)
     {
-        for (int idx = 0; idx < BUFFER_SIZE; idx += 1)
+        for (int idx = 0; idx < node->size; idx += 1)
         {
+#ifdef PAYLOAD_INLINE
+            if (node->items[idx].state == CELL_FULL)
+#else
             if (node->items[idx] != EMPTY && node->items[idx] != TAKEN)
+#endif
             {
                 size += 1;
             }
@@ -267,18 +556,18 @@ uint64_t faaaq_enq_count(faaaq_t *q)
 {
     segment_t *tail = q->tail;
     uint64_t idx = tail->enq_idx;
-    if (idx > BUFFER_SIZE - 1)
-        idx = BUFFER_SIZE;
-    return idx + BUFFER_SIZE * tail->node_idx;
+    if (idx > tail->size - 1)
+        idx = tail->size;
+    return idx + tail->size * tail->node_idx;
 }
 
 uint64_t faaaq_deq_count(faaaq_t *q)
 {
     segment_t *head = q->head;
     uint64_t idx = head->deq_idx;
-    if (idx > BUFFER_SIZE - 1)
-        idx = BUFFER_SIZE;
-    return idx + BUFFER_SIZE * head->node_idx;
+    if (idx > head->size - 1)
+        idx = head->size;
+    return idx + head->size * head->node_idx;
 }
 
 faaaq_t *queue_register(faaaq_t *set, int thread_id)
@@ -24,8 +24,14 @@
 #elif RELAXATION_ANALYSIS
 #include "relaxation_analysis_queue.h"
 #endif
+#ifdef PAYLOAD_INLINE
+#include "payload.h"
+#define DS_ADD_PAYLOAD(s,p)     faaaq_enqueue_payload(s,p)
+#define DS_REMOVE_PAYLOAD(s,p)  faaaq_dequeue_payload(s,p)
+#else
 #define DS_ADD(s,k,v)       faaaq_enqueue(s,k,v)
 #define DS_REMOVE(s)        faaaq_dequeue(s, NULL)
+#endif
 #define DS_SIZE(s)          faaaq_queue_size(s)
 #define DS_REGISTER(s,i)    queue_register(s,i)
 #define DS_NEW(i)           create_faaaq_queue(i)
@@ -37,24 +43,68 @@
 #define EMPTY						((sval_t)0)
 // Internally used macros
 #define TAKEN				        ((sval_t) -1)
-#define BUFFER_SIZE 		        ((uint64_t) 1024)
+// Returned by the enqueues of a queue with a capacity, when its segments are all in use
+#define QUEUE_FULL                  0
+
+// Default items per segment, the size of the segments of a queue can be changed with faaaq_set_segment_size
+#ifndef FAAAQ_SEGMENT_SIZE
+#define FAAAQ_SEGMENT_SIZE          ((uint64_t) 1024)
+#endif
+// Segment sizes are powers of two in this range, with one pool of drained segments per size
+#define FAAAQ_MIN_SEGMENT_ORDER     1
+#define FAAAQ_MAX_SEGMENT_ORDER     24
+
+// Operations between the quiescent points where a thread announces it holds no segment loaded before
+#ifndef FAAAQ_QUIESCENT_PERIOD
+#define FAAAQ_QUIESCENT_PERIOD      64
+#endif
+// Threads that can operate on segments at the same time
+#ifndef FAAAQ_MAX_THREADS
+#define FAAAQ_MAX_THREADS           512
+#endif
 
 /* Type definitions */
 
+#ifdef PAYLOAD_INLINE
+// States of a cell, kept apart from its payload so that no payload value is reserved
+#define CELL_EMPTY                  0
+#define CELL_FULL                   1
+#define CELL_TAKEN                  2
+
+// The payload is written before the state is set to full, and only read by the dequeuer taking the cell
+typedef struct cell
+{
+    volatile uint64_t state;
+    payload_t val;
+} faaaq_item_t;
+
+typedef const payload_t* faaaq_val_t;
+#else
+typedef volatile sval_t faaaq_item_t;
+typedef sval_t faaaq_val_t;
+#endif
+
 typedef ALIGNED(CACHE_LINE_SIZE) struct segment
 {
 	ALIGNED(CACHE_LINE_SIZE) volatile uint64_t enq_idx;
     ALIGNED(CACHE_LINE_SIZE) volatile uint64_t deq_idx;
     ALIGNED(CACHE_LINE_SIZE) struct segment *volatile next;
     uint64_t node_idx;
-	volatile sval_t items[];
+    uint64_t size;
+    // Link while retired or pooled, as next stays readable by threads still in the segment
+    struct segment *pool_next;
+	faaaq_item_t items[];
 } segment_t;
 
 typedef ALIGNED(CACHE_LINE_SIZE) struct faaaq
 {
     segment_t * volatile head;
     segment_t * volatile tail;
-	uint8_t padding[CACHE_LINE_SIZE - 2*sizeof(segment_t*)];
+    // Items per segment allocated for this queue
+    uint64_t segment_size;
+    // Items the queue holds, rounded up to whole segments, before enqueues fail, 0 for unbounded
+    uint64_t capacity;
+	uint8_t padding[CACHE_LINE_SIZE - 2*sizeof(segment_t*) - 2*sizeof(uint64_t)];
 } faaaq_t;
 
 
@@ -69,12 +119,23 @@ extern __thread unsigned long my_get_cas_fail_count;
 extern __thread unsigned long my_null_count;
 extern __thread unsigned long my_hop_count;
 extern __thread unsigned long my_slide_count;
+extern __thread unsigned long my_segment_alloc_count;
+extern __thread unsigned long my_segment_reuse_count;
 
 /* Interfaces */
+#ifdef PAYLOAD_INLINE
+int faaaq_enqueue_payload(faaaq_t *queue, const payload_t *val);
+int faaaq_dequeue_payload(faaaq_t *queue, payload_t *val);
+#else
 int faaaq_enqueue(faaaq_t *queue, skey_t key, sval_t val);
+int faaaq_enqueue_wait(faaaq_t *queue, skey_t key, sval_t val);
 sval_t faaaq_dequeue(faaaq_t *queue, uint64_t *double_collect_count);
+#endif
 void init_faaaq_queue(faaaq_t *queue, int thread_id);
 faaaq_t *create_faaaq_queue(int thread_id);
+void faaaq_set_segment_size(faaaq_t *queue, uint64_t segment_size);
+void faaaq_set_capacity(faaaq_t *queue, uint64_t capacity);
+void faaaq_thread_offline(void);
 faaaq_t* queue_register(faaaq_t* set, int thread_id);
 size_t faaaq_queue_size(faaaq_t *queue);
 uint64_t faaaq_enq_count(faaaq_t *queue);
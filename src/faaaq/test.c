@@ -49,6 +49,7 @@
 RETRY_STATS_VARS_GLOBAL;
 
 size_t initial = DEFAULT_INITIAL;
+size_t capacity = 0;
 size_t range = DEFAULT_RANGE;
 size_t update = 100;
 size_t load_factor;
@@ -67,6 +68,7 @@ uint32_t rand_max;
 
 static volatile int stop;
 size_t side_work = 0;
+uint64_t segment_size = FAAAQ_SEGMENT_SIZE;
 
 TEST_VARS_GLOBAL;
 
@@ -81,6 +83,8 @@ volatile unsigned long *get_cas_fail_count;
 volatile unsigned long *null_count;
 volatile unsigned long *hop_count;
 volatile unsigned long *slide_count;
+volatile unsigned long *segment_alloc_count;
+volatile unsigned long *segment_reuse_count;
 volatile ticks *removing_count;
 volatile ticks *removing_count_succ;
 volatile ticks *total;
@@ -224,6 +228,8 @@ void *test(void *thread)
 	null_count[thread_id] = my_null_count;
 	hop_count[thread_id] = my_hop_count;
 	slide_count[thread_id] = my_slide_count;
+	segment_alloc_count[thread_id] = my_segment_alloc_count;
+	segment_reuse_count[thread_id] = my_segment_reuse_count;
 
 	EXEC_IN_DEC_ID_ORDER(thread_id, num_threads)
 	{
@@ -257,13 +263,15 @@ int main(int argc, char **argv)
 		{"num-buckets", required_argument, NULL, 'b'},
 		{"print-vals", required_argument, NULL, 'v'},
 		{"vals-pf", required_argument, NULL, 'f'},
+		{"capacity", required_argument, NULL, 'C'},
+		{"segment-size", required_argument, NULL, 'R'},
 		{NULL, 0, NULL, 0}};
 
 	int i, c;
 	while (1)
 	{
 		i = 0;
-		c = getopt_long(argc, argv, "hAf:d:i:n:r:u:m:a:l:p:b:v:f:y:z:k:w:s:c:", long_options, &i);
+		c = getopt_long(argc, argv, "hAf:d:i:n:r:u:m:a:l:p:b:v:f:y:z:k:w:s:c:R:C:", long_options, &i);
 		if (c == -1)
 			break;
 		if (c == 0 && long_options[i].flag == 0)
@@ -306,12 +314,19 @@ int main(int argc, char **argv)
 				   "  -w, --width <int>\n"
 				   "        Width (Number of sub-structures).\n"
 				   "  -c, --choices <int>\n"
-				   "        The number of choices to use (refered to as d in d-balanced queues) [DEFAULT=2].\n",
+				   "        The number of choices to use (refered to as d in d-balanced queues) [DEFAULT=2].\n"
+				   "  -R, --segment-size <int>\n"
+				   "        Items per segment, a power of two [DEFAULT=1024].\n"
+				   "  -C, --capacity <int>\n"
+				   "        Items the queue holds before enqueues fail as full, in whole segments, 0 is unbounded [DEFAULT=0].\n",
 				   argv[0]);
 			exit(0);
 		case 'd':
 			duration = atoi(optarg);
 			break;
+		case 'C':
+			capacity = atol(optarg);
+			break;
 		case 'i':
 			initial = atoi(optarg);
 			break;
@@ -340,6 +355,14 @@ int main(int argc, char **argv)
 		case 's':
 			side_work = atoi(optarg);
 			break;
+		case 'R':
+			segment_size = atol(optarg);
+			if (!is_power_of_two(segment_size) || segment_size < (1ull << FAAAQ_MIN_SEGMENT_ORDER) || segment_size > (1ull << FAAAQ_MAX_SEGMENT_ORDER))
+			{
+				printf("The segment size must be a power of two between %llu and %llu\n", 1ull << FAAAQ_MIN_SEGMENT_ORDER, 1ull << FAAAQ_MAX_SEGMENT_ORDER);
+				exit(1);
+			}
+			break;
 		case 'w':
 		case 'c':
 		case 'm':
@@ -400,6 +423,12 @@ int main(int argc, char **argv)
 
 	rand_max = range - 1;
 
+	if (capacity != 0 && capacity < initial)
+	{
+		printf("** raising capacity to fit the initial items: old: %zu / new: %zu\n", capacity, initial);
+		capacity = initial;
+	}
+
 	struct timeval start, end;
 	struct timespec timeout;
 	timeout.tv_sec = duration / 1000;
@@ -408,6 +437,8 @@ int main(int argc, char **argv)
 
 	DS_TYPE *set = DS_NEW(thread_id);
 	assert(set != NULL);
+	faaaq_set_capacity(set, capacity);
+	faaaq_set_segment_size(set, segment_size);
 
 	/* Initializes the local data */
 	putting_succ = (ticks *)calloc(num_threads, sizeof(ticks));
@@ -422,6 +453,8 @@ int main(int argc, char **argv)
 	get_cas_fail_count = (unsigned long *)calloc(num_threads, sizeof(unsigned long));
 	null_count = (unsigned long *)calloc(num_threads, sizeof(unsigned long));
 	slide_count = (unsigned long *)calloc(num_threads, sizeof(unsigned long));
+	segment_alloc_count = (unsigned long *)calloc(num_threads, sizeof(unsigned long));
+	segment_reuse_count = (unsigned long *)calloc(num_threads, sizeof(unsigned long));
 	hop_count = (unsigned long *)calloc(num_threads, sizeof(unsigned long));
 
 	pthread_t threads[num_threads];
@@ -486,6 +519,8 @@ int main(int argc, char **argv)
 	volatile unsigned long get_cas_fail_count_total = 0;
 	volatile unsigned long null_count_total = 0;
 	volatile unsigned long slide_count_total = 0;
+	volatile unsigned long segment_alloc_count_total = 0;
+	volatile unsigned long segment_reuse_count_total = 0;
 	volatile unsigned long hop_count_total = 0;
 	volatile uint64_t removing_count_total = 0;
 	volatile uint64_t removing_count_total_succ = 0;
@@ -504,6 +539,8 @@ int main(int argc, char **argv)
 		null_count_total += null_count[t];
 		hop_count_total += hop_count[t];
 		slide_count_total += slide_count[t];
+		segment_alloc_count_total += segment_alloc_count[t];
+		segment_reuse_count_total += segment_reuse_count[t];
 		removing_count_total += removing_count[t];
 		removing_count_total_succ += removing_count_succ[t];
 	}
@@ -546,7 +583,8 @@ int main(int argc, char **argv)
 	printf("removing_perc , %10.1f \n", removing_perc);
 	printf("removing_effective , %10.1f \n", (removing_perc * removing_perc_succ) / 100);
 
-	double throughput = (putting_count_total + removing_count_total) * 1000.0 / duration;
+	// Enqueues that found the queue full are left out
+	double throughput = (putting_count_total_succ + removing_count_total) * 1000.0 / duration;
 
 	printf("num_threads , %zu \n", num_threads);
 	printf("Mops , %.3f\n", throughput / 1e6);
@@ -569,6 +607,11 @@ int main(int argc, char **argv)
 	printf("Null_Count , %zu\n", null_count_total);
 	printf("Hop_Count , %zu\n", hop_count_total);
 	printf("Slide_Count , %zu\n", slide_count_total);
+	printf("Capacity , %zu\n", capacity);
+	printf("Max_RSS_MB , %.1f\n", max_rss_mb());
+	printf("Segment_Size , %llu\n", (LLU)segment_size);
+	printf("Segment_Allocs , %zu\n", segment_alloc_count_total);
+	printf("Segment_Reuses , %zu\n", segment_reuse_count_total);
 
 	pthread_exit(NULL);
 
@@ -11,8 +11,6 @@
 #include "relaxation_analysis_timestamps.c"
 #endif
 
-#define RING_SIZE LCRQ_RING_SIZE
-
 // Want timers at FAA increments and not with the normal CAE
 #ifdef RELAXATION_TIMER_ANALYSIS
 uint64_t enq_timestamp, deq_timestamp;
@@ -33,10 +31,11 @@ static inline uint64_t node_unsafe(uint64_t i) __attribute__ ((pure));
 static inline uint64_t tail_index(uint64_t t) __attribute__ ((pure));
 static inline int crq_is_closed(uint64_t t) __attribute__ ((pure));
 
-static inline void init_ring(RingQueue *r) {
-  int i;
+static inline void init_ring(RingQueue *r, uint64_t size) {
+  uint64_t i;
 
-  for (i = 0; i < RING_SIZE; i++) {
+  r->size = size;
+  for (i = 0; i < size; i++) {
     r->array[i].ring_node.val = -1;
     r->array[i].ring_node.idx = i;
   }
@@ -109,16 +108,217 @@ static int deq_cae(volatile RingNode* item_loc, RingNode* expected, RingNode* ne
 #endif
 }
 
-void queue_init(queue_t * q, int nprocs)
+/*
+ * Recycling of drained rings. The thread unlinking a ring from the head keeps it in a limbo list, and
+ * takes a snapshot of the quiescent slots of all threads once it has no older rings waiting. When every
+ * slot has changed since the snapshot, no thread can still be inside those rings and they move to the
+ * pool of their size, from where enqueuers closing a ring take one before allocating a new ring.
+ *
+ * A thread changes its slot with an atomic swap at the start of every LCRQ_QUIESCENT_PERIOD-th operation,
+ * when it holds no ring, so each operation only pays a thread local increment. The swap orders the
+ * ring loads of the following operations after it, which is what makes a changed slot safe.
+ */
+#define RING_OFFLINE UINT64_MAX
+#define RING_BYTES(size) ((sizeof(RingQueue) + (size)*sizeof(PaddedRingNode) + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1))
+
+typedef struct __attribute__((aligned(16))) ring_pool_top {
+  RingQueue *ring;
+  uint64_t tag;
+} ring_pool_top_t;
+
+typedef CACHE_ALIGNED struct ring_pool {
+  ring_pool_top_t top;
+  uint8_t padding[CACHE_LINE_SIZE - sizeof(ring_pool_top_t)];
+} ring_pool_t;
+
+typedef CACHE_ALIGNED struct quiescent_slot {
+  volatile uint64_t epoch;
+  uint8_t padding[CACHE_LINE_SIZE - sizeof(uint64_t)];
+} quiescent_slot_t;
+
+static ring_pool_t ring_pools[LCRQ_MAX_RING_ORDER + 1];
+static quiescent_slot_t quiescent_slots[LCRQ_MAX_THREADS];
+static volatile uint32_t n_quiescent_slots;
+
+static __thread quiescent_slot_t *my_quiescent_slot;
+static __thread uint64_t my_ring_ops;
+static __thread uint64_t my_ring_epoch;
+// Rings retired after the snapshot was taken, and the ones waiting for every slot to change since it
+static __thread RingQueue *my_retired_rings;
+static __thread RingQueue *my_waiting_rings;
+static __thread uint64_t *my_ring_snapshot;
+static __thread uint32_t my_ring_snapshot_len;
+
+__thread unsigned long my_ring_alloc_count;
+__thread unsigned long my_ring_reuse_count;
+
+static inline uint32_t ring_order(uint64_t size) {
+  return __builtin_ctzll(size);
+}
+
+static void ring_pool_push(RingQueue *r) {
+  ring_pool_t *pool = &ring_pools[ring_order(r->size)];
+  ring_pool_top_t top = pool->top;
+  ring_pool_top_t new_top;
+
+  do {
+    r->pool_next = top.ring;
+    new_top.ring = r;
+    new_top.tag = top.tag + 1;
+  } while (!CAE(&pool->top, &top, &new_top));
+}
+
+static RingQueue* ring_pool_pop(uint64_t size) {
+  ring_pool_t *pool = &ring_pools[ring_order(size)];
+  ring_pool_top_t top = pool->top;
+  ring_pool_top_t new_top;
+
+  // Pooled rings are never freed, so reading pool_next of a ring popped concurrently is safe, the tag fails the CAE
+  do {
+    if (top.ring == NULL)
+      return NULL;
+    new_top.ring = top.ring->pool_next;
+    new_top.tag = top.tag + 1;
+  } while (!CAE(&pool->top, &top, &new_top));
+  return top.ring;
+}
+
+static void ring_snapshot_take(void) {
+  if (my_ring_snapshot == NULL) {
+    my_ring_snapshot = (uint64_t*) malloc(LCRQ_MAX_THREADS*sizeof(uint64_t));
+    assert(my_ring_snapshot != NULL);
+  }
+  my_ring_snapshot_len = n_quiescent_slots;
+  if (my_ring_snapshot_len > LCRQ_MAX_THREADS)
+    my_ring_snapshot_len = LCRQ_MAX_THREADS;
+  for (uint32_t i = 0; i < my_ring_snapshot_len; i++)
+    my_ring_snapshot[i] = quiescent_slots[i].epoch;
+}
+
+static int ring_snapshot_passed(void) {
+  for (uint32_t i = 0; i < my_ring_snapshot_len; i++) {
+    if (my_ring_snapshot[i] != RING_OFFLINE && quiescent_slots[i].epoch == my_ring_snapshot[i])
+      return 0;
+  }
+  return 1;
+}
+
+// Pools the waiting rings if every thread passed a quiescent point, then starts waiting for the retired ones
+static void ring_reclaim(void) {
+  if (my_waiting_rings != NULL) {
+    if (!ring_snapshot_passed())
+      return;
+    while (my_waiting_rings != NULL) {
+      RingQueue *r = my_waiting_rings;
+      my_waiting_rings = r->pool_next;
+      ring_pool_push(r);
+    }
+  }
+  if (my_retired_rings != NULL) {
+    ring_snapshot_take();
+    my_waiting_rings = my_retired_rings;
+    my_retired_rings = NULL;
+  }
+}
+
+static void ring_retire(RingQueue *rq) {
+  rq->pool_next = my_retired_rings;
+  my_retired_rings = rq;
+  ring_reclaim();
+}
+
+// Takes a free slot, either one released by an offline thread or a new one
+static void ring_thread_online(void) {
+  uint64_t offline = RING_OFFLINE;
+  uint32_t n = n_quiescent_slots;
+  for (uint32_t i = 0; i < n && i < LCRQ_MAX_THREADS; i++) {
+    if (quiescent_slots[i].epoch == RING_OFFLINE && CAE(&quiescent_slots[i].epoch, &offline, &my_ring_epoch)) {
+      my_quiescent_slot = &quiescent_slots[i];
+      return;
+    }
+    offline = RING_OFFLINE;
+  }
+  uint32_t i = FAI_U32(&n_quiescent_slots);
+  if (i >= LCRQ_MAX_THREADS) {
+    fprintf(stderr, "More than %d threads on LCRQ rings, raise LCRQ_MAX_THREADS\n", LCRQ_MAX_THREADS);
+    abort();
+  }
+  my_quiescent_slot = &quiescent_slots[i];
+  SWAP_U64(&my_quiescent_slot->epoch, my_ring_epoch);
+}
+
+static void ring_quiescent(void) {
+  SWAP_U64(&my_quiescent_slot->epoch, ++my_ring_epoch);
+  ring_reclaim();
+}
+
+// Called by each entry point before it loads any ring, never while a ring is held
+static inline void ring_op_begin(void) {
+  if (unlikely(my_quiescent_slot == NULL))
+    ring_thread_online();
+  else if (unlikely((++my_ring_ops & (LCRQ_QUIESCENT_PERIOD - 1)) == 0))
+    ring_quiescent();
+}
+
+// Releases the slot of a thread done with LCRQ operations for now, so it no longer holds back recycling
+void lcrq_thread_offline(void) {
+  if (my_quiescent_slot == NULL)
+    return;
+  SWAP_U64(&my_quiescent_slot->epoch, RING_OFFLINE);
+  my_quiescent_slot = NULL;
+  ring_reclaim();
+}
+
+// A ring for an enqueuer that closed the previous one, recycled if the pool has one of the size
+static RingQueue* ring_get(uint64_t size) {
+  RingQueue *nrq = ring_pool_pop(size);
+
+  if (nrq != NULL) {
+    my_ring_reuse_count += 1;
+  } else {
+#if GC == 1
+    //nrq = align_malloc(PAGE_SIZE, RING_BYTES(size));
+    nrq = (RingQueue*) ssmem_alloc(alloc, RING_BYTES(size));
+#else
+    nrq = (RingQueue*) ssalloc(RING_BYTES(size));
+#endif
+    my_ring_alloc_count += 1;
+  }
+  init_ring(nrq, size);
+  return nrq;
+}
+
+static void queue_init_sized(queue_t * q, uint64_t ring_size)
 {
-  RingQueue *rq = (RingQueue*) ssalloc_aligned(CACHE_LINE_SIZE, sizeof(RingQueue));
-  //RingQueue *rq = align_malloc(PAGE_SIZE, sizeof(RingQueue));
-  init_ring(rq);
+  RingQueue *rq = (RingQueue*) ssalloc_aligned(CACHE_LINE_SIZE, RING_BYTES(ring_size));
+  //RingQueue *rq = align_malloc(PAGE_SIZE, RING_BYTES(ring_size));
+  init_ring(rq, ring_size);
 
   q->head = rq;
   q->tail = rq;
+  q->ring_size = ring_size;
+}
+
+void queue_init(queue_t * q, int nprocs)
+{
+  queue_init_sized(q, LCRQ_RING_SIZE);
   //q->nprocs = nprocs;
 }
+
+// Sets the entries of the rings of q, including its first ring, so it must be called before q is shared
+void lcrq_set_ring_size(queue_t * q, uint64_t ring_size)
+{
+  assert((ring_size & (ring_size - 1)) == 0);
+  assert(ring_order(ring_size) >= LCRQ_MIN_RING_ORDER && ring_order(ring_size) <= LCRQ_MAX_RING_ORDER);
+  assert(q->head == q->tail && q->head->tail == 0);
+
+  RingQueue *first = q->head;
+  if (first->size == ring_size)
+    return;
+  queue_init_sized(q, ring_size);
+  // Never used, so it can go straight to the pool
+  ring_pool_push(first);
+}
 //Unique to this strict variant
 queue_t* queue_create()
 {
@@ -161,6 +361,7 @@ static void lcrq_put(queue_t * q, handle_t * handle, uint64_t arg) {
   while (1) {
     //RingQueue *rq = hzdptr_setv(&q->tail, &handle->hzdptr, 0);
     RingQueue *rq = q->tail;
+    const uint64_t ring_size = rq->size;
 
     RingQueue *next = rq->next;
 
@@ -177,15 +378,13 @@ static void lcrq_put(queue_t * q, handle_t * handle, uint64_t arg) {
 alloc:
       nrq = handle->next;
 
-      if (nrq == NULL) {
-	#if GC == 1
-        //nrq = align_malloc(PAGE_SIZE, sizeof(RingQueue));
-        nrq = (RingQueue*) ssmem_alloc(alloc, sizeof(RingQueue));
-	#else
-        nrq = (RingQueue*) ssalloc(sizeof(RingQueue));
-	#endif
-        init_ring(nrq);
+      // The spare ring may come from a queue with another ring size
+      if (nrq != NULL && nrq->size != q->ring_size) {
+        ring_pool_push(nrq);
+        nrq = NULL;
       }
+      if (nrq == NULL)
+        nrq = ring_get(q->ring_size);
 
       // Solo enqueue
       nrq->tail = 1;
@@ -206,7 +405,7 @@ alloc:
       continue;
     }
 
-    RingNode cell = rq->array[t & (RING_SIZE-1)].ring_node;
+    RingNode cell = rq->array[t & (ring_size-1)].ring_node;
 
     uint64_t idx = cell.idx;
     uint64_t val = cell.val;
@@ -217,7 +416,7 @@ alloc:
         new_value_ring_node.val = arg;
         new_value_ring_node.idx = t;
         if ((!node_unsafe(idx) || rq->head < t) &&
-            enq_cae(&rq->array[t & (RING_SIZE-1)].ring_node, &cell, &new_value_ring_node)) {
+            enq_cae(&rq->array[t & (ring_size-1)].ring_node, &cell, &new_value_ring_node)) {
           return;
         }
       }
@@ -225,7 +424,7 @@ alloc:
 
     uint64_t h = rq->head;
 
-    if ((int64_t)(t - h) >= (int64_t)RING_SIZE &&
+    if ((int64_t)(t - h) >= (int64_t)ring_size &&
         close_crq(rq, t, ++try_close)) {
       goto alloc;
     }
@@ -239,6 +438,7 @@ static uint64_t lcrq_get(queue_t * q, handle_t * handle) {
     //RingQueue *rq = hzdptr_setv(&q->head, &handle->hzdptr, 0);
     RingQueue *rq = q->head;
     RingQueue *next;
+    const uint64_t ring_size = rq->size;
 
     // Not in the paper, but added for better performance at nearly empty queues
     // Requires x86 memory order and volatile to not re-order these two reads
@@ -249,7 +449,7 @@ static uint64_t lcrq_get(queue_t * q, handle_t * handle) {
     uint64_t h = FAI_U64(&rq->head);
     DEQ_TIMESTAMP;
 
-    RingNode cell = rq->array[h & (RING_SIZE-1)].ring_node;
+    RingNode cell = rq->array[h & (ring_size-1)].ring_node;
 
     uint64_t tt = 0;
     int r = 0;
@@ -267,13 +467,13 @@ static uint64_t lcrq_get(queue_t * q, handle_t * handle) {
       if (!is_empty(val)) {
         if (idx == h) {
           new_value_ring_node.val = -1;
-          new_value_ring_node.idx = (unsafe | h) + RING_SIZE;
-          if (deq_cae(&rq->array[h & (RING_SIZE-1)].ring_node, &cell, &new_value_ring_node))
+          new_value_ring_node.idx = (unsafe | h) + ring_size;
+          if (deq_cae(&rq->array[h & (ring_size-1)].ring_node, &cell, &new_value_ring_node))
             return val;
         } else {
           new_value_ring_node.val = val;
           new_value_ring_node.idx = set_unsafe(idx);
-          if (CAE(&rq->array[h & (RING_SIZE-1)].ring_node, &cell, &new_value_ring_node)) {
+          if (CAE(&rq->array[h & (ring_size-1)].ring_node, &cell, &new_value_ring_node)) {
             break;
           }
         }
@@ -287,15 +487,15 @@ static uint64_t lcrq_get(queue_t * q, handle_t * handle) {
 
         if (unsafe) { // Nothing to do, move along
           new_value_ring_node.val = val;
-          new_value_ring_node.idx = (unsafe | h) + RING_SIZE;
-          if (CAE(&rq->array[h & (RING_SIZE-1)].ring_node, &cell, &new_value_ring_node))
+          new_value_ring_node.idx = (unsafe | h) + ring_size;
+          if (CAE(&rq->array[h & (ring_size-1)].ring_node, &cell, &new_value_ring_node))
             break;
         } else if (t < h + 1 || r > 200000 || crq_closed) {
           new_value_ring_node.val = val;
-          new_value_ring_node.idx = h + RING_SIZE;
+          new_value_ring_node.idx = h + ring_size;
           //Do not believe this replaces starvation functionality
-          if (CAE(&rq->array[h & (RING_SIZE-1)].ring_node, &cell, &new_value_ring_node)) {
-            if (r > 200000 && tt > RING_SIZE)
+          if (CAE(&rq->array[h & (ring_size-1)].ring_node, &cell, &new_value_ring_node)) {
+            if (r > 200000 && tt > ring_size)
               TAS_U64(&rq->tail, 63);
             break;
           }
@@ -314,7 +514,7 @@ static uint64_t lcrq_get(queue_t * q, handle_t * handle) {
       if (tail_index(rq->tail) <= h + 1) {
         if (CAE(&q->head, &rq, &next)) {
           #if GC == 1
-    				ssmem_free(alloc, (void*) rq);
+    				ring_retire(rq);
     			#endif
     //      hzdptr_retire(&handle->hzdptr, rq);
         }
@@ -334,11 +534,13 @@ static uint64_t lcrq_get(queue_t * q, handle_t * handle) {
 
 void enqueue_(queue_t * q, handle_t * th, void * val)
 {
+  ring_op_begin();
   lcrq_put(q, th, (uint64_t) val);
 }
 
 void * dequeue_(queue_t * q, handle_t * th)
 {
+  ring_op_begin();
   return (void *) lcrq_get(q, th);
 }
 //By K
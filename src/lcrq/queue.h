@@ -32,6 +32,8 @@ uint64_t lcrq_deq_count(queue_t *q);
 uint64_t lcrq_tail_version(queue_t *q);
 queue_t *queue_create();
 queue_t* queue_register(queue_t* set, int thread_id);
+void lcrq_set_ring_size(queue_t *q, uint64_t ring_size);
+void lcrq_thread_offline(void);
 
 /* End of interface */
 
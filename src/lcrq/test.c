@@ -69,6 +69,7 @@ static volatile int stop;
 uint64_t relaxation_bound = 1;
 uint64_t width = 1;
 uint64_t choices = 2;
+uint64_t ring_size = LCRQ_RING_SIZE;
 size_t side_work = 0;
 
 TEST_VARS_GLOBAL;
@@ -84,6 +85,8 @@ volatile unsigned long *get_cas_fail_count;
 volatile unsigned long *null_count;
 volatile unsigned long *hop_count;
 volatile unsigned long *slide_count;
+volatile unsigned long *ring_alloc_count;
+volatile unsigned long *ring_reuse_count;
 volatile ticks *removing_count;
 volatile ticks *removing_count_succ;
 volatile ticks *total;
@@ -218,6 +221,8 @@ void* test(void* thread)
 	null_count[thread_id]=my_null_count;
 	hop_count[thread_id]=my_hop_count;
 	slide_count[thread_id]=my_slide_count;
+	ring_alloc_count[thread_id]=my_ring_alloc_count;
+	ring_reuse_count[thread_id]=my_ring_reuse_count;
 
 	EXEC_IN_DEC_ID_ORDER(thread_id, num_threads)
     {
@@ -251,6 +256,7 @@ int main(int argc, char **argv)
 		{"num-buckets",               required_argument, NULL, 'b'},
 		{"print-vals",                required_argument, NULL, 'v'},
 		{"vals-pf",                   required_argument, NULL, 'f'},
+		{"ring-size",                 required_argument, NULL, 'R'},
 		{NULL, 0, NULL, 0}
 	};
 
@@ -258,7 +264,7 @@ int main(int argc, char **argv)
 	while(1)
     {
 		i = 0;
-		c = getopt_long(argc, argv, "hAf:d:i:n:r:u:m:a:l:p:b:v:f:y:z:k:w:s:c:", long_options, &i);
+		c = getopt_long(argc, argv, "hAf:d:i:n:r:u:m:a:l:p:b:v:f:y:z:k:w:s:c:R:", long_options, &i);
 		if(c == -1)
 		break;
 		if(c == 0 && long_options[i].flag == 0)
@@ -302,6 +308,8 @@ int main(int argc, char **argv)
 			"        Width (Number of sub-structures).\n"
 			"  -c, --choices <int>\n"
 			"        The number of choices to use (refered to as d in d-balanced queues) [DEFAULT=2].\n"
+			"  -R, --ring-size <int>\n"
+			"        Entries per ring, a power of two [DEFAULT=4096].\n"
 			, argv[0]);
 			exit(0);
 			case 'd':
@@ -340,6 +348,15 @@ int main(int argc, char **argv)
 			break;
 			case 'c':
 			choices = atoi(optarg);
+			break;
+			case 'R':
+			ring_size = atol(optarg);
+			if (!is_power_of_two(ring_size) || ring_size < (1ull << LCRQ_MIN_RING_ORDER) || ring_size > (1ull << LCRQ_MAX_RING_ORDER))
+			{
+				printf("The ring size must be a power of two between %llu and %llu\n", 1ull << LCRQ_MIN_RING_ORDER, 1ull << LCRQ_MAX_RING_ORDER);
+				exit(1);
+			}
+			break;
 			case 'm':
 			case 'k':
 			break;
@@ -407,6 +424,7 @@ int main(int argc, char **argv)
 
 	DS_TYPE* set = DS_NEW(width, choices);
 	assert(set != NULL);
+	lcrq_set_ring_size(set, ring_size);
 
 	/* Initializes the local data */
 	putting_succ = (ticks *) calloc(num_threads , sizeof(ticks));
@@ -422,6 +440,8 @@ int main(int argc, char **argv)
 	null_count = (unsigned long *) calloc(num_threads , sizeof(unsigned long));
 	slide_count = (unsigned long *) calloc(num_threads , sizeof(unsigned long));
 	hop_count = (unsigned long *) calloc(num_threads , sizeof(unsigned long));
+	ring_alloc_count = (unsigned long *) calloc(num_threads , sizeof(unsigned long));
+	ring_reuse_count = (unsigned long *) calloc(num_threads , sizeof(unsigned long));
 
 	pthread_t threads[num_threads];
 	pthread_attr_t attr;
@@ -486,6 +506,8 @@ int main(int argc, char **argv)
 	volatile unsigned long null_count_total = 0;
 	volatile unsigned long slide_count_total = 0;
 	volatile unsigned long hop_count_total = 0;
+	volatile unsigned long ring_alloc_count_total = 0;
+	volatile unsigned long ring_reuse_count_total = 0;
 	volatile uint64_t removing_count_total = 0;
 	volatile uint64_t removing_count_total_succ = 0;
 
@@ -503,6 +525,8 @@ int main(int argc, char **argv)
 		null_count_total += null_count[t];
 		hop_count_total += hop_count[t];
 		slide_count_total += slide_count[t];
+		ring_alloc_count_total += ring_alloc_count[t];
+		ring_reuse_count_total += ring_reuse_count[t];
 		removing_count_total += removing_count[t];
 		removing_count_total_succ += removing_count_succ[t];
 	}
@@ -566,6 +590,9 @@ int main(int argc, char **argv)
 	printf("Null_Count , %zu\n", null_count_total);
 	printf("Hop_Count , %zu\n", hop_count_total);
 	printf("Slide_Count , %zu\n", slide_count_total);
+	printf("Ring_Size , %zu\n", set->ring_size);
+	printf("Ring_Allocs , %zu\n", ring_alloc_count_total);
+	printf("Ring_Reuses , %zu\n", ring_reuse_count_total);
 	//printf("Width , %u\n", set->width);
 	//printf("Choices (d) , %u\n", set->d);
 
@@ -0,0 +1,134 @@
+#include <getopt.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "semrelax.h"
+
+/*
+ * A small consumer of libsemrelax, using nothing but semrelax.h. Every thread registers its own handle,
+ * puts its share of the items and then gets items until all have been taken. Checks that each item
+ * came out exactly once and prints the throughput.
+ */
+
+static semrelax_t *s;
+static uint64_t items_per_thread = 100000;
+static uint64_t total_items;
+static volatile uint64_t taken;
+
+typedef struct worker
+{
+	pthread_t thread;
+	uint64_t id;
+	uint64_t sum;
+} worker_t;
+
+static void* work(void *arg)
+{
+	worker_t *w = (worker_t*) arg;
+	semrelax_handle_t *h = semrelax_register(s);
+	if (h == NULL)
+	{
+		fprintf(stderr, "Could not register a handle\n");
+		exit(1);
+	}
+
+	// The thread id in the high half keeps the items distinct and nonzero
+	for (uint64_t i = 1; i <= items_per_thread; i++)
+		semrelax_put(h, (w->id << 32) | i);
+
+	while (__atomic_load_n(&taken, __ATOMIC_RELAXED) < total_items)
+	{
+		uint64_t val = semrelax_get(h);
+		if (val == 0) continue;
+		w->sum += val;
+		__atomic_fetch_add(&taken, 1, __ATOMIC_RELAXED);
+	}
+
+	semrelax_deregister(h);
+	return NULL;
+}
+
+static void usage(char *name)
+{
+	printf("Usage:\n  %s [options...]\n\nOptions:\n", name);
+	printf("  -q <kind>   Structure, one of");
+	for (int kind = 0; kind < SEMRELAX_NUM_KINDS; kind++)
+		printf(" %s", semrelax_kind_name(kind));
+	printf(" [DEFAULT=dcbo-ms]\n");
+	printf("  -n <int>    Number of threads\n");
+	printf("  -i <int>    Items put by each thread\n");
+	printf("  -w <int>    Width, 0 for the number of threads\n");
+	printf("  -c <int>    Choices of the d-CBO queues\n");
+	printf("  -l <int>    Depth of the 2D structures\n");
+}
+
+int main(int argc, char **argv)
+{
+	semrelax_kind_t kind = SEMRELAX_DCBO_MS;
+	semrelax_config_t config = {.max_threads = 4};
+
+	int c;
+	while ((c = getopt(argc, argv, "hq:n:i:w:c:l:")) != -1)
+	{
+		switch (c)
+		{
+			case 'q':
+				if (semrelax_kind_parse(optarg) < 0)
+				{
+					usage(argv[0]);
+					exit(1);
+				}
+				kind = (semrelax_kind_t) semrelax_kind_parse(optarg);
+				break;
+			case 'n': config.max_threads = atoi(optarg); break;
+			case 'i': items_per_thread = atoll(optarg); break;
+			case 'w': config.width = atoi(optarg); break;
+			case 'c': config.choices = atoi(optarg); break;
+			case 'l': config.depth = atoi(optarg); break;
+			default:
+				usage(argv[0]);
+				exit(c == 'h' ? 0 : 1);
+		}
+	}
+
+	s = semrelax_create(kind, &config);
+	if (s == NULL)
+	{
+		fprintf(stderr, "Could not create a %s\n", semrelax_kind_name(kind));
+		exit(1);
+	}
+
+	uint64_t n = config.max_threads;
+	total_items = n * items_per_thread;
+	worker_t *workers = (worker_t*) calloc(n, sizeof(worker_t));
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (uint64_t t = 0; t < n; t++)
+	{
+		workers[t].id = t;
+		pthread_create(&workers[t].thread, NULL, work, &workers[t]);
+	}
+	uint64_t sum = 0, expected = 0;
+	for (uint64_t t = 0; t < n; t++)
+	{
+		pthread_join(workers[t].thread, NULL);
+		sum += workers[t].sum;
+		expected += (t << 32) * items_per_thread + items_per_thread * (items_per_thread + 1) / 2;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+	// Reuses a deregistered handle on the main thread, the structure should now be empty
+	semrelax_handle_t *h = semrelax_register(s);
+	int empty = h != NULL && semrelax_get(h) == 0 && semrelax_size(s) == 0;
+	semrelax_deregister(h);
+
+	printf("kind , %s\n", semrelax_kind_name(kind));
+	printf("num_threads , %lu\n", n);
+	printf("Mops , %.3f\n", 2 * total_items / seconds / 1e6);
+	printf("items_ok , %d\n", sum == expected && empty);
+	free(workers);
+	return sum == expected && empty ? 0 : 1;
+}
@@ -0,0 +1,22 @@
+#include "../2Dc-stack_optimized/2Dc-stack_optimized.h"
+#include "semrelax-internal.h"
+
+/* The 2D relaxed stack, with a fixed width and depth */
+
+__thread unsigned long my_put_cas_fail_count;
+__thread unsigned long my_get_cas_fail_count;
+__thread unsigned long my_null_count;
+__thread unsigned long my_hop_count;
+__thread unsigned long my_slide_count;
+__thread unsigned long my_slide_fail_count;
+
+#define FAMILY_FN(name)             semrelax_2dc_##name
+#define FAMILY_CREATE(c)            create_stack((c)->max_threads, (c)->width, (c)->depth, (c)->width, 0, 0)
+#define FAMILY_REGISTER(ds, id)     register_stack((mstack_t*) (ds), id)
+#define FAMILY_PUT(ds, v)           push((mstack_t*) (ds), v, v)
+#define FAMILY_GET(ds)              pop((mstack_t*) (ds))
+#define FAMILY_SIZE(ds)             stack_size((mstack_t*) (ds))
+// The window is a global of 2Dc-window_optimized.h
+#define FAMILY_SINGLE_INSTANCE      1
+
+#include "lib-family.c"
@@ -0,0 +1,29 @@
+#include "../2Dd-queue_optimized/2Dd-queue_optimized.h"
+#include "semrelax-internal.h"
+
+/* The 2D relaxed queue, with a fixed width and depth */
+
+__thread unsigned long my_put_cas_fail_count;
+__thread unsigned long my_get_cas_fail_count;
+__thread unsigned long my_null_count;
+__thread unsigned long my_hop_count;
+__thread unsigned long my_slide_count;
+
+static mqueue_t* create_bounded_queue(const semrelax_config_t *c)
+{
+	mqueue_t *q = create_queue(c->max_threads, c->width, c->depth, 0, 0, c->max_threads);
+	queue_set_capacity(q, c->capacity);
+	return q;
+}
+
+#define FAMILY_FN(name)             semrelax_2dd_##name
+#define FAMILY_CREATE(c)            create_bounded_queue(c)
+#define FAMILY_REGISTER(ds, id)     queue_register((mqueue_t*) (ds), id)
+#define FAMILY_PUT(ds, v)           enqueue((mqueue_t*) (ds), v, v)
+#define FAMILY_PUT_WAIT(ds, v)      enqueue_wait((mqueue_t*) (ds), v, v)
+#define FAMILY_GET(ds)              dequeue((mqueue_t*) (ds))
+#define FAMILY_SIZE(ds)             queue_size((mqueue_t*) (ds))
+// The windows are globals of 2Dd-window_optimized.h
+#define FAMILY_SINGLE_INSTANCE      1
+
+#include "lib-family.c"
@@ -0,0 +1,104 @@
+#include "../dcbo-multi/d-balanced-queue.h"
+#include "semrelax-internal.h"
+
+/* The d-CBO queues, through the runtime selected backends of dcbo-multi */
+
+// Thread locals the queues expect from the benchmark
+__thread unsigned long *seeds;
+__thread int thread_id;
+__thread unsigned long my_put_cas_fail_count;
+__thread unsigned long my_get_cas_fail_count;
+__thread unsigned long my_null_count;
+__thread unsigned long my_hop_count;
+__thread unsigned long my_slide_count;
+
+// Handle whose state the thread locals hold
+static __thread semrelax_handle_t *bound;
+
+void lcrq_thread_offline(void);
+void lprq_thread_offline(void);
+void faaaq_thread_offline(void);
+
+static void save_handle(semrelax_handle_t *h)
+{
+	void **state = backend_thread_state((mqueue_t*) h->s->ds);
+	if (state != NULL) h->backend_state = *state;
+	h->sticky[0] = sticky_enq_index;
+	h->sticky[1] = sticky_enq_left;
+	h->sticky[2] = sticky_deq_index;
+	h->sticky[3] = sticky_deq_left;
+}
+
+static void bind_handle(semrelax_handle_t *h)
+{
+	if (bound != NULL) save_handle(bound);
+
+	SEMRELAX_BIND_COMMON(h);
+	double_collect_counts = h->scratch;
+	void **state = backend_thread_state((mqueue_t*) h->s->ds);
+	if (state != NULL) *state = h->backend_state;
+	sticky_enq_index = h->sticky[0];
+	sticky_enq_left = h->sticky[1];
+	sticky_deq_index = h->sticky[2];
+	sticky_deq_left = h->sticky[3];
+	bound = h;
+}
+
+void* semrelax_dcbo_create(semrelax_kind_t kind, const semrelax_config_t *config)
+{
+	// The d-CBO kinds are listed in the order of dcbo_backend_t
+	dcbo_backend_t backend = (dcbo_backend_t) (kind - SEMRELAX_DCBO_MS);
+	mqueue_t *q = create_queue(config->width, config->choices, config->max_threads, backend);
+	dcbo_set_capacity(q, config->capacity);
+	return q;
+}
+
+void semrelax_dcbo_attach(semrelax_handle_t *h, int fresh)
+{
+	ssalloc_init();
+	bind_handle(h);
+	if (fresh)
+	{
+		d_balanced_register((mqueue_t*) h->s->ds, h->thread_id);
+		h->scratch = double_collect_counts;
+	}
+}
+
+void semrelax_dcbo_detach(semrelax_handle_t *h)
+{
+	if (bound != h) return;
+	save_handle(h);
+	bound = NULL;
+	// The allocator may move to another thread with the handle
+	alloc = NULL;
+	// Drained rings and segments can be recycled without waiting for this thread to operate again
+	if (h->s->kind == SEMRELAX_DCBO_LCRQ)
+		lcrq_thread_offline();
+	else if (h->s->kind == SEMRELAX_DCBO_LPRQ)
+		lprq_thread_offline();
+	else if (h->s->kind == SEMRELAX_DCBO_FAAAQ)
+		faaaq_thread_offline();
+}
+
+int semrelax_dcbo_put(semrelax_handle_t *h, uint64_t val)
+{
+	if (unlikely(bound != h)) bind_handle(h);
+	return enqueue((mqueue_t*) h->s->ds, val, val);
+}
+
+int semrelax_dcbo_put_wait(semrelax_handle_t *h, uint64_t val)
+{
+	if (unlikely(bound != h)) bind_handle(h);
+	return enqueue_wait((mqueue_t*) h->s->ds, val, val);
+}
+
+uint64_t semrelax_dcbo_get(semrelax_handle_t *h)
+{
+	if (unlikely(bound != h)) bind_handle(h);
+	return dequeue((mqueue_t*) h->s->ds);
+}
+
+size_t semrelax_dcbo_size(void *ds)
+{
+	return queue_size((mqueue_t*) ds);
+}
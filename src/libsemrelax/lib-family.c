@@ -0,0 +1,91 @@
+/*
+ * The handles of a family whose thread state is only the one common to all families, compiled once
+ * per family by lib-<name>.c after it has included the family's structure and defined:
+ * - FAMILY_FN(name), the family specific name of each function,
+ * - FAMILY_CREATE(c), FAMILY_REGISTER(ds, id), FAMILY_PUT(ds, v), FAMILY_GET(ds) and FAMILY_SIZE(ds),
+ * - FAMILY_SINGLE_INSTANCE, 1 if the structure keeps its state in globals and can only be created once,
+ * and optionally FAMILY_PUT_WAIT(ds, v), the put that waits while a structure with a capacity is full.
+ */
+
+#ifndef FAMILY_PUT_WAIT
+// Without a capacity the structure never fills up
+#define FAMILY_PUT_WAIT(ds, v)      FAMILY_PUT(ds, v)
+#endif
+
+__thread unsigned long *seeds;
+__thread int thread_id;
+
+// Handle whose state the thread locals hold
+static __thread semrelax_handle_t *bound;
+// Allocator for the nodes a structure allocates when created, as the creating thread may have no handle
+static __thread ssmem_allocator_t *creation_alloc;
+#if FAMILY_SINGLE_INSTANCE == 1
+static volatile uint32_t created;
+#endif
+
+static inline void bind_handle(semrelax_handle_t *h)
+{
+	SEMRELAX_BIND_COMMON(h);
+	bound = h;
+}
+
+void* FAMILY_FN(create)(semrelax_kind_t kind, const semrelax_config_t *config)
+{
+#if FAMILY_SINGLE_INSTANCE == 1
+	uint32_t expected = 0;
+	if (!CAE(&created, &expected, &(uint32_t){1}))
+		return NULL;
+#endif
+
+	ssalloc_init();
+	if (alloc == NULL)
+	{
+		if (creation_alloc == NULL)
+		{
+			creation_alloc = (ssmem_allocator_t*) malloc(sizeof(ssmem_allocator_t));
+			assert(creation_alloc != NULL);
+			ssmem_alloc_init_fs_size(creation_alloc, SSMEM_DEFAULT_MEM_SIZE, SSMEM_GC_FREE_SET_SIZE, config->max_threads);
+		}
+		alloc = creation_alloc;
+	}
+	return FAMILY_CREATE(config);
+}
+
+void FAMILY_FN(attach)(semrelax_handle_t *h, int fresh)
+{
+	ssalloc_init();
+	bind_handle(h);
+	if (fresh)
+		FAMILY_REGISTER(h->s->ds, h->thread_id);
+}
+
+void FAMILY_FN(detach)(semrelax_handle_t *h)
+{
+	if (bound != h) return;
+	bound = NULL;
+	// The allocator may move to another thread with the handle
+	alloc = NULL;
+}
+
+int FAMILY_FN(put)(semrelax_handle_t *h, uint64_t val)
+{
+	if (unlikely(bound != h)) bind_handle(h);
+	return FAMILY_PUT(h->s->ds, val);
+}
+
+int FAMILY_FN(put_wait)(semrelax_handle_t *h, uint64_t val)
+{
+	if (unlikely(bound != h)) bind_handle(h);
+	return FAMILY_PUT_WAIT(h->s->ds, val);
+}
+
+uint64_t FAMILY_FN(get)(semrelax_handle_t *h)
+{
+	if (unlikely(bound != h)) bind_handle(h);
+	return FAMILY_GET(h->s->ds);
+}
+
+size_t FAMILY_FN(size)(void *ds)
+{
+	return FAMILY_SIZE(ds);
+}
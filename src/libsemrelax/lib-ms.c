@@ -0,0 +1,20 @@
+#include "../ms/ms.h"
+#include "semrelax-internal.h"
+
+/* The strict Michael-Scott queue */
+
+__thread unsigned long my_put_cas_fail_count;
+__thread unsigned long my_get_cas_fail_count;
+__thread unsigned long my_null_count;
+__thread unsigned long my_hop_count;
+__thread unsigned long my_slide_count;
+
+#define FAMILY_FN(name)             semrelax_ms_##name
+#define FAMILY_CREATE(c)            create_ms_queue((c)->max_threads)
+#define FAMILY_REGISTER(ds, id)     queue_register((ms_queue_t*) (ds), id)
+#define FAMILY_PUT(ds, v)           ms_enqueue((ms_queue_t*) (ds), v, v)
+#define FAMILY_GET(ds)              ms_dequeue((ms_queue_t*) (ds), NULL)
+#define FAMILY_SIZE(ds)             ms_queue_size((ms_queue_t*) (ds))
+#define FAMILY_SINGLE_INSTANCE      0
+
+#include "lib-family.c"
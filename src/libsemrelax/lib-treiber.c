@@ -0,0 +1,20 @@
+#include "../stack-treiber/stack-treiber.h"
+#include "semrelax-internal.h"
+
+/* The strict Treiber stack */
+
+__thread unsigned long my_push_cas_fail_count;
+__thread unsigned long my_pop_cas_fail_count;
+__thread unsigned long my_null_count;
+__thread unsigned long my_hop_count;
+__thread unsigned long my_slide_count;
+
+#define FAMILY_FN(name)             semrelax_treiber_##name
+#define FAMILY_CREATE(c)            mstack_new()
+#define FAMILY_REGISTER(ds, id)     register_stack((mstack_t*) (ds), id)
+#define FAMILY_PUT(ds, v)           mstack_treiber_insert((mstack_t*) (ds), v, v)
+#define FAMILY_GET(ds)              mstack_treiber_delete((mstack_t*) (ds))
+#define FAMILY_SIZE(ds)             mstack_size((mstack_t*) (ds))
+#define FAMILY_SINGLE_INSTANCE      0
+
+#include "lib-family.c"
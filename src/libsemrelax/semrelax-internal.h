@@ -0,0 +1,63 @@
+#ifndef SEMRELAX_INTERNAL_H
+#define SEMRELAX_INTERNAL_H
+
+#include <pthread.h>
+#include "common.h"
+#include "ssmem.h"
+#include "semrelax.h"
+
+/*
+ * Each family of structures is linked into its own object whose symbols are all made local except
+ * the semrelax_* ones, see the Makefile. The benchmark-owned thread locals the structures expect
+ * (seeds, thread_id, alloc, ...) are thereby private to the family, and point into the handle that
+ * the thread last used. A family only rebinds them when a thread switches handles.
+ */
+
+struct semrelax
+{
+	semrelax_kind_t kind;
+	void *ds;
+	uint32_t max_threads;
+	uint32_t n_handles; // Handles created, deregistered ones are kept in free_handles for reuse
+	semrelax_handle_t *free_handles;
+	pthread_mutex_t lock;
+};
+
+struct semrelax_handle
+{
+	semrelax_t *s;
+	int thread_id;
+	unsigned long *seeds;
+	ssmem_allocator_t *alloc;
+	uint64_t *scratch; // double_collect_counts of the d-CBO queues
+	void *backend_state; // Thread local word of the d-CBO sub-queues, LCRQ or LPRQ spare ring or wait-free queue handles
+	uint32_t sticky[4]; // Sticky sub-queue choices of the d-CBO queues
+	semrelax_handle_t *next_free;
+};
+
+// Points the thread locals shared by all families at the handle
+#define SEMRELAX_BIND_COMMON(h) \
+	seeds = (h)->seeds; \
+	alloc = (h)->alloc; \
+	thread_id = (h)->thread_id
+
+/*
+ * Per family interface. Attach sets up the calling thread for the handle, registering it with the
+ * structure if fresh, and detach saves the thread locals back before the handle may move to another thread.
+ */
+#define SEMRELAX_FAMILY_INTERFACE(f) \
+	void* semrelax_##f##_create(semrelax_kind_t kind, const semrelax_config_t *config); \
+	void semrelax_##f##_attach(semrelax_handle_t *h, int fresh); \
+	void semrelax_##f##_detach(semrelax_handle_t *h); \
+	int semrelax_##f##_put(semrelax_handle_t *h, uint64_t val); \
+	int semrelax_##f##_put_wait(semrelax_handle_t *h, uint64_t val); \
+	uint64_t semrelax_##f##_get(semrelax_handle_t *h); \
+	size_t semrelax_##f##_size(void *ds);
+
+SEMRELAX_FAMILY_INTERFACE(dcbo)
+SEMRELAX_FAMILY_INTERFACE(2dd)
+SEMRELAX_FAMILY_INTERFACE(2dc)
+SEMRELAX_FAMILY_INTERFACE(ms)
+SEMRELAX_FAMILY_INTERFACE(treiber)
+
+#endif
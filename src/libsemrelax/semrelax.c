@@ -0,0 +1,174 @@
+#include "semrelax-internal.h"
+#include "utils.h"
+
+// Indexed by semrelax_kind_t
+static const char *semrelax_kind_names[SEMRELAX_NUM_KINDS] = {
+	"dcbo-ms", "dcbo-faaaq", "dcbo-lcrq", "dcbo-lprq", "dcbo-wfqueue", "2Dd-queue", "2Dc-stack", "ms", "treiber"
+};
+
+// A switch on the kind, well predicted as a handle never changes structure, instead of an indirect call per operation
+#define SEMRELAX_DISPATCH(kind, fn, ...) \
+	switch (kind) \
+	{ \
+		case SEMRELAX_2DD_QUEUE: return semrelax_2dd_##fn(__VA_ARGS__); \
+		case SEMRELAX_2DC_STACK: return semrelax_2dc_##fn(__VA_ARGS__); \
+		case SEMRELAX_MS_QUEUE: return semrelax_ms_##fn(__VA_ARGS__); \
+		case SEMRELAX_TREIBER_STACK: return semrelax_treiber_##fn(__VA_ARGS__); \
+		default: return semrelax_dcbo_##fn(__VA_ARGS__); \
+	}
+
+static void* create_ds(semrelax_kind_t kind, const semrelax_config_t *config)
+{
+	SEMRELAX_DISPATCH(kind, create, kind, config);
+}
+
+static void attach(semrelax_handle_t *h, int fresh)
+{
+	switch (h->s->kind)
+	{
+		case SEMRELAX_2DD_QUEUE: semrelax_2dd_attach(h, fresh); break;
+		case SEMRELAX_2DC_STACK: semrelax_2dc_attach(h, fresh); break;
+		case SEMRELAX_MS_QUEUE: semrelax_ms_attach(h, fresh); break;
+		case SEMRELAX_TREIBER_STACK: semrelax_treiber_attach(h, fresh); break;
+		default: semrelax_dcbo_attach(h, fresh); break;
+	}
+}
+
+static void detach(semrelax_handle_t *h)
+{
+	switch (h->s->kind)
+	{
+		case SEMRELAX_2DD_QUEUE: semrelax_2dd_detach(h); break;
+		case SEMRELAX_2DC_STACK: semrelax_2dc_detach(h); break;
+		case SEMRELAX_MS_QUEUE: semrelax_ms_detach(h); break;
+		case SEMRELAX_TREIBER_STACK: semrelax_treiber_detach(h); break;
+		default: semrelax_dcbo_detach(h); break;
+	}
+}
+
+semrelax_t* semrelax_create(semrelax_kind_t kind, const semrelax_config_t *config)
+{
+	if (kind >= SEMRELAX_NUM_KINDS || config == NULL || config->max_threads == 0)
+		return NULL;
+
+	semrelax_config_t c = *config;
+	if (c.width == 0) c.width = c.max_threads;
+	if (c.choices == 0) c.choices = 2;
+	if (c.depth == 0) c.depth = 1;
+	// The strict structures and the 2D stack have no capacity to bound them with
+	if (c.capacity != 0 && kind >= SEMRELAX_2DC_STACK)
+		return NULL;
+
+	semrelax_t *s = (semrelax_t*) malloc(sizeof(semrelax_t));
+	if (s == NULL)
+		return NULL;
+	s->ds = create_ds(kind, &c);
+	if (s->ds == NULL)
+	{
+		free(s);
+		return NULL;
+	}
+	s->kind = kind;
+	s->max_threads = c.max_threads;
+	s->n_handles = 0;
+	s->free_handles = NULL;
+	pthread_mutex_init(&s->lock, NULL);
+	return s;
+}
+
+semrelax_handle_t* semrelax_register(semrelax_t *s)
+{
+	semrelax_handle_t *h = (semrelax_handle_t*) calloc(1, sizeof(semrelax_handle_t));
+	if (h == NULL)
+		return NULL;
+
+	// Reuse a deregistered handle if there is one, keeping its allocator and its place in the sub-queues
+	pthread_mutex_lock(&s->lock);
+	if (s->free_handles != NULL)
+	{
+		free(h);
+		h = s->free_handles;
+		s->free_handles = h->next_free;
+		pthread_mutex_unlock(&s->lock);
+		// The allocator takes the GC timestamp of the thread it now runs on, ssmem_free advances it
+		ssmem_gc_thread_init(h->alloc, h->thread_id);
+		attach(h, false);
+		return h;
+	}
+	if (s->n_handles == s->max_threads)
+	{
+		pthread_mutex_unlock(&s->lock);
+		free(h);
+		return NULL;
+	}
+	h->thread_id = s->n_handles++;
+	pthread_mutex_unlock(&s->lock);
+
+	h->s = s;
+	h->seeds = seed_rand();
+	h->alloc = (ssmem_allocator_t*) malloc(sizeof(ssmem_allocator_t));
+	assert(h->alloc != NULL);
+	ssmem_alloc_init_fs_size(h->alloc, SSMEM_DEFAULT_MEM_SIZE, SSMEM_GC_FREE_SET_SIZE, h->thread_id);
+	attach(h, true);
+	return h;
+}
+
+void semrelax_deregister(semrelax_handle_t *h)
+{
+	semrelax_t *s = h->s;
+	detach(h);
+	pthread_mutex_lock(&s->lock);
+	h->next_free = s->free_handles;
+	s->free_handles = h;
+	pthread_mutex_unlock(&s->lock);
+}
+
+static inline int storable(semrelax_handle_t *h, uint64_t val)
+{
+	// 0 is returned by get when empty and UINT64_MAX marks empty LCRQ cells, so neither can be stored
+	if (unlikely(val == 0 || val == UINT64_MAX))
+		return false;
+	// Values with the top bit set mark the cells reserved by LPRQ enqueuers
+	if (unlikely(h->s->kind == SEMRELAX_DCBO_LPRQ && (val >> 63) != 0))
+		return false;
+	return true;
+}
+
+int semrelax_put(semrelax_handle_t *h, uint64_t val)
+{
+	if (unlikely(!storable(h, val)))
+		return false;
+	SEMRELAX_DISPATCH(h->s->kind, put, h, val);
+}
+
+int semrelax_put_wait(semrelax_handle_t *h, uint64_t val)
+{
+	if (unlikely(!storable(h, val)))
+		return false;
+	SEMRELAX_DISPATCH(h->s->kind, put_wait, h, val);
+}
+
+uint64_t semrelax_get(semrelax_handle_t *h)
+{
+	SEMRELAX_DISPATCH(h->s->kind, get, h);
+}
+
+size_t semrelax_size(semrelax_t *s)
+{
+	SEMRELAX_DISPATCH(s->kind, size, s->ds);
+}
+
+const char* semrelax_kind_name(semrelax_kind_t kind)
+{
+	return kind < SEMRELAX_NUM_KINDS ? semrelax_kind_names[kind] : NULL;
+}
+
+int semrelax_kind_parse(const char *name)
+{
+	for (int kind = 0; kind < SEMRELAX_NUM_KINDS; kind++)
+	{
+		if (strcmp(name, semrelax_kind_names[kind]) == 0)
+			return kind;
+	}
+	return -1;
+}
@@ -0,0 +1,62 @@
+#ifndef SEMRELAX_H
+#define SEMRELAX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * libsemrelax, the relaxed queues and stacks of this repository as a linkable library.
+ * A structure is created once and then used by each thread through a handle it registers itself,
+ * which holds that thread's random state, allocator and per structure scratch space. A handle must
+ * only be used by one thread at a time. Values are 64 bit words other than 0, which get returns when
+ * empty, and UINT64_MAX, which marks empty cells in the LCRQ. The LPRQ kind also rejects values with the
+ * top bit set, which mark reserved cells.
+ */
+
+typedef enum semrelax_kind
+{
+	SEMRELAX_DCBO_MS,		// d-CBO queue over Michael-Scott sub-queues
+	SEMRELAX_DCBO_FAAAQ,	// d-CBO queue over FAA array sub-queues
+	SEMRELAX_DCBO_LCRQ,		// d-CBO queue over LCRQ sub-queues
+	SEMRELAX_DCBO_LPRQ,		// d-CBO queue over LPRQ sub-queues, which need no 128 bit CAS
+	SEMRELAX_DCBO_WFQUEUE,	// d-CBO queue over wait-free sub-queues
+	SEMRELAX_2DD_QUEUE,		// 2D relaxed queue, at most one per process
+	SEMRELAX_2DC_STACK,		// 2D relaxed stack, at most one per process
+	SEMRELAX_MS_QUEUE,		// Strict Michael-Scott queue
+	SEMRELAX_TREIBER_STACK,	// Strict Treiber stack
+	SEMRELAX_NUM_KINDS
+} semrelax_kind_t;
+
+typedef struct semrelax_config
+{
+	uint32_t max_threads;	// Handles registered at the same time, required
+	uint32_t width;			// Sub-structures of the relaxed kinds, 0 for max_threads
+	uint32_t choices;		// Sub-queues sampled per d-CBO operation, 0 for 2
+	uint32_t depth;			// Operations per sub-structure in a 2D window, 0 for 1
+	uint64_t capacity;		// Items a relaxed queue holds, approximately, before put returns 0, 0 for unbounded
+} semrelax_config_t;
+
+typedef struct semrelax semrelax_t;
+typedef struct semrelax_handle semrelax_handle_t;
+
+/* Returns NULL if the configuration is invalid, or if a second 2D structure of the same kind is created.
+ * Only the d-CBO and 2D queues take a capacity, see their READMEs for how it is rounded. */
+semrelax_t* semrelax_create(semrelax_kind_t kind, const semrelax_config_t *config);
+/* Returns NULL if max_threads handles are already registered */
+semrelax_handle_t* semrelax_register(semrelax_t *s);
+/* Called by the thread that last used the handle, which is then kept for reuse by a later semrelax_register */
+void semrelax_deregister(semrelax_handle_t *h);
+
+/* Returns 0 if the value can not be stored, or if the queue is at its capacity */
+int semrelax_put(semrelax_handle_t *h, uint64_t val);
+/* Like semrelax_put, but backs off and retries while the queue is at its capacity */
+int semrelax_put_wait(semrelax_handle_t *h, uint64_t val);
+uint64_t semrelax_get(semrelax_handle_t *h);
+/* Not linearizable, only exact when no operations run concurrently */
+size_t semrelax_size(semrelax_t *s);
+
+const char* semrelax_kind_name(semrelax_kind_t kind);
+/* Returns the kind with the given name, or -1 if there is none */
+int semrelax_kind_parse(const char *name);
+
+#endif
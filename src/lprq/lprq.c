@@ -0,0 +1,682 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lprq.h"
+#include "align.h"
+
+#ifdef RELAXATION_ANALYSIS
+#include "relaxation_analysis_queue.c"
+#elif RELAXATION_TIMER_ANALYSIS
+#include "relaxation_analysis_timestamps.c"
+#endif
+
+// Want timers at FAA increments and not with the normal CAE
+#ifdef RELAXATION_TIMER_ANALYSIS
+uint64_t enq_timestamp, deq_timestamp;
+#define ENQ_TIMESTAMP (enq_timestamp = get_timestamp())
+#define DEQ_TIMESTAMP (deq_timestamp = get_timestamp())
+#else
+#define ENQ_TIMESTAMP
+#define DEQ_TIMESTAMP
+#endif
+
+/*
+ * The LOCK analysis has to see the items in the order of their tickets, which is the order dequeuers take
+ * them in, but an enqueue only commits its item some time after its FAA. Each operation therefore runs
+ * under the lock of the analysis as a whole, from its ticket to its commit, and the commits below record
+ * the item without locking again.
+ */
+#ifdef RELAXATION_ANALYSIS
+#define ANALYSIS_LOCK lock_relaxation_lists()
+#define ANALYSIS_UNLOCK unlock_relaxation_lists()
+#else
+#define ANALYSIS_LOCK
+#define ANALYSIS_UNLOCK
+#endif
+
+__thread ssmem_allocator_t* alloc;
+__thread handle_t thread_handle;
+
+#define PRQ_EMPTY ((uint64_t) 0)
+#define PRQ_BOTTOM (1ull << 63)
+
+// Marks the cells reserved by this thread, unique among the threads operating on rings
+static __thread uint64_t my_prq_bottom;
+
+static inline int is_bottom(uint64_t v) {
+  return (v & PRQ_BOTTOM) != 0;
+}
+
+static inline uint64_t node_index(uint64_t i) {
+  return (i & ~(1ull << 63));
+}
+
+static inline uint64_t set_unsafe(uint64_t i) {
+  return (i | (1ull << 63));
+}
+
+static inline uint64_t node_unsafe(uint64_t i) {
+  return (i & (1ull << 63));
+}
+
+static inline uint64_t tail_index(uint64_t t) {
+  return (t & ~(1ull << 63));
+}
+
+static inline int prq_is_closed(uint64_t t) {
+  return (t & (1ull << 63)) != 0;
+}
+
+static inline uint32_t ring_order(uint64_t size) {
+  return __builtin_ctzll(size);
+}
+
+/*
+ * The cell of a ticket. Ticket i goes to cell i / lines of line i % lines, so the tickets handed out
+ * by consecutive FAAs are on different lines, and the threads taking them do not contend on one line.
+ */
+static inline PrqCell* prq_cell(PrqRing *r, uint64_t ticket) {
+  uint64_t i = ticket & (r->size - 1);
+  uint64_t line = i & ((1ull << r->line_order) - 1);
+  return &r->array[(line << r->cell_order) | (i >> r->line_order)];
+}
+
+static inline void init_ring(PrqRing *r, uint64_t size) {
+  uint64_t i;
+  uint32_t order = ring_order(size);
+
+  r->size = size;
+  r->cell_order = __builtin_ctzll(LPRQ_CELLS_PER_LINE);
+  if (r->cell_order > order)
+    r->cell_order = order;
+  r->line_order = order - r->cell_order;
+  for (i = 0; i < size; i++) {
+    PrqCell *cell = prq_cell(r, i);
+    cell->val = PRQ_EMPTY;
+    cell->idx = i;
+  }
+
+  r->head = r->tail = 0;
+  r->next = NULL;
+  r->items_enqueued = 0;
+}
+
+// Writes the item over the bottom reserving the cell, which linearizes the enqueue
+static int enq_commit(volatile uint64_t *val_loc, uint64_t bottom, uint64_t item)
+{
+#ifdef RELAXATION_TIMER_ANALYSIS
+	// Use timers to track relaxation instead of locks
+	if (CAE(val_loc, &bottom, &item))
+	{
+		add_relaxed_put(item, enq_timestamp);
+		return true;
+	}
+	return false;
+#elif RELAXATION_ANALYSIS
+	// Under the lock taken by the operation
+	if (CAE(val_loc, &bottom, &item))
+	{
+		*val_loc = gen_relaxation_count();
+		add_linear(*val_loc, 0);
+		return true;
+	}
+	return false;
+#else
+	return CAE(val_loc, &bottom, &item);
+#endif
+}
+
+// Links a new ring already holding n solo enqueued items, which linearizes those enqueues
+static int enq_link(PrqRing *rq, PrqRing *next, PrqRing *nrq, uint64_t n)
+{
+#ifdef RELAXATION_TIMER_ANALYSIS
+	if (CAE(&rq->next, &next, &nrq))
+	{
+		for (uint64_t i = 0; i < n; i++)
+			add_relaxed_put(prq_cell(nrq, i)->val, enq_timestamp);
+		return true;
+	}
+	return false;
+#elif RELAXATION_ANALYSIS
+	if (CAE(&rq->next, &next, &nrq))
+	{
+		for (uint64_t i = 0; i < n; i++)
+		{
+			PrqCell *cell = prq_cell(nrq, i);
+			cell->val = gen_relaxation_count();
+			add_linear(cell->val, 0);
+		}
+		return true;
+	}
+	return false;
+#else
+	return CAE(&rq->next, &next, &nrq);
+#endif
+}
+
+// Empties the cell holding the item of this dequeuer, only it can take the item so no CAS is needed
+static uint64_t deq_take(volatile uint64_t *val_loc, uint64_t val)
+{
+#ifdef RELAXATION_TIMER_ANALYSIS
+	*val_loc = PRQ_EMPTY;
+	add_relaxed_get(val, deq_timestamp);
+	return val;
+#elif RELAXATION_ANALYSIS
+	val = SWAP_U64(val_loc, PRQ_EMPTY);
+	remove_linear(val);
+	return val;
+#else
+	*val_loc = PRQ_EMPTY;
+	return val;
+#endif
+}
+
+/*
+ * Recycling of drained rings, as in the LCRQ. The thread unlinking a ring from the head keeps it in a
+ * limbo list, and takes a snapshot of the quiescent slots of all threads once it has no older rings
+ * waiting. When every slot has changed since the snapshot, no thread can still be inside those rings
+ * and they move to the pool of their size, from where enqueuers closing a ring take one before
+ * allocating a new ring.
+ *
+ * A thread changes its slot with an atomic swap at the start of every LPRQ_QUIESCENT_PERIOD-th operation,
+ * when it holds no ring, so each operation only pays a thread local increment. The swap orders the
+ * ring loads of the following operations after it, which is what makes a changed slot safe.
+ */
+#define RING_OFFLINE UINT64_MAX
+#define RING_BYTES(size) ((sizeof(PrqRing) + (size)*sizeof(PrqCell) + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1))
+
+// The top of a pool is a ring pointer with a tag in its unused high bits, so it is updated with a single word CAS
+#define POOL_TAG_SHIFT 48
+#define POOL_RING_MASK ((1ull << POOL_TAG_SHIFT) - 1)
+
+typedef CACHE_ALIGNED struct ring_pool {
+  volatile uint64_t top;
+  uint8_t padding[CACHE_LINE_SIZE - sizeof(uint64_t)];
+} ring_pool_t;
+
+typedef CACHE_ALIGNED struct quiescent_slot {
+  volatile uint64_t epoch;
+  uint8_t padding[CACHE_LINE_SIZE - sizeof(uint64_t)];
+} quiescent_slot_t;
+
+static ring_pool_t ring_pools[LPRQ_MAX_RING_ORDER + 1];
+static quiescent_slot_t quiescent_slots[LPRQ_MAX_THREADS];
+static volatile uint32_t n_quiescent_slots;
+
+static __thread quiescent_slot_t *my_quiescent_slot;
+static __thread uint64_t my_ring_ops;
+static __thread uint64_t my_ring_epoch;
+// Rings retired after the snapshot was taken, and the ones waiting for every slot to change since it
+static __thread PrqRing *my_retired_rings;
+static __thread PrqRing *my_waiting_rings;
+static __thread uint64_t *my_ring_snapshot;
+static __thread uint32_t my_ring_snapshot_len;
+
+__thread unsigned long my_prq_alloc_count;
+__thread unsigned long my_prq_reuse_count;
+
+static void ring_pool_push(PrqRing *r) {
+  ring_pool_t *pool = &ring_pools[ring_order(r->size)];
+  uint64_t top = pool->top;
+  uint64_t new_top;
+
+  do {
+    r->pool_next = (PrqRing*) (top & POOL_RING_MASK);
+    new_top = (uint64_t) r | ((top & ~POOL_RING_MASK) + (1ull << POOL_TAG_SHIFT));
+  } while (!CAE(&pool->top, &top, &new_top));
+}
+
+static PrqRing* ring_pool_pop(uint64_t size) {
+  ring_pool_t *pool = &ring_pools[ring_order(size)];
+  uint64_t top = pool->top;
+  uint64_t new_top;
+  PrqRing *r;
+
+  // Pooled rings are never freed, so reading pool_next of a ring popped concurrently is safe, the tag fails the CAE
+  do {
+    r = (PrqRing*) (top & POOL_RING_MASK);
+    if (r == NULL)
+      return NULL;
+    new_top = (uint64_t) r->pool_next | ((top & ~POOL_RING_MASK) + (1ull << POOL_TAG_SHIFT));
+  } while (!CAE(&pool->top, &top, &new_top));
+  return r;
+}
+
+static void ring_snapshot_take(void) {
+  if (my_ring_snapshot == NULL) {
+    my_ring_snapshot = (uint64_t*) malloc(LPRQ_MAX_THREADS*sizeof(uint64_t));
+    assert(my_ring_snapshot != NULL);
+  }
+  my_ring_snapshot_len = n_quiescent_slots;
+  if (my_ring_snapshot_len > LPRQ_MAX_THREADS)
+    my_ring_snapshot_len = LPRQ_MAX_THREADS;
+  for (uint32_t i = 0; i < my_ring_snapshot_len; i++)
+    my_ring_snapshot[i] = quiescent_slots[i].epoch;
+}
+
+static int ring_snapshot_passed(void) {
+  for (uint32_t i = 0; i < my_ring_snapshot_len; i++) {
+    if (my_ring_snapshot[i] != RING_OFFLINE && quiescent_slots[i].epoch == my_ring_snapshot[i])
+      return 0;
+  }
+  return 1;
+}
+
+// Pools the waiting rings if every thread passed a quiescent point, then starts waiting for the retired ones
+static void ring_reclaim(void) {
+  if (my_waiting_rings != NULL) {
+    if (!ring_snapshot_passed())
+      return;
+    while (my_waiting_rings != NULL) {
+      PrqRing *r = my_waiting_rings;
+      my_waiting_rings = r->pool_next;
+      ring_pool_push(r);
+    }
+  }
+  if (my_retired_rings != NULL) {
+    ring_snapshot_take();
+    my_waiting_rings = my_retired_rings;
+    my_retired_rings = NULL;
+  }
+}
+
+static void ring_retire(PrqRing *rq) {
+  rq->pool_next = my_retired_rings;
+  my_retired_rings = rq;
+  ring_reclaim();
+}
+
+// Takes a free slot, either one released by an offline thread or a new one, whose index also gives the bottom
+static void ring_thread_online(void) {
+  uint64_t offline = RING_OFFLINE;
+  uint32_t n = n_quiescent_slots;
+  for (uint32_t i = 0; i < n && i < LPRQ_MAX_THREADS; i++) {
+    if (quiescent_slots[i].epoch == RING_OFFLINE && CAE(&quiescent_slots[i].epoch, &offline, &my_ring_epoch)) {
+      my_quiescent_slot = &quiescent_slots[i];
+      my_prq_bottom = PRQ_BOTTOM | i;
+      return;
+    }
+    offline = RING_OFFLINE;
+  }
+  uint32_t i = FAI_U32(&n_quiescent_slots);
+  if (i >= LPRQ_MAX_THREADS) {
+    fprintf(stderr, "More than %d threads on LPRQ rings, raise LPRQ_MAX_THREADS\n", LPRQ_MAX_THREADS);
+    abort();
+  }
+  my_quiescent_slot = &quiescent_slots[i];
+  my_prq_bottom = PRQ_BOTTOM | i;
+  SWAP_U64(&my_quiescent_slot->epoch, my_ring_epoch);
+}
+
+static void ring_quiescent(void) {
+  SWAP_U64(&my_quiescent_slot->epoch, ++my_ring_epoch);
+  ring_reclaim();
+}
+
+// Called by each entry point before it loads any ring, never while a ring is held
+static inline void ring_op_begin(void) {
+  if (unlikely(my_quiescent_slot == NULL))
+    ring_thread_online();
+  else if (unlikely((++my_ring_ops & (LPRQ_QUIESCENT_PERIOD - 1)) == 0))
+    ring_quiescent();
+}
+
+// Releases the slot of a thread done with LPRQ operations for now, so it no longer holds back recycling
+void lprq_thread_offline(void) {
+  if (my_quiescent_slot == NULL)
+    return;
+  SWAP_U64(&my_quiescent_slot->epoch, RING_OFFLINE);
+  my_quiescent_slot = NULL;
+  ring_reclaim();
+}
+
+// A ring for an enqueuer that closed the previous one, recycled if the pool has one of the size
+static PrqRing* ring_get(uint64_t size) {
+  PrqRing *nrq = ring_pool_pop(size);
+
+  if (nrq != NULL) {
+    my_prq_reuse_count += 1;
+  } else {
+#if GC == 1
+    nrq = (PrqRing*) ssmem_alloc(alloc, RING_BYTES(size));
+#else
+    nrq = (PrqRing*) ssalloc(RING_BYTES(size));
+#endif
+    my_prq_alloc_count += 1;
+  }
+  init_ring(nrq, size);
+  return nrq;
+}
+
+// The spare ring of the handle if it has the ring size of q, otherwise one from the pool or a new one
+static PrqRing* ring_take_spare(queue_t * q, handle_t * handle) {
+  PrqRing *nrq = handle->next;
+
+  // The spare ring may come from a queue with another ring size
+  if (nrq != NULL && nrq->size != q->ring_size) {
+    ring_pool_push(nrq);
+    nrq = NULL;
+  }
+  if (nrq == NULL)
+    nrq = ring_get(q->ring_size);
+  return nrq;
+}
+
+static void queue_init_sized(queue_t * q, uint64_t ring_size)
+{
+  PrqRing *rq = (PrqRing*) ssalloc_aligned(CACHE_LINE_SIZE, RING_BYTES(ring_size));
+  init_ring(rq, ring_size);
+
+  q->head = rq;
+  q->tail = rq;
+  q->ring_size = ring_size;
+}
+
+void lprq_queue_init(queue_t * q, int nprocs)
+{
+  queue_init_sized(q, LPRQ_RING_SIZE);
+}
+
+//Unique to this strict variant
+queue_t* queue_create()
+{
+  queue_t *q = (queue_t*) ssalloc_aligned(CACHE_LINE_SIZE, sizeof(queue_t));
+  lprq_queue_init(q, 0);
+
+  return q;
+}
+
+// Sets the entries of the rings of q, including its first ring, so it must be called before q is shared
+void lprq_set_ring_size(queue_t * q, uint64_t ring_size)
+{
+  assert((ring_size & (ring_size - 1)) == 0);
+  assert(ring_order(ring_size) >= LPRQ_MIN_RING_ORDER && ring_order(ring_size) <= LPRQ_MAX_RING_ORDER);
+  assert(q->head == q->tail && q->head->tail == 0);
+
+  PrqRing *first = q->head;
+  if (first->size == ring_size)
+    return;
+  queue_init_sized(q, ring_size);
+  // Never used, so it can go straight to the pool
+  ring_pool_push(first);
+}
+
+static inline void fixState(PrqRing *rq) {
+
+  while (1) {
+    uint64_t t = rq->tail;
+    uint64_t h = rq->head;
+
+    if (rq->tail != t)
+      continue;
+
+    if (h > t) {
+      if (CAE(&rq->tail, &t, &h)) break;
+      continue;
+    }
+    break;
+  }
+}
+
+static inline int close_prq(PrqRing *rq, const uint64_t t, const int tries) {
+  uint64_t tt = t + 1;
+
+  if (tries < 10) {
+    uint64_t nt = tt|1ull<<63;
+    return CAE(&rq->tail, &tt, &nt);}
+  else
+    return TAS_U64(&rq->tail, 63);
+}
+
+/*
+ * Tries to put arg in the cell of ticket t. Without a CAS over both words of the cell, the enqueuer first
+ * reserves the empty cell with its bottom, then moves the index to the round of the ticket and finally
+ * replaces the bottom with the item. A dequeuer that gives up on the ticket removes the bottom, which
+ * fails the last step.
+ */
+static inline int lprq_put_cell(PrqRing *rq, uint64_t t, uint64_t arg) {
+  PrqCell *cell = prq_cell(rq, t);
+  uint64_t idx = cell->idx;
+  uint64_t val = cell->val;
+
+  if (val == PRQ_EMPTY && node_index(idx) <= t &&
+      (!node_unsafe(idx) || (uint64_t) rq->head <= t)) {
+    uint64_t bottom = my_prq_bottom;
+    if (CAE(&cell->val, &val, &bottom)) {
+      uint64_t nidx = t + rq->size;
+      if (CAE(&cell->idx, &idx, &nidx)) {
+        if (enq_commit(&cell->val, bottom, arg))
+          return 1;
+      } else {
+        uint64_t empty = PRQ_EMPTY;
+        CAE(&cell->val, &bottom, &empty);
+      }
+    }
+  }
+  return 0;
+}
+
+static void lprq_put(queue_t * q, handle_t * handle, uint64_t arg) {
+  int try_close = 0;
+
+  while (1) {
+    PrqRing *rq = q->tail;
+    const uint64_t ring_size = rq->size;
+
+    PrqRing *next = rq->next;
+
+    if (next != NULL) {
+      CAE(&q->tail, &rq, &next);
+      continue;
+    }
+
+    uint64_t t = FAI_U64(&rq->tail);
+    ENQ_TIMESTAMP;
+
+    if (prq_is_closed(t)) {
+      PrqRing * nrq;
+alloc:
+      nrq = ring_take_spare(q, handle);
+
+      // Solo enqueue
+      nrq->tail = 1;
+      prq_cell(nrq, 0)->val = arg;
+      prq_cell(nrq, 0)->idx = nrq->size;
+      nrq->items_enqueued = rq->items_enqueued + tail_index(t);
+
+      if (enq_link(rq, next, nrq, 1)) {
+        CAE(&q->tail, &rq, &nrq);
+        handle->next = NULL;
+        return;
+      }
+      //Shared between other queues!
+      handle->next = nrq;
+      continue;
+    }
+
+    if (lprq_put_cell(rq, t, arg))
+      return;
+
+    my_put_cas_fail_count+=1;
+    uint64_t h = rq->head;
+
+    if ((int64_t)(t - h) >= (int64_t)ring_size &&
+        close_prq(rq, t, ++try_close)) {
+      goto alloc;
+    }
+  }
+}
+
+// Tries to take the item at ticket h, returns 1 and sets *val_out on success
+static inline int lprq_get_cell(PrqRing *rq, uint64_t h, uint64_t *val_out) {
+  const uint64_t ring_size = rq->size;
+  PrqCell *cell = prq_cell(rq, h);
+
+  uint64_t tt = 0;
+  int r = 0;
+
+  while (1) {
+
+    uint64_t cell_idx = cell->idx;
+    uint64_t unsafe = node_unsafe(cell_idx);
+    uint64_t idx = node_index(cell_idx);
+    uint64_t val = cell->val;
+
+    // A dequeuer of a later round already moved the cell on
+    if (idx > h + ring_size) return 0;
+
+    if (val != PRQ_EMPTY && !is_bottom(val)) {
+      if (idx == h + ring_size) {
+        *val_out = deq_take(&cell->val, val);
+        return 1;
+      }
+      // An item of an earlier round, mark the cell so its enqueuer's round is not reused too early
+      if (unsafe) {
+        if (cell->idx == cell_idx)
+          return 0;
+      } else {
+        uint64_t nidx = set_unsafe(idx);
+        if (CAE(&cell->idx, &cell_idx, &nidx))
+          return 0;
+      }
+    } else {
+      if ((r & ((1ull << 8) - 1)) == 0)
+        tt = rq->tail;
+
+      // Optimization: try to bail quickly if queue is closed.
+      int prq_closed = prq_is_closed(tt);
+      uint64_t t = tail_index(tt);
+
+      if (unsafe || t < h + 1 || prq_closed || r > 4096) {
+        // Give up on the ticket, removing the bottom of an enqueuer that has not written its item yet
+        uint64_t empty = PRQ_EMPTY;
+        if (is_bottom(val) && !CAE(&cell->val, &val, &empty))
+          continue;
+        uint64_t nidx = unsafe | (h + ring_size);
+        if (CAE(&cell->idx, &cell_idx, &nidx))
+          return 0;
+      } else {
+        ++r;
+      }
+    }
+  }
+}
+
+// Moves the queue head past rq if it is drained, returns 0 if the queue is empty
+static inline int lprq_advance_head(queue_t * q, PrqRing *rq, uint64_t h) {
+  if (tail_index(rq->tail) <= h + 1) {
+    // try to return empty
+    PrqRing *next = rq->next;
+    if (next == NULL) {
+      fixState(rq);
+      return 0;  // EMPTY
+    }
+    if (tail_index(rq->tail) <= h + 1) {
+      if (CAE(&q->head, &rq, &next)) {
+        #if GC == 1
+          ring_retire(rq);
+        #endif
+      }
+    }
+  }
+  return 1;
+}
+
+static uint64_t lprq_get(queue_t * q, handle_t * handle) {
+  while (1) {
+    PrqRing *rq = q->head;
+
+    // Not in the paper, but added for better performance at nearly empty queues
+    // Requires x86 memory order and volatile to not re-order these two reads
+    int64_t head = rq->head;
+    int64_t tail = rq->tail;
+    if (head >= tail && rq->next == NULL) return PRQ_EMPTY;
+
+    uint64_t h = FAI_U64(&rq->head);
+    DEQ_TIMESTAMP;
+
+    uint64_t val;
+    if (lprq_get_cell(rq, h, &val))
+      return val;
+    my_get_cas_fail_count+=1;
+
+    if (!lprq_advance_head(q, rq, h))
+      return PRQ_EMPTY;
+  }
+}
+
+static inline void lprq_enqueue(queue_t * q, handle_t * th, uint64_t val)
+{
+  ring_op_begin();
+  ANALYSIS_LOCK;
+  lprq_put(q, th, val);
+  ANALYSIS_UNLOCK;
+}
+
+static inline uint64_t lprq_dequeue(queue_t * q, handle_t * th)
+{
+  ring_op_begin();
+  ANALYSIS_LOCK;
+  uint64_t val = lprq_get(q, th);
+  ANALYSIS_UNLOCK;
+  return val;
+}
+
+void lprq_queue_free(queue_t * q, handle_t * h){
+  PrqRing *rq = q->head;
+  while(rq){
+    PrqRing *n = rq->next;
+    free(rq);
+    rq = n;
+  };
+}
+
+// Values are in [1, 2^63), as 0 marks empty cells and the top bit the reserved ones
+int enqueue_wrap(queue_t *q, sval_t v) {
+  assert(v != PRQ_EMPTY && !is_bottom(v));
+  lprq_enqueue(q, &thread_handle, (uint64_t) v);
+  return 1;
+}
+
+sval_t dequeue_wrap(queue_t *q) {
+  return (sval_t) lprq_dequeue(q, &thread_handle);
+}
+
+//Need one more function here. Enq count does not guarantee uniqueness!
+uint64_t lprq_enq_count (queue_t *q){
+  PrqRing *tail = q->tail;
+  return tail_index(tail->tail) + tail->items_enqueued;
+}
+
+uint64_t lprq_deq_count(queue_t *q){
+  PrqRing *head = q->head;
+  return head->head + head->items_enqueued;
+}
+
+uint64_t lprq_queue_size(queue_t *q){
+  uint64_t enq_count = lprq_enq_count(q);
+  uint64_t deq_count = lprq_deq_count(q);
+
+  if (enq_count <= deq_count) return 0;
+  return enq_count - deq_count;
+}
+
+uint64_t lprq_tail_version(queue_t *q){
+  PrqRing *tail = q->tail;
+  return (tail_index(tail->tail) & 0xFFFFFFFF) | (tail->items_enqueued << 32);
+}
+
+queue_t* queue_register(queue_t *set, int thread_id)
+{
+    ssalloc_init();
+	#if GC == 1
+    if (alloc == NULL)
+    {
+		alloc = (ssmem_allocator_t*) malloc(sizeof(ssmem_allocator_t));
+		assert(alloc != NULL);
+		ssmem_alloc_init_fs_size(alloc, SSMEM_DEFAULT_MEM_SIZE, SSMEM_GC_FREE_SET_SIZE, thread_id);
+    }
+	#endif
+
+    return set;
+}
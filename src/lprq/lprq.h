@@ -0,0 +1,90 @@
+#ifndef LPRQ_H
+#define LPRQ_H
+
+#include <stdint.h>
+#include "align.h"
+
+#include <assert.h>
+#include <getopt.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/time.h>
+#include <time.h>
+#include "common.h"
+
+#include "lock_if.h"
+#include "ssmem.h"
+#include "utils.h"
+
+#ifdef RELAXATION_TIMER_ANALYSIS
+#include "relaxation_analysis_timestamps.h"
+#elif RELAXATION_ANALYSIS
+#include "relaxation_analysis_queue.h"
+#endif
+
+/*External definitions*/
+extern __thread ssmem_allocator_t* alloc;
+extern __thread int thread_id;
+
+extern __thread unsigned long my_put_cas_fail_count;
+extern __thread unsigned long my_get_cas_fail_count;
+extern __thread unsigned long my_null_count;
+extern __thread unsigned long my_hop_count;
+extern __thread unsigned long my_slide_count;
+extern __thread unsigned long my_prq_alloc_count;
+extern __thread unsigned long my_prq_reuse_count;
+
+// Default entries per ring, the size of the rings of a queue can be changed with lprq_set_ring_size
+#ifndef LPRQ_RING_SIZE
+#define LPRQ_RING_SIZE (1ull << 12)
+#endif
+// Ring sizes are powers of two in this range, with one pool of drained rings per size
+#define LPRQ_MIN_RING_ORDER 1
+#define LPRQ_MAX_RING_ORDER 24
+
+// Operations between the quiescent points where a thread announces it holds no ring loaded before
+#ifndef LPRQ_QUIESCENT_PERIOD
+#define LPRQ_QUIESCENT_PERIOD 64
+#endif
+// Threads that can operate on rings at the same time
+#ifndef LPRQ_MAX_THREADS
+#define LPRQ_MAX_THREADS 512
+#endif
+
+// A value of 0 is an empty cell, and values with the top bit set are the bottoms enqueuers reserve cells with
+typedef struct PrqCell {
+  volatile uint64_t val;
+  volatile uint64_t idx;
+} PrqCell;
+
+#define LPRQ_CELLS_PER_LINE (CACHE_LINE_SIZE / sizeof(PrqCell))
+
+typedef ALIGNED(CACHE_LINE_SIZE) struct PrqRing {
+  volatile int64_t head CACHE_ALIGNED;
+  volatile int64_t tail CACHE_ALIGNED;
+  struct PrqRing *next CACHE_ALIGNED;
+  int64_t items_enqueued;
+  uint64_t size;
+  // Tickets are spread over the lines of the ring, see prq_cell
+  uint32_t line_order;
+  uint32_t cell_order;
+  // Link while retired or pooled, as next stays readable by threads still in the ring
+  struct PrqRing *pool_next;
+  PrqCell array[] CACHE_ALIGNED;
+} PrqRing;
+
+typedef CACHE_ALIGNED struct {
+  PrqRing * volatile head;
+  PrqRing * volatile tail;
+  // Entries of the rings allocated for this queue
+  uint64_t ring_size;
+} queue_t;
+
+typedef struct {
+  PrqRing * next;
+} handle_t;
+
+#endif /* end of include guard: LPRQ_H */
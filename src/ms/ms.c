@@ -9,19 +9,28 @@
 __thread ssmem_allocator_t* alloc;
 
 
-node_t* create_ms_node(skey_t key, sval_t val, node_t* next)
+static node_t* alloc_ms_node(node_t* next)
 {
 	#if GC == 1
 		node_t *node = ssmem_alloc(alloc, sizeof(node_t));
 	#else
 	  	node_t* node = ssalloc(sizeof(node_t));
 	#endif
+	node->next = next;
+
+	return node;
+}
+
+#ifndef PAYLOAD_INLINE
+node_t* create_ms_node(skey_t key, sval_t val, node_t* next)
+{
+	node_t* node = alloc_ms_node(next);
 	node->key = key;
 	node->val = val;
-	node->next = next;
 
 	return node;
 }
+#endif
 
 void init_ms_queue(ms_queue_t *q, int thread_id) {
 	#if GC == 1
@@ -33,7 +42,7 @@ void init_ms_queue(ms_queue_t *q, int thread_id) {
     }
 	#endif
 
-	node_t* node = create_ms_node(0, 0, NULL);
+	node_t* node = alloc_ms_node(NULL);
 	descriptor_t init_desc;
 	init_desc.count = 0;
 	init_desc.node = node;
@@ -112,9 +121,9 @@ static int deq_cae(volatile descriptor_t* des_loc, descriptor_t* read_des_loc, d
 #endif
 }
 
-int ms_enqueue(ms_queue_t *q, skey_t key, sval_t val)
+// Links new_node after the tail
+static void link_node(ms_queue_t *q, node_t* new_node)
 {
-    node_t* new_node = create_ms_node(key, val, NULL);
 	descriptor_t tail;
 
     while(1)
@@ -141,15 +150,14 @@ int ms_enqueue(ms_queue_t *q, skey_t key, sval_t val)
     new_tail.count = tail.count + 1;
     new_tail.node = new_node;
 	CAE(&q->tail, &tail, &new_tail);
-	return 1;
 }
 
-sval_t ms_dequeue(ms_queue_t *q, uint64_t *double_collect_count)
+// Moves the head one node forward and returns the old head, whose next node holds the dequeued item, or NULL if
+// empty. The caller frees the old head after reading the item.
+static node_t* unlink_head(ms_queue_t *q)
 {
 	descriptor_t head, tail, new_tail, new_head;
 
-	uint64_t index;
-	sval_t val;
 	while (1)
     {
 		head = q->head;
@@ -160,7 +168,7 @@ sval_t ms_dequeue(ms_queue_t *q, uint64_t *double_collect_count)
 			if(head.node->next == NULL)
 			{
 				my_null_count+=1;
-				return 0;
+				return NULL;
 			}
 			else
 			{
@@ -175,16 +183,53 @@ sval_t ms_dequeue(ms_queue_t *q, uint64_t *double_collect_count)
             new_head.node = head.node->next;
 			if(deq_cae((descriptor_t*) &q->head, &head, &new_head))
 			{
-				val = head.node->next->val;
-				#if GC == 1
-					ssmem_free(alloc, (void*) head.node);
-				#endif
-				return val;
+				return head.node;
 			}
 		}
     }
 }
 
+#ifdef PAYLOAD_INLINE
+int ms_enqueue_payload(ms_queue_t *q, const payload_t *val)
+{
+	node_t* new_node = alloc_ms_node(NULL);
+	new_node->val = *val;
+	link_node(q, new_node);
+	return 1;
+}
+
+// Copies the payload out of the node, and returns 0 if empty
+int ms_dequeue_payload(ms_queue_t *q, payload_t *val)
+{
+	node_t* old_head = unlink_head(q);
+	if (old_head == NULL)
+		return 0;
+	*val = old_head->next->val;
+	#if GC == 1
+		ssmem_free(alloc, (void*) old_head);
+	#endif
+	return 1;
+}
+#else
+int ms_enqueue(ms_queue_t *q, skey_t key, sval_t val)
+{
+	link_node(q, create_ms_node(key, val, NULL));
+	return 1;
+}
+
+sval_t ms_dequeue(ms_queue_t *q, uint64_t *double_collect_count)
+{
+	node_t* old_head = unlink_head(q);
+	if (old_head == NULL)
+		return 0;
+	sval_t val = old_head->next->val;
+	#if GC == 1
+		ssmem_free(alloc, (void*) old_head);
+	#endif
+	return val;
+}
+#endif
+
 size_t ms_queue_size(ms_queue_t *q){
 	return q->tail.count - q->head.count;
 }
@@ -24,8 +24,14 @@
 #endif
 
 
+#ifdef PAYLOAD_INLINE
+#include "payload.h"
+#define DS_ADD_PAYLOAD(s,p)     ms_enqueue_payload(s,p)
+#define DS_REMOVE_PAYLOAD(s,p)  ms_dequeue_payload(s,p)
+#else
 #define DS_ADD(s,k,v)       ms_enqueue(s,k,v)
 #define DS_REMOVE(s)        ms_dequeue(s, NULL)
+#endif
 #define DS_SIZE(s)          ms_queue_size(s)
 #define DS_NEW(i)           create_ms_queue(i)
 #define DS_REGISTER(s,i)    queue_register(s,i)
@@ -49,8 +55,12 @@
 /* Type definitions */
 typedef struct mqueue_node
 {
+#ifdef PAYLOAD_INLINE
+	payload_t val;
+#else
 	skey_t key;
 	sval_t val;
+#endif
 	struct mqueue_node* volatile next;
 	// uint8_t padding[CACHE_LINE_SIZE - sizeof(skey_t) - sizeof(sval_t) - sizeof(struct mqueue_node*)];
 } node_t;
@@ -84,8 +94,13 @@ extern __thread unsigned long my_hop_count;
 extern __thread unsigned long my_slide_count;
 
 /* Interfaces */
+#ifdef PAYLOAD_INLINE
+int ms_enqueue_payload(ms_queue_t *q, const payload_t *val);
+int ms_dequeue_payload(ms_queue_t *q, payload_t *val);
+#else
 int ms_enqueue(ms_queue_t *set, skey_t key, sval_t val);
 sval_t ms_dequeue(ms_queue_t *q, uint64_t *double_collect_count);
+#endif
 size_t ms_queue_size(ms_queue_t *set);
 uint64_t ms_enq_count(ms_queue_t *set);
 uint64_t ms_deq_count(ms_queue_t *set);
@@ -0,0 +1,277 @@
+/*
+	*   File: test-payload.c
+	*
+	* Random enqueues and dequeues of PAYLOAD_BYTES items, which are either stored inline
+	* in the queue (PAYLOAD_INLINE) or allocated by the enqueuer and passed as pointers
+	* (PAYLOAD_POINTER). Every dequeued payload is read in full and checked, so the
+	* throughput includes the cost of getting at the payload.
+	*
+*/
+
+#include <assert.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include "utils.h"
+
+#include "ms.h"
+#include "payload.h"
+
+/* ################################################################### *
+	* GLOBALS
+* ################################################################### */
+
+size_t num_threads = DEFAULT_NB_THREADS;
+size_t duration = DEFAULT_DURATION;
+size_t initial = 1024;
+size_t put_rate = 50;
+
+static volatile int stop;
+
+uint64_t *ops;
+uint64_t *put_count;
+uint64_t *get_count;
+uint64_t *torn;
+
+/* ################################################################### *
+	* LOCALS
+* ################################################################### */
+
+__thread unsigned long *seeds;
+__thread unsigned long my_put_cas_fail_count;
+__thread unsigned long my_get_cas_fail_count;
+__thread unsigned long my_null_count;
+__thread unsigned long my_hop_count;
+__thread unsigned long my_slide_count;
+__thread int thread_id;
+
+barrier_t barrier, barrier_global;
+
+typedef struct thread_data
+{
+	uint32_t id;
+	DS_TYPE* set;
+} thread_data_t;
+
+// Item n of a thread, where thread 0 starts at 0 to show that an all-zero payload can be stored
+static inline uint64_t item_seq(uint64_t n)
+{
+	return ((uint64_t) thread_id << 40) | n;
+}
+
+#ifdef PAYLOAD_INLINE
+static inline void put_item(DS_HANDLE set, uint64_t seq)
+{
+	payload_t p;
+	payload_fill(&p, seq);
+	DS_ADD_PAYLOAD(set, &p);
+}
+
+static inline int get_item(DS_HANDLE set)
+{
+	payload_t p;
+	if (!DS_REMOVE_PAYLOAD(set, &p))
+		return 0;
+	torn[thread_id] += !payload_check(&p);
+	return 1;
+}
+#else
+static inline void put_item(DS_HANDLE set, uint64_t seq)
+{
+#if GC == 1
+	payload_t *p = (payload_t*) ssmem_alloc(alloc, sizeof(payload_t));
+#else
+	payload_t *p = (payload_t*) ssalloc(sizeof(payload_t));
+#endif
+	payload_fill(p, seq);
+	DS_ADD(set, (skey_t) p, (sval_t) p);
+}
+
+static inline int get_item(DS_HANDLE set)
+{
+	payload_t *p = (payload_t*) DS_REMOVE(set);
+	if (p == NULL)
+		return 0;
+	torn[thread_id] += !payload_check(p);
+#if GC == 1
+	ssmem_free(alloc, (void*) p);
+#endif
+	return 1;
+}
+#endif
+
+void* test(void* thread)
+{
+	thread_data_t* td = (thread_data_t*) thread;
+	thread_id = td->id;
+	set_cpu(thread_id);
+	seeds = seed_rand();
+
+	DS_HANDLE handle = DS_REGISTER(td->set, thread_id);
+	barrier_cross(&barrier);
+
+	uint64_t my_ops = 0, my_gets = 0, n = 0;
+	barrier_cross(&barrier_global);
+	while (!stop)
+	{
+		if (my_random(&(seeds[0]), &(seeds[1]), &(seeds[2])) % 100 < put_rate)
+			put_item(handle, item_seq(n++));
+		else
+			my_gets += get_item(handle);
+		my_ops++;
+	}
+	ops[thread_id] = my_ops;
+	put_count[thread_id] = n;
+	get_count[thread_id] = my_gets;
+
+	pthread_exit(NULL);
+}
+
+int main(int argc, char **argv)
+{
+	set_cpu(0);
+	seeds = seed_rand();
+
+	struct option long_options[] = {
+		// These options don't set a flag
+		{"help",                      no_argument,       NULL, 'h'},
+		{"num-threads",               required_argument, NULL, 'n'},
+		{"duration",                  required_argument, NULL, 'd'},
+		{"initial-size",              required_argument, NULL, 'i'},
+		{"put-rate",                  required_argument, NULL, 'p'},
+		{NULL, 0, NULL, 0}
+	};
+
+	int i, c;
+	while(1)
+	{
+		i = 0;
+		c = getopt_long(argc, argv, "hn:d:i:p:", long_options, &i);
+		if(c == -1)
+			break;
+		if(c == 0 && long_options[i].flag == 0)
+			c = long_options[i].val;
+		switch(c)
+		{
+			case 0:
+			/* Flag is automatically set */
+			break;
+			case 'h':
+			printf("Payloads"
+			"\n"
+			"\n"
+			"Usage:\n"
+			"  %s [options...]\n"
+			"\n"
+			"Options:\n"
+			"  -h, --help\n"
+			"        Print this message\n"
+			"  -n, --num-threads <int>\n"
+			"        Number of threads\n"
+			"  -d, --duration <int>\n"
+			"        Test duration in milliseconds\n"
+			"  -i, --initial-size <int>\n"
+			"        Number of items inserted before the test [DEFAULT=1024].\n"
+			"  -p, --put-rate <int>\n"
+			"        Percentage of enqueues [DEFAULT=50].\n"
+			, argv[0]);
+			exit(0);
+			case 'n':
+			num_threads = atoi(optarg);
+			break;
+			case 'd':
+			duration = atoi(optarg);
+			break;
+			case 'i':
+			initial = atoi(optarg);
+			break;
+			case 'p':
+			put_rate = atoi(optarg);
+			break;
+			case '?':
+			default:
+			printf("Use -h or --help for help\n");
+			exit(1);
+		}
+	}
+
+	thread_id = num_threads;
+
+	DS_TYPE* set = DS_NEW(thread_id);
+	assert(set != NULL);
+	DS_HANDLE handle = DS_REGISTER(set, thread_id);
+	for (size_t n = 0; n < initial; n++)
+		put_item(handle, item_seq(n));
+
+	ops = (uint64_t*) calloc(num_threads, sizeof(uint64_t));
+	put_count = (uint64_t*) calloc(num_threads, sizeof(uint64_t));
+	get_count = (uint64_t*) calloc(num_threads, sizeof(uint64_t));
+	torn = (uint64_t*) calloc(num_threads + 1, sizeof(uint64_t));
+
+	pthread_t threads[num_threads];
+	thread_data_t* tds = (thread_data_t*) malloc(num_threads * sizeof(thread_data_t));
+	barrier_init(&barrier_global, num_threads + 1);
+	barrier_init(&barrier, num_threads);
+
+	long t;
+	for(t = 0; t < num_threads; t++)
+	{
+		tds[t].id = t;
+		tds[t].set = set;
+		int rc = pthread_create(&threads[t], NULL, test, tds + t);
+		if (rc)
+		{
+			printf("ERROR; return code from pthread_create() is %d\n", rc);
+			exit(-1);
+		}
+	}
+
+	struct timespec timeout;
+	timeout.tv_sec = duration / 1000;
+	timeout.tv_nsec = (duration % 1000) * 1000000;
+	struct timeval start, end;
+
+	barrier_cross(&barrier_global);
+	gettimeofday(&start, NULL);
+	nanosleep(&timeout, NULL);
+	stop = 1;
+	gettimeofday(&end, NULL);
+	duration = (end.tv_sec * 1000 + end.tv_usec / 1000) - (start.tv_sec * 1000 + start.tv_usec / 1000);
+
+	for(t = 0; t < num_threads; t++)
+	{
+		pthread_join(threads[t], NULL);
+	}
+	free(tds);
+
+	// Drain the queue, so every payload left is checked as well
+	size_t left = 0;
+	while (get_item(handle))
+		left++;
+
+	uint64_t ops_total = 0, torn_total = torn[num_threads], in_total = initial, out_total = left;
+	for(t = 0; t < num_threads; t++)
+	{
+		ops_total += ops[t];
+		torn_total += torn[t];
+		in_total += put_count[t];
+		out_total += get_count[t];
+	}
+
+	printf("num_threads , %zu \n", num_threads);
+	printf("Payload_Bytes , %d\n", PAYLOAD_BYTES);
+#ifdef PAYLOAD_INLINE
+	printf("Payload_Inline , 1\n");
+#else
+	printf("Payload_Inline , 0\n");
+#endif
+	printf("Mops , %.3f\n", ops_total / (duration * 1000.0));
+	printf("Items_Left , %zu\n", left);
+	printf("Torn_Payloads , %lu\n", torn_total);
+	printf("Lost_Items , %ld\n", (int64_t) (in_total - out_total));
+
+	pthread_exit(NULL);
+	return 0;
+}
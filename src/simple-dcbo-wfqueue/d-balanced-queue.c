@@ -4,7 +4,7 @@
 // Don't have in header as it would double-instantiate both here and in the test file
 __thread uint64_t *double_collect_counts;
 __thread ssmem_allocator_t* alloc;
-__thread handle_t* thread_handles;
+__thread handle_t** thread_handles;
 
 
 int enqueue(mqueue_t *set, skey_t key, sval_t val) {
@@ -145,11 +145,8 @@ mqueue_t* d_balanced_register(mqueue_t *set, int thread_id)
 	#endif
 
 	double_collect_counts = malloc(set->width*sizeof(uint64_t));
-    thread_handles = malloc(set->width*sizeof(handle_t));
-    for (int i = 0; i < set->width; i++)
-    {
-        wfqueue_register(&set->queues[i].partial, &thread_handles[i], thread_id);
-    }
+    // Handles are registered lazily, so the setup does not grow with the width
+    thread_handles = calloc(set->width, sizeof(handle_t*));
 #ifdef RELAXATION_TIMER_ANALYSIS
 	init_relaxation_analysis_local(thread_id);
 #endif
@@ -2,18 +2,16 @@
 
 #include "lock_if.h"
 
-extern __thread handle_t* thread_handles;
-
 int wrapped_enqueue(wrapped_queue_t *queue, uint32_t index, skey_t key, sval_t val)
 {
-    enqueue_wrap(&thread_handles[index],(void*) val);
+    enqueue_wrap(WFQUEUE_HANDLE(&queue->partial, index),(void*) val);
     FAI_U64(&queue->enq_count);
     return 1;
 }
 
 sval_t wrapped_dequeue(wrapped_queue_t *queue, uint32_t index)
 {
-    sval_t ret = dequeue_wrap(&thread_handles[index]);
+    sval_t ret = dequeue_wrap(WFQUEUE_HANDLE(&queue->partial, index));
     if (ret != EMPTY)
     {
         // Count number of successful dequeues only
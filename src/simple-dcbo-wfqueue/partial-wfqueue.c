@@ -35,6 +35,9 @@ typedef struct _deq_t deq_t;
 typedef struct _cell_t cell_t;
 typedef struct _node_t node_t;
 
+// Node to link when a queue runs out of cells, one per thread rather than one per handle, as a thread has a handle on every sub-queue it touched
+static __thread node_t *my_spare;
+
 
 // Spins until the value v is set to something
 static inline void *spin(void *volatile *p) {
@@ -163,18 +166,19 @@ static cell_t *find_cell(node_t *volatile *ptr, long i, handle_t *th) {
         node_t *next = curr->next;
 
         if (next == NULL) {
-            node_t *temp = th->spare;
+            node_t *temp = my_spare;
 
             if (!temp) {
                 temp = new_node();
-                th->spare = temp;
+                my_spare = temp;
             }
 
             temp->id = j + 1;
 
             if (CASra(&curr->next, &next, temp)) {
                 next = temp;
-                th->spare = NULL;
+                my_spare = NULL;
+                th->grown = 1;
             }
         }
 
@@ -422,9 +426,11 @@ void *wfqueue_dequeue(queue_t *q, handle_t *th) {
     th->deq_node_id = th->Dp->id;
     RELEASE(&th->hzd_node_id, -1);
 
-    if (th->spare == NULL) {
+    if (th->grown) {
+        th->grown = 0;
         cleanup(q, th);
-        th->spare = new_node();
+        if (my_spare == NULL)
+            my_spare = new_node();
     }
 
 #ifdef RECORD
@@ -499,7 +505,7 @@ handle_t* wfqueue_register(queue_t *q, handle_t *th, int id) {
     th->Dr.idx = -1;
 
     th->Ei = 0;
-    th->spare = new_node();
+    th->grown = 0;
 #ifdef RECORD
     th->slowenq = 0;
     th->slowdeq = 0;
@@ -530,6 +536,25 @@ handle_t* wfqueue_register(queue_t *q, handle_t *th, int id) {
     return th;
 }
 
+// Registers a new handle with q while other threads might already operate on it. Cleanup frees the nodes
+// before Hp while it holds Hi at -1, so taking Hi the same way keeps Hp alive until the handle is in the
+// ring, where the next cleanup sees its Ep and Dp. Only the first operation of a thread on q waits here.
+handle_t* wfqueue_register_lazy(queue_t *q, handle_t **slot) {
+    handle_t *th = aligned_alloc(CACHE_LINE_SIZE, sizeof(handle_t));
+    assert(th != NULL);
+
+    long oid = ACQUIRE(&q->Hi);
+    while (oid == -1 || !CASa(&q->Hi, &oid, -1)) {
+        PAUSE();
+        oid = ACQUIRE(&q->Hi);
+    }
+    wfqueue_register(q, th, 0);
+    RELEASE(&q->Hi, oid);
+
+    *slot = th;
+    return th;
+}
+
 // Wrappers which return bullshit values to fit into benchmarking framework
 int enqueue_wrap(handle_t *th, void *v) {
   wfqueue_enqueue(th->queue, th, v);
@@ -129,9 +129,10 @@ typedef struct _handle_t {
   struct _handle_t * Dh;
 
   /**
-   * Pointer to a spare node to use, to speedup adding a new node.
+   * Set when this handle linked the spare node of its thread into the queue, so that its next
+   * dequeue runs cleanup. The spare node itself is shared by all handles of the thread.
    */
-  struct _node_t * spare CACHE_ALIGNED;
+  int grown CACHE_ALIGNED;
 
   /**
    * Count the delay rounds of helping another dequeuer.
@@ -154,6 +155,11 @@ typedef struct _handle_t {
 
 
 extern __thread ssmem_allocator_t* alloc;
+// Handles of this thread per sub-queue, NULL until the thread first operates on the sub-queue
+extern __thread handle_t** thread_handles;
+
+// Handle of this thread for sub-queue q at index i, registered with q on the first operation on it
+#define WFQUEUE_HANDLE(q, i)        (thread_handles[i] != NULL ? thread_handles[i] : wfqueue_register_lazy(q, &thread_handles[i]))
 
 // Expose functions
 int enqueue_wrap(handle_t *th, void *v);
@@ -161,6 +167,7 @@ sval_t dequeue_wrap(handle_t *th);
 queue_t* wfqueue_create(int nprocs, int thread_id);
 void wfqueue_init(queue_t *q, int nprocs);
 handle_t* wfqueue_register(queue_t *q, handle_t* th, int id);
+handle_t* wfqueue_register_lazy(queue_t *q, handle_t **slot);
 uint64_t wfqueue_enq_count(queue_t *q);
 uint64_t wfqueue_deq_count(queue_t *q);
 uint64_t wfqueue_length_heuristic(queue_t *q);